@@ -0,0 +1,146 @@
+#define GL_GLEXT_PROTOTYPES // Buffer objects are GL 1.5 entry points
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+// Cube faces as in the old immediate-mode cube: normal, then four corners
+static const float cube_faces[6][5][3] = {
+    {{0, 0, 1},  {-0.5f, -0.5f, 0.5f},  {0.5f, -0.5f, 0.5f},  {0.5f, 0.5f, 0.5f},   {-0.5f, 0.5f, 0.5f}},
+    {{0, 0, -1}, {-0.5f, -0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, -0.5f},  {0.5f, -0.5f, -0.5f}},
+    {{0, 1, 0},  {-0.5f, 0.5f, -0.5f},  {-0.5f, 0.5f, 0.5f},  {0.5f, 0.5f, 0.5f},   {0.5f, 0.5f, -0.5f}},
+    {{0, -1, 0}, {-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, 0.5f},  {-0.5f, -0.5f, 0.5f}},
+    {{1, 0, 0},  {0.5f, -0.5f, -0.5f},  {0.5f, 0.5f, -0.5f},  {0.5f, 0.5f, 0.5f},   {0.5f, -0.5f, 0.5f}},
+    {{-1, 0, 0}, {-0.5f, -0.5f, -0.5f}, {-0.5f, -0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f},  {-0.5f, 0.5f, -0.5f}},
+};
+
+// Two triangles per quad
+static const int quad_corners[6] = {0, 1, 2, 0, 2, 3};
+
+void batch_free(RenderBatch* batch) {
+    if (batch->buffer) glDeleteBuffers(1, &batch->buffer);
+    free(batch->vertices);
+    free(batch->uploaded);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void batch_begin(RenderBatch* batch) {
+    batch->count = 0;
+    batch->flushed = 0;
+    batch->upload_bytes = 0;
+}
+
+RenderVertex* batch_reserve(RenderBatch* batch, size_t count) {
+    if (batch->count + count > batch->capacity) {
+        size_t capacity = batch->capacity ? batch->capacity : 1024;
+        while (capacity < batch->count + count) capacity *= 2;
+        RenderVertex* vertices = realloc(batch->vertices, capacity * sizeof(RenderVertex));
+        if (!vertices) return NULL;
+        batch->vertices = vertices;
+        RenderVertex* uploaded = realloc(batch->uploaded, capacity * sizeof(RenderVertex));
+        if (!uploaded) return NULL;
+        batch->uploaded = uploaded;
+        batch->capacity = capacity;
+    }
+    RenderVertex* v = batch->vertices + batch->count;
+    batch->count += count;
+    return v;
+}
+
+static void set_vertex(RenderVertex* v, float x, float y, float z, const float* normal,
+                       float r, float g, float b) {
+    v->position[0] = x;
+    v->position[1] = y;
+    v->position[2] = z;
+    v->normal[0] = normal[0];
+    v->normal[1] = normal[1];
+    v->normal[2] = normal[2];
+    v->color[0] = (unsigned char)(r >= 1.0f ? 255 : r <= 0.0f ? 0 : r * 255.0f + 0.5f);
+    v->color[1] = (unsigned char)(g >= 1.0f ? 255 : g <= 0.0f ? 0 : g * 255.0f + 0.5f);
+    v->color[2] = (unsigned char)(b >= 1.0f ? 255 : b <= 0.0f ? 0 : b * 255.0f + 0.5f);
+    v->color[3] = 255;
+}
+
+void batch_vertex(RenderBatch* batch, float x, float y, float r, float g, float b) {
+    static const float facing[3] = {0, 0, 1};
+    RenderVertex* v = batch_reserve(batch, 1);
+    if (v) set_vertex(v, x, y, 0.0f, facing, r, g, b);
+}
+
+void batch_rect(RenderBatch* batch, float x, float y, float width, float height,
+                float r, float g, float b) {
+    static const float facing[3] = {0, 0, 1};
+    RenderVertex* v = batch_reserve(batch, 6);
+    if (!v) return;
+    const float corners[4][2] = {{x, y}, {x + width, y}, {x + width, y + height}, {x, y + height}};
+    for (int i = 0; i < 6; i++) {
+        set_vertex(&v[i], corners[quad_corners[i]][0], corners[quad_corners[i]][1], 0.0f, facing, r, g, b);
+    }
+}
+
+void batch_cube(RenderBatch* batch, float x, float y, float z, float size,
+                float r, float g, float b) {
+    RenderVertex* v = batch_reserve(batch, 36);
+    if (!v) return;
+    for (int face = 0; face < 6; face++) {
+        for (int i = 0; i < 6; i++) {
+            const float* corner = cube_faces[face][1 + quad_corners[i]];
+            set_vertex(v++, x + corner[0] * size, y + corner[1] * size, z + corner[2] * size,
+                       cube_faces[face][0], r, g, b);
+        }
+    }
+}
+
+static int same_vertices(const RenderBatch* batch, size_t first, size_t count) {
+    return memcmp(batch->vertices + first, batch->uploaded + first, count * sizeof(RenderVertex)) == 0;
+}
+
+void batch_flush(RenderBatch* batch, unsigned int mode) {
+    size_t first = batch->flushed;
+    size_t end = batch->count;
+    if (first == end) return;
+
+    if (!batch->buffer) glGenBuffers(1, &batch->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    if (batch->capacity * sizeof(RenderVertex) > batch->buffer_size) {
+        // Reallocating drops the contents, so everything is sent again
+        batch->buffer_size = batch->capacity * sizeof(RenderVertex);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)batch->buffer_size, NULL, GL_DYNAMIC_DRAW);
+        batch->uploaded_count = 0;
+    }
+
+    // Upload only the span that differs from what the buffer holds
+    size_t low = first;
+    size_t high = end;
+    if (high > batch->uploaded_count || !same_vertices(batch, low, high - low)) {
+        while (low < high && low < batch->uploaded_count && same_vertices(batch, low, 1)) low++;
+        while (high > low && high <= batch->uploaded_count && same_vertices(batch, high - 1, 1)) high--;
+        size_t bytes = (high - low) * sizeof(RenderVertex);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(low * sizeof(RenderVertex)), (GLsizeiptr)bytes,
+                        batch->vertices + low);
+        memcpy(batch->uploaded + low, batch->vertices + low, bytes);
+        batch->upload_bytes += bytes;
+        if (end > batch->uploaded_count) batch->uploaded_count = end;
+    }
+
+    // The color array leaves the current color undefined; text drawn next relies on it
+    glPushAttrib(GL_CURRENT_BIT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RenderVertex), (const void*)offsetof(RenderVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(RenderVertex), (const void*)offsetof(RenderVertex, normal));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(RenderVertex), (const void*)offsetof(RenderVertex, color));
+    glDrawArrays(mode, (GLint)first, (GLsizei)(end - first));
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glPopAttrib();
+
+    batch->flushed = end;
+}
@@ -0,0 +1,56 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+// Retained vertex batches
+//
+// Drawing code appends vertices for the whole frame into a batch and
+// flushes it at state changes (text, projection, primitive type). Each
+// flush draws its range from a vertex buffer object in one call. The
+// buffer keeps the previous frame's vertices, and only ranges whose bytes
+// differ are uploaded again, so a frame identical to the last one costs
+// one compare and no upload.
+
+typedef struct {
+    float position[3];
+    float normal[3];
+    unsigned char color[4];
+} RenderVertex;
+
+typedef struct {
+    unsigned int buffer;    // GL buffer object, 0 until the first flush
+    size_t buffer_size;     // Bytes allocated on the GPU
+    RenderVertex* vertices; // This frame's vertices
+    RenderVertex* uploaded; // Copy of what the buffer holds
+    size_t count;
+    size_t capacity;
+    size_t uploaded_count;
+    size_t flushed;         // Vertices already drawn this frame
+    size_t upload_bytes;    // Bytes sent to the GPU this frame
+} RenderBatch;
+
+void batch_free(RenderBatch* batch);
+
+// Start a frame: the next vertices overwrite the previous frame's
+void batch_begin(RenderBatch* batch);
+
+// Room for count vertices, or NULL when out of memory
+RenderVertex* batch_reserve(RenderBatch* batch, size_t count);
+
+// One 2D vertex, for line strips and other primitives built point by point
+void batch_vertex(RenderBatch* batch, float x, float y, float r, float g, float b);
+
+// Axis-aligned 2D rectangle as two triangles
+void batch_rect(RenderBatch* batch, float x, float y, float width, float height,
+                float r, float g, float b);
+
+// Unit cube (36 lit vertices) scaled and moved to (x, y, z)
+void batch_cube(RenderBatch* batch, float x, float y, float z, float size,
+                float r, float g, float b);
+
+// Draw the vertices added since the last flush as primitives of mode
+// (GL_TRIANGLES, GL_LINE_STRIP, ...), uploading any that changed
+void batch_flush(RenderBatch* batch, unsigned int mode);
+
+#endif
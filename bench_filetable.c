@@ -0,0 +1,157 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "filetable.h"
+
+// Scan benchmark: count live entries of one type, the filter the tree and
+// the analyzers run most. Compares the hot columns of FileTable with the
+// array-of-structs layout they replaced.
+
+#define BENCH_ENTRIES 10000000
+#define BENCH_ROUNDS 5
+
+// Previous per-entry layout, everything inline in one record
+typedef struct {
+    unsigned int name;
+    unsigned int format;
+    unsigned int metadata;
+    int parent;
+    long long size;
+    time_t created;
+    time_t modified;
+    time_t accessed;
+    unsigned char md5[16];
+    unsigned char type;
+    unsigned char is_deleted;
+    unsigned char has_md5;
+    unsigned short depth;
+} AosEntry;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Hardware cache-miss counter for the calling thread; -1 if unavailable
+static int open_cache_miss_counter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static long long counter_read(int fd) {
+    long long value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value)) return -1;
+    return value;
+}
+
+static long scan_aos(const AosEntry* entries, int count, unsigned char type) {
+    long hits = 0;
+    for (int i = 0; i < count; i++) {
+        hits += (entries[i].type == type) & (entries[i].is_deleted == 0);
+    }
+    return hits;
+}
+
+static long scan_soa(const FileColumns* columns, int count, unsigned char type) {
+    const unsigned char* types = columns->type;
+    const unsigned char* deleted = columns->deleted;
+    long hits = 0;
+    for (int i = 0; i < count; i++) {
+        hits += (types[i] == type) & (deleted[i] == 0);
+    }
+    return hits;
+}
+
+typedef struct {
+    double seconds;
+    long long misses;
+    long hits;
+} ScanResult;
+
+static ScanResult run(const char* label, int counter, const AosEntry* aos,
+                      const FileColumns* columns, int count) {
+    ScanResult best = {1e9, -1, 0};
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        double start = now_seconds();
+        long hits = aos ? scan_aos(aos, count, FILE_TYPE_EXECUTABLE)
+                        : scan_soa(columns, count, FILE_TYPE_EXECUTABLE);
+        double elapsed = now_seconds() - start;
+        if (counter >= 0) ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+
+        if (elapsed < best.seconds) {
+            best.seconds = elapsed;
+            best.misses = counter_read(counter);
+            best.hits = hits;
+        }
+    }
+
+    printf("%-4s %8.2f ms  %6.2f ns/entry  %6.2f GB/s  hits=%ld  cache-misses=",
+           label, best.seconds * 1e3, best.seconds * 1e9 / count,
+           (double)count * (aos ? sizeof(AosEntry) : 2) / best.seconds / 1e9, best.hits);
+    if (best.misses >= 0) printf("%lld\n", best.misses);
+    else printf("n/a\n");
+    return best;
+}
+
+int main(void) {
+    int count = BENCH_ENTRIES;
+    FileTable* table = file_table_create();
+    AosEntry* aos = calloc((size_t)count, sizeof(AosEntry));
+    if (!table || !aos) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // Same synthetic volume in both layouts: 1 in 8 deleted, mixed types
+    srand(42);
+    for (int i = 0; i < count; i++) {
+        FileType type = (FileType)(rand() % (FILE_TYPE_UNKNOWN + 1));
+        int deleted = rand() % 8 == 0;
+        long long size = rand();
+        int index = file_table_add(table, "entry", i > 0 ? 0 : FILE_TABLE_NO_PARENT, type, size);
+        file_table_set_deleted(table, index, deleted);
+        aos[i].type = (unsigned char)type;
+        aos[i].is_deleted = (unsigned char)deleted;
+        aos[i].size = size;
+    }
+
+    int counter = open_cache_miss_counter();
+    printf("%d entries, AoS stride %zu bytes, SoA scan touches 2 bytes/entry\n",
+           count, sizeof(AosEntry));
+    ScanResult a = run("AoS", counter, aos, NULL, count);
+    ScanResult s = run("SoA", counter, NULL, file_table_columns(table), count);
+
+    // Cache lines the scan has to pull in, independent of the counters
+    double aos_lines = (double)count * sizeof(AosEntry) / 64.0;
+    double soa_lines = (double)count * 2 / 64.0;
+    printf("cache lines touched: AoS %.0f, SoA %.0f (%.1fx fewer)\n",
+           aos_lines, soa_lines, aos_lines / soa_lines);
+    if (a.misses > 0 && s.misses >= 0) {
+        printf("measured cache misses: %.1fx fewer\n", (double)a.misses / (double)(s.misses > 0 ? s.misses : 1));
+    }
+    printf("speedup: %.1fx\n", a.seconds / s.seconds);
+
+    if (counter >= 0) close(counter);
+    free(aos);
+    file_table_destroy(table);
+    return a.hits == s.hits ? 0 : 1;
+}
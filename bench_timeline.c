@@ -0,0 +1,114 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "timeline.h"
+
+// Timeline benchmark: build a store of random events over five years,
+// merge it, reopen it and time the two reads the Timeline tab makes:
+// walking the events of a 15-minute window and a histogram of a window
+// at every zoom from the whole span down to a minute.
+
+#define BENCH_EVENTS 10000000
+#define BENCH_QUERIES 10000
+#define BENCH_COLUMNS 600
+#define BASE_TIME 1500000000LL
+#define SPAN (5LL * 365 * 86400)
+#define WINDOW 900
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long seed = 88172645463325252ULL;
+
+static unsigned long long next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+int main(int argc, char** argv) {
+    long long count = argc > 1 ? atoll(argv[1]) : BENCH_EVENTS;
+    char path[] = "/tmp/bench_timeline.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || count <= 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    double start = now_seconds();
+    Timeline* timeline = timeline_create(path);
+    for (long long i = 0; timeline && i < count; i++) {
+        TimelineEvent event = {BASE_TIME + (long long)(next_random() % SPAN), (unsigned int)i,
+                               (unsigned short)(1 + next_random() % 15), TIMELINE_SOURCE_FILE};
+        if (timeline_add(timeline, &event) != 0) {
+            timeline_close(timeline);
+            timeline = NULL;
+        }
+    }
+    if (!timeline || timeline_flush(timeline) != 0) {
+        fprintf(stderr, "cannot write %s\n", path);
+        unlink(path);
+        return 1;
+    }
+    double added = now_seconds() - start;
+    int runs = timeline_run_count(timeline);
+    start = now_seconds();
+    int merged = timeline_merge(timeline, NULL, NULL);
+    double merging = now_seconds() - start;
+    timeline_close(timeline);
+    timeline = merged == 0 ? timeline_open(path) : NULL;
+    if (!timeline) {
+        fprintf(stderr, "cannot merge and reopen %s\n", path);
+        unlink(path);
+        return 1;
+    }
+    printf("%lld events: added in %.2f s as %d runs, merged in %.2f s\n", count, added, runs, merging);
+
+    // Query windows picked up front so the loop times only the store
+    long long* from = malloc(BENCH_QUERIES * sizeof(long long));
+    if (!from) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int q = 0; q < BENCH_QUERIES; q++) from[q] = BASE_TIME + (long long)(next_random() % SPAN);
+
+    size_t walked = 0;
+    start = now_seconds();
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        TimelineCursor cursor;
+        timeline_query(timeline, from[q], from[q] + WINDOW, &cursor);
+        while (timeline_next(&cursor)) walked++;
+    }
+    double querying = now_seconds() - start;
+    printf("%d-second windows: %.2f us each, %.1f events each\n", WINDOW, querying * 1e6 / BENCH_QUERIES,
+           (double)walked / BENCH_QUERIES);
+
+    unsigned long long counts[BENCH_COLUMNS];
+    for (long long width = SPAN; width >= 60; width /= 10) {
+        unsigned long long total = 0;
+        int level = 0;
+        start = now_seconds();
+        for (int q = 0; q < BENCH_QUERIES; q++) {
+            long long window_from = BASE_TIME + (from[q] - BASE_TIME) % (SPAN - width + 1);
+            level = timeline_histogram(timeline, window_from, window_from + width, BENCH_COLUMNS, counts);
+            total += counts[q % BENCH_COLUMNS];
+        }
+        double histogram = now_seconds() - start;
+        printf("%d-column histogram of %lld s: %.2f us each, level %d (%llu)\n", BENCH_COLUMNS, width,
+               histogram * 1e6 / BENCH_QUERIES, level, total);
+    }
+
+    free(from);
+    timeline_close(timeline);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,644 @@
+#define _GNU_SOURCE
+#include "carve.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CARVE_X86 1
+#endif
+
+#define CARVE_BLOCK (1 << 20)   // Bytes fetched from the image per step
+#define CARVE_PAD 64            // Readable bytes past a block for pattern compares
+#define CARVE_SUBBLOCK 65536    // Bytes prefiltered per candidate batch
+#define CARVE_MAX_OPEN 64       // Open candidates tracked at once
+#define CARVE_MAX_PATTERNS 64
+
+#define MB (1024LL * 1024LL)
+
+typedef enum {
+    CARVE_JPEG,
+    CARVE_PNG,
+    CARVE_GIF,
+    CARVE_PDF,
+    CARVE_ZIP,
+    CARVE_RAR,
+    CARVE_7Z,
+    CARVE_PE,
+    CARVE_SQLITE,
+    CARVE_BMP,
+    CARVE_TYPE_COUNT
+} CarveTypeId;
+
+typedef enum {
+    SIZE_BY_FOOTER,      // Ends at the first footer after the header
+    SIZE_BY_LAST_FOOTER, // Ends at the last footer within max_size (PDF updates)
+    SIZE_BY_HEADER       // Length is recorded in the header
+} CarveSizing;
+
+typedef struct {
+    CarveType type;
+    CarveSizing sizing;
+    int nested;          // Headers may occur inside an open file (JPEG thumbnails)
+} CarveRule;
+
+static const CarveRule carve_rules[CARVE_TYPE_COUNT] = {
+    [CARVE_JPEG] = {{"JPEG", "jpg", FILE_TYPE_IMAGE, 32 * MB}, SIZE_BY_FOOTER, 1},
+    [CARVE_PNG] = {{"PNG", "png", FILE_TYPE_IMAGE, 64 * MB}, SIZE_BY_FOOTER, 0},
+    [CARVE_GIF] = {{"GIF", "gif", FILE_TYPE_IMAGE, 16 * MB}, SIZE_BY_FOOTER, 0},
+    [CARVE_PDF] = {{"PDF", "pdf", FILE_TYPE_DOCUMENT, 64 * MB}, SIZE_BY_LAST_FOOTER, 0},
+    [CARVE_ZIP] = {{"ZIP", "zip", FILE_TYPE_UNKNOWN, 256 * MB}, SIZE_BY_FOOTER, 0},
+    [CARVE_RAR] = {{"RAR", "rar", FILE_TYPE_UNKNOWN, 256 * MB}, SIZE_BY_FOOTER, 0},
+    [CARVE_7Z] = {{"7Z", "7z", FILE_TYPE_UNKNOWN, 1024 * MB}, SIZE_BY_HEADER, 0},
+    [CARVE_PE] = {{"PE", "exe", FILE_TYPE_EXECUTABLE, 256 * MB}, SIZE_BY_HEADER, 0},
+    [CARVE_SQLITE] = {{"SQLITE", "sqlite", FILE_TYPE_DOCUMENT, 1024 * MB}, SIZE_BY_HEADER, 0},
+    [CARVE_BMP] = {{"BMP", "bmp", FILE_TYPE_IMAGE, 64 * MB}, SIZE_BY_HEADER, 0},
+};
+
+typedef struct {
+    CarveTypeId type;
+    int footer;
+    const char* bytes;
+    int length;
+} CarvePattern;
+
+#define HEADER(type, bytes) {type, 0, bytes, (int)sizeof(bytes) - 1}
+#define FOOTER(type, bytes) {type, 1, bytes, (int)sizeof(bytes) - 1}
+
+// Every pattern is at least two bytes long; the first two feed the prefilter
+static const CarvePattern carve_patterns[] = {
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xE0"),
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xE1"),
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xE2"),
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xE8"),
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xDB"),
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xEE"),
+    HEADER(CARVE_JPEG, "\xFF\xD8\xFF\xFE"),
+    FOOTER(CARVE_JPEG, "\xFF\xD9"),
+    HEADER(CARVE_PNG, "\x89PNG\r\n\x1A\n"),
+    FOOTER(CARVE_PNG, "IEND\xAE\x42\x60\x82"),
+    HEADER(CARVE_GIF, "GIF87a"),
+    HEADER(CARVE_GIF, "GIF89a"),
+    FOOTER(CARVE_GIF, "\x00\x3B"),
+    HEADER(CARVE_PDF, "%PDF-"),
+    FOOTER(CARVE_PDF, "%%EOF"),
+    HEADER(CARVE_ZIP, "PK\x03\x04"),
+    FOOTER(CARVE_ZIP, "PK\x05\x06"),
+    HEADER(CARVE_RAR, "Rar!\x1A\x07"),
+    FOOTER(CARVE_RAR, "\xC4\x3D\x7B\x00\x40\x07\x00"),
+    HEADER(CARVE_7Z, "7z\xBC\xAF\x27\x1C"),
+    HEADER(CARVE_PE, "MZ"),
+    HEADER(CARVE_SQLITE, "SQLite format 3\0"),
+    HEADER(CARVE_BMP, "BM"),
+};
+
+#define CARVE_PATTERN_COUNT ((int)(sizeof(carve_patterns) / sizeof(carve_patterns[0])))
+
+// Prefilter tables, built at startup. Candidate positions are those whose
+// first two bytes equal the first two bytes of some pattern. The SIMD
+// kernel narrows positions down with nibble lookups: each pair belongs to
+// one of eight buckets, and a position passes when some bucket accepts
+// the low and high nibbles of both bytes. The exact pair bitmap then
+// removes the few false positives.
+static uint64_t pair_bitmap[65536 / 64];
+static signed char pair_head[65536];    // First pattern with this pair, -1 for none
+static signed char pattern_next[CARVE_MAX_PATTERNS];
+static unsigned char nibble_tables[4][16]; // First low/high, second low/high
+
+typedef size_t (*PrefilterFunction)(const unsigned char* data, size_t length, uint32_t* out);
+
+static PrefilterFunction prefilter;
+
+static inline unsigned pair_at(const unsigned char* p) {
+    return (unsigned)p[0] << 8 | p[1];
+}
+
+static inline int pair_known(unsigned pair) {
+    return (int)(pair_bitmap[pair >> 6] >> (pair & 63) & 1);
+}
+
+// data must be readable one byte past length
+static size_t prefilter_portable(const unsigned char* data, size_t length, uint32_t* out) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (pair_known(pair_at(data + i))) out[count++] = (uint32_t)i;
+    }
+    return count;
+}
+
+#ifdef CARVE_X86
+
+__attribute__((target("avx2")))
+static size_t prefilter_avx2(const unsigned char* data, size_t length, uint32_t* out) {
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i first_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nibble_tables[0]));
+    const __m256i first_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nibble_tables[1]));
+    const __m256i second_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nibble_tables[2]));
+    const __m256i second_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)nibble_tables[3]));
+
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+
+        __m256i buckets = _mm256_and_si256(
+            _mm256_shuffle_epi8(first_low, _mm256_and_si256(v0, low_nibble)),
+            _mm256_shuffle_epi8(first_high, _mm256_and_si256(_mm256_srli_epi16(v0, 4), low_nibble)));
+        buckets = _mm256_and_si256(buckets, _mm256_shuffle_epi8(second_low, _mm256_and_si256(v1, low_nibble)));
+        buckets = _mm256_and_si256(buckets, _mm256_shuffle_epi8(
+            second_high, _mm256_and_si256(_mm256_srli_epi16(v1, 4), low_nibble)));
+
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(buckets, zero));
+        while (mask) {
+            size_t position = i + (size_t)__builtin_ctz(mask);
+            if (pair_known(pair_at(data + position))) out[count++] = (uint32_t)position;
+            mask &= mask - 1;
+        }
+    }
+    size_t tail = prefilter_portable(data + i, length - i, out + count);
+    for (size_t t = 0; t < tail; t++) out[count + t] += (uint32_t)i;
+    return count + tail;
+}
+
+#endif
+
+__attribute__((constructor))
+static void carve_build_prefilter(void) {
+    unsigned char firsts[CARVE_MAX_PATTERNS];
+    int first_count = 0;
+
+    memset(pair_head, -1, sizeof(pair_head));
+
+    // Chain patterns by pair in reverse so each chain keeps table order
+    for (int i = CARVE_PATTERN_COUNT - 1; i >= 0; i--) {
+        const unsigned char* bytes = (const unsigned char*)carve_patterns[i].bytes;
+        unsigned pair = pair_at(bytes);
+        if (!pair_known(pair)) {
+            // Pairs sharing a first byte share a bucket
+            int f = 0;
+            while (f < first_count && firsts[f] != bytes[0]) f++;
+            if (f == first_count) firsts[first_count++] = bytes[0];
+            unsigned char bucket = (unsigned char)(1 << (f % 8));
+
+            nibble_tables[0][bytes[0] & 15] |= bucket;
+            nibble_tables[1][bytes[0] >> 4] |= bucket;
+            nibble_tables[2][bytes[1] & 15] |= bucket;
+            nibble_tables[3][bytes[1] >> 4] |= bucket;
+            pair_bitmap[pair >> 6] |= 1ULL << (pair & 63);
+        }
+        pattern_next[i] = pair_head[pair];
+        pair_head[pair] = (signed char)i;
+    }
+
+    prefilter = prefilter_portable;
+#ifdef CARVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) prefilter = prefilter_avx2;
+#endif
+}
+
+const char* carve_engine_name(void) {
+#ifdef CARVE_X86
+    if (prefilter == prefilter_avx2) return "AVX2";
+#endif
+    return "portable";
+}
+
+int carve_type_count(void) {
+    return CARVE_TYPE_COUNT;
+}
+
+const CarveType* carve_type(int index) {
+    if (index < 0 || index >= CARVE_TYPE_COUNT) return NULL;
+    return &carve_rules[index].type;
+}
+
+typedef struct {
+    CarveTypeId type;
+    long long start;
+    long long last_end;  // End of the last footer seen, SIZE_BY_LAST_FOOTER only
+    int owned;           // Header lies in this scan's range; others only pair footers
+} OpenCandidate;
+
+typedef struct {
+    EvidenceImage* image;
+    long long image_size;
+    long long end;
+    CarveResult* result;
+    const ImageRun* extents;  // Where headers may open owned candidates, sorted
+    int extent_count;
+    OpenCandidate open[CARVE_MAX_OPEN];
+    int open_count;
+    int owned_count;
+} Carver;
+
+static uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t le32(const unsigned char* p) { return (uint32_t)le16(p) | (uint32_t)le16(p + 2) << 16; }
+static uint64_t le64(const unsigned char* p) { return (uint64_t)le32(p) | (uint64_t)le32(p + 4) << 32; }
+static uint16_t be16(const unsigned char* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static uint32_t be32(const unsigned char* p) { return (uint32_t)be16(p) << 16 | be16(p + 2); }
+
+// Read bytes after a hit; short reads past the image end are zero-filled
+static int read_at(Carver* carver, long long offset, unsigned char* buffer, size_t length) {
+    memset(buffer, 0, length);
+    if (offset >= carver->image_size) return -1;
+    return image_read(carver->image, offset, buffer, length) > 0 ? 0 : -1;
+}
+
+static int emit(Carver* carver, CarveTypeId type, long long offset, long long length) {
+    CarveResult* result = carver->result;
+    if (length <= 0 || length > carve_rules[type].type.max_size) return 0;
+    if (offset + length > carver->image_size) length = carver->image_size - offset;
+
+    if (result->count == result->capacity) {
+        int capacity = result->capacity ? result->capacity * 2 : 64;
+        CarvedFile* files = realloc(result->files, (size_t)capacity * sizeof(CarvedFile));
+        if (!files) return -1;
+        result->files = files;
+        result->capacity = capacity;
+    }
+    CarvedFile* file = &result->files[result->count++];
+    file->offset = offset;
+    file->length = length;
+    file->type = type;
+    return 0;
+}
+
+static long long pe_size(Carver* carver, long long offset) {
+    unsigned char header[4096];
+    if (read_at(carver, offset, header, sizeof(header)) != 0) return 0;
+
+    uint32_t pe = le32(header + 0x3C);
+    if (pe < 0x40 || pe > sizeof(header) - 24 || memcmp(header + pe, "PE\0\0", 4) != 0) return 0;
+    unsigned sections = le16(header + pe + 6);
+    unsigned optional = le16(header + pe + 20);
+    size_t table = pe + 24 + optional;
+    if (sections == 0 || sections > 96 || table + sections * 40 > sizeof(header)) return 0;
+
+    long long size = optional >= 64 ? le32(header + pe + 24 + 60) : 0; // SizeOfHeaders
+    for (unsigned i = 0; i < sections; i++) {
+        const unsigned char* section = header + table + i * 40;
+        long long raw_end = (long long)le32(section + 20) + le32(section + 16);
+        if (le32(section + 16) && raw_end > size) size = raw_end;
+    }
+    return size;
+}
+
+static long long sqlite_size(Carver* carver, long long offset) {
+    unsigned char header[100];
+    if (read_at(carver, offset, header, sizeof(header)) != 0) return 0;
+
+    long long page_size = be16(header + 16);
+    if (page_size == 1) page_size = 65536;
+    if (page_size < 512 || (page_size & (page_size - 1))) return 0;
+    return page_size * be32(header + 28);
+}
+
+static long long bmp_size(Carver* carver, long long offset) {
+    unsigned char header[18];
+    if (read_at(carver, offset, header, sizeof(header)) != 0) return 0;
+
+    uint32_t size = le32(header + 2);
+    uint32_t pixels = le32(header + 10);
+    uint32_t dib = le32(header + 14);
+    if (le32(header + 6) != 0 || pixels < 26 || pixels >= size) return 0;
+    if (dib != 12 && dib != 40 && dib != 52 && dib != 56 && dib != 64 && dib != 108 && dib != 124) return 0;
+    return size;
+}
+
+static long long sevenzip_size(Carver* carver, long long offset) {
+    unsigned char header[32];
+    if (read_at(carver, offset, header, sizeof(header)) != 0) return 0;
+
+    if (header[6] != 0) return 0; // Major version
+    uint64_t next = le64(header + 12);
+    uint64_t next_size = le64(header + 20);
+    if (next > (1ULL << 40) || next_size == 0 || next_size > (1ULL << 32)) return 0;
+    return (long long)(32 + next + next_size);
+}
+
+// The segment after SOI must end at another marker
+static int jpeg_valid(Carver* carver, long long offset) {
+    unsigned char segment[2];
+    unsigned char marker;
+    if (read_at(carver, offset + 4, segment, 2) != 0) return 0;
+    unsigned length = be16(segment);
+    if (length < 2 || read_at(carver, offset + 4 + length, &marker, 1) != 0) return 0;
+    return marker == 0xFF;
+}
+
+// Bytes past the footer pattern that still belong to the file
+static long long footer_trailer(Carver* carver, CarveTypeId type, long long footer_end) {
+    unsigned char tail[2];
+    switch (type) {
+    case CARVE_ZIP:
+        // End of central directory: 18 more bytes, then the comment
+        if (read_at(carver, footer_end + 16, tail, 2) != 0) return 18;
+        return 18 + le16(tail);
+    case CARVE_PDF:
+        read_at(carver, footer_end, tail, 2);
+        if (tail[0] == '\r' && tail[1] == '\n') return 2;
+        return tail[0] == '\n' || tail[0] == '\r';
+    default:
+        return 0;
+    }
+}
+
+static void drop_candidate(Carver* carver, int index) {
+    if (carver->open[index].owned) carver->owned_count--;
+    memmove(&carver->open[index], &carver->open[index + 1],
+            (size_t)(carver->open_count - index - 1) * sizeof(OpenCandidate));
+    carver->open_count--;
+}
+
+// First extent ending past offset, NULL when none
+static const ImageRun* extent_after(const Carver* carver, long long offset) {
+    int low = 0, high = carver->extent_count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (carver->extents[middle].offset + carver->extents[middle].length <= offset) low = middle + 1;
+        else high = middle;
+    }
+    return low < carver->extent_count ? &carver->extents[low] : NULL;
+}
+
+// Bytes of [from, to) inside the extents
+static long long extent_overlap(const Carver* carver, long long from, long long to) {
+    long long total = 0;
+    const ImageRun* last = carver->extents + carver->extent_count;
+    for (const ImageRun* extent = extent_after(carver, from); extent && extent < last && extent->offset < to; extent++) {
+        long long a = extent->offset > from ? extent->offset : from;
+        long long b = extent->offset + extent->length < to ? extent->offset + extent->length : to;
+        total += b - a;
+    }
+    return total;
+}
+
+static int on_header(Carver* carver, CarveTypeId type, long long offset) {
+    const CarveRule* rule = &carve_rules[type];
+    // Headers in allocated space still open candidates, so that their
+    // footers do not close a file found in a gap
+    const ImageRun* extent = extent_after(carver, offset);
+    int owned = offset < carver->end && extent && extent->offset <= offset;
+
+    if (rule->sizing == SIZE_BY_HEADER) {
+        if (!owned) return 0;
+        long long size = 0;
+        switch (type) {
+        case CARVE_PE: size = pe_size(carver, offset); break;
+        case CARVE_SQLITE: size = sqlite_size(carver, offset); break;
+        case CARVE_BMP: size = bmp_size(carver, offset); break;
+        case CARVE_7Z: size = sevenzip_size(carver, offset); break;
+        default: break;
+        }
+        return size > 0 ? emit(carver, type, offset, size) : 0;
+    }
+
+    if (type == CARVE_JPEG && !jpeg_valid(carver, offset)) return 0;
+    if (!rule->nested) {
+        for (int i = 0; i < carver->open_count; i++) {
+            if (carver->open[i].type != type) continue;
+            // A header after the last footer starts the next file
+            if (carver->open[i].last_end == 0) return 0;
+            if (carver->open[i].owned) {
+                emit(carver, type, carver->open[i].start, carver->open[i].last_end - carver->open[i].start);
+            }
+            drop_candidate(carver, i);
+            break;
+        }
+    }
+    if (carver->open_count == CARVE_MAX_OPEN) drop_candidate(carver, 0);
+
+    OpenCandidate* candidate = &carver->open[carver->open_count++];
+    candidate->type = type;
+    candidate->start = offset;
+    candidate->last_end = 0;
+    candidate->owned = owned;
+    carver->owned_count += owned;
+    return 0;
+}
+
+static int on_footer(Carver* carver, CarveTypeId type, long long offset, int length) {
+    // Pair with the innermost open file of the type
+    int i = carver->open_count - 1;
+    while (i >= 0 && carver->open[i].type != type) i--;
+    if (i < 0) return 0;
+
+    OpenCandidate* candidate = &carver->open[i];
+    long long end = offset + length;
+    end += footer_trailer(carver, type, end);
+
+    if (carve_rules[type].sizing == SIZE_BY_LAST_FOOTER) {
+        candidate->last_end = end;
+        return 0;
+    }
+    int status = candidate->owned ? emit(carver, type, candidate->start, end - candidate->start) : 0;
+    drop_candidate(carver, i);
+    return status;
+}
+
+// Close candidates whose maximum size ends before offset
+static int expire_candidates(Carver* carver, long long offset, int all) {
+    int status = 0;
+    for (int i = carver->open_count - 1; i >= 0; i--) {
+        OpenCandidate* candidate = &carver->open[i];
+        if (!all && offset - candidate->start <= carve_rules[candidate->type].type.max_size) continue;
+        if (candidate->owned && candidate->last_end > 0) {
+            status |= emit(carver, candidate->type, candidate->start, candidate->last_end - candidate->start);
+        }
+        drop_candidate(carver, i);
+    }
+    return status;
+}
+
+static int match_candidates(Carver* carver, const unsigned char* data, long long base,
+                            const uint32_t* positions, size_t count) {
+    for (size_t c = 0; c < count; c++) {
+        const unsigned char* p = data + positions[c];
+        for (int i = pair_head[pair_at(p)]; i >= 0; i = pattern_next[i]) {
+            const CarvePattern* pattern = &carve_patterns[i];
+            if (memcmp(p + 2, pattern->bytes + 2, (size_t)pattern->length - 2) != 0) continue;
+
+            long long offset = base + positions[c];
+            int status = pattern->footer ? on_footer(carver, pattern->type, offset, pattern->length)
+                                         : on_header(carver, pattern->type, offset);
+            if (status != 0) return -1;
+            break;
+        }
+    }
+    return 0;
+}
+
+// One sequential pass over [start, end) and the footers of its files
+// past end. Headers are owned only inside the extents; allocated space
+// between them is read while an owned file is open, to find its footer,
+// and skipped otherwise.
+static int scan_range(EvidenceImage* image, const ImageRun* extents, int extent_count, long long start,
+                      long long end, CarveResult* result, long long* progress, const int* cancel) {
+    Carver carver;
+    memset(&carver, 0, sizeof(carver));
+    carver.image = image;
+    carver.image_size = image_size(image);
+    carver.result = result;
+    carver.extents = extents;
+    carver.extent_count = extent_count;
+    if (end > carver.image_size) end = carver.image_size;
+    carver.end = end;
+    if (start >= end) return 0;
+
+    unsigned char* buffer = malloc(CARVE_BLOCK + CARVE_PAD);
+    uint32_t* positions = malloc(CARVE_SUBBLOCK * sizeof(uint32_t));
+    if (!buffer || !positions) {
+        free(buffer);
+        free(positions);
+        return -1;
+    }
+    image_advise(image, start, end - start, IMAGE_ACCESS_SEQUENTIAL);
+
+    int status = 0;
+    long long offset = start;
+    while (offset < carver.image_size && (offset < end || carver.owned_count > 0)) {
+        if (cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+            status = -1;
+            break;
+        }
+        // With no file of this range open, allocated space has nothing to find
+        if (carver.owned_count == 0) {
+            const ImageRun* next = extent_after(&carver, offset);
+            if (!next || next->offset >= end) break;
+            if (next->offset > offset) {
+                carver.open_count = 0;
+                offset = next->offset;
+            }
+        }
+
+        // Blocks stop at end so progress only counts the owned range
+        long long block = CARVE_BLOCK;
+        if (offset < end && offset + block > end) block = end - offset;
+        if (offset + block > carver.image_size) block = carver.image_size - offset;
+
+        // Raw images are scanned in place; everything else through the buffer
+        const unsigned char* data;
+        ImageView view;
+        if (image_view(image, offset, (size_t)block + CARVE_PAD, &view) == 0 &&
+            view.length >= (size_t)block + CARVE_PAD) {
+            data = view.data;
+        } else {
+            long got = image_read(image, offset, buffer, (size_t)block + CARVE_PAD);
+            if (got < block) {
+                status = -1;
+                break;
+            }
+            memset(buffer + got, 0, (size_t)(block + CARVE_PAD - got));
+            data = buffer;
+        }
+
+        status = expire_candidates(&carver, offset, 0);
+        for (long long sub = 0; sub < block && status == 0; sub += CARVE_SUBBLOCK) {
+            size_t length = (size_t)(block - sub < CARVE_SUBBLOCK ? block - sub : CARVE_SUBBLOCK);
+            size_t count = prefilter(data + sub, length, positions);
+            status = match_candidates(&carver, data + sub, offset + sub, positions, count);
+        }
+        if (status != 0) break;
+
+        if (progress && offset < end) {
+            __atomic_add_fetch(progress, extent_overlap(&carver, offset, offset + block), __ATOMIC_RELAXED);
+        }
+        offset += block;
+    }
+
+    if (status == 0) status = expire_candidates(&carver, offset, 1);
+    image_advise(image, start, offset - start, IMAGE_ACCESS_DONTNEED);
+    free(buffer);
+    free(positions);
+    return status;
+}
+
+int carve_scan(EvidenceImage* image, long long start, long long end,
+               CarveResult* result, long long* progress, const int* cancel) {
+    ImageRun extent = {start, end - start};
+    return scan_range(image, &extent, 1, start, end, result, progress, cancel);
+}
+
+int carve_scan_extents(EvidenceImage* image, const ImageRun* extents, int count, long long start,
+                       long long end, CarveResult* result, long long* progress, const int* cancel) {
+    return scan_range(image, extents, count, start, end, result, progress, cancel);
+}
+
+static int compare_runs(const void* a, const void* b) {
+    const ImageRun* x = a;
+    const ImageRun* y = b;
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+int carve_unallocated(const FileTable* table, const ImageRun* allocated, int allocated_count,
+                      long long image_size, ImageRun** extents) {
+    // The allocated extents and every data run of a live file, in image order
+    size_t used = 0, capacity = 1024;
+    ImageRun* runs = malloc(capacity * sizeof(ImageRun));
+    if (!runs) return -1;
+    int entries = file_table_count(table);
+    for (int index = -1; index < entries; index++) {
+        int count;
+        const ImageRun* file_runs;
+        if (index < 0) {
+            file_runs = allocated;
+            count = allocated_count;
+        } else if (file_table_is_deleted(table, index)) {
+            continue;
+        } else {
+            file_runs = file_table_runs(table, index, &count);
+        }
+        for (int i = 0; i < count; i++) {
+            if (file_runs[i].offset == IMAGE_RUN_SPARSE || file_runs[i].length <= 0) continue;
+            if (used == capacity) {
+                capacity *= 2;
+                ImageRun* grown = realloc(runs, capacity * sizeof(ImageRun));
+                if (!grown) {
+                    free(runs);
+                    return -1;
+                }
+                runs = grown;
+            }
+            runs[used++] = file_runs[i];
+        }
+    }
+    qsort(runs, used, sizeof(ImageRun), compare_runs);
+
+    // The gaps between them, written over the runs already passed: there
+    // is at most one gap more than there are runs
+    ImageRun* gaps = used + 1 > capacity ? realloc(runs, (used + 1) * sizeof(ImageRun)) : runs;
+    if (!gaps) {
+        free(runs);
+        return -1;
+    }
+    int count = 0;
+    long long covered = 0;
+    for (size_t i = 0; i < used && covered < image_size; i++) {
+        ImageRun run = gaps[i];
+        if (run.offset > covered) {
+            gaps[count].offset = covered;
+            gaps[count].length = (run.offset < image_size ? run.offset : image_size) - covered;
+            count++;
+        }
+        if (run.offset + run.length > covered) covered = run.offset + run.length;
+    }
+    if (covered < image_size) {
+        gaps[count].offset = covered;
+        gaps[count].length = image_size - covered;
+        count++;
+    }
+    *extents = gaps;
+    return count;
+}
+
+void carve_result_free(CarveResult* result) {
+    free(result->files);
+    result->files = NULL;
+    result->count = 0;
+    result->capacity = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef CARVE_H
+#define CARVE_H
+
+#include "filetable.h"
+#include "image.h"
+
+// File carving over unallocated space
+//
+// Unallocated space is what the parsed file systems leave free: their
+// allocation bitmaps and tables, with the data runs of the live files in
+// the file table as a fallback, mark the rest as allocated.
+// One pass over the image looks for every header and footer pattern at
+// once. A SIMD prefilter compares each position against the first two
+// bytes of all patterns, so only the rare candidate positions are
+// verified against the full patterns. Headers open a candidate; footers
+// close the most recent open candidate of their type, and formats whose
+// size is in the header (PE, SQLite, BMP, 7z) are sized directly.
+
+typedef struct {
+    const char* name;       // Format name, e.g. "JPEG"
+    const char* extension;  // For carved file names
+    FileType type;
+    long long max_size;     // Candidates without a footer by then are dropped
+} CarveType;
+
+typedef struct {
+    long long offset;       // Image offset of the header
+    long long length;
+    int type;               // Index of the CarveType
+} CarvedFile;
+
+typedef struct {
+    CarvedFile* files;
+    int count;
+    int capacity;
+} CarveResult;
+
+int carve_type_count(void);
+const CarveType* carve_type(int index);
+
+// Prefilter kernel selected at startup, e.g. "AVX2"
+const char* carve_engine_name(void);
+
+// Carve the files whose header lies in [start, end). Footers are followed
+// past end, up to the types' maximum sizes. Adds the bytes scanned in
+// [start, end) to *progress and stops early once *cancel is set; both may
+// be NULL. Returns 0 on success.
+int carve_scan(EvidenceImage* image, long long start, long long end,
+               CarveResult* result, long long* progress, const int* cancel);
+
+// carve_scan restricted to extents, which are sorted and do not overlap.
+// Headers only open files inside an extent, but footers close them
+// anywhere, so a file may run on through allocated space. The range is
+// read in one sequential pass; allocated space is skipped only while no
+// file is open, and progress counts just the extent bytes.
+int carve_scan_extents(EvidenceImage* image, const ImageRun* extents, int count, long long start,
+                       long long end, CarveResult* result, long long* progress, const int* cancel);
+
+// Extents of the image that neither the allocated extents, which may
+// overlap, nor a live file's data runs cover, in image order; the whole
+// image when there are none. Returns their count and sets *extents,
+// which the caller frees, or -1 when out of memory.
+int carve_unallocated(const FileTable* table, const ImageRun* allocated, int allocated_count,
+                      long long image_size, ImageRun** extents);
+void carve_result_free(CarveResult* result);
+
+#endif
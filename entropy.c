@@ -0,0 +1,206 @@
+#include "entropy.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ENTROPY_LANES 4               // Interleaved sub-histograms
+#define ENTROPY_TABLE_SIZE 65537      // c*log2(c) for c up to 64 KiB windows
+#define ENTROPY_FLUSH (1u << 30)      // Keep 32-bit lane counters from wrapping
+
+typedef struct {
+    uint32_t lanes[ENTROPY_LANES][256];
+} LaneHistogram;
+
+static float xlogx_table[ENTROPY_TABLE_SIZE];
+
+__attribute__((constructor))
+static void entropy_init_table(void) {
+    xlogx_table[0] = 0.0f;
+    for (int c = 1; c < ENTROPY_TABLE_SIZE; c++) {
+        xlogx_table[c] = (float)(c * log2((double)c));
+    }
+}
+
+static inline double xlogx(unsigned long long c) {
+    return c < ENTROPY_TABLE_SIZE ? (double)xlogx_table[c] : (double)c * log2((double)c);
+}
+
+// Count bytes into the lane histograms. Consecutive bytes land in
+// different lanes, so a run of one value does not stall on a single
+// counter's store-to-load dependency.
+static void count_bytes(LaneHistogram* h, const unsigned char* p, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint64_t a, b;
+        memcpy(&a, p + i, 8);
+        memcpy(&b, p + i + 8, 8);
+        h->lanes[0][a & 0xFF]++;
+        h->lanes[1][(a >> 8) & 0xFF]++;
+        h->lanes[2][(a >> 16) & 0xFF]++;
+        h->lanes[3][(a >> 24) & 0xFF]++;
+        h->lanes[0][(a >> 32) & 0xFF]++;
+        h->lanes[1][(a >> 40) & 0xFF]++;
+        h->lanes[2][(a >> 48) & 0xFF]++;
+        h->lanes[3][a >> 56]++;
+        h->lanes[0][b & 0xFF]++;
+        h->lanes[1][(b >> 8) & 0xFF]++;
+        h->lanes[2][(b >> 16) & 0xFF]++;
+        h->lanes[3][(b >> 24) & 0xFF]++;
+        h->lanes[0][(b >> 32) & 0xFF]++;
+        h->lanes[1][(b >> 40) & 0xFF]++;
+        h->lanes[2][(b >> 48) & 0xFF]++;
+        h->lanes[3][b >> 56]++;
+    }
+    for (; i < length; i++) h->lanes[i & 3][p[i]]++;
+}
+
+// Fold the lanes into counts and clear them
+static void fold_lanes(LaneHistogram* restrict h, uint32_t* restrict counts) {
+    // Row by row so the adds vectorize
+    memcpy(counts, h->lanes[0], 256 * sizeof(uint32_t));
+    for (int lane = 1; lane < ENTROPY_LANES; lane++) {
+        for (int v = 0; v < 256; v++) counts[v] += h->lanes[lane][v];
+    }
+    memset(h, 0, sizeof(LaneHistogram));
+}
+
+static double bits_from_counts(const uint32_t counts[256], unsigned long long total) {
+    if (total == 0) return 0.0;
+    double sum = 0.0;
+    if (total < ENTROPY_TABLE_SIZE) {
+        // Window-sized counts: plain table lookups, independent partial sums
+        float partial[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int v = 0; v < 256; v += 4) {
+            partial[0] += xlogx_table[counts[v]];
+            partial[1] += xlogx_table[counts[v + 1]];
+            partial[2] += xlogx_table[counts[v + 2]];
+            partial[3] += xlogx_table[counts[v + 3]];
+        }
+        sum = (double)partial[0] + partial[1] + partial[2] + partial[3];
+    } else {
+        for (int v = 0; v < 256; v++) sum += xlogx(counts[v]);
+    }
+    double entropy = log2((double)total) - sum / (double)total;
+    return entropy > 0.0 ? entropy : 0.0;
+}
+
+// Whole-file entropy from 64-bit counts, past the table's range
+static double bits_from_totals(const unsigned long long counts[256], unsigned long long total) {
+    if (total == 0) return 0.0;
+    double sum = 0.0;
+    for (int v = 0; v < 256; v++) sum += xlogx(counts[v]);
+    double entropy = log2((double)total) - sum / (double)total;
+    return entropy > 0.0 ? entropy : 0.0;
+}
+
+// Streaming state shared by the buffer and image-run front ends
+typedef struct {
+    EntropyProfile* profile;
+    LaneHistogram lanes;
+    unsigned long long totals[256];
+    unsigned long long total;
+    size_t filled; // Bytes in the current window
+} ProfileBuilder;
+
+static int builder_flush(ProfileBuilder* b) {
+    EntropyProfile* profile = b->profile;
+    if (b->filled == 0) return 0;
+
+    if (profile->window_count == profile->window_capacity) {
+        int capacity = profile->window_capacity ? profile->window_capacity * 2 : 256;
+        float* windows = realloc(profile->windows, (size_t)capacity * sizeof(float));
+        if (!windows) return -1;
+        profile->windows = windows;
+        profile->window_capacity = capacity;
+    }
+
+    uint32_t counts[256];
+    fold_lanes(&b->lanes, counts);
+    for (int v = 0; v < 256; v++) b->totals[v] += counts[v];
+    b->total += b->filled;
+
+    float bits = (float)bits_from_counts(counts, b->filled);
+    if (profile->window_count == 0 || bits < profile->minimum) profile->minimum = bits;
+    if (profile->window_count == 0 || bits > profile->maximum) profile->maximum = bits;
+    if (bits >= ENTROPY_HIGH) profile->high_windows++;
+    profile->windows[profile->window_count++] = bits;
+    b->filled = 0;
+    return 0;
+}
+
+static int builder_update(ProfileBuilder* b, const unsigned char* p, size_t length) {
+    size_t window = b->profile->window;
+    while (length > 0) {
+        size_t n = window - b->filled;
+        if (n > length) n = length;
+        count_bytes(&b->lanes, p, n);
+        b->filled += n;
+        p += n;
+        length -= n;
+        if (b->filled == window && builder_flush(b) != 0) return -1;
+    }
+    return 0;
+}
+
+static void builder_begin(ProfileBuilder* b, EntropyProfile* profile, size_t window) {
+    memset(b, 0, sizeof(ProfileBuilder));
+    b->profile = profile;
+    profile->window = window ? window : ENTROPY_WINDOW;
+    if (profile->window >= ENTROPY_FLUSH) profile->window = ENTROPY_FLUSH - 1;
+    profile->window_count = 0;
+    profile->minimum = profile->maximum = 0.0f;
+    profile->high_windows = 0;
+    profile->entropy = 0.0;
+}
+
+static int builder_end(ProfileBuilder* b) {
+    if (builder_flush(b) != 0) return -1;
+    b->profile->entropy = bits_from_totals(b->totals, b->total);
+    return 0;
+}
+
+int entropy_profile_bytes(const void* data, size_t length, size_t window, EntropyProfile* profile) {
+    ProfileBuilder b;
+    builder_begin(&b, profile, window);
+    if (builder_update(&b, data, length) != 0) return -1;
+    return builder_end(&b);
+}
+
+int entropy_profile_runs(EvidenceImage* image, const ImageRun* runs, int run_count,
+                         size_t window, EntropyProfile* profile) {
+    static const unsigned char zeros[ENTROPY_WINDOW];
+    ProfileBuilder b;
+    builder_begin(&b, profile, window);
+
+    for (int i = 0; i < run_count; i++) {
+        long long offset = runs[i].offset;
+        long long remaining = runs[i].length;
+        if (offset != IMAGE_RUN_SPARSE) {
+            image_advise(image, offset, remaining, IMAGE_ACCESS_SEQUENTIAL);
+        }
+        while (remaining > 0) {
+            if (offset == IMAGE_RUN_SPARSE) {
+                size_t n = remaining < (long long)sizeof(zeros) ? (size_t)remaining : sizeof(zeros);
+                if (builder_update(&b, zeros, n) != 0) return -1;
+                remaining -= (long long)n;
+                continue;
+            }
+            ImageView view;
+            size_t want = remaining < (1 << 20) ? (size_t)remaining : (size_t)(1 << 20);
+            if (image_view(image, offset, want, &view) != 0 || view.length == 0) return -1;
+            if (builder_update(&b, view.data, view.length) != 0) return -1;
+            offset += (long long)view.length;
+            remaining -= (long long)view.length;
+        }
+    }
+    return builder_end(&b);
+}
+
+void entropy_profile_free(EntropyProfile* profile) {
+    free(profile->windows);
+    profile->windows = NULL;
+    profile->window_count = 0;
+    profile->window_capacity = 0;
+}
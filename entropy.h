@@ -0,0 +1,37 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include <stddef.h>
+
+#include "image.h"
+
+// Shannon entropy of byte data
+//
+// The byte histogram is the hot loop: it is run over every file on the
+// volume. Counting goes to several interleaved sub-histograms so that
+// runs of equal bytes do not serialize on one counter, and the entropy
+// of a window is summed from a c*log2(c) table instead of calling log2.
+
+#define ENTROPY_WINDOW 4096
+#define ENTROPY_HIGH 7.2 // Bits per byte above which data looks compressed or encrypted
+
+// Per-window entropy of a file plus its whole-file entropy
+typedef struct {
+    double entropy;     // Whole file, bits per byte
+    float* windows;     // One value per window, in file order
+    int window_count;
+    int window_capacity;
+    size_t window;
+    float minimum;
+    float maximum;
+    int high_windows;   // Windows at or above ENTROPY_HIGH
+} EntropyProfile;
+
+// Stream a memory buffer or the data runs of a file into a profile of
+// consecutive windows. The last window may be short. 0 on success.
+int entropy_profile_bytes(const void* data, size_t length, size_t window, EntropyProfile* profile);
+int entropy_profile_runs(EvidenceImage* image, const ImageRun* runs, int run_count,
+                         size_t window, EntropyProfile* profile);
+void entropy_profile_free(EntropyProfile* profile);
+
+#endif
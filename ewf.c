@@ -0,0 +1,510 @@
+#define _GNU_SOURCE
+#include "ewf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define EWF_FILE_HEADER_SIZE 13
+#define EWF_SECTION_SIZE 76
+#define EWF_TABLE_HEADER_SIZE 24
+#define EWF_MAX_SEGMENTS 14971 // .E01-.E99 then .EAA-.ZZZ: 99 + 22 * 26 * 26
+#define EWF_OPEN_SEGMENTS 16    // Segment files kept open per image
+
+static const unsigned char ewf_signature[8] = {'E', 'V', 'F', 0x09, 0x0D, 0x0A, 0xFF, 0x00};
+
+typedef struct {
+    int fd;                 // -1 while closed
+    long long size;
+} EwfSegment;
+
+typedef struct {
+    unsigned long long offset; // Absolute offset inside the segment file
+    unsigned int size;         // Stored size, including checksum if uncompressed
+    unsigned short segment;
+    unsigned char compressed;
+} EwfChunk;
+
+typedef struct {
+    long long chunk;  // -1 when the slot is free
+    int prev;
+    int next;
+    int hash_next;
+    unsigned int length;
+    unsigned char* data;
+} EwfCacheSlot;
+
+struct EwfImage {
+    char* path;             // First segment; the others are named after it
+    EwfSegment* segments;
+    int segment_count;
+    int segment_capacity;
+    int open[EWF_OPEN_SEGMENTS]; // Open segments, most recently used first
+    int open_count;
+
+    EwfChunk* chunks;
+    long long chunk_count;
+    long long chunk_capacity;
+    unsigned int chunk_size;
+    long long media_size;
+
+    // LRU cache of decompressed chunks
+    EwfCacheSlot* slots;
+    int slot_count;
+    int lru_head; // Most recently used
+    int lru_tail; // Next victim
+    int* buckets;
+    int bucket_mask;
+    long hits;
+    long misses;
+
+    unsigned char* scratch; // Compressed chunk staging buffer
+    size_t scratch_size;
+
+    // Acquisition hashes from the hash/digest sections
+    int stored_mask;
+    unsigned char stored_md5[16];
+    unsigned char stored_sha1[20];
+};
+
+static unsigned int read_le32(const unsigned char* p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+           ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned long long read_le64(const unsigned char* p) {
+    return (unsigned long long)read_le32(p) | ((unsigned long long)read_le32(p + 4) << 32);
+}
+
+static int read_exact(int fd, void* buffer, size_t length, long long offset) {
+    unsigned char* out = buffer;
+    while (length > 0) {
+        ssize_t n = pread(fd, out, length, (off_t)offset);
+        if (n <= 0) return -1;
+        out += n;
+        offset += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+// Build the path of segment number (1-based) from the first segment path
+static int segment_path(const char* first, int number, char* out, size_t out_size) {
+    size_t len = strlen(first);
+    if (len < 4 || len + 1 > out_size || first[len - 4] != '.') return -1;
+
+    memcpy(out, first, len + 1);
+    char base = first[len - 3];
+    int upper = base >= 'A' && base <= 'Z';
+    if (number <= 99) {
+        out[len - 2] = (char)('0' + number / 10);
+        out[len - 1] = (char)('0' + number % 10);
+        return 0;
+    }
+
+    // .E99 is followed by .EAA ... .EZZ, .FAA ...
+    int n = number - 100;
+    char a = upper ? 'A' : 'a';
+    out[len - 3] = (char)(base + n / (26 * 26));
+    out[len - 2] = (char)(a + (n / 26) % 26);
+    out[len - 1] = (char)(a + n % 26);
+    return 0;
+}
+
+// Descriptor of a segment file, opened on first use. Only the
+// EWF_OPEN_SEGMENTS most recently used stay open, so images of thousands
+// of segments read by several workers do not run out of descriptors.
+static int segment_fd(EwfImage* image, int segment) {
+    EwfSegment* seg = &image->segments[segment];
+    int position = 0;
+    while (position < image->open_count && image->open[position] != segment) position++;
+
+    if (position == image->open_count) {
+        char name[4096];
+        const char* path = image->path;
+        if (segment > 0) {
+            if (segment_path(image->path, segment + 1, name, sizeof(name)) != 0) return -1;
+            path = name;
+        }
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return -1;
+        if (image->open_count == EWF_OPEN_SEGMENTS) {
+            EwfSegment* victim = &image->segments[image->open[--image->open_count]];
+            close(victim->fd);
+            victim->fd = -1;
+        }
+        seg->fd = fd;
+        position = image->open_count++;
+    }
+    memmove(image->open + 1, image->open, (size_t)position * sizeof(int));
+    image->open[0] = segment;
+    return seg->fd;
+}
+
+static int add_chunk(EwfImage* image, unsigned short segment, unsigned long long offset,
+                     unsigned int size, int compressed) {
+    if (image->chunk_count == image->chunk_capacity) {
+        long long capacity = image->chunk_capacity ? image->chunk_capacity * 2 : 4096;
+        EwfChunk* chunks = realloc(image->chunks, (size_t)capacity * sizeof(EwfChunk));
+        if (!chunks) return -1;
+        image->chunks = chunks;
+        image->chunk_capacity = capacity;
+    }
+
+    EwfChunk* chunk = &image->chunks[image->chunk_count++];
+    chunk->offset = offset;
+    chunk->size = size;
+    chunk->segment = segment;
+    chunk->compressed = (unsigned char)compressed;
+    return 0;
+}
+
+// Parse a table section and append its chunks to the chunk map
+static int parse_table(EwfImage* image, int segment, long long data_offset,
+                       unsigned long long data_end) {
+    int fd = segment_fd(image, segment);
+    unsigned char header[EWF_TABLE_HEADER_SIZE];
+    if (fd < 0 || read_exact(fd, header, sizeof(header), data_offset) != 0) return -1;
+
+    unsigned int entry_count = read_le32(header);
+    unsigned long long base = read_le64(header + 8);
+    if (entry_count == 0) return 0;
+
+    unsigned char* entries = malloc((size_t)entry_count * 4);
+    if (!entries) return -1;
+    if (read_exact(fd, entries, (size_t)entry_count * 4, data_offset + EWF_TABLE_HEADER_SIZE) != 0) {
+        free(entries);
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < entry_count; i++) {
+        unsigned int entry = read_le32(entries + (size_t)i * 4);
+        unsigned long long offset = base + (entry & 0x7FFFFFFFu);
+        unsigned long long end = data_end;
+        if (i + 1 < entry_count) {
+            end = base + (read_le32(entries + (size_t)(i + 1) * 4) & 0x7FFFFFFFu);
+        }
+        if (end <= offset || end - offset > 0xFFFFFFFFull) {
+            free(entries);
+            return -1;
+        }
+        if (add_chunk(image, (unsigned short)segment, offset,
+                      (unsigned int)(end - offset), (int)(entry >> 31)) != 0) {
+            free(entries);
+            return -1;
+        }
+    }
+
+    free(entries);
+    return 0;
+}
+
+// Walk the section chain of one segment file
+static int parse_segment(EwfImage* image, int segment) {
+    EwfSegment* seg = &image->segments[segment];
+    int fd = segment_fd(image, segment);
+    unsigned char header[EWF_FILE_HEADER_SIZE];
+    if (fd < 0 || read_exact(fd, header, sizeof(header), 0) != 0) return -1;
+    if (memcmp(header, ewf_signature, sizeof(ewf_signature)) != 0) return -1;
+
+    long long offset = EWF_FILE_HEADER_SIZE;
+    unsigned long long sectors_end = 0;
+
+    while (offset + EWF_SECTION_SIZE <= seg->size) {
+        unsigned char section[EWF_SECTION_SIZE];
+        if (read_exact(fd, section, sizeof(section), offset) != 0) return -1;
+
+        char type[17];
+        memcpy(type, section, 16);
+        type[16] = '\0';
+        unsigned long long next = read_le64(section + 16);
+        unsigned long long size = read_le64(section + 24);
+        long long data_offset = offset + EWF_SECTION_SIZE;
+
+        if (strcmp(type, "volume") == 0 || strcmp(type, "disk") == 0) {
+            unsigned char volume[24];
+            if (read_exact(fd, volume, sizeof(volume), data_offset) != 0) return -1;
+            unsigned int sectors_per_chunk = read_le32(volume + 8);
+            unsigned int bytes_per_sector = read_le32(volume + 12);
+            unsigned long long sector_count = read_le64(volume + 16);
+            image->chunk_size = sectors_per_chunk * bytes_per_sector;
+            image->media_size = (long long)(sector_count * bytes_per_sector);
+        } else if (strcmp(type, "sectors") == 0) {
+            sectors_end = (unsigned long long)offset + size;
+        } else if (strcmp(type, "table") == 0) {
+            // The last chunk of a table ends where its sectors section ends
+            unsigned long long data_end = sectors_end ? sectors_end : (unsigned long long)offset;
+            if (parse_table(image, segment, data_offset, data_end) != 0) return -1;
+            fd = segment_fd(image, segment);
+        } else if (strcmp(type, "hash") == 0 || strcmp(type, "digest") == 0) {
+            // hash: MD5; digest: MD5 followed by SHA-1
+            int digest = type[0] == 'd';
+            unsigned char data[36];
+            if (read_exact(fd, data, digest ? 36 : 16, data_offset) != 0) return -1;
+            memcpy(image->stored_md5, data, 16);
+            image->stored_mask |= 1;
+            if (digest) {
+                memcpy(image->stored_sha1, data + 16, 20);
+                image->stored_mask |= 2;
+            }
+        } else if (strcmp(type, "next") == 0 || strcmp(type, "done") == 0) {
+            break;
+        }
+
+        if (next <= (unsigned long long)offset) break;
+        offset = (long long)next;
+    }
+
+    return 0;
+}
+
+// Find the segment files and parse each one's sections; the files are
+// opened through segment_fd, so only the last few stay open
+static int open_segments(EwfImage* image, const char* path) {
+    image->path = strdup(path);
+    if (!image->path) return -1;
+
+    char segment_name[4096];
+    for (int number = 1; number <= EWF_MAX_SEGMENTS; number++) {
+        const char* name = path;
+        if (number > 1) {
+            if (segment_path(path, number, segment_name, sizeof(segment_name)) != 0) break;
+            name = segment_name;
+        }
+        struct stat st;
+        if (stat(name, &st) != 0) break;
+
+        if (image->segment_count == image->segment_capacity) {
+            int capacity = image->segment_capacity ? image->segment_capacity * 2 : 16;
+            EwfSegment* segments = realloc(image->segments, (size_t)capacity * sizeof(EwfSegment));
+            if (!segments) return -1;
+            image->segments = segments;
+            image->segment_capacity = capacity;
+        }
+        EwfSegment* seg = &image->segments[image->segment_count++];
+        seg->fd = -1;
+        seg->size = (long long)st.st_size;
+        if (parse_segment(image, image->segment_count - 1) != 0) return -1;
+    }
+
+    return image->segment_count > 0 ? 0 : -1;
+}
+
+static int init_cache(EwfImage* image, int cache_chunks) {
+    if (cache_chunks < 1) cache_chunks = EWF_DEFAULT_CACHE_CHUNKS;
+    int bucket_count = 1;
+    while (bucket_count < cache_chunks * 2) bucket_count <<= 1;
+
+    image->slots = calloc((size_t)cache_chunks, sizeof(EwfCacheSlot));
+    image->buckets = malloc((size_t)bucket_count * sizeof(int));
+    image->scratch_size = (size_t)image->chunk_size + 1024;
+    image->scratch = malloc(image->scratch_size);
+    if (!image->slots || !image->buckets || !image->scratch) return -1;
+
+    image->slot_count = cache_chunks;
+    image->bucket_mask = bucket_count - 1;
+    for (int i = 0; i < bucket_count; i++) image->buckets[i] = -1;
+
+    // All slots start free, chained oldest-first so they are used in order
+    for (int i = 0; i < cache_chunks; i++) {
+        image->slots[i].chunk = -1;
+        image->slots[i].hash_next = -1;
+        image->slots[i].prev = i + 1 < cache_chunks ? i + 1 : -1;
+        image->slots[i].next = i - 1;
+    }
+    image->lru_head = cache_chunks - 1;
+    image->lru_tail = 0;
+    return 0;
+}
+
+EwfImage* ewf_open(const char* path, int cache_chunks) {
+    EwfImage* image = calloc(1, sizeof(EwfImage));
+    if (!image) return NULL;
+
+    if (open_segments(image, path) != 0 || image->chunk_size == 0 ||
+        image->chunk_count == 0 || init_cache(image, cache_chunks) != 0) {
+        ewf_close(image);
+        return NULL;
+    }
+
+    // Trust the chunk map over the volume section if they disagree
+    long long mapped = image->chunk_count * (long long)image->chunk_size;
+    if (image->media_size <= 0 || image->media_size > mapped) image->media_size = mapped;
+    return image;
+}
+
+void ewf_close(EwfImage* image) {
+    if (!image) return;
+    for (int i = 0; i < image->open_count; i++) {
+        close(image->segments[image->open[i]].fd);
+    }
+    if (image->slots) {
+        for (int i = 0; i < image->slot_count; i++) free(image->slots[i].data);
+    }
+    free(image->segments);
+    free(image->path);
+    free(image->chunks);
+    free(image->slots);
+    free(image->buckets);
+    free(image->scratch);
+    free(image);
+}
+
+long long ewf_media_size(const EwfImage* image) {
+    return image->media_size;
+}
+
+unsigned int ewf_chunk_size(const EwfImage* image) {
+    return image->chunk_size;
+}
+
+long long ewf_chunk_count(const EwfImage* image) {
+    return image->chunk_count;
+}
+
+int ewf_segment_count(const EwfImage* image) {
+    return image->segment_count;
+}
+
+void ewf_cache_stats(const EwfImage* image, long* hits, long* misses) {
+    if (hits) *hits = image->hits;
+    if (misses) *misses = image->misses;
+}
+
+int ewf_stored_hashes(const EwfImage* image, unsigned char md5[16], unsigned char sha1[20]) {
+    if (image->stored_mask & 1) memcpy(md5, image->stored_md5, 16);
+    if (image->stored_mask & 2) memcpy(sha1, image->stored_sha1, 20);
+    return image->stored_mask;
+}
+
+static void lru_unlink(EwfImage* image, int slot) {
+    EwfCacheSlot* s = &image->slots[slot];
+    if (s->prev >= 0) image->slots[s->prev].next = s->next;
+    else image->lru_head = s->next;
+    if (s->next >= 0) image->slots[s->next].prev = s->prev;
+    else image->lru_tail = s->prev;
+}
+
+static void lru_push_front(EwfImage* image, int slot) {
+    EwfCacheSlot* s = &image->slots[slot];
+    s->prev = -1;
+    s->next = image->lru_head;
+    if (image->lru_head >= 0) image->slots[image->lru_head].prev = slot;
+    image->lru_head = slot;
+    if (image->lru_tail < 0) image->lru_tail = slot;
+}
+
+static void hash_remove(EwfImage* image, int slot) {
+    int* link = &image->buckets[image->slots[slot].chunk & image->bucket_mask];
+    while (*link >= 0) {
+        if (*link == slot) {
+            *link = image->slots[slot].hash_next;
+            return;
+        }
+        link = &image->slots[*link].hash_next;
+    }
+}
+
+// Inflate (or copy) one chunk from its segment file into the slot
+static int load_chunk(EwfImage* image, long long index, EwfCacheSlot* slot) {
+    const EwfChunk* chunk = &image->chunks[index];
+    int fd = segment_fd(image, chunk->segment);
+    if (fd < 0) return -1;
+
+    if (!slot->data) {
+        slot->data = malloc(image->chunk_size);
+        if (!slot->data) return -1;
+    }
+
+    long long remaining = image->media_size - index * (long long)image->chunk_size;
+    unsigned int expected = remaining < (long long)image->chunk_size ?
+                            (unsigned int)remaining : image->chunk_size;
+
+    if (chunk->compressed) {
+        if (chunk->size > image->scratch_size) {
+            unsigned char* scratch = realloc(image->scratch, chunk->size);
+            if (!scratch) return -1;
+            image->scratch = scratch;
+            image->scratch_size = chunk->size;
+        }
+        if (read_exact(fd, image->scratch, chunk->size, (long long)chunk->offset) != 0) return -1;
+
+        uLongf length = image->chunk_size;
+        if (uncompress(slot->data, &length, image->scratch, chunk->size) != Z_OK) return -1;
+        slot->length = (unsigned int)length;
+    } else {
+        // Uncompressed chunks carry a trailing Adler-32 we do not need
+        unsigned int length = chunk->size < expected ? chunk->size : expected;
+        if (read_exact(fd, slot->data, length, (long long)chunk->offset) != 0) return -1;
+        slot->length = length;
+    }
+
+    if (slot->length > expected) slot->length = expected;
+    return 0;
+}
+
+const unsigned char* ewf_chunk_data(EwfImage* image, long long chunk, unsigned int* length) {
+    if (chunk < 0 || chunk >= image->chunk_count) return NULL;
+
+    for (int slot = image->buckets[chunk & image->bucket_mask]; slot >= 0;
+         slot = image->slots[slot].hash_next) {
+        if (image->slots[slot].chunk == chunk) {
+            image->hits++;
+            if (slot != image->lru_head) {
+                lru_unlink(image, slot);
+                lru_push_front(image, slot);
+            }
+            if (length) *length = image->slots[slot].length;
+            return image->slots[slot].data;
+        }
+    }
+
+    // Miss: recycle the least recently used slot
+    image->misses++;
+    int victim = image->lru_tail;
+    EwfCacheSlot* slot = &image->slots[victim];
+    if (slot->chunk >= 0) hash_remove(image, victim);
+    slot->chunk = -1;
+
+    if (load_chunk(image, chunk, slot) != 0) return NULL;
+
+    slot->chunk = chunk;
+    int* bucket = &image->buckets[chunk & image->bucket_mask];
+    slot->hash_next = *bucket;
+    *bucket = victim;
+    lru_unlink(image, victim);
+    lru_push_front(image, victim);
+
+    if (length) *length = slot->length;
+    return slot->data;
+}
+
+long ewf_read(EwfImage* image, long long offset, void* buffer, size_t length) {
+    if (offset < 0 || offset >= image->media_size) return offset == image->media_size ? 0 : -1;
+    if ((long long)length > image->media_size - offset) {
+        length = (size_t)(image->media_size - offset);
+    }
+
+    unsigned char* out = buffer;
+    size_t done = 0;
+    while (done < length) {
+        long long position = offset + (long long)done;
+        long long chunk = position / image->chunk_size;
+        unsigned int within = (unsigned int)(position % image->chunk_size);
+
+        unsigned int chunk_length;
+        const unsigned char* data = ewf_chunk_data(image, chunk, &chunk_length);
+        if (!data || within >= chunk_length) return done > 0 ? (long)done : -1;
+
+        size_t n = chunk_length - within;
+        if (n > length - done) n = length - done;
+        memcpy(out + done, data + within, n);
+        done += n;
+    }
+
+    return (long)done;
+}
@@ -0,0 +1,41 @@
+#ifndef EWF_H
+#define EWF_H
+
+#include <stddef.h>
+
+// Expert Witness Format (E01) evidence reader
+//
+// Parses the section chain of every segment file (.E01, .E02, ...),
+// builds a chunk map from the table sections and inflates chunks on
+// demand. Decompressed chunks are kept in an LRU cache so repeated
+// seeks into the same region do not re-inflate the chunk. Segment files
+// are opened as their chunks are read and only the few most recently
+// used stay open, so a handle per worker stays cheap on long sets.
+
+#define EWF_DEFAULT_CACHE_CHUNKS 256 // 8 MiB with 32 KiB chunks
+
+typedef struct EwfImage EwfImage;
+
+// Open an image by the path of its first segment; NULL on failure
+EwfImage* ewf_open(const char* path, int cache_chunks);
+void ewf_close(EwfImage* image);
+
+long long ewf_media_size(const EwfImage* image);
+unsigned int ewf_chunk_size(const EwfImage* image);
+long long ewf_chunk_count(const EwfImage* image);
+int ewf_segment_count(const EwfImage* image);
+
+// Return the decompressed chunk from the cache. The pointer stays valid
+// until the chunk is evicted, i.e. until the next cache miss.
+const unsigned char* ewf_chunk_data(EwfImage* image, long long chunk, unsigned int* length);
+
+// Read media bytes; returns the number of bytes read or -1 on error
+long ewf_read(EwfImage* image, long long offset, void* buffer, size_t length);
+
+void ewf_cache_stats(const EwfImage* image, long* hits, long* misses);
+
+// Acquisition hashes recorded in the hash/digest sections. Returns a mask:
+// 1 when md5 was filled, 2 when sha1 was filled.
+int ewf_stored_hashes(const EwfImage* image, unsigned char md5[16], unsigned char sha1[20]);
+
+#endif
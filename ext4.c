@@ -0,0 +1,692 @@
+#define _GNU_SOURCE
+#include "ext4.h"
+#include "sig.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define EXT4_SUPERBLOCK 1024
+#define EXT4_MAGIC 0xEF53
+#define EXT4_EXTENT_MAGIC 0xF30A
+#define EXT4_ROOT_INODE 2
+#define EXT4_SCAN_BATCH (4 << 20)      // Inode table bytes read at once
+#define EXT4_MAX_DEPTH 256             // Directory nesting followed
+#define EXT4_MAX_TREE 5                // Extent tree depth the format allows
+#define EXT4_MAX_DIRECTORY (256 << 20) // Largest directory read
+
+#define INCOMPAT_FILETYPE 0x0002
+#define INCOMPAT_META_BG 0x0010
+#define INCOMPAT_64BIT 0x0080
+#define RO_COMPAT_SPARSE_SUPER 0x0001
+#define RO_COMPAT_GDT_CSUM 0x0010
+#define RO_COMPAT_METADATA_CSUM 0x0400
+
+#define BG_INODE_UNINIT 0x0001
+#define BG_BLOCK_UNINIT 0x0002
+
+#define INODE_INDEX_FL 0x00001000
+#define INODE_EXTENTS_FL 0x00080000
+#define INODE_INLINE_DATA_FL 0x10000000
+
+#define MODE_TYPE 0xF000
+#define MODE_DIRECTORY 0x4000
+#define MODE_REGULAR 0x8000
+#define MODE_SYMLINK 0xA000
+
+// Ext4Inode flags
+#define INODE_LIVE 0x01
+#define INODE_INDEXED 0x02
+#define INODE_REACHED 0x04
+
+typedef struct {
+    uint32_t ino;
+    uint16_t mode;
+    uint16_t flags;
+    long long size;
+    time_t created;
+    time_t modified;
+    time_t accessed;
+    time_t changed;
+    uint32_t run_first;
+    uint32_t run_count;
+} Ext4Inode;
+
+typedef struct {
+    EvidenceImage* image;
+    FileTable* table;
+    VolumeStats* stats;
+    long long offset;
+    long long block_size;
+    unsigned long long blocks_count;
+    uint32_t first_data_block;
+    uint32_t blocks_per_group;
+    uint32_t inodes_per_group;
+    uint32_t inodes_count;
+    uint32_t inode_size;
+    uint32_t first_ino;
+    uint32_t incompat;
+    uint32_t ro_compat;
+    uint32_t desc_size;
+    uint32_t first_meta_bg;
+    uint32_t reserved_gdt_blocks;
+
+    Ext4Inode* inodes;       // In-use inodes, sorted by number
+    size_t inode_count;
+    size_t inode_capacity;
+
+    ImageRun* runs;          // Content of every inode, appended in scan order
+    size_t run_count;
+    size_t run_capacity;
+    size_t run_floor;        // First run of the inode being mapped; no merging below it
+    long long remaining;     // Bytes of the inode still to map
+} Ext4Volume;
+
+typedef struct {
+    uint32_t ino;
+    int directory;
+    int deleted;
+    size_t name;             // Offset into the directory's name arena
+} Ext4Child;
+
+static uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t le32(const unsigned char* p) { return (uint32_t)le16(p) | (uint32_t)le16(p + 2) << 16; }
+
+// Append up to the inode's remaining bytes, merging with the previous run
+static int run_add(Ext4Volume* volume, long long offset, long long length) {
+    if (length > volume->remaining) length = volume->remaining;
+    if (length <= 0) return 0;
+    volume->remaining -= length;
+
+    if (volume->run_count > volume->run_floor) {
+        ImageRun* last = &volume->runs[volume->run_count - 1];
+        if ((offset == IMAGE_RUN_SPARSE && last->offset == IMAGE_RUN_SPARSE) ||
+            (offset != IMAGE_RUN_SPARSE && last->offset != IMAGE_RUN_SPARSE && last->offset + last->length == offset)) {
+            last->length += length;
+            return 0;
+        }
+    }
+    if (volume->run_count == volume->run_capacity) {
+        size_t capacity = volume->run_capacity ? volume->run_capacity * 2 : 4096;
+        ImageRun* runs = realloc(volume->runs, capacity * sizeof(ImageRun));
+        if (!runs) return -1;
+        volume->runs = runs;
+        volume->run_capacity = capacity;
+    }
+    volume->runs[volume->run_count].offset = offset;
+    volume->runs[volume->run_count].length = length;
+    volume->run_count++;
+    return 0;
+}
+
+// A data block, or a hole when the pointer falls outside the volume
+static int block_run(Ext4Volume* volume, unsigned long long block, long long blocks) {
+    if (block == 0 || block >= volume->blocks_count || (unsigned long long)blocks > volume->blocks_count - block) {
+        return run_add(volume, IMAGE_RUN_SPARSE, blocks * volume->block_size);
+    }
+    return run_add(volume, volume->offset + (long long)block * volume->block_size, blocks * volume->block_size);
+}
+
+static int read_block(Ext4Volume* volume, unsigned long long block, unsigned char* buffer) {
+    if (block == 0 || block >= volume->blocks_count) return -1;
+    long long offset = volume->offset + (long long)block * volume->block_size;
+    return image_read(volume->image, offset, buffer, (size_t)volume->block_size) == (long)volume->block_size ? 0 : -1;
+}
+
+// Walk an extent tree node in logical order. Holes and unwritten extents
+// read as zeros.
+static int map_extents(Ext4Volume* volume, const unsigned char* node, size_t node_size,
+                       int level, unsigned long long* next_block) {
+    if (le16(node) != EXT4_EXTENT_MAGIC || level > EXT4_MAX_TREE) return 0;
+    int entries = le16(node + 2);
+    int depth = le16(node + 6);
+    if ((size_t)entries > (node_size - 12) / 12) entries = (int)((node_size - 12) / 12);
+
+    for (int i = 0; i < entries && volume->remaining > 0; i++) {
+        const unsigned char* entry = node + 12 + i * 12;
+        uint32_t logical = le32(entry);
+        if (depth > 0) {
+            unsigned long long child = le32(entry + 4) | (unsigned long long)le16(entry + 8) << 32;
+            unsigned char* buffer = malloc((size_t)volume->block_size);
+            if (!buffer) return -1;
+            int status = 0;
+            if (read_block(volume, child, buffer) == 0) {
+                status = map_extents(volume, buffer, (size_t)volume->block_size, level + 1, next_block);
+            }
+            free(buffer);
+            if (status != 0) return -1;
+            continue;
+        }
+
+        long long length = le16(entry + 4);
+        int unwritten = length > 32768;
+        if (unwritten) length -= 32768;
+        unsigned long long start = le32(entry + 8) | (unsigned long long)le16(entry + 6) << 32;
+        if (logical < *next_block) continue; // Overlapping extent in a damaged tree
+        if (logical > *next_block &&
+            run_add(volume, IMAGE_RUN_SPARSE, (long long)(logical - *next_block) * volume->block_size) != 0) return -1;
+        if (unwritten ? run_add(volume, IMAGE_RUN_SPARSE, length * volume->block_size) != 0
+                      : block_run(volume, start, length) != 0) return -1;
+        *next_block = logical + (unsigned long long)length;
+    }
+    return 0;
+}
+
+// ext2/3 block map: level 0 is a data block, higher levels hold pointers
+static int map_indirect(Ext4Volume* volume, uint32_t block, int level) {
+    long long per_block = volume->block_size / 4;
+    long long span = 1;
+    for (int i = 0; i < level; i++) span *= per_block;
+    if (block == 0 || level == 0) return block_run(volume, block, span);
+
+    unsigned char* buffer = malloc((size_t)volume->block_size);
+    if (!buffer) return -1;
+    int status = 0;
+    if (read_block(volume, block, buffer) != 0) {
+        status = run_add(volume, IMAGE_RUN_SPARSE, span * volume->block_size);
+    } else {
+        for (long long i = 0; i < per_block && volume->remaining > 0 && status == 0; i++) {
+            status = map_indirect(volume, le32(buffer + i * 4), level - 1);
+        }
+    }
+    free(buffer);
+    return status;
+}
+
+static time_t inode_time(const unsigned char* inode, int seconds, int extra, uint32_t extra_size) {
+    long long value = (int32_t)le32(inode + seconds);
+    // The low bits of the extra field extend the epoch past 2038
+    if (extra && (uint32_t)(extra + 4 - 128) <= extra_size) value += (long long)(le32(inode + extra) & 3) << 32;
+    return (time_t)value;
+}
+
+static int map_inode(Ext4Volume* volume, Ext4Inode* entry, const unsigned char* raw, long long raw_offset) {
+    uint32_t type = entry->mode & MODE_TYPE;
+    if (type != MODE_REGULAR && type != MODE_DIRECTORY && type != MODE_SYMLINK) return 0;
+
+    uint32_t flags = le32(raw + 0x20);
+    const unsigned char* block_map = raw + 0x28;
+    volume->run_floor = volume->run_count;
+    volume->remaining = entry->size;
+    int status = 0;
+
+    if ((flags & INODE_INLINE_DATA_FL) || (type == MODE_SYMLINK && entry->size < 60 && le32(raw + 0x1C) == 0)) {
+        // Content lives inside the inode itself; inline directories start
+        // with the parent's inode number
+        long long skip = type == MODE_DIRECTORY && (flags & INODE_INLINE_DATA_FL) ? 4 : 0;
+        if (type == MODE_DIRECTORY) volume->remaining = 60 - skip;
+        status = run_add(volume, raw_offset + 0x28 + skip, 60 - skip);
+    } else if (flags & INODE_EXTENTS_FL) {
+        unsigned long long next_block = 0;
+        status = map_extents(volume, block_map, 60, 0, &next_block);
+    } else {
+        for (int i = 0; i < 12 && volume->remaining > 0 && status == 0; i++) status = map_indirect(volume, le32(block_map + i * 4), 0);
+        for (int level = 1; level <= 3 && volume->remaining > 0 && status == 0; level++) {
+            status = map_indirect(volume, le32(block_map + (11 + level) * 4), level);
+        }
+    }
+    // Trailing hole past the last mapped block
+    if (status == 0 && volume->remaining > 0) status = run_add(volume, IMAGE_RUN_SPARSE, volume->remaining);
+
+    entry->run_first = (uint32_t)volume->run_floor;
+    entry->run_count = (uint32_t)(volume->run_count - volume->run_floor);
+    return status;
+}
+
+static int add_inode(Ext4Volume* volume, uint32_t ino, const unsigned char* raw, long long raw_offset) {
+    uint16_t mode = le16(raw);
+    if (mode == 0) return 0;
+
+    if (volume->inode_count == volume->inode_capacity) {
+        size_t capacity = volume->inode_capacity ? volume->inode_capacity * 2 : 4096;
+        Ext4Inode* inodes = realloc(volume->inodes, capacity * sizeof(Ext4Inode));
+        if (!inodes) return -1;
+        volume->inodes = inodes;
+        volume->inode_capacity = capacity;
+    }
+    Ext4Inode* entry = &volume->inodes[volume->inode_count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->ino = ino;
+    entry->mode = mode;
+    entry->size = (long long)((unsigned long long)le32(raw + 0x04) | (unsigned long long)le32(raw + 0x6C) << 32);
+    if (entry->size < 0) entry->size = 0;
+    if (le16(raw + 0x1A) > 0) entry->flags |= INODE_LIVE;
+    if (le32(raw + 0x20) & INODE_INDEX_FL) entry->flags |= INODE_INDEXED;
+
+    uint32_t extra = volume->inode_size > 128 ? le16(raw + 0x80) : 0;
+    entry->modified = inode_time(raw, 0x10, 0x88, extra);
+    entry->accessed = inode_time(raw, 0x08, 0x8C, extra);
+    entry->changed = inode_time(raw, 0x0C, 0x84, extra);
+    // Birth time is an ext4 addition; older inodes only have change time
+    entry->created = extra >= 0x14 ? inode_time(raw, 0x90, 0x94, extra) : entry->changed;
+    return map_inode(volume, entry, raw, raw_offset);
+}
+
+static int has_super(const Ext4Volume* volume, uint32_t group) {
+    if (!(volume->ro_compat & RO_COMPAT_SPARSE_SUPER) || group <= 1) return 1;
+    static const uint32_t bases[3] = {3, 5, 7};
+    for (int i = 0; i < 3; i++) {
+        uint32_t power = bases[i];
+        while (power < group) power *= bases[i];
+        if (power == group) return 1;
+    }
+    return 0;
+}
+
+// Block holding the n-th block of group descriptors
+static unsigned long long descriptor_block(const Ext4Volume* volume, uint32_t n) {
+    if (!(volume->incompat & INCOMPAT_META_BG) || n < volume->first_meta_bg) {
+        return volume->first_data_block + 1ULL + n;
+    }
+    // Meta block groups keep their descriptors in their own first group
+    uint32_t group = n * (uint32_t)(volume->block_size / volume->desc_size);
+    return volume->first_data_block + (unsigned long long)group * volume->blocks_per_group + (unsigned)has_super(volume, group);
+}
+
+// Read every group's inode table in batches, prefetching the next group
+static int scan_inodes(Ext4Volume* volume) {
+    uint32_t groups = (uint32_t)((volume->blocks_count - volume->first_data_block + volume->blocks_per_group - 1) /
+                                 volume->blocks_per_group);
+    uint32_t per_block = (uint32_t)(volume->block_size / volume->desc_size);
+    int checksummed = (volume->ro_compat & (RO_COMPAT_GDT_CSUM | RO_COMPAT_METADATA_CSUM)) != 0;
+
+    // Descriptors first: inode table location and how much of it is used
+    unsigned long long* tables = malloc((size_t)groups * sizeof(unsigned long long));
+    uint32_t* used = malloc((size_t)groups * sizeof(uint32_t));
+    unsigned char* buffer = malloc(EXT4_SCAN_BATCH > volume->block_size ? EXT4_SCAN_BATCH : (size_t)volume->block_size);
+    int status = tables && used && buffer ? 0 : -1;
+
+    for (uint32_t g = 0; g < groups && status == 0; g += per_block) {
+        if (read_block(volume, descriptor_block(volume, g / per_block), buffer) != 0) {
+            status = -1;
+            break;
+        }
+        for (uint32_t i = 0; i < per_block && g + i < groups; i++) {
+            const unsigned char* desc = buffer + (size_t)i * volume->desc_size;
+            int wide = volume->desc_size >= 64;
+            tables[g + i] = le32(desc + 0x08) | (wide ? (unsigned long long)le32(desc + 0x28) << 32 : 0);
+            uint32_t unused = le16(desc + 0x1C) | (wide ? (uint32_t)le16(desc + 0x32) << 16 : 0);
+            used[g + i] = volume->inodes_per_group;
+            if (checksummed) {
+                used[g + i] = le16(desc + 0x12) & BG_INODE_UNINIT ? 0
+                            : unused < volume->inodes_per_group ? volume->inodes_per_group - unused : 0;
+            }
+        }
+    }
+
+    for (uint32_t g = 0; g < groups && status == 0; g++) {
+        long long table = volume->offset + (long long)tables[g] * volume->block_size;
+        long long bytes = (long long)used[g] * volume->inode_size;
+        if (g + 1 < groups && used[g + 1]) {
+            image_advise(volume->image, volume->offset + (long long)tables[g + 1] * volume->block_size,
+                         (long long)used[g + 1] * volume->inode_size, IMAGE_ACCESS_WILLNEED);
+        }
+        if (tables[g] == 0 || tables[g] >= volume->blocks_count) continue;
+
+        for (long long done = 0; done < bytes && status == 0;) {
+            long long length = bytes - done < EXT4_SCAN_BATCH ? bytes - done : EXT4_SCAN_BATCH;
+            length -= length % volume->inode_size;
+            if (image_read(volume->image, table + done, buffer, (size_t)length) != (long)length) break;
+            for (long long position = 0; position < length && status == 0; position += volume->inode_size) {
+                uint32_t ino = g * volume->inodes_per_group + (uint32_t)((done + position) / volume->inode_size) + 1;
+                status = add_inode(volume, ino, buffer + position, table + done + position);
+                volume->stats->records++;
+            }
+            done += length;
+        }
+    }
+    free(tables);
+    free(used);
+    free(buffer);
+    return status;
+}
+
+static Ext4Inode* find_inode(Ext4Volume* volume, uint32_t ino) {
+    size_t low = 0;
+    size_t high = volume->inode_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (volume->inodes[middle].ino < ino) low = middle + 1;
+        else high = middle;
+    }
+    return low < volume->inode_count && volume->inodes[low].ino == ino ? &volume->inodes[low] : NULL;
+}
+
+typedef struct {
+    Ext4Child* children;
+    size_t count;
+    size_t capacity;
+    char* names;
+    size_t names_used;
+    size_t names_capacity;
+} ChildList;
+
+static int child_add(ChildList* list, uint32_t ino, int directory, int deleted, const unsigned char* name, int length) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 64;
+        Ext4Child* children = realloc(list->children, capacity * sizeof(Ext4Child));
+        if (!children) return -1;
+        list->children = children;
+        list->capacity = capacity;
+    }
+    if (list->names_used + (size_t)length + 1 > list->names_capacity) {
+        size_t capacity = list->names_capacity ? list->names_capacity * 2 : 4096;
+        while (capacity < list->names_used + (size_t)length + 1) capacity *= 2;
+        char* names = realloc(list->names, capacity);
+        if (!names) return -1;
+        list->names = names;
+        list->names_capacity = capacity;
+    }
+    Ext4Child* child = &list->children[list->count++];
+    child->ino = ino;
+    child->directory = directory;
+    child->deleted = deleted;
+    child->name = list->names_used;
+    memcpy(list->names + list->names_used, name, (size_t)length);
+    list->names[list->names_used + (size_t)length] = '\0';
+    list->names_used += (size_t)length + 1;
+    return 0;
+}
+
+static const char* sort_names; // qsort has no context argument in C99
+
+static int compare_children(const void* a, const void* b) {
+    const Ext4Child* x = a;
+    const Ext4Child* y = b;
+    if (x->directory != y->directory) return y->directory - x->directory;
+    int order = strcasecmp(sort_names + x->name, sort_names + y->name);
+    if (order) return order;
+    return (x->ino > y->ino) - (x->ino < y->ino);
+}
+
+static int is_dot(const unsigned char* name, int length) {
+    return (length == 1 && name[0] == '.') || (length == 2 && name[0] == '.' && name[1] == '.');
+}
+
+// Directory entry file type matching an inode mode
+static int dirent_type(uint16_t mode) {
+    static const unsigned char types[16] = {0, 5, 3, 0, 2, 0, 4, 0, 1, 0, 7, 0, 6};
+    return types[mode >> 12];
+}
+
+// Deleted entries survive in the slack of the record that absorbed them.
+// Only names whose inode is still free and of the recorded type are kept.
+static int recover_slack(Ext4Volume* volume, ChildList* list, const unsigned char* block, long long start, long long end) {
+    for (long long p = start; p + 8 <= end;) {
+        uint32_t ino = le32(block + p);
+        int rec_len = le16(block + p + 4);
+        int name_len = block[p + 6];
+        int valid = ino != 0 && ino <= volume->inodes_count && name_len > 0 && p + 8 + name_len <= end &&
+                    rec_len >= 8 + name_len && (rec_len & 3) == 0 && !is_dot(block + p + 8, name_len);
+        for (int i = 0; valid && i < name_len; i++) {
+            if (block[p + 8 + i] == '/' || block[p + 8 + i] == '\0') valid = 0;
+        }
+        Ext4Inode* inode = valid ? find_inode(volume, ino) : NULL;
+        if (inode && (volume->incompat & INCOMPAT_FILETYPE) && block[p + 7] != dirent_type(inode->mode)) inode = NULL;
+        if (!inode || (inode->flags & INODE_LIVE)) {
+            p += 4;
+            continue;
+        }
+        int directory = (inode->mode & MODE_TYPE) == MODE_DIRECTORY;
+        if (child_add(list, ino, directory, 1, block + p + 8, name_len) != 0) return -1;
+        p += (8 + name_len + 3) & ~3;
+    }
+    return 0;
+}
+
+static int parse_directory(Ext4Volume* volume, Ext4Inode* directory, ChildList* list) {
+    long long size = 0;
+    for (uint32_t i = 0; i < directory->run_count; i++) size += volume->runs[directory->run_first + i].length;
+    if (size <= 0 || size > EXT4_MAX_DIRECTORY) return 0;
+
+    unsigned char* data = malloc((size_t)size);
+    if (!data) return -1;
+    long got = image_read_runs(volume->image, volume->runs + directory->run_first, (int)directory->run_count, 0, data, (size_t)size);
+    int filetype = (volume->incompat & INCOMPAT_FILETYPE) != 0;
+    int indexed = (directory->flags & INODE_INDEXED) != 0;
+    // Inline directories are one short block
+    long long block_size = size < volume->block_size ? size : volume->block_size;
+
+    int status = 0;
+    for (long long base = 0; base + block_size <= got && status == 0; base += block_size) {
+        const unsigned char* block = data + base;
+        for (long long p = 0; p + 8 <= block_size && status == 0;) {
+            uint32_t ino = le32(block + p);
+            int rec_len = le16(block + p + 4);
+            int name_len = filetype ? block[p + 6] : le16(block + p + 6) & 0xFF;
+            if (rec_len < 8 || (rec_len & 3) || p + rec_len > block_size || 8 + name_len > rec_len) break;
+
+            if (ino != 0 && name_len > 0 && !is_dot(block + p + 8, name_len)) {
+                Ext4Inode* inode = find_inode(volume, ino);
+                if (inode) status = child_add(list, ino, (inode->mode & MODE_TYPE) == MODE_DIRECTORY, 0, block + p + 8, name_len);
+            }
+            // Hash tree nodes hide in the slack of the first block and of
+            // empty records spanning a whole block
+            int tree_node = indexed && (base == 0 || (ino == 0 && rec_len == block_size));
+            if (status == 0 && !tree_node) {
+                status = recover_slack(volume, list, block, p + ((8 + name_len + 3) & ~3), p + rec_len);
+            }
+            p += rec_len;
+        }
+    }
+    free(data);
+    return status;
+}
+
+static int add_child(Ext4Volume* volume, Ext4Inode* inode, const char* name, int parent, int deleted) {
+    int directory = (inode->mode & MODE_TYPE) == MODE_DIRECTORY;
+    FileType type = directory ? FILE_TYPE_FOLDER : deleted ? FILE_TYPE_DELETED : sig_type_from_name(name);
+    int index = file_table_add(volume->table, name, parent, type, directory ? 0 : inode->size);
+    if (index < 0) return -1;
+
+    FileRecord* record = file_table_record(volume->table, index);
+    record->created = inode->created;
+    record->modified = inode->modified;
+    record->accessed = inode->accessed;
+    record->changed = inode->changed;
+    if (deleted) {
+        file_table_set_deleted(volume->table, index, 1);
+        volume->stats->deleted++;
+    }
+    if (!directory && inode->run_count &&
+        file_table_set_runs(volume->table, index, volume->runs + inode->run_first, (int)inode->run_count) != 0) return -1;
+    inode->flags |= INODE_REACHED;
+    volume->stats->entries++;
+    return index;
+}
+
+// Append a directory's children in preorder, directories first, then by name
+static int walk_directory(Ext4Volume* volume, Ext4Inode* directory, int parent, int deleted, int depth) {
+    ChildList list;
+    memset(&list, 0, sizeof(list));
+    directory->flags |= INODE_REACHED;
+    int status = parse_directory(volume, directory, &list);
+    if (status == 0 && list.count > 1) {
+        sort_names = list.names;
+        qsort(list.children, list.count, sizeof(Ext4Child), compare_children);
+    }
+
+    for (size_t i = 0; i < list.count && status == 0; i++) {
+        Ext4Child* child = &list.children[i];
+        Ext4Inode* inode = find_inode(volume, child->ino);
+        if (!inode) continue;
+        int walked = (inode->flags & INODE_REACHED) != 0;
+        int gone = deleted || child->deleted;
+        int index = add_child(volume, inode, list.names + child->name, parent, gone);
+        if (index < 0) {
+            status = -1;
+        } else if (child->directory && !walked && depth < EXT4_MAX_DEPTH) {
+            status = walk_directory(volume, inode, index, gone, depth + 1);
+        }
+    }
+    free(list.children);
+    free(list.names);
+    return status;
+}
+
+// Live inodes no directory reaches, such as files unlinked while open
+static int add_orphans(Ext4Volume* volume, int parent) {
+    int folder = -1;
+    for (size_t i = 0; i < volume->inode_count; i++) {
+        Ext4Inode* inode = &volume->inodes[i];
+        uint32_t type = inode->mode & MODE_TYPE;
+        if (inode->ino < volume->first_ino || !(inode->flags & INODE_LIVE) || (inode->flags & INODE_REACHED)) continue;
+        if (type != MODE_REGULAR && type != MODE_DIRECTORY) continue;
+
+        if (folder < 0) {
+            folder = file_table_add(volume->table, "$OrphanFiles", parent, FILE_TYPE_FOLDER, 0);
+            if (folder < 0) return -1;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "inode %u", inode->ino);
+        int index = add_child(volume, inode, name, folder, 0);
+        if (index < 0) return -1;
+        volume->stats->orphans++;
+        if (type == MODE_DIRECTORY && walk_directory(volume, inode, index, 0, 1) != 0) return -1;
+    }
+    return 0;
+}
+
+static int read_superblock(EvidenceImage* image, long long offset, Ext4Volume* volume) {
+    unsigned char sb[1024];
+    if (image_read(image, offset + EXT4_SUPERBLOCK, sb, sizeof(sb)) != (long)sizeof(sb)) return -1;
+    if (le16(sb + 0x38) != EXT4_MAGIC || le32(sb + 0x18) > 6) return -1;
+
+    memset(volume, 0, sizeof(*volume));
+    volume->image = image;
+    volume->offset = offset;
+    volume->block_size = 1024LL << le32(sb + 0x18);
+    volume->inodes_count = le32(sb + 0x00);
+    volume->first_data_block = le32(sb + 0x14);
+    volume->blocks_per_group = le32(sb + 0x20);
+    volume->inodes_per_group = le32(sb + 0x28);
+    volume->incompat = le32(sb + 0x60);
+    volume->ro_compat = le32(sb + 0x64);
+    volume->blocks_count = le32(sb + 0x04) |
+                           (volume->incompat & INCOMPAT_64BIT ? (unsigned long long)le32(sb + 0x150) << 32 : 0);
+    // Revision 0 file systems have fixed inode geometry
+    int dynamic = le32(sb + 0x4C) >= 1;
+    volume->inode_size = dynamic ? le16(sb + 0x58) : 128;
+    volume->first_ino = dynamic ? le32(sb + 0x54) : 11;
+    volume->desc_size = volume->incompat & INCOMPAT_64BIT ? le16(sb + 0xFE) : 32;
+    volume->first_meta_bg = le32(sb + 0x104);
+    volume->reserved_gdt_blocks = le16(sb + 0xCE);
+
+    if (volume->blocks_per_group == 0 || volume->inodes_per_group == 0 || volume->blocks_count <= volume->first_data_block) return -1;
+    if (volume->inode_size < 128 || volume->inode_size > volume->block_size || (volume->inode_size & (volume->inode_size - 1))) return -1;
+    if (volume->desc_size < 32 || volume->desc_size > volume->block_size || (volume->desc_size & (volume->desc_size - 1))) return -1;
+    return 0;
+}
+
+static int ext4_probe(EvidenceImage* image, long long offset) {
+    Ext4Volume volume;
+    return read_superblock(image, offset, &volume) == 0;
+}
+
+static int ext4_load(EvidenceImage* image, const char* path, long long offset,
+                     FileTable* table, int parent, int threads, VolumeStats* stats) {
+    (void)path; (void)threads; // The scan is bound by sequential reads
+    memset(stats, 0, sizeof(*stats));
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    Ext4Volume volume;
+    if (read_superblock(image, offset, &volume) != 0) return -1;
+    volume.table = table;
+    volume.stats = stats;
+
+    int status = scan_inodes(&volume);
+    Ext4Inode* root = status == 0 ? find_inode(&volume, EXT4_ROOT_INODE) : NULL;
+    if (!root || (root->mode & MODE_TYPE) != MODE_DIRECTORY) status = -1;
+    if (status == 0) status = walk_directory(&volume, root, parent, 0, 0);
+    if (status == 0) status = add_orphans(&volume, parent);
+
+    free(volume.inodes);
+    free(volume.runs);
+    stats->threads = 1;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    stats->seconds = (double)(finished.tv_sec - started.tv_sec) +
+                     (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+    return status;
+}
+
+// Blocks at the start of a group taken by its superblock and descriptor
+// copies, which an uninitialised block bitmap leaves implicit
+static unsigned long long group_overhead(const Ext4Volume* volume, uint32_t group, uint32_t groups) {
+    uint32_t per_block = (uint32_t)(volume->block_size / volume->desc_size);
+    if (!(volume->incompat & INCOMPAT_META_BG)) {
+        if (!has_super(volume, group)) return 0;
+        return 1ULL + (groups + per_block - 1) / per_block + volume->reserved_gdt_blocks;
+    }
+    // Meta block groups: each keeps its descriptor block in its first,
+    // second and last group
+    uint32_t index = group % per_block;
+    int descriptors = group / per_block >= volume->first_meta_bg &&
+                      (index == 0 || index == 1 || index == per_block - 1);
+    return (unsigned long long)has_super(volume, group) + (unsigned)descriptors;
+}
+
+// Blocks the group bitmaps mark in use, the boot block before the first
+// group, and the implicit metadata of groups whose bitmap is uninitialised
+static int ext4_allocated(EvidenceImage* image, long long offset, VolumeExtents* extents) {
+    Ext4Volume volume;
+    if (read_superblock(image, offset, &volume) != 0) return -1;
+    if (volume.blocks_per_group > volume.block_size * 8) return -1;
+
+    uint32_t groups = (uint32_t)((volume.blocks_count - volume.first_data_block + volume.blocks_per_group - 1) /
+                                 volume.blocks_per_group);
+    uint32_t per_block = (uint32_t)(volume.block_size / volume.desc_size);
+    int checksummed = (volume.ro_compat & (RO_COMPAT_GDT_CSUM | RO_COMPAT_METADATA_CSUM)) != 0;
+    int wide = volume.desc_size >= 64;
+    long long table_blocks = ((long long)volume.inodes_per_group * volume.inode_size + volume.block_size - 1) /
+                             volume.block_size;
+
+    unsigned char* descriptors = malloc((size_t)volume.block_size);
+    unsigned char* bitmap = malloc((size_t)volume.block_size);
+    int status = descriptors && bitmap ? 0 : -1;
+    // Superblock 0 sits in the first 2 KiB, inside block 0 or 1
+    if (status == 0) status = volume_extents_add(extents, offset, (volume.first_data_block + 1LL) * volume.block_size);
+
+    for (uint32_t g = 0; g < groups && status == 0; g++) {
+        if (g % per_block == 0 && read_block(&volume, descriptor_block(&volume, g / per_block), descriptors) != 0) {
+            status = -1;
+            break;
+        }
+        const unsigned char* desc = descriptors + (size_t)(g % per_block) * volume.desc_size;
+        unsigned long long first = volume.first_data_block + (unsigned long long)g * volume.blocks_per_group;
+        unsigned long long blocks = volume.blocks_count - first < volume.blocks_per_group
+                                  ? volume.blocks_count - first : volume.blocks_per_group;
+        unsigned long long block_bitmap = le32(desc + 0x00) | (wide ? (unsigned long long)le32(desc + 0x20) << 32 : 0);
+
+        if (!(checksummed && le16(desc + 0x12) & BG_BLOCK_UNINIT) && read_block(&volume, block_bitmap, bitmap) == 0) {
+            status = volume_extents_add_bits(extents, bitmap, (long long)blocks,
+                                             offset + (long long)first * volume.block_size, volume.block_size);
+            continue;
+        }
+        // Uninitialised or unreadable: the descriptor still says where the
+        // group's own metadata lives
+        unsigned long long overhead = group_overhead(&volume, g, groups);
+        unsigned long long inode_bitmap = le32(desc + 0x04) | (wide ? (unsigned long long)le32(desc + 0x24) << 32 : 0);
+        unsigned long long inode_table = le32(desc + 0x08) | (wide ? (unsigned long long)le32(desc + 0x28) << 32 : 0);
+        status = volume_extents_add(extents, offset + (long long)first * volume.block_size,
+                                    (long long)(overhead < blocks ? overhead : blocks) * volume.block_size);
+        if (status == 0 && block_bitmap && block_bitmap < volume.blocks_count) {
+            status = volume_extents_add(extents, offset + (long long)block_bitmap * volume.block_size, volume.block_size);
+        }
+        if (status == 0 && inode_bitmap && inode_bitmap < volume.blocks_count) {
+            status = volume_extents_add(extents, offset + (long long)inode_bitmap * volume.block_size, volume.block_size);
+        }
+        if (status == 0 && inode_table && inode_table + table_blocks <= volume.blocks_count) {
+            status = volume_extents_add(extents, offset + (long long)inode_table * volume.block_size,
+                                        table_blocks * volume.block_size);
+        }
+    }
+    free(descriptors);
+    free(bitmap);
+    return status;
+}
+
+const FsBackend ext4_backend = {"ext4", ext4_probe, ext4_load, ext4_allocated};
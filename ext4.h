@@ -0,0 +1,18 @@
+#ifndef EXT4_H
+#define EXT4_H
+
+#include "volume.h"
+
+// ext2/3/4 volume parser
+//
+// The inode tables are read group by group in large sequential batches,
+// prefetching the next group while the current one is decoded, and the
+// in-use inodes are kept in a compact array sorted by inode number. File
+// content is mapped from extent trees (or ext2/3 block maps) into image
+// runs; unwritten extents and holes become sparse runs. Directories are
+// then walked from the root inode, recovering deleted entries from the
+// slack of the records that absorbed them.
+
+extern const FsBackend ext4_backend;
+
+#endif
@@ -0,0 +1,642 @@
+#define _GNU_SOURCE
+#include "fat.h"
+#include "sig.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FAT_MAX_DEPTH 128             // Directory nesting followed
+#define FAT_MAX_DIRECTORY (256 << 20) // Largest directory read, exFAT's limit
+
+#define FAT_FREE 0
+#define FAT_END 0xFFFFFFFFu           // Normalised end of chain; bad clusters too
+
+#define ATTR_VOLUME 0x08
+#define ATTR_DIRECTORY 0x10
+#define ATTR_LONG_NAME 0x0F
+
+#define EXFAT_BITMAP 0x81
+#define EXFAT_FILE 0x85
+#define EXFAT_STREAM 0xC0
+#define EXFAT_NAME 0xC1
+#define EXFAT_IN_USE 0x80
+#define EXFAT_NO_FAT_CHAIN 0x02
+
+typedef struct {
+    ImageRun* runs;
+    int count;
+    int capacity;
+} RunArray;
+
+typedef struct {
+    EvidenceImage* image;
+    FileTable* table;
+    VolumeStats* stats;
+    int exfat;
+    long long offset;        // Volume start in the image
+    long long cluster_size;
+    long long heap;          // Image offset of cluster 2
+    uint32_t cluster_count;
+    uint32_t* next;          // Normalised allocation table, indexed by cluster
+    uint32_t root_cluster;   // FAT32 and exFAT
+    long long root_offset;   // FAT12/16 fixed root directory
+    long long root_size;
+    unsigned char* visited;  // Directory clusters already walked
+    RunArray runs;
+} FatVolume;
+
+static uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t le32(const unsigned char* p) { return (uint32_t)le16(p) | (uint32_t)le16(p + 2) << 16; }
+static uint64_t le64(const unsigned char* p) { return (uint64_t)le32(p) | (uint64_t)le32(p + 4) << 32; }
+
+static int run_append(RunArray* array, long long offset, long long length) {
+    if (array->count > 0) {
+        ImageRun* last = &array->runs[array->count - 1];
+        if (last->offset + last->length == offset) {
+            last->length += length;
+            return 0;
+        }
+    }
+    if (array->count == array->capacity) {
+        int capacity = array->capacity ? array->capacity * 2 : 64;
+        ImageRun* runs = realloc(array->runs, (size_t)capacity * sizeof(ImageRun));
+        if (!runs) return -1;
+        array->runs = runs;
+        array->capacity = capacity;
+    }
+    array->runs[array->count].offset = offset;
+    array->runs[array->count].length = length;
+    array->count++;
+    return 0;
+}
+
+// Days since 1970-01-01 of a civil date
+static long long days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - (int)era * 400;
+    int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// DOS date and time fields; FAT stores local time without a zone
+static time_t dos_time(uint16_t date, uint16_t time) {
+    if (date == 0) return 0;
+    int day = date & 31;
+    int month = date >> 5 & 15;
+    if (day == 0 || month == 0 || month > 12) return 0;
+    long long days = days_from_civil(1980 + (date >> 9), month, day);
+    return (time_t)(days * 86400 + (time >> 11) * 3600 + (time >> 5 & 63) * 60 + (time & 31) * 2);
+}
+
+// exFAT timestamp with its UTC offset byte (15-minute steps when valid)
+static time_t exfat_time(uint32_t stamp, unsigned char utc_offset) {
+    time_t value = dos_time((uint16_t)(stamp >> 16), (uint16_t)stamp);
+    if (value && (utc_offset & 0x80)) {
+        int quarters = utc_offset & 0x40 ? (int)(utc_offset & 0x7F) - 128 : utc_offset & 0x7F;
+        value -= (time_t)quarters * 15 * 60;
+    }
+    return value;
+}
+
+// Append UTF-16LE as UTF-8; out holds at least length * 3 + 1 bytes
+static size_t utf16_to_utf8(const uint16_t* units, int length, char* out) {
+    unsigned char* p = (unsigned char*)out;
+    for (int i = 0; i < length; i++) {
+        uint32_t c = units[i];
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < length && units[i + 1] >= 0xDC00 && units[i + 1] < 0xE000) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (units[++i] - 0xDC00u);
+        } else if (c >= 0xD800 && c < 0xE000) {
+            c = 0xFFFD;
+        }
+        if (c < 0x80) {
+            *p++ = (unsigned char)c;
+        } else if (c < 0x800) {
+            *p++ = (unsigned char)(0xC0 | c >> 6);
+            *p++ = (unsigned char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            *p++ = (unsigned char)(0xE0 | c >> 12);
+            *p++ = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+            *p++ = (unsigned char)(0x80 | (c & 0x3F));
+        } else {
+            *p++ = (unsigned char)(0xF0 | c >> 18);
+            *p++ = (unsigned char)(0x80 | (c >> 12 & 0x3F));
+            *p++ = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+            *p++ = (unsigned char)(0x80 | (c & 0x3F));
+        }
+    }
+    *p = '\0';
+    return (size_t)(p - (unsigned char*)out);
+}
+
+static long long cluster_offset(const FatVolume* volume, uint32_t cluster) {
+    return volume->offset + volume->heap + (long long)(cluster - 2) * volume->cluster_size;
+}
+
+static int valid_cluster(const FatVolume* volume, uint32_t cluster) {
+    return cluster >= 2 && cluster - 2 < volume->cluster_count;
+}
+
+// Runs of a cluster chain, trimmed to size; size < 0 follows the whole
+// chain. Contiguous chains (deleted files, exFAT NoFatChain) skip the
+// table. Returns the number of runs in volume->runs.
+static int chain_runs(FatVolume* volume, uint32_t first, long long size, int contiguous) {
+    volume->runs.count = 0;
+    if (!valid_cluster(volume, first) || size == 0) return 0;
+
+    if (contiguous) {
+        long long available = (long long)(volume->cluster_count - (first - 2)) * volume->cluster_size;
+        if (size < 0 || size > available) size = available;
+        return run_append(&volume->runs, cluster_offset(volume, first), size) == 0 ? volume->runs.count : 0;
+    }
+
+    long long remaining = size;
+    uint32_t cluster = first;
+    for (uint32_t steps = 0; valid_cluster(volume, cluster) && steps < volume->cluster_count; steps++) {
+        long long length = volume->cluster_size;
+        if (remaining >= 0 && length > remaining) length = remaining;
+        if (length <= 0 || run_append(&volume->runs, cluster_offset(volume, cluster), length) != 0) break;
+        if (remaining >= 0) remaining -= length;
+        cluster = volume->next[cluster];
+    }
+    return volume->runs.count;
+}
+
+// Read a directory's bytes; the caller frees the buffer
+static unsigned char* read_directory(FatVolume* volume, uint32_t first, long long size, int contiguous,
+                                     long long* length) {
+    *length = 0;
+    long long total = 0;
+    if (first == 0 && !volume->exfat && volume->root_size > 0) {
+        // FAT12/16 root directory sits in its own region
+        volume->runs.count = 0;
+        if (run_append(&volume->runs, volume->offset + volume->root_offset, volume->root_size) != 0) return NULL;
+    } else {
+        if (!valid_cluster(volume, first)) return NULL;
+        if (volume->visited[first >> 3] & (1 << (first & 7))) return NULL; // Loop or cross-link
+        volume->visited[first >> 3] |= (unsigned char)(1 << (first & 7));
+        chain_runs(volume, first, size, contiguous);
+    }
+    for (int i = 0; i < volume->runs.count; i++) total += volume->runs.runs[i].length;
+    if (total == 0 || total > FAT_MAX_DIRECTORY) return NULL;
+
+    unsigned char* buffer = malloc((size_t)total);
+    if (!buffer) return NULL;
+    long got = image_read_runs(volume->image, volume->runs.runs, volume->runs.count, 0, buffer, (size_t)total);
+    if (got <= 0) {
+        free(buffer);
+        return NULL;
+    }
+    *length = got;
+    return buffer;
+}
+
+static int add_file(FatVolume* volume, const char* name, int parent, int directory, int deleted,
+                    long long size, uint32_t first, int contiguous,
+                    time_t created, time_t modified, time_t accessed) {
+    FileType type = directory ? FILE_TYPE_FOLDER : deleted ? FILE_TYPE_DELETED : sig_type_from_name(name);
+    int index = file_table_add(volume->table, name, parent, type, directory ? 0 : size);
+    if (index < 0) return -1;
+
+    FileRecord* record = file_table_record(volume->table, index);
+    record->created = created;
+    record->modified = modified;
+    record->accessed = accessed;
+    if (deleted) {
+        file_table_set_deleted(volume->table, index, 1);
+        volume->stats->deleted++;
+    }
+    // A released chain is gone; deleted content is taken as contiguous
+    if (!directory && size > 0 && chain_runs(volume, first, size, contiguous || deleted) > 0 &&
+        file_table_set_runs(volume->table, index, volume->runs.runs, volume->runs.count) != 0) return -1;
+    volume->stats->entries++;
+    return index;
+}
+
+// Short 8.3 name, lower-cased where the case flags say so
+static void short_name(const unsigned char* entry, int deleted, char* out) {
+    int n = 0;
+    for (int i = 0; i < 8 && entry[i] != ' '; i++) {
+        char c = (char)entry[i];
+        if (i == 0 && deleted) c = '_';
+        else if (i == 0 && entry[0] == 0x05) c = (char)0xE5;
+        if ((entry[12] & 0x08) && c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        out[n++] = c;
+    }
+    if (entry[8] != ' ') {
+        out[n++] = '.';
+        for (int i = 8; i < 11 && entry[i] != ' '; i++) {
+            char c = (char)entry[i];
+            if ((entry[12] & 0x10) && c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+            out[n++] = c;
+        }
+    }
+    out[n] = '\0';
+}
+
+static unsigned char short_checksum(const unsigned char* entry) {
+    unsigned char sum = 0;
+    for (int i = 0; i < 11; i++) sum = (unsigned char)(((sum & 1) << 7) + (sum >> 1) + entry[i]);
+    return sum;
+}
+
+static int walk_fat_directory(FatVolume* volume, uint32_t first, int contiguous, int parent,
+                              int inherited_deletion, int depth);
+
+// Deleted directories keep no chain; their first cluster is trusted only
+// if it still starts with the "." and ".." entries
+static int looks_like_directory(FatVolume* volume, uint32_t cluster) {
+    unsigned char head[64];
+    if (!valid_cluster(volume, cluster) ||
+        image_read(volume->image, cluster_offset(volume, cluster), head, sizeof(head)) != (long)sizeof(head)) return 0;
+    return memcmp(head, ".          ", 11) == 0 && memcmp(head + 32, "..         ", 11) == 0;
+}
+
+static int walk_fat_directory(FatVolume* volume, uint32_t first, int contiguous, int parent,
+                              int inherited_deletion, int depth) {
+    long long length;
+    unsigned char* buffer = read_directory(volume, first, contiguous ? volume->cluster_size : -1, contiguous, &length);
+    if (!buffer) return 0;
+
+    // Long name parts as met, last part first
+    uint16_t parts[20][13];
+    unsigned char part_checksum[20];
+    int part_count = 0;
+    int status = 0;
+
+    for (long long position = 0; position + 32 <= length && status == 0; position += 32) {
+        const unsigned char* entry = buffer + position;
+        if (entry[0] == 0x00) break;
+        volume->stats->records++;
+        int deleted = entry[0] == 0xE5;
+
+        if (entry[11] == ATTR_LONG_NAME) {
+            // A live part with the "last" flag starts a new name
+            if (!deleted && (entry[0] & 0x40)) part_count = 0;
+            if (part_count < 20) {
+                static const int offsets[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+                for (int i = 0; i < 13; i++) parts[part_count][i] = le16(entry + offsets[i]);
+                part_checksum[part_count++] = entry[13];
+            }
+            continue;
+        }
+        if ((entry[11] & ATTR_VOLUME) || entry[0] == '.') {
+            part_count = 0;
+            continue;
+        }
+
+        char name[20 * 13 * 3 + 1];
+        // Deletion overwrites the first byte the checksum covers, so deleted
+        // parts only have to agree with each other
+        int long_name = part_count > 0;
+        unsigned char checksum = deleted && part_count ? part_checksum[0] : short_checksum(entry);
+        for (int i = 0; i < part_count; i++) {
+            if (part_checksum[i] != checksum) long_name = 0;
+        }
+        if (long_name) {
+            uint16_t units[20 * 13];
+            int n = 0;
+            for (int i = part_count - 1; i >= 0; i--) {
+                for (int k = 0; k < 13 && parts[i][k] != 0x0000 && parts[i][k] != 0xFFFF; k++) units[n++] = parts[i][k];
+            }
+            utf16_to_utf8(units, n, name);
+        } else {
+            short_name(entry, deleted, name);
+        }
+        part_count = 0;
+
+        int directory = (entry[11] & ATTR_DIRECTORY) != 0;
+        uint32_t cluster = (uint32_t)le16(entry + 26) | (volume->cluster_count >= 65525 ? (uint32_t)le16(entry + 20) << 16 : 0);
+        int gone = deleted || inherited_deletion;
+        int index = add_file(volume, name, parent, directory, gone, (long long)le32(entry + 28), cluster, 0,
+                             dos_time(le16(entry + 16), le16(entry + 14)),
+                             dos_time(le16(entry + 24), le16(entry + 22)),
+                             dos_time(le16(entry + 18), 0));
+        if (index < 0) {
+            status = -1;
+            break;
+        }
+        if (directory && depth < FAT_MAX_DEPTH && (!deleted || looks_like_directory(volume, cluster))) {
+            status = walk_fat_directory(volume, cluster, deleted, index, gone, depth + 1);
+        }
+    }
+    free(buffer);
+    return status;
+}
+
+static int walk_exfat_directory(FatVolume* volume, uint32_t first, long long size, int contiguous,
+                                int parent, int inherited_deletion, int depth) {
+    long long length;
+    unsigned char* buffer = read_directory(volume, first, size, contiguous, &length);
+    if (!buffer) return 0;
+
+    int status = 0;
+    for (long long position = 0; position + 32 <= length && status == 0;) {
+        const unsigned char* entry = buffer + position;
+        if (entry[0] == 0x00) break;
+        volume->stats->records++;
+        if ((entry[0] & 0x7F) != (EXFAT_FILE & 0x7F)) {
+            position += 32;
+            continue;
+        }
+
+        // File entry, stream extension, then name entries
+        int deleted = !(entry[0] & EXFAT_IN_USE);
+        int secondary = entry[1];
+        if (secondary < 2 || position + (long long)(secondary + 1) * 32 > length ||
+            (buffer[position + 32] & 0x7F) != (EXFAT_STREAM & 0x7F)) {
+            position += 32;
+            continue;
+        }
+        const unsigned char* stream = buffer + position + 32;
+        int name_length = stream[3];
+        uint16_t units[255];
+        int n = 0;
+        for (int s = 2; s <= secondary && n < name_length; s++) {
+            const unsigned char* part = buffer + position + (long long)s * 32;
+            if ((part[0] & 0x7F) != (EXFAT_NAME & 0x7F)) break;
+            for (int k = 0; k < 15 && n < name_length; k++) units[n++] = le16(part + 2 + k * 2);
+        }
+        char name[255 * 3 + 1];
+        utf16_to_utf8(units, n, name);
+
+        int directory = (le16(entry + 4) & ATTR_DIRECTORY) != 0;
+        int no_chain = (stream[1] & EXFAT_NO_FAT_CHAIN) != 0;
+        uint32_t cluster = le32(stream + 20);
+        long long data_length = (long long)le64(stream + 24);
+        int gone = deleted || inherited_deletion;
+        int index = add_file(volume, name, parent, directory, gone, data_length, cluster, no_chain,
+                             exfat_time(le32(entry + 8), entry[22]),
+                             exfat_time(le32(entry + 12), entry[23]),
+                             exfat_time(le32(entry + 16), entry[24]));
+        if (index < 0) {
+            status = -1;
+            break;
+        }
+        if (directory && depth < FAT_MAX_DEPTH) {
+            status = walk_exfat_directory(volume, cluster, data_length, no_chain || deleted, index, gone, depth + 1);
+        }
+        position += (long long)(secondary + 1) * 32;
+    }
+    free(buffer);
+    return status;
+}
+
+// Read the allocation table and normalise it to 32-bit next pointers
+static int load_table(FatVolume* volume, long long table_offset, int bits) {
+    uint32_t entries = volume->cluster_count + 2;
+    long long bytes = bits == 12 ? ((long long)entries * 3 + 1) / 2 : (long long)entries * (bits / 8);
+    unsigned char* raw = malloc((size_t)bytes);
+    volume->next = malloc((size_t)entries * sizeof(uint32_t));
+    if (!raw || !volume->next ||
+        image_read(volume->image, volume->offset + table_offset, raw, (size_t)bytes) != (long)bytes) {
+        free(raw);
+        return -1;
+    }
+
+    for (uint32_t c = 0; c < entries; c++) {
+        uint32_t value;
+        if (bits == 12) {
+            uint16_t pair = le16(raw + c + c / 2);
+            value = c & 1 ? pair >> 4 : pair & 0x0FFF;
+            if (value >= 0xFF7) value = FAT_END;
+        } else if (bits == 16) {
+            value = le16(raw + (size_t)c * 2);
+            if (value >= 0xFFF7) value = FAT_END;
+        } else {
+            value = le32(raw + (size_t)c * 4);
+            if (!volume->exfat) value &= 0x0FFFFFFF;
+            if (value >= (volume->exfat ? 0xFFFFFFF7u : 0x0FFFFFF7u)) value = FAT_END;
+        }
+        volume->next[c] = value;
+    }
+    free(raw);
+    return 0;
+}
+
+typedef struct {
+    unsigned sector;
+    unsigned cluster_sectors;
+    unsigned reserved;
+    unsigned fats;
+    unsigned root_entries;
+    unsigned long long total;
+    unsigned long long table_sectors;
+    unsigned long long data_start;
+    unsigned long long clusters;
+    int bits;
+} FatGeometry;
+
+static int fat_geometry(EvidenceImage* image, long long offset, FatGeometry* g) {
+    unsigned char boot[512];
+    if (image_read(image, offset, boot, sizeof(boot)) != (long)sizeof(boot)) return -1;
+    if (boot[510] != 0x55 || boot[511] != 0xAA || (boot[0] != 0xEB && boot[0] != 0xE9)) return -1;
+
+    g->sector = le16(boot + 0x0B);
+    g->cluster_sectors = boot[0x0D];
+    g->reserved = le16(boot + 0x0E);
+    g->fats = boot[0x10];
+    g->root_entries = le16(boot + 0x11);
+    g->total = le16(boot + 0x13) ? le16(boot + 0x13) : le32(boot + 0x20);
+    g->table_sectors = le16(boot + 0x16) ? le16(boot + 0x16) : le32(boot + 0x24);
+    if (g->sector < 512 || g->sector > 4096 || (g->sector & (g->sector - 1))) return -1;
+    if (g->cluster_sectors == 0 || (g->cluster_sectors & (g->cluster_sectors - 1))) return -1;
+    if (g->reserved == 0 || g->fats == 0 || g->fats > 2 || g->table_sectors == 0) return -1;
+    if (boot[0x15] != 0xF0 && boot[0x15] < 0xF8) return -1; // Media descriptor
+
+    unsigned long long root_sectors = ((unsigned long long)g->root_entries * 32 + g->sector - 1) / g->sector;
+    g->data_start = g->reserved + g->fats * g->table_sectors + root_sectors;
+    if (g->total <= g->data_start) return -1;
+    g->clusters = (g->total - g->data_start) / g->cluster_sectors;
+    g->bits = g->clusters < 4085 ? 12 : g->clusters < 65525 ? 16 : 32;
+    if (g->bits == 32 && (g->root_entries != 0 || le16(boot + 0x16) != 0)) return -1;
+    // The table must cover every cluster
+    if (g->table_sectors * g->sector * 8 / (unsigned)g->bits < g->clusters + 2) return -1;
+    return 0;
+}
+
+static int fat_probe(EvidenceImage* image, long long offset) {
+    FatGeometry geometry;
+    return fat_geometry(image, offset, &geometry) == 0;
+}
+
+static int exfat_probe(EvidenceImage* image, long long offset) {
+    unsigned char boot[512];
+    if (image_read(image, offset, boot, sizeof(boot)) != (long)sizeof(boot)) return 0;
+    return memcmp(boot + 3, "EXFAT   ", 8) == 0 && boot[510] == 0x55 && boot[511] == 0xAA &&
+           boot[0x6C] >= 9 && boot[0x6C] <= 12 && boot[0x6C] + boot[0x6D] <= 25;
+}
+
+static int load_volume(FatVolume* volume, long long table_offset, int bits, VolumeStats* stats, int parent) {
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    int status = -1;
+    volume->visited = calloc(((size_t)volume->cluster_count + 2) / 8 + 1, 1);
+    if (volume->visited && load_table(volume, table_offset, bits) == 0) {
+        if (volume->exfat) {
+            status = walk_exfat_directory(volume, volume->root_cluster, -1, 0, parent, 0, 0);
+        } else {
+            status = walk_fat_directory(volume, volume->root_size ? 0 : volume->root_cluster, 0, parent, 0, 0);
+        }
+    }
+    free(volume->visited);
+    free(volume->next);
+    free(volume->runs.runs);
+
+    stats->threads = 1;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    stats->seconds = (double)(finished.tv_sec - started.tv_sec) +
+                     (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+    return status;
+}
+
+// Volume layout from the boot sector; the table and runs are left to the caller
+static int fat_open(EvidenceImage* image, long long offset, FatVolume* volume,
+                    long long* table_offset, int* bits) {
+    FatGeometry g;
+    if (fat_geometry(image, offset, &g) != 0) return -1;
+
+    unsigned char boot[512];
+    if (image_read(image, offset, boot, sizeof(boot)) != (long)sizeof(boot)) return -1;
+
+    memset(volume, 0, sizeof(*volume));
+    volume->image = image;
+    volume->offset = offset;
+    volume->cluster_size = (long long)g.sector * g.cluster_sectors;
+    volume->heap = (long long)g.data_start * g.sector;
+    volume->cluster_count = (uint32_t)g.clusters;
+    if (g.bits == 32) {
+        volume->root_cluster = le32(boot + 0x2C);
+    } else {
+        volume->root_offset = (long long)(g.reserved + g.fats * g.table_sectors) * g.sector;
+        volume->root_size = (long long)g.root_entries * 32;
+    }
+    *table_offset = (long long)g.reserved * g.sector;
+    *bits = g.bits;
+    return 0;
+}
+
+static int exfat_open(EvidenceImage* image, long long offset, FatVolume* volume,
+                      long long* table_offset, int* bits) {
+    if (!exfat_probe(image, offset)) return -1;
+
+    unsigned char boot[512];
+    if (image_read(image, offset, boot, sizeof(boot)) != (long)sizeof(boot)) return -1;
+
+    memset(volume, 0, sizeof(*volume));
+    volume->image = image;
+    volume->exfat = 1;
+    volume->offset = offset;
+    long long sector = 1LL << boot[0x6C];
+    volume->cluster_size = sector << boot[0x6D];
+    volume->heap = (long long)le32(boot + 0x58) * sector;
+    volume->cluster_count = le32(boot + 0x5C);
+    volume->root_cluster = le32(boot + 0x60);
+    *table_offset = (long long)le32(boot + 0x50) * sector;
+    *bits = 32;
+    return 0;
+}
+
+static int fat_load(EvidenceImage* image, const char* path, long long offset,
+                    FileTable* table, int parent, int threads, VolumeStats* stats) {
+    (void)path; (void)threads; // Directory walking is sequential
+    memset(stats, 0, sizeof(*stats));
+
+    FatVolume volume;
+    long long table_offset;
+    int bits;
+    if (fat_open(image, offset, &volume, &table_offset, &bits) != 0) return -1;
+    volume.table = table;
+    volume.stats = stats;
+    return load_volume(&volume, table_offset, bits, stats, parent);
+}
+
+static int exfat_load(EvidenceImage* image, const char* path, long long offset,
+                      FileTable* table, int parent, int threads, VolumeStats* stats) {
+    (void)path; (void)threads;
+    memset(stats, 0, sizeof(*stats));
+
+    FatVolume volume;
+    long long table_offset;
+    int bits;
+    if (exfat_open(image, offset, &volume, &table_offset, &bits) != 0) return -1;
+    volume.table = table;
+    volume.stats = stats;
+    return load_volume(&volume, table_offset, bits, stats, parent);
+}
+
+// exFAT marks clusters in its allocation bitmap, whose entry is in the
+// root directory; files flagged NoFatChain leave the table empty
+static int exfat_bitmap(FatVolume* volume, VolumeExtents* extents) {
+    long long length;
+    unsigned char* root = read_directory(volume, volume->root_cluster, -1, 0, &length);
+    if (!root) return -1;
+
+    int status = -1;
+    for (long long position = 0; position + 32 <= length && root[position] != 0x00; position += 32) {
+        const unsigned char* entry = root + position;
+        if (entry[0] != EXFAT_BITMAP) continue;
+        uint32_t first = le32(entry + 20);
+        long long size = (long long)le64(entry + 24);
+        long long bits = volume->cluster_count;
+        if (size < (bits + 7) / 8 || chain_runs(volume, first, (bits + 7) / 8, 0) == 0) break;
+
+        unsigned char* bitmap = malloc((size_t)(bits + 7) / 8);
+        if (bitmap && image_read_runs(volume->image, volume->runs.runs, volume->runs.count, 0, bitmap,
+                                      (size_t)(bits + 7) / 8) == (long)((bits + 7) / 8)) {
+            status = volume_extents_add_bits(extents, bitmap, bits, volume->offset + volume->heap,
+                                             volume->cluster_size);
+        }
+        free(bitmap);
+        break;
+    }
+    free(root);
+    return status;
+}
+
+// Everything before the cluster heap (boot sectors, tables, the FAT12/16
+// root directory) and every cluster the table or bitmap marks in use
+static int allocated_clusters(FatVolume* volume, long long table_offset, int bits, VolumeExtents* extents) {
+    int status = -1;
+    volume->visited = calloc(((size_t)volume->cluster_count + 2) / 8 + 1, 1);
+    if (volume->visited && load_table(volume, table_offset, bits) == 0 &&
+        volume_extents_add(extents, volume->offset, volume->heap) == 0) {
+        if (volume->exfat) {
+            status = exfat_bitmap(volume, extents);
+        } else {
+            status = 0;
+            for (uint32_t c = 2; c - 2 < volume->cluster_count && status == 0; c++) {
+                if (volume->next[c] != FAT_FREE) {
+                    status = volume_extents_add(extents, cluster_offset(volume, c), volume->cluster_size);
+                }
+            }
+        }
+    }
+    free(volume->visited);
+    free(volume->next);
+    free(volume->runs.runs);
+    return status;
+}
+
+static int fat_allocated(EvidenceImage* image, long long offset, VolumeExtents* extents) {
+    FatVolume volume;
+    long long table_offset;
+    int bits;
+    if (fat_open(image, offset, &volume, &table_offset, &bits) != 0) return -1;
+    return allocated_clusters(&volume, table_offset, bits, extents);
+}
+
+static int exfat_allocated(EvidenceImage* image, long long offset, VolumeExtents* extents) {
+    FatVolume volume;
+    long long table_offset;
+    int bits;
+    if (exfat_open(image, offset, &volume, &table_offset, &bits) != 0) return -1;
+    return allocated_clusters(&volume, table_offset, bits, extents);
+}
+
+const FsBackend fat_backend = {"FAT", fat_probe, fat_load, fat_allocated};
+const FsBackend exfat_backend = {"exFAT", exfat_probe, exfat_load, exfat_allocated};
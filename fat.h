@@ -0,0 +1,18 @@
+#ifndef FAT_H
+#define FAT_H
+
+#include "volume.h"
+
+// FAT12/16/32 and exFAT volume parsers
+//
+// The allocation table is read into memory once and cluster chains are
+// coalesced into image runs. Directories are walked depth first from the
+// root, so entries reach the file table in preorder as they are found.
+// Deleted entries keep their names (FAT loses the first character) and
+// their content is recovered assuming contiguous clusters, since the
+// chain is released on deletion.
+
+extern const FsBackend fat_backend;
+extern const FsBackend exfat_backend;
+
+#endif
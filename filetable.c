@@ -0,0 +1,404 @@
+#include "filetable.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FILE_TABLE_PAGE_SIZE (1 << FILE_TABLE_PAGE_SHIFT)
+#define FILE_TABLE_PAGE_MASK (FILE_TABLE_PAGE_SIZE - 1)
+#define ARENA_BLOCK_SIZE (4u << 20)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    unsigned char data[];
+} ArenaBlock;
+
+struct FileTable {
+    // Hot columns
+    FileColumns columns;
+    int count;
+    int capacity;
+
+    // Cold record pages, allocated from the arena
+    ArenaBlock* arena;
+    FileRecord** pages;
+    int page_count;
+    int page_capacity;
+
+    // Out-of-line digests (slot 0 unused) and data runs
+    HashDigests* digests;
+    unsigned int digest_count;
+    unsigned int digest_capacity;
+    ImageRun* runs;
+    unsigned int run_count;
+    unsigned int run_capacity;
+
+    // String pool: NUL-terminated strings addressed by byte offset
+    char* pool;
+    size_t pool_used;
+    size_t pool_capacity;
+
+    // Open-addressed intern index of pool offsets (0 = empty slot)
+    unsigned int* intern;
+    size_t intern_capacity;
+    size_t intern_count;
+};
+
+static void* arena_alloc(FileTable* table, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    ArenaBlock* block = table->arena;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) return NULL;
+        block->next = table->arena;
+        block->used = 0;
+        block->size = block_size;
+        table->arena = block;
+    }
+
+    void* p = block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+static void arena_free(FileTable* table) {
+    ArenaBlock* block = table->arena;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    table->arena = NULL;
+}
+
+FileTable* file_table_create(void) {
+    FileTable* table = calloc(1, sizeof(FileTable));
+    if (!table) return NULL;
+
+    table->pool_capacity = 64 * 1024;
+    table->pool = malloc(table->pool_capacity);
+    table->intern_capacity = 4096;
+    table->intern = calloc(table->intern_capacity, sizeof(unsigned int));
+    if (!table->pool || !table->intern) {
+        file_table_destroy(table);
+        return NULL;
+    }
+
+    table->pool[0] = '\0';
+    table->pool_used = 1;
+    return table;
+}
+
+void file_table_destroy(FileTable* table) {
+    if (!table) return;
+    arena_free(table);
+    free(table->columns.type);
+    free(table->columns.deleted);
+    free(table->columns.depth);
+    free(table->columns.size);
+    free(table->columns.name);
+    free(table->columns.last);
+    free(table->pages);
+    free(table->digests);
+    free(table->runs);
+    free(table->pool);
+    free(table->intern);
+    free(table);
+}
+
+void file_table_clear(FileTable* table) {
+    arena_free(table);
+    table->page_count = 0;
+    table->count = 0;
+    table->digest_count = 0;
+    table->run_count = 0;
+    table->pool_used = 1;
+    table->intern_count = 0;
+    memset(table->intern, 0, table->intern_capacity * sizeof(unsigned int));
+}
+
+static unsigned int hash_string(const char* text, size_t length) {
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int grow_intern(FileTable* table) {
+    size_t capacity = table->intern_capacity * 2;
+    unsigned int* intern = calloc(capacity, sizeof(unsigned int));
+    if (!intern) return -1;
+
+    for (size_t i = 0; i < table->intern_capacity; i++) {
+        unsigned int id = table->intern[i];
+        if (!id) continue;
+        const char* text = table->pool + id;
+        size_t slot = hash_string(text, strlen(text)) & (capacity - 1);
+        while (intern[slot]) slot = (slot + 1) & (capacity - 1);
+        intern[slot] = id;
+    }
+
+    free(table->intern);
+    table->intern = intern;
+    table->intern_capacity = capacity;
+    return 0;
+}
+
+unsigned int file_table_intern(FileTable* table, const char* text) {
+    if (!text || !text[0]) return 0;
+
+    size_t length = strlen(text);
+    size_t mask = table->intern_capacity - 1;
+    size_t slot = hash_string(text, length) & mask;
+    while (table->intern[slot]) {
+        unsigned int id = table->intern[slot];
+        if (memcmp(table->pool + id, text, length + 1) == 0) return id;
+        slot = (slot + 1) & mask;
+    }
+
+    // Keep the table at most half full; a new string is refused rather
+    // than inserted past that when the table cannot grow
+    if ((table->intern_count + 1) * 2 > table->intern_capacity) {
+        if (grow_intern(table) != 0) return 0;
+        mask = table->intern_capacity - 1;
+        slot = hash_string(text, length) & mask;
+        while (table->intern[slot]) slot = (slot + 1) & mask;
+    }
+
+    if (table->pool_used + length + 1 > table->pool_capacity) {
+        size_t capacity = table->pool_capacity;
+        while (table->pool_used + length + 1 > capacity) capacity *= 2;
+        if (capacity > 0xFFFFFFFFu) return 0;
+        char* pool = realloc(table->pool, capacity);
+        if (!pool) return 0;
+        table->pool = pool;
+        table->pool_capacity = capacity;
+    }
+
+    unsigned int id = (unsigned int)table->pool_used;
+    memcpy(table->pool + id, text, length + 1);
+    table->pool_used += length + 1;
+
+    table->intern[slot] = id;
+    table->intern_count++;
+    return id;
+}
+
+const char* file_table_string(const FileTable* table, unsigned int id) {
+    return id < table->pool_used ? table->pool + id : "";
+}
+
+static int grow_columns(FileTable* table) {
+    int capacity = table->capacity ? table->capacity * 2 : 4096;
+    FileColumns* c = &table->columns;
+
+    // Each column is reassigned as soon as it moves so a failure leaks nothing
+    void* p;
+    if (!(p = realloc(c->type, (size_t)capacity))) return -1;
+    c->type = p;
+    if (!(p = realloc(c->deleted, (size_t)capacity))) return -1;
+    c->deleted = p;
+    if (!(p = realloc(c->depth, (size_t)capacity * sizeof(unsigned short)))) return -1;
+    c->depth = p;
+    if (!(p = realloc(c->size, (size_t)capacity * sizeof(long long)))) return -1;
+    c->size = p;
+    if (!(p = realloc(c->name, (size_t)capacity * sizeof(unsigned int)))) return -1;
+    c->name = p;
+    if (!(p = realloc(c->last, (size_t)capacity * sizeof(int)))) return -1;
+    c->last = p;
+
+    table->capacity = capacity;
+    return 0;
+}
+
+static int grow_records(FileTable* table) {
+    if (table->page_count == table->page_capacity) {
+        int capacity = table->page_capacity ? table->page_capacity * 2 : 16;
+        FileRecord** pages = realloc(table->pages, (size_t)capacity * sizeof(FileRecord*));
+        if (!pages) return -1;
+        table->pages = pages;
+        table->page_capacity = capacity;
+    }
+
+    FileRecord* page = arena_alloc(table, FILE_TABLE_PAGE_SIZE * sizeof(FileRecord));
+    if (!page) return -1;
+    table->pages[table->page_count++] = page;
+    return 0;
+}
+
+int file_table_add(FileTable* table, const char* name, int parent, FileType type, long long size) {
+    if (table->count == table->capacity && grow_columns(table) != 0) return -1;
+    if (table->count == table->page_count * FILE_TABLE_PAGE_SIZE && grow_records(table) != 0) return -1;
+
+    int index = table->count;
+    FileColumns* c = &table->columns;
+    c->type[index] = (unsigned char)type;
+    c->deleted[index] = 0;
+    c->size[index] = size;
+    c->name[index] = file_table_intern(table, name);
+    c->depth[index] = (parent >= 0 && parent < index) ? (unsigned short)(c->depth[parent] + 1) : 0;
+    c->last[index] = index;
+
+    FileRecord* record = file_table_record(table, index);
+    memset(record, 0, sizeof(FileRecord));
+    record->parent = parent;
+    record->entropy = -1.0f;
+
+    // Every ancestor's subtree now ends here
+    for (int child = index, p = parent; p >= 0 && p < child; child = p, p = file_table_parent(table, p)) {
+        c->last[p] = index;
+    }
+
+    table->count++;
+    return index;
+}
+
+int file_table_count(const FileTable* table) {
+    return table->count;
+}
+
+const FileColumns* file_table_columns(const FileTable* table) {
+    return &table->columns;
+}
+
+FileRecord* file_table_record(FileTable* table, int index) {
+    return &table->pages[index >> FILE_TABLE_PAGE_SHIFT][index & FILE_TABLE_PAGE_MASK];
+}
+
+FileType file_table_type(const FileTable* table, int index) {
+    return (FileType)table->columns.type[index];
+}
+
+long long file_table_size(const FileTable* table, int index) {
+    return table->columns.size[index];
+}
+
+int file_table_depth(const FileTable* table, int index) {
+    return table->columns.depth[index];
+}
+
+int file_table_is_deleted(const FileTable* table, int index) {
+    return table->columns.deleted[index];
+}
+
+int file_table_parent(const FileTable* table, int index) {
+    return table->pages[index >> FILE_TABLE_PAGE_SHIFT][index & FILE_TABLE_PAGE_MASK].parent;
+}
+
+int file_table_last_descendant(const FileTable* table, int index) {
+    return table->columns.last[index];
+}
+
+void file_table_set_type(FileTable* table, int index, FileType type) {
+    table->columns.type[index] = (unsigned char)type;
+}
+
+void file_table_set_size(FileTable* table, int index, long long size) {
+    table->columns.size[index] = size;
+}
+
+void file_table_set_deleted(FileTable* table, int index, int deleted) {
+    table->columns.deleted[index] = (unsigned char)(deleted != 0);
+}
+
+int file_table_set_digests(FileTable* table, int index, const HashDigests* digests) {
+    FileRecord* record = file_table_record(table, index);
+    if (record->digests) {
+        table->digests[record->digests] = *digests;
+        return 0;
+    }
+
+    if (table->digest_count == 0) table->digest_count = 1;
+    if (table->digest_count >= table->digest_capacity) {
+        unsigned int capacity = table->digest_capacity ? table->digest_capacity * 2 : 1024;
+        HashDigests* store = realloc(table->digests, capacity * sizeof(HashDigests));
+        if (!store) return -1;
+        table->digests = store;
+        table->digest_capacity = capacity;
+    }
+
+    table->digests[table->digest_count] = *digests;
+    record->digests = table->digest_count++;
+    return 0;
+}
+
+const HashDigests* file_table_digests(const FileTable* table, int index) {
+    unsigned int id = table->pages[index >> FILE_TABLE_PAGE_SHIFT][index & FILE_TABLE_PAGE_MASK].digests;
+    return id ? &table->digests[id] : NULL;
+}
+
+int file_table_set_runs(FileTable* table, int index, const ImageRun* runs, int count) {
+    if (count < 0) return -1;
+    if (table->run_count + (unsigned int)count > table->run_capacity) {
+        unsigned int capacity = table->run_capacity ? table->run_capacity : 4096;
+        while (table->run_count + (unsigned int)count > capacity) capacity *= 2;
+        ImageRun* store = realloc(table->runs, capacity * sizeof(ImageRun));
+        if (!store) return -1;
+        table->runs = store;
+        table->run_capacity = capacity;
+    }
+
+    // Runs are append-only; replacing an entry's runs abandons the old ones
+    FileRecord* record = file_table_record(table, index);
+    memcpy(table->runs + table->run_count, runs, (size_t)count * sizeof(ImageRun));
+    record->runs = table->run_count;
+    record->run_count = (unsigned int)count;
+    table->run_count += (unsigned int)count;
+    return 0;
+}
+
+const ImageRun* file_table_runs(const FileTable* table, int index, int* count) {
+    const FileRecord* record = &table->pages[index >> FILE_TABLE_PAGE_SHIFT][index & FILE_TABLE_PAGE_MASK];
+    *count = (int)record->run_count;
+    return record->run_count ? table->runs + record->runs : NULL;
+}
+
+const char* file_table_name(const FileTable* table, int index) {
+    return file_table_string(table, table->columns.name[index]);
+}
+
+size_t file_table_path(const FileTable* table, int index, char* buffer, size_t size) {
+    if (size == 0) return 0;
+
+    // Collect the chain up to (but excluding) the root, then emit it forwards
+    int chain[256];
+    int depth = 0;
+    for (int i = index; i >= 0 && file_table_parent(table, i) >= 0 && depth < 256;
+         i = file_table_parent(table, i)) {
+        chain[depth++] = i;
+    }
+
+    size_t length = 0;
+    if (depth == 0) {
+        buffer[length++] = '/';
+    }
+    while (depth > 0) {
+        const char* name = file_table_name(table, chain[--depth]);
+        size_t name_length = strlen(name);
+        if (length + 1 + name_length >= size) break;
+        buffer[length++] = '/';
+        memcpy(buffer + length, name, name_length);
+        length += name_length;
+    }
+
+    if (length >= size) length = size - 1;
+    buffer[length] = '\0';
+    return length;
+}
+
+size_t file_table_memory(const FileTable* table) {
+    size_t column_bytes = 2 + sizeof(unsigned short) + sizeof(long long) + sizeof(unsigned int) + sizeof(int);
+    size_t total = (size_t)table->capacity * column_bytes +
+                   table->digest_capacity * sizeof(HashDigests) +
+                   table->run_capacity * sizeof(ImageRun) +
+                   table->pool_capacity + table->intern_capacity * sizeof(unsigned int) +
+                   (size_t)table->page_capacity * sizeof(FileRecord*);
+    for (const ArenaBlock* block = table->arena; block; block = block->next) {
+        total += sizeof(ArenaBlock) + block->size;
+    }
+    return total;
+}
@@ -0,0 +1,111 @@
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "hash.h"
+#include "image.h"
+
+// Growable file table
+//
+// Fields that tree rendering, sorting and filtering scan (type, size,
+// depth, deletion flag, name, subtree extent) are kept as contiguous hot
+// columns. Entries are appended in preorder, so every subtree is the
+// contiguous index range from its root to its last descendant. The
+// rest of each entry is a cold FileRecord living in fixed-size pages
+// carved from an arena, so the record store grows without moving
+// existing records. Names, formats and metadata are interned in a string
+// pool and referenced by 32-bit ids; full paths are not stored but
+// rebuilt from the parent chain on demand.
+
+#define FILE_TABLE_PAGE_SHIFT 12 // 4096 entries per page
+#define FILE_TABLE_NO_PARENT (-1)
+
+typedef enum {
+    FILE_TYPE_FOLDER,
+    FILE_TYPE_EXECUTABLE,
+    FILE_TYPE_IMAGE,
+    FILE_TYPE_DOCUMENT,
+    FILE_TYPE_TEXT,
+    FILE_TYPE_DELETED,
+    FILE_TYPE_UNKNOWN
+} FileType;
+
+// Hot columns, indexed by entry. Pointers are invalidated by file_table_add.
+typedef struct {
+    unsigned char* type;      // FileType
+    unsigned char* deleted;
+    unsigned short* depth;
+    long long* size;
+    unsigned int* name;       // String pool id
+    int* last;                // Last descendant, the entry itself for a leaf
+} FileColumns;
+
+#define FILE_FLAG_EXTENSION_MISMATCH 0x0001 // Content does not fit the name's extension
+#define FILE_FLAG_CLASSIFIED 0x0002          // Signature detection has run
+#define FILE_FLAG_TIMESTAMP_ANOMALY 0x0004   // Creation time predates the file system's own record of it
+
+// Cold per-entry record
+typedef struct {
+    unsigned int format;    // String pool id, 0 when unknown
+    unsigned short signature; // Signature format id, 0 when unknown
+    unsigned short flags;   // FILE_FLAG_*
+    unsigned int metadata;  // String pool id, 0 when none
+    int parent;             // Entry index, FILE_TABLE_NO_PARENT for the root
+    unsigned int digests;   // Digest store id, 0 until hashed
+    unsigned int runs;      // First data run in the run store
+    unsigned int run_count;
+    time_t created;
+    time_t modified;
+    time_t accessed;
+    time_t changed;         // Metadata change; 0 where the file system keeps none
+    float entropy;          // Shannon bits per byte, negative until analysed
+} FileRecord;
+
+typedef struct FileTable FileTable;
+
+FileTable* file_table_create(void);
+void file_table_destroy(FileTable* table);
+void file_table_clear(FileTable* table);
+
+// Append an entry; returns its index or -1 when out of memory. The
+// parent must be the previous entry or one of its ancestors.
+int file_table_add(FileTable* table, const char* name, int parent, FileType type, long long size);
+int file_table_count(const FileTable* table);
+const FileColumns* file_table_columns(const FileTable* table);
+FileRecord* file_table_record(FileTable* table, int index);
+
+FileType file_table_type(const FileTable* table, int index);
+long long file_table_size(const FileTable* table, int index);
+int file_table_depth(const FileTable* table, int index);
+int file_table_is_deleted(const FileTable* table, int index);
+int file_table_parent(const FileTable* table, int index);
+int file_table_last_descendant(const FileTable* table, int index);
+void file_table_set_type(FileTable* table, int index, FileType type);
+void file_table_set_size(FileTable* table, int index, long long size);
+void file_table_set_deleted(FileTable* table, int index, int deleted);
+
+// Digests are stored out of line; NULL when the entry was never hashed
+int file_table_set_digests(FileTable* table, int index, const HashDigests* digests);
+const HashDigests* file_table_digests(const FileTable* table, int index);
+
+// Data runs of the entry's content inside the image
+int file_table_set_runs(FileTable* table, int index, const ImageRun* runs, int count);
+const ImageRun* file_table_runs(const FileTable* table, int index, int* count);
+
+// String pool; id 0 is always the empty string, which is also what a new
+// string gets when the pool cannot grow. Returned pointers are valid
+// until the next intern call.
+unsigned int file_table_intern(FileTable* table, const char* text);
+const char* file_table_string(const FileTable* table, unsigned int id);
+
+const char* file_table_name(const FileTable* table, int index);
+// Build "/dir/sub/name"; the root itself is "/". Returns the path length.
+size_t file_table_path(const FileTable* table, int index, char* buffer, size_t size);
+
+// Bytes held by columns, record pages, digest and run stores, string pool
+// and intern index
+size_t file_table_memory(const FileTable* table);
+
+#endif
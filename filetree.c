@@ -0,0 +1,143 @@
+#include "filetree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct FileTree {
+    FileTable* table;
+    int* rows;               // Shown entries, ascending
+    int row_count;
+    int row_capacity;
+    unsigned char* expanded; // Per entry
+    int expanded_capacity;
+    int synced;              // Entries taken in so far
+};
+
+FileTree* file_tree_create(FileTable* table) {
+    FileTree* tree = calloc(1, sizeof(FileTree));
+    if (!tree) return NULL;
+    tree->table = table;
+    if (file_tree_sync(tree) != 0) {
+        file_tree_destroy(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+void file_tree_destroy(FileTree* tree) {
+    if (!tree) return;
+    free(tree->rows);
+    free(tree->expanded);
+    free(tree);
+}
+
+static int reserve_rows(FileTree* tree, int extra) {
+    if (tree->row_count + extra <= tree->row_capacity) return 0;
+    int capacity = tree->row_capacity ? tree->row_capacity : 1024;
+    while (capacity < tree->row_count + extra) capacity *= 2;
+    int* rows = realloc(tree->rows, (size_t)capacity * sizeof(int));
+    if (!rows) return -1;
+    tree->rows = rows;
+    tree->row_capacity = capacity;
+    return 0;
+}
+
+// First row whose entry is above index
+static int row_after(const FileTree* tree, int first, int index) {
+    int low = first;
+    int high = tree->row_count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (tree->rows[middle] <= index) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+int file_tree_sync(FileTree* tree) {
+    int count = file_table_count(tree->table);
+    if (tree->synced == count) return 0;
+
+    if (count > tree->expanded_capacity) {
+        int capacity = tree->expanded_capacity ? tree->expanded_capacity : 4096;
+        while (capacity < count) capacity *= 2;
+        unsigned char* expanded = realloc(tree->expanded, (size_t)capacity);
+        if (!expanded) return -1;
+        tree->expanded = expanded;
+        tree->expanded_capacity = capacity;
+    }
+
+    // New entries come after every existing row, so shown ones are appended
+    int shown_parent = -1;
+    for (int i = tree->synced; i < count; i++) {
+        int parent = file_table_parent(tree->table, i);
+        int top = parent < 0 || parent >= i;
+        tree->expanded[i] = (unsigned char)top;
+        if (!top && parent != shown_parent) {
+            if (!tree->expanded[parent] || file_tree_entry_row(tree, parent) < 0) continue;
+            shown_parent = parent;
+        }
+        if (reserve_rows(tree, 1) != 0) return -1;
+        tree->rows[tree->row_count++] = i;
+    }
+    tree->synced = count;
+    return 0;
+}
+
+int file_tree_row_count(const FileTree* tree) {
+    return tree->row_count;
+}
+
+int file_tree_row_entry(const FileTree* tree, int row) {
+    return tree->rows[row];
+}
+
+int file_tree_entry_row(const FileTree* tree, int index) {
+    int row = row_after(tree, 0, index) - 1;
+    return row >= 0 && tree->rows[row] == index ? row : -1;
+}
+
+int file_tree_has_children(const FileTree* tree, int index) {
+    return file_table_last_descendant(tree->table, index) > index;
+}
+
+int file_tree_is_expanded(const FileTree* tree, int index) {
+    return index < tree->synced && tree->expanded[index];
+}
+
+// Descendants of a shown directory that expanding it would show: children
+// in order, stepping over the subtree of any that are collapsed
+static int visible_descendants(const FileTree* tree, int index, int* out) {
+    const int* last = file_table_columns(tree->table)->last;
+    int n = 0;
+    for (int i = index + 1; i <= last[index]; i = tree->expanded[i] ? i + 1 : last[i] + 1) {
+        if (out) out[n] = i;
+        n++;
+    }
+    return n;
+}
+
+int file_tree_set_expanded(FileTree* tree, int index, int expanded) {
+    if (file_tree_sync(tree) != 0) return -1;
+    if (index < 0 || index >= tree->synced || tree->expanded[index] == (expanded != 0)) return 0;
+    tree->expanded[index] = (unsigned char)(expanded != 0);
+
+    int row = file_tree_entry_row(tree, index);
+    if (row < 0 || !file_tree_has_children(tree, index)) return 0;
+
+    if (expanded) {
+        int n = visible_descendants(tree, index, NULL);
+        if (reserve_rows(tree, n) != 0) {
+            tree->expanded[index] = 0;
+            return -1;
+        }
+        memmove(tree->rows + row + 1 + n, tree->rows + row + 1, (size_t)(tree->row_count - row - 1) * sizeof(int));
+        visible_descendants(tree, index, tree->rows + row + 1);
+        tree->row_count += n;
+    } else {
+        int end = row_after(tree, row + 1, file_table_last_descendant(tree->table, index));
+        memmove(tree->rows + row + 1, tree->rows + end, (size_t)(tree->row_count - end) * sizeof(int));
+        tree->row_count -= end - row - 1;
+    }
+    return 0;
+}
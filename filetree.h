@@ -0,0 +1,35 @@
+#ifndef FILETREE_H
+#define FILETREE_H
+
+#include "filetable.h"
+
+// Expandable tree view over the file table
+//
+// Keeps the rows currently shown, in table order, plus an expanded flag
+// per directory. Because each subtree is a contiguous index range, a
+// collapsed directory is stepped over in one jump: expanding one touches
+// only its direct children (and those of subdirectories left expanded),
+// and collapsing removes a single contiguous run of rows. Entries the
+// backends or the carver append later are picked up by file_tree_sync.
+
+typedef struct FileTree FileTree;
+
+// Tree over table with its top-level entries expanded
+FileTree* file_tree_create(FileTable* table);
+void file_tree_destroy(FileTree* tree);
+
+// Take in entries appended to the table since the last call
+int file_tree_sync(FileTree* tree);
+
+int file_tree_row_count(const FileTree* tree);
+int file_tree_row_entry(const FileTree* tree, int row);
+// Row showing the entry, or -1 while an ancestor is collapsed
+int file_tree_entry_row(const FileTree* tree, int index);
+
+int file_tree_has_children(const FileTree* tree, int index);
+int file_tree_is_expanded(const FileTree* tree, int index);
+// Expand or collapse a directory; its rows change only while it is shown.
+// Returns 0 on success.
+int file_tree_set_expanded(FileTree* tree, int index, int expanded);
+
+#endif
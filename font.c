@@ -0,0 +1,235 @@
+#define GL_GLEXT_PROTOTYPES // Framebuffer and buffer objects are GL 1.5-3.0 entry points
+#include "font.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glut.h>
+
+#define CELL_SIZE 32    // Atlas cell per glyph, room for the 18 pixel font
+#define CELL_PEN 8      // Pen position inside a cell, room for bearings and descenders
+#define CELL_COLUMNS 16
+
+static unsigned char clamp_color(float value) {
+    return (unsigned char)(value >= 1.0f ? 255 : value <= 0.0f ? 0 : value * 255.0f + 0.5f);
+}
+
+// Tight box of the lit pixels in one cell, relative to the pen
+static void measure_glyph(FontGlyph* glyph, const unsigned char* pixels, int stride, int cell_x, int cell_y) {
+    int x0 = CELL_SIZE, y0 = CELL_SIZE, x1 = -1, y1 = -1;
+    for (int y = 0; y < CELL_SIZE; y++) {
+        const unsigned char* row = pixels + (size_t)(cell_y + y) * stride + cell_x;
+        for (int x = 0; x < CELL_SIZE; x++) {
+            if (!row[x]) continue;
+            if (x < x0) x0 = x;
+            if (x > x1) x1 = x;
+            if (y < y0) y0 = y;
+            if (y > y1) y1 = y;
+        }
+    }
+    if (x1 < 0) x0 = y0 = 0, x1 = y1 = -1; // Blank, such as space
+    glyph->left = (short)(x0 - CELL_PEN);
+    glyph->bottom = (short)(y0 - CELL_PEN);
+    glyph->width = (short)(x1 - x0 + 1);
+    glyph->height = (short)(y1 - y0 + 1);
+    glyph->u = (short)(cell_x + x0);
+    glyph->v = (short)(cell_y + y0);
+}
+
+int font_atlas_init(FontAtlas* atlas) {
+    memset(atlas, 0, sizeof(*atlas));
+
+    // Framebuffer objects need GL 3.0
+    int major = 0, minor = 0;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 || major < 3) return -1;
+
+    // Bitmap fonts the panels use
+    void* fonts[FONT_ATLAS_FONTS] = {
+        GLUT_BITMAP_8_BY_13, GLUT_BITMAP_HELVETICA_10, GLUT_BITMAP_HELVETICA_12, GLUT_BITMAP_HELVETICA_18,
+    };
+    int rows = FONT_GLYPHS / CELL_COLUMNS;
+    atlas->width = CELL_COLUMNS * CELL_SIZE;
+    atlas->height = FONT_ATLAS_FONTS * rows * CELL_SIZE;
+    unsigned char* pixels = malloc((size_t)atlas->width * atlas->height * 4);
+    if (!pixels) return -1;
+
+    // Draw every glyph with GLUT into an offscreen target at integer pens
+    GLuint framebuffer, target;
+    glGenRenderbuffers(1, &target);
+    glBindRenderbuffer(GL_RENDERBUFFER, target);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, atlas->width, atlas->height);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+    int complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glPushAttrib(GL_ENABLE_BIT | GL_VIEWPORT_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_PIXEL_MODE_BIT);
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0, atlas->width, 0, atlas->height, -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+        glViewport(0, 0, atlas->width, atlas->height);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_DEPTH_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glColor3f(1.0f, 1.0f, 1.0f);
+        for (int f = 0; f < FONT_ATLAS_FONTS; f++) {
+            for (int c = 1; c < FONT_GLYPHS; c++) {
+                glRasterPos2i((c % CELL_COLUMNS) * CELL_SIZE + CELL_PEN,
+                              (f * rows + c / CELL_COLUMNS) * CELL_SIZE + CELL_PEN);
+                glutBitmapCharacter(fonts[f], c);
+            }
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, atlas->width, atlas->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
+        glPopAttrib();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &target);
+    if (!complete) {
+        free(pixels);
+        return -1;
+    }
+
+    // Keep coverage only, then record each glyph's box
+    size_t area = (size_t)atlas->width * atlas->height;
+    for (size_t i = 0; i < area; i++) pixels[i] = pixels[i * 4] ? 255 : 0;
+    for (int f = 0; f < FONT_ATLAS_FONTS; f++) {
+        atlas->fonts[f] = fonts[f];
+        for (int c = 0; c < FONT_GLYPHS; c++) {
+            FontGlyph* glyph = &atlas->glyphs[f][c];
+            measure_glyph(glyph, pixels, atlas->width, (c % CELL_COLUMNS) * CELL_SIZE,
+                          (f * rows + c / CELL_COLUMNS) * CELL_SIZE);
+            glyph->advance = (short)(c ? glutBitmapWidth(fonts[f], c) : 0);
+        }
+    }
+
+    glGenTextures(1, &atlas->texture);
+    glBindTexture(GL_TEXTURE_2D, atlas->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, atlas->width, atlas->height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    free(pixels);
+    atlas->ready = 1;
+    return 0;
+}
+
+void font_atlas_free(FontAtlas* atlas) {
+    if (atlas->texture) glDeleteTextures(1, &atlas->texture);
+    if (atlas->buffer) glDeleteBuffers(1, &atlas->buffer);
+    free(atlas->vertices);
+    free(atlas->uploaded);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+static FontVertex* reserve_vertices(FontAtlas* atlas, size_t count) {
+    if (atlas->count + count > atlas->capacity) {
+        size_t capacity = atlas->capacity ? atlas->capacity : 4096;
+        while (capacity < atlas->count + count) capacity *= 2;
+        FontVertex* vertices = realloc(atlas->vertices, capacity * sizeof(FontVertex));
+        if (!vertices) return NULL;
+        atlas->vertices = vertices;
+        FontVertex* uploaded = realloc(atlas->uploaded, capacity * sizeof(FontVertex));
+        if (!uploaded) return NULL;
+        atlas->uploaded = uploaded;
+        atlas->capacity = capacity;
+    }
+    FontVertex* v = atlas->vertices + atlas->count;
+    atlas->count += count;
+    return v;
+}
+
+int font_text(FontAtlas* atlas, void* font, float x, float y, const char* text, const float color[4]) {
+    int f = 0;
+    while (f < FONT_ATLAS_FONTS && (!atlas->ready || atlas->fonts[f] != font)) f++;
+    if (f == FONT_ATLAS_FONTS) return -1;
+
+    unsigned char rgba[4] = {clamp_color(color[0]), clamp_color(color[1]), clamp_color(color[2]),
+                             clamp_color(color[3])};
+    float scale_u = 1.0f / atlas->width;
+    float scale_v = 1.0f / atlas->height;
+    // glBitmap places each glyph at the floor of the raster position
+    float pen_x = x;
+    float pen_y = floorf(y + 0.0001f);
+    static const int corners[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    for (; *text; text++) {
+        signed char c = (signed char)*text;
+        if (c <= 0) continue; // As glutBitmapCharacter, which draws nothing for these
+        const FontGlyph* glyph = &atlas->glyphs[f][(int)c];
+        if (glyph->width > 0) {
+            FontVertex* v = reserve_vertices(atlas, 6);
+            if (!v) return 0;
+            float left = floorf(pen_x + 0.0001f) + glyph->left;
+            float bottom = pen_y + glyph->bottom;
+            for (int i = 0; i < 6; i++) {
+                int cx = corners[i][0], cy = corners[i][1];
+                v[i].position[0] = left + cx * glyph->width;
+                v[i].position[1] = bottom + cy * glyph->height;
+                v[i].texcoord[0] = (glyph->u + cx * glyph->width) * scale_u;
+                v[i].texcoord[1] = (glyph->v + cy * glyph->height) * scale_v;
+                memcpy(v[i].color, rgba, 4);
+            }
+        }
+        pen_x += glyph->advance;
+    }
+    return 0;
+}
+
+void font_flush(FontAtlas* atlas) {
+    if (atlas->count == 0) return;
+
+    if (!atlas->buffer) glGenBuffers(1, &atlas->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, atlas->buffer);
+    // Text rarely changes between frames; send it only when it does
+    size_t bytes = atlas->count * sizeof(FontVertex);
+    if (atlas->count != atlas->uploaded_count || memcmp(atlas->vertices, atlas->uploaded, bytes) != 0) {
+        if (bytes > atlas->buffer_size) {
+            atlas->buffer_size = atlas->capacity * sizeof(FontVertex);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)atlas->buffer_size, NULL, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, atlas->vertices);
+        memcpy(atlas->uploaded, atlas->vertices, bytes);
+        atlas->uploaded_count = atlas->count;
+    }
+
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, atlas->texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_ALPHA_TEST); // Coverage is 0 or 1, as with bitmaps
+    glAlphaFunc(GL_GREATER, 0.5f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(FontVertex), (const void*)offsetof(FontVertex, position));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(FontVertex), (const void*)offsetof(FontVertex, texcoord));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(FontVertex), (const void*)offsetof(FontVertex, color));
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)atlas->count);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glPopAttrib();
+
+    atlas->count = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stddef.h>
+
+// Glyph atlas text
+//
+// The GLUT bitmap fonts the panels use are rendered once into a texture,
+// and each glyph's tight box inside it is recorded. Text then becomes
+// textured quads appended to one vertex buffer, so a frame's text is a
+// single draw call instead of a glBitmap per character. Glyphs land on
+// the same pixels glutBitmapCharacter would put them on.
+
+#define FONT_ATLAS_FONTS 4
+#define FONT_GLYPHS 128 // glutBitmapCharacter skips the rest of a signed char
+
+typedef struct {
+    short left, bottom;   // Tight box relative to the pen
+    short width, height;
+    short u, v;           // Box position in the atlas, pixels
+    short advance;
+} FontGlyph;
+
+typedef struct {
+    float position[2];
+    float texcoord[2];
+    unsigned char color[4];
+} FontVertex;
+
+typedef struct {
+    int ready;                          // Atlas built; otherwise callers draw bitmaps
+    unsigned int texture;
+    int width, height;
+    void* fonts[FONT_ATLAS_FONTS];
+    FontGlyph glyphs[FONT_ATLAS_FONTS][FONT_GLYPHS];
+    unsigned int buffer;                // GL buffer object
+    size_t buffer_size;
+    FontVertex* vertices;               // This frame's glyph quads
+    FontVertex* uploaded;               // Copy of what the buffer holds
+    size_t count;
+    size_t capacity;
+    size_t uploaded_count;
+} FontAtlas;
+
+// Render the atlas; needs a current context with framebuffer objects.
+// Returns 0, or -1 with ready left 0.
+int font_atlas_init(FontAtlas* atlas);
+void font_atlas_free(FontAtlas* atlas);
+
+// Queue text with its baseline starting at window position (x, y).
+// Returns -1 when the font is not in the atlas.
+int font_text(FontAtlas* atlas, void* font, float x, float y, const char* text, const float color[4]);
+
+// Draw the text queued since the last flush in window coordinates
+void font_flush(FontAtlas* atlas);
+
+#endif
@@ -1,7 +1,9 @@
 #define _GNU_SOURCE
+#define GL_GLEXT_PROTOTYPES // Framebuffer objects for the panel cache
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <time.h>
 #include <math.h>
 
@@ -14,50 +16,71 @@
 #ifdef _WIN32
     #include <windows.h>
     #include <GL/gl.h>
+    #include <GL/glext.h>
     #include <GL/glu.h>
 #else
     #include <GL/gl.h>
+    #include <GL/glext.h>
     #include <GL/glu.h>
     #include <GL/glut.h>
     #include <unistd.h>
 #endif
 
+#include "filetable.h"
+#include "filetree.h"
+#include "batch.h"
+#include "font.h"
+#include "hexdump.h"
+#include "hexview.h"
+#include "model.h"
+#include "carve.h"
+#include "entropy.h"
+#include "hash.h"
+#include "image.h"
+#include "kwscan.h"
+#include "volume.h"
+#include "pool.h"
+#include "sig.h"
+#include "strext.h"
+#include "textindex.h"
+#include "timeline.h"
+#include "verify.h"
+
 // Constants
 #define MAX_PATH_LENGTH 1024
 #define MAX_FILENAME 256
-#define MAX_FILES 1000
 #define MAX_HEX_DISPLAY 512
+#define PREVIEW_ENTROPY_WINDOW 64 // Preview bytes are too few for 4 KiB windows
+#define BULK_QUEUE_DEPTH 4         // Bulk jobs kept queued per worker thread
+#define HASH_BATCH_SIZE (1LL << 20) // Bulk files up to this size are hashed HASH_BATCH_LANES to a job
+#define CARVE_JOB_SIZE (64LL << 20) // Image bytes per carving job
+#define STRINGS_JOB_SIZE (64LL << 20) // Image bytes per strings index job
+#define KEYWORD_JOB_SIZE (64LL << 20) // Image bytes per keyword scan job
+#define TEXT_SCAN_STEP (4 << 20)     // Selected file bytes searched for strings per tick
+#define TEXT_COLUMNS 72              // Characters of a string shown in the text tab
 #define WINDOW_WIDTH 1200
 #define WINDOW_HEIGHT 800
+#define TREE_ROW_HEIGHT 25
+#define TREE_FIRST_ROW_Y (WINDOW_HEIGHT - 180) // Baseline of the top row
+#define TREE_ROWS 21                           // Rows that fit the panel
+#define TREE_LABEL_CACHE 128                   // Formatted labels kept, a power of two
+#define HEX_FIRST_ROW_Y (WINDOW_HEIGHT - 340)  // Baseline of the top hex row
+#define HEX_ROW_HEIGHT 15
+#define HEX_ROWS 22                            // Rows that fit the preview
+#define HEX_SCREEN_BYTES (HEX_ROWS * HEX_VIEW_ROW_BYTES)
+#define HISTOGRAM_COLUMNS 230                  // Bars of the timeline histogram, 2 pixels each
+#define HISTOGRAM_Y (WINDOW_HEIGHT - 430)      // Bottom of the histogram bars
+#define HISTOGRAM_HEIGHT 75
+#define TIMELINE_FIRST_ROW_Y (WINDOW_HEIGHT - 450) // Baseline of the top timeline row
+#define TIMELINE_ROWS 14                       // Rows that fit below the histogram
+#define PANEL_MENU 0x01                        // Dirty panel bits
+#define PANEL_TREE 0x02
+#define PANEL_CENTER 0x04
+#define PANEL_RIGHT 0x08
+#define PANEL_STATUS 0x10
+#define PANEL_ALL 0x1f
 
 // Structures
-typedef enum {
-    FILE_TYPE_FOLDER,
-    FILE_TYPE_EXECUTABLE,
-    FILE_TYPE_IMAGE,
-    FILE_TYPE_DOCUMENT,
-    FILE_TYPE_TEXT,
-    FILE_TYPE_DELETED,
-    FILE_TYPE_UNKNOWN
-} FileType;
-
-typedef struct {
-    char name[MAX_FILENAME];
-    char full_path[MAX_PATH_LENGTH];
-    FileType type;
-    long size;
-    time_t created;
-    time_t modified;
-    time_t accessed;
-    char md5_hash[33];
-    char format[32];
-    int is_deleted;
-    int depth;
-    char metadata[512];
-    unsigned char hex_data[MAX_HEX_DISPLAY];
-    int hex_length;
-} FileEntry;
-
 typedef struct {
     char image_path[MAX_PATH_LENGTH];
     char format[32];
@@ -66,21 +89,151 @@ typedef struct {
     char evidence_number[64];
     time_t creation_date;
     char examiner[128];
+    char file_system[32];
 } ForensicImage;
 
+typedef enum {
+    ANALYSIS_HASH,
+    ANALYSIS_HASH_BATCH,
+    ANALYSIS_ENTROPY,
+    ANALYSIS_SIGNATURE,
+    ANALYSIS_CARVE,
+    ANALYSIS_EXPORT,
+    ANALYSIS_STRINGS,
+    ANALYSIS_INDEX,
+    ANALYSIS_KEYWORDS
+} AnalysisKind;
+
+// Payload of a background analysis job. Inputs are copied in so the
+// worker never touches the file table; results are published by
+// analysis_done on the UI thread.
+typedef struct {
+    AnalysisKind kind;
+    int file_index;
+    unsigned int generation; // Selection generation at submit time
+    int bulk;                // Part of a whole-volume pass
+    int status;
+    HashDigests digests;
+    int batch_count;         // Small files hashed side by side, runs[] in turn
+    int batch_files[HASH_BATCH_LANES];
+    int batch_run_counts[HASH_BATCH_LANES];
+    HashDigests batch_digests[HASH_BATCH_LANES];
+    EntropyProfile profile;
+    int signature;           // Signature format id
+    long long scan_start;    // Image range a carving, strings or keyword job owns
+    long long scan_end;
+    CarveResult carved;
+    StringList strings;
+    KeywordHitList keyword_hits;
+    TextIndexExtent* extents; // Files' image extents for the keyword index
+    int extent_count;
+    int run_count;
+    ImageRun runs[];
+} AnalysisJob;
+
+// Formatted file tree row, reused while the inputs it was built from hold
+typedef struct {
+    int index;
+    unsigned int name;
+    unsigned char type;
+    unsigned char marker;
+    char text[300];
+} TreeLabel;
+
 // Global variables
-FileEntry files[MAX_FILES];
-int file_count = 0;
+FileTable* file_table = NULL;
+FileTree* file_tree = NULL;           // Rows shown in the file tree panel
+int tree_scroll = 0;                  // First row drawn
+TreeLabel tree_labels[TREE_LABEL_CACHE]; // Direct-mapped by entry index
+RenderBatch ui_batch;                 // Panel rectangles and plots of the frame
+RenderBatch model_batch;              // 3D view cubes without instancing
+ModelView model_view;                 // 3D view instances
+FontAtlas font_atlas;                 // Text of the frame, drawn per panel
+unsigned int dirty_panels = PANEL_ALL; // Panels to render again at the next redisplay
+unsigned int ui_cache = 0;            // Framebuffer keeping every panel between redisplays
+int auto_rotate = 1;                  // Turn the 3D view a little every tick
 int selected_file_index = 0;
 ForensicImage current_image;
+EvidenceImage* evidence_image = NULL;
+unsigned char preview_data[MAX_HEX_DISPLAY];
+const unsigned char* preview_bytes = NULL; // Selected file preview: image view or preview_data
+int preview_length = 0;
+HexView* hex_view = NULL;             // Hex tab, paged over the whole selected file
+char offset_entry[17];                // Hex digits typed after G
+int entering_offset = 0;
+StringScanner text_scanner;           // Text tab, strings of the selected file found so far
+StringList text_strings;
+long long text_scanned = 0;           // Selected file bytes fed to the scanner
+int text_scroll = 0;                  // First string shown
+EntropyProfile entropy_profile;   // Selected file's entropy map
+int entropy_valid = 0;
+int entropy_from_preview = 0;     // Profile covers only the preview bytes
+int entropy_pending = 0;          // Background job queued for the selection
 int current_tab = 0; // 0=hex, 1=text, 2=metadata, 3=timeline
+WorkerPool* analysis_pool = NULL;     // Background jobs, drained in timer_callback
+unsigned int selection_generation = 0;
+int bulk_cursor = -1;                 // Next entry of the bulk pass, -1 when idle
+int bulk_done = 0;
+int bulk_total = 0;
+int hash_batch[HASH_BATCH_LANES];     // Small files waiting for a batched hash job
+int hash_batch_count = 0;
+long long carve_next = -1;            // Next image offset to carve, -1 when idle
+int carve_jobs = 0;                   // Carving jobs in flight
+int carve_cancel = 0;
+long long carve_scanned = 0;          // Bytes scanned, updated by the workers
+ImageRun* carve_extents = NULL;       // Unallocated space of the running pass
+int carve_extent_count = 0;
+int carve_extent_next = 0;            // First extent not yet wholly scheduled
+long long carve_total = 0;            // Unallocated bytes
+VolumeExtents allocated_space;        // What the parsed volumes' bitmaps and tables mark in use
+int exporting = 0;                    // Hex export job in flight
+int export_cancel = 0;
+long long export_done = 0;            // Bytes exported, updated by the worker
+long long export_length = 0;
+char export_path[MAX_PATH_LENGTH];    // Report the running export writes
+StringList string_index;              // Strings of the whole image, by offset
+long long strings_next = -1;          // Next image offset to index, -1 when idle
+int strings_jobs = 0;                 // Strings jobs in flight
+int strings_cancel = 0;
+long long strings_scanned = 0;        // Bytes searched, updated by the workers
+TextIndex* text_index = NULL;         // Keyword index of string_index, mapped from disk
+char index_path[MAX_PATH_LENGTH];
+int indexing = 0;                     // Keyword index job in flight
+long long index_progress = 0;         // Strings indexed, updated by the worker
+TextHitList search_hits;              // Last keyword search, shown in the text tab
+int search_active = 0;
+int search_keywords = 0;
+char keyword_entry[256];              // Comma-separated keywords typed after K
+int entering_keywords = 0;
+KeywordScanner* keyword_scanner = NULL; // Keyword list and regex subset, shared by the scan jobs
+KeywordHitList scan_hits;             // Hits of the last raw keyword scan, by offset
+long long scan_next = -1;             // Next image offset to scan, -1 when idle
+int scan_jobs = 0;                    // Keyword scan jobs in flight
+int scan_cancel = 0;
+long long scan_scanned = 0;           // Bytes scanned, updated by the workers
+int scan_shown = 0;                   // Text tab lists scan_hits
+Timeline* timeline = NULL;            // MACB times of every file as events, mapped from disk
+char timeline_path[MAX_PATH_LENGTH];
+size_t timeline_top = 0;              // First event shown in the timeline tab
+long long timeline_view_from = 0;     // Seconds the histogram spans, [from, to)
+long long timeline_view_to = 0;
+int carved_folder = -1;
+int carved_count = 0;
+ImageVerify* image_verify = NULL;     // Running acquisition verification
+int verify_cancelled = 0;             // V pressed again while it ran
+float operation_progress = 0.0f;
+char operation_status[160] = "Idle";
 float camera_angle = 0.0f;
 float camera_elevation = 0.0f;
 float camera_distance = 10.0f;
 
 // Function prototypes
-void init_forensic_data(void);
+void init_forensic_data(const char* image_path);
+int load_file_systems(int root);
+int load_volume(const Volume* volume, int parent);
 void init_opengl(void);
+void init_ui_cache(void);
+void mark_dirty(unsigned int panels);
 void display_callback(void);
 void reshape_callback(int width, int height);
 void keyboard_callback(unsigned char key, int x, int y);
@@ -95,182 +248,292 @@ void render_right_panel(void);
 void render_menu_bar(void);
 void render_status_bar(void);
 void update_file_selection(int index);
+void toggle_directory(int index);
+void scroll_file_tree(int first_row);
+void scroll_hex_view(long long offset);
+void reset_text_strings(void);
+void extend_text_strings(void);
+void scroll_text_strings(int first);
+void render_search_hits(float panel_x, float preview_y);
+void render_scan_hits(float panel_x, float preview_y);
+void render_timeline_histogram(float panel_x, long long top_time);
+void render_timeline(float panel_x, float preview_y);
+void format_time(time_t seconds, char* out, size_t size);
+const char* tree_row_label(int index);
 void generate_hex_data(int file_index);
+int add_demo_file(const char* name, int parent, FileType type, long long size,
+                  const char* format, const char* md5_hex);
+void format_digest(int file_index, int algorithm, char* out);
 void calculate_file_hash(int file_index);
+void start_image_verification(void);
+void finish_image_verification(void);
 void analyze_file_entropy(int file_index);
+void classify_file(int file_index, const unsigned char* header, int length);
+void apply_signature(int file_index, int format_id);
 void draw_text(float x, float y, const char* text, void* font);
 void draw_rect(float x, float y, float width, float height, float r, float g, float b);
-void draw_3d_cube(float x, float y, float z, float size, float r, float g, float b);
-void simulate_file_analysis(void);
+void flush_ui(void);
+void set_2d_projection(void);
+int submit_analysis(int file_index, AnalysisKind kind, int bulk);
+int submit_hash_batch(void);
+void* open_worker_image(void* path);
+void close_worker_image(void* image);
+void analysis_work(PoolJob* job, void* worker);
+void analysis_done(PoolJob* job);
+void start_bulk_analysis(void);
+void schedule_bulk_analysis(void);
+void start_file_carving(void);
+void schedule_file_carving(void);
+void start_hex_export(void);
+void schedule_hex_export(void);
+void start_string_index(void);
+void schedule_string_index(void);
+void start_keyword_index(void);
+void schedule_keyword_index(void);
+void search_keywords_entry(void);
+void load_keyword_list(const char* path);
+void start_keyword_scan(void);
+void schedule_keyword_scan(void);
+void add_carved_files(const CarveResult* carved);
+void build_timeline(void);
+void scroll_timeline(long long first);
+void show_file_in_timeline(int index);
+void set_timeline_view(long long from, long long to);
+void zoom_timeline(double factor, double anchor);
+int timeline_histogram_hit(int x, int y, long long* time);
 
 // Initialize forensic data
-void init_forensic_data(void) {
+void init_forensic_data(const char* image_path) {
     // Initialize forensic image info
-    strcpy(current_image.image_path, "evidence/disk_image.E01");
+    snprintf(current_image.image_path, sizeof(current_image.image_path), "%s", image_path);
     strcpy(current_image.format, "E01");
     current_image.total_size = 2500000000L; // 2.5 GB
     strcpy(current_image.compression, "ZLIB");
+
+    // Open the evidence image
+    evidence_image = image_open(current_image.image_path);
+    if (evidence_image) {
+        current_image.total_size = (long)image_size(evidence_image);
+        strcpy(current_image.format, image_format_name(evidence_image));
+        strcpy(current_image.compression, image_compression_name(evidence_image));
+        
+        // Each worker reads through its own handle; the EWF cache is not shared
+        analysis_pool = pool_create(0, open_worker_image, close_worker_image,
+                                    current_image.image_path);
+        
+        // A keyword index left by an earlier session is used as is
+        const char* base = strrchr(current_image.image_path, '/');
+        snprintf(index_path, sizeof(index_path), "%.1000s.strings.idx", base ? base + 1 : current_image.image_path);
+        text_index = text_index_open(index_path, evidence_image);
+    } else {
+        fprintf(stderr, "Warning: cannot open evidence image %s, showing demo data\n",
+                current_image.image_path);
+    }
+    hex_view = hex_view_create(evidence_image);
     strcpy(current_image.evidence_number, "EV-2024-001");
     current_image.creation_date = time(NULL);
     strcpy(current_image.examiner, "Digital Forensics Team");
 
     // Initialize file tree structure
-    file_count = 0;
+    file_table = file_table_create();
+    file_tree = file_tree_create(file_table);
     
     // Root
-    strcpy(files[file_count].name, "disk_image.E01");
-    strcpy(files[file_count].full_path, "/");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = current_image.total_size;
-    files[file_count].depth = 0;
-    files[file_count].is_deleted = 0;
-    file_count++;
-
-    // Windows folder
-    strcpy(files[file_count].name, "Windows");
-    strcpy(files[file_count].full_path, "/Windows");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = 15000000;
-    files[file_count].depth = 1;
-    files[file_count].is_deleted = 0;
-    file_count++;
-
-    // System32
-    strcpy(files[file_count].name, "System32");
-    strcpy(files[file_count].full_path, "/Windows/System32");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = 8000000;
-    files[file_count].depth = 2;
-    files[file_count].is_deleted = 0;
-    file_count++;
-
-    // notepad.exe
-    strcpy(files[file_count].name, "notepad.exe");
-    strcpy(files[file_count].full_path, "/Windows/System32/notepad.exe");
-    files[file_count].type = FILE_TYPE_EXECUTABLE;
-    files[file_count].size = 179712;
-    files[file_count].depth = 3;
-    files[file_count].is_deleted = 0;
-    strcpy(files[file_count].format, "PE");
-    strcpy(files[file_count].md5_hash, "a1b2c3d4e5f6789012345678901234ab");
-    file_count++;
-
-    // calc.exe
-    strcpy(files[file_count].name, "calc.exe");
-    strcpy(files[file_count].full_path, "/Windows/System32/calc.exe");
-    files[file_count].type = FILE_TYPE_EXECUTABLE;
-    files[file_count].size = 27648;
-    files[file_count].depth = 3;
-    files[file_count].is_deleted = 0;
-    strcpy(files[file_count].format, "PE");
-    strcpy(files[file_count].md5_hash, "b2c3d4e5f67890123456789012345abc");
-    file_count++;
-
-    // Users folder
-    strcpy(files[file_count].name, "Users");
-    strcpy(files[file_count].full_path, "/Users");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = 5000000;
-    files[file_count].depth = 1;
-    files[file_count].is_deleted = 0;
-    file_count++;
-
-    // John user folder
-    strcpy(files[file_count].name, "John");
-    strcpy(files[file_count].full_path, "/Users/John");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = 3000000;
-    files[file_count].depth = 2;
-    files[file_count].is_deleted = 0;
-    file_count++;
-
-    // Documents
-    strcpy(files[file_count].name, "Documents");
-    strcpy(files[file_count].full_path, "/Users/John/Documents");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = 2000000;
-    files[file_count].depth = 3;
-    files[file_count].is_deleted = 0;
-    file_count++;
-
-    // report.pdf
-    strcpy(files[file_count].name, "report.pdf");
-    strcpy(files[file_count].full_path, "/Users/John/Documents/report.pdf");
-    files[file_count].type = FILE_TYPE_DOCUMENT;
-    files[file_count].size = 867328;
-    files[file_count].depth = 4;
-    files[file_count].is_deleted = 0;
-    strcpy(files[file_count].format, "PDF");
-    strcpy(files[file_count].md5_hash, "c3d4e5f678901234567890123456abcd");
-    file_count++;
-
-    // photo.jpg
-    strcpy(files[file_count].name, "photo.jpg");
-    strcpy(files[file_count].full_path, "/Users/John/Documents/photo.jpg");
-    files[file_count].type = FILE_TYPE_IMAGE;
-    files[file_count].size = 2097152;
-    files[file_count].depth = 4;
-    files[file_count].is_deleted = 0;
-    strcpy(files[file_count].format, "JPEG");
-    strcpy(files[file_count].md5_hash, "d4e5f67890123456789012345678abcd");
-    file_count++;
-
-    // Program Files
-    strcpy(files[file_count].name, "Program Files");
-    strcpy(files[file_count].full_path, "/Program Files");
-    files[file_count].type = FILE_TYPE_FOLDER;
-    files[file_count].size = 1000000000;
-    files[file_count].depth = 1;
-    files[file_count].is_deleted = 0;
-    file_count++;
+    const char* image_name = strrchr(current_image.image_path, '/');
+    image_name = image_name ? image_name + 1 : current_image.image_path;
+    int root = add_demo_file(image_name, FILE_TABLE_NO_PARENT, FILE_TYPE_FOLDER,
+                             current_image.total_size, NULL, NULL);
+    if (evidence_image && load_file_systems(root) > 0) {
+        build_timeline();
+        generate_hex_data(selected_file_index);
+        analyze_file_entropy(selected_file_index);
+        return;
+    }
+    strcpy(current_image.file_system, "NTFS (demo data)");
+
+    int windows = add_demo_file("Windows", root, FILE_TYPE_FOLDER, 15000000, NULL, NULL);
+    int system32 = add_demo_file("System32", windows, FILE_TYPE_FOLDER, 8000000, NULL, NULL);
+    add_demo_file("notepad.exe", system32, FILE_TYPE_EXECUTABLE, 179712,
+                  "PE", "a1b2c3d4e5f6789012345678901234ab");
+    add_demo_file("calc.exe", system32, FILE_TYPE_EXECUTABLE, 27648,
+                  "PE", "b2c3d4e5f67890123456789012345abc");
+
+    int users = add_demo_file("Users", root, FILE_TYPE_FOLDER, 5000000, NULL, NULL);
+    int john = add_demo_file("John", users, FILE_TYPE_FOLDER, 3000000, NULL, NULL);
+    int documents = add_demo_file("Documents", john, FILE_TYPE_FOLDER, 2000000, NULL, NULL);
+    add_demo_file("report.pdf", documents, FILE_TYPE_DOCUMENT, 867328,
+                  "PDF", "c3d4e5f678901234567890123456abcd");
+    add_demo_file("photo.jpg", documents, FILE_TYPE_IMAGE, 2097152,
+                  "JPEG", "d4e5f67890123456789012345678abcd");
+
+    add_demo_file("Program Files", root, FILE_TYPE_FOLDER, 1000000000, NULL, NULL);
 
     // Deleted file
-    strcpy(files[file_count].name, "deleted_file.txt (recovered)");
-    strcpy(files[file_count].full_path, "/deleted_file.txt");
-    files[file_count].type = FILE_TYPE_DELETED;
-    files[file_count].size = 4096;
-    files[file_count].depth = 1;
-    files[file_count].is_deleted = 1;
-    strcpy(files[file_count].format, "TXT");
-    strcpy(files[file_count].md5_hash, "e5f678901234567890123456789abcde");
-    file_count++;
+    int deleted = add_demo_file("deleted_file.txt (recovered)", root, FILE_TYPE_DELETED, 4096,
+                                "TXT", "e5f678901234567890123456789abcde");
+    file_table_set_deleted(file_table, deleted, 1);
 
     // Generate initial hex data for selected file
     generate_hex_data(selected_file_index);
+    analyze_file_entropy(selected_file_index);
+}
+
+// Find the volumes in the image and add their trees under root: the
+// image itself may be a volume, otherwise its partitions are walked.
+// Returns the number of volumes loaded.
+int load_file_systems(int root) {
+    Volume volumes[VOLUME_MAX];
+    int count = volume_scan(evidence_image, volumes, VOLUME_MAX);
+    
+    int loaded = 0;
+    for (int i = 0; i < count; i++) {
+        if (!volumes[i].backend) continue;
+        int parent = root;
+        if (volumes[i].partition > 0) {
+            char name[64];
+            snprintf(name, sizeof(name), "Partition %d (%s)", volumes[i].partition, volumes[i].backend->name);
+            parent = file_table_add(file_table, name, root, FILE_TYPE_FOLDER, 0);
+            if (parent < 0) break;
+        }
+        if (load_volume(&volumes[i], parent) == 0) loaded++;
+    }
+    return loaded;
+}
+
+// Parse a recognised volume under parent; returns 0 on success
+int load_volume(const Volume* volume, int parent) {
+    const FsBackend* backend = volume->backend;
+    VolumeStats stats;
+    if (backend->load(evidence_image, current_image.image_path, volume->offset, file_table, parent, 0, &stats) != 0) {
+        fprintf(stderr, "Warning: %s volume at offset %lld could not be parsed\n", backend->name, volume->offset);
+        return -1;
+    }
+    // Carving then falls back to the data runs of the live files alone
+    if (backend->allocated(evidence_image, volume->offset, &allocated_space) != 0) {
+        fprintf(stderr, "Warning: %s volume at offset %lld: allocation bitmap unreadable\n",
+                backend->name, volume->offset);
+    }
+    // Several volumes list each file system once
+    size_t used = strlen(current_image.file_system);
+    if (!strstr(current_image.file_system, backend->name) &&
+        used + strlen(backend->name) + 3 <= sizeof(current_image.file_system)) {
+        snprintf(current_image.file_system + used, sizeof(current_image.file_system) - used,
+                 "%s%s", used ? ", " : "", backend->name);
+    }
+    printf("%s at offset %lld: %lld records, %lld entries (%lld deleted, %lld orphaned) "
+           "in %.2f s on %d threads\n", backend->name, volume->offset, stats.records, stats.entries,
+           stats.deleted, stats.orphans, stats.seconds, stats.threads);
+    snprintf(operation_status, sizeof(operation_status), "Loaded %lld %s entries in %.2f s",
+             stats.entries, backend->name, stats.seconds);
+    return 0;
+}
+
+// Add a demo entry; md5_hex is a 32-digit hex string or NULL
+int add_demo_file(const char* name, int parent, FileType type, long long size,
+                  const char* format, const char* md5_hex) {
+    int index = file_table_add(file_table, name, parent, type, size);
+    if (index < 0) return index;
+    
+    FileRecord* record = file_table_record(file_table, index);
+    if (format) record->format = file_table_intern(file_table, format);
+    if (md5_hex) {
+        HashDigests digests;
+        memset(&digests, 0, sizeof(digests));
+        for (int i = 0; i < 16; i++) {
+            unsigned int byte = 0;
+            sscanf(md5_hex + i * 2, "%2x", &byte);
+            digests.md5[i] = (unsigned char)byte;
+        }
+        digests.valid = HASH_MD5;
+        file_table_set_digests(file_table, index, &digests);
+    }
+    return index;
+}
+
+// Format one digest of a file as hex; out holds 65 bytes
+void format_digest(int file_index, int algorithm, char* out) {
+    const HashDigests* digests = file_table_digests(file_table, file_index);
+    if (!digests || !(digests->valid & algorithm)) {
+        strcpy(out, "-");
+        return;
+    }
+    switch (algorithm) {
+        case HASH_MD5: hash_format(digests->md5, sizeof(digests->md5), out); break;
+        case HASH_SHA1: hash_format(digests->sha1, sizeof(digests->sha1), out); break;
+        case HASH_SHA256: hash_format(digests->sha256, sizeof(digests->sha256), out); break;
+        default: strcpy(out, "-"); break;
+    }
 }
 
 // Generate hex data for file preview
 void generate_hex_data(int file_index) {
-    if (file_index < 0 || file_index >= file_count) return;
+    if (file_index < 0 || file_index >= file_table_count(file_table)) return;
+    reset_text_strings();
+    
+    // The root entry is the evidence image itself
+    if (file_index == 0 && evidence_image) {
+        ImageRun whole = {0, image_size(evidence_image)};
+        hex_view_set_runs(hex_view, &whole, 1, whole.length);
+        scroll_hex_view(0);
+        
+        ImageView view;
+        image_advise(evidence_image, 0, MAX_HEX_DISPLAY, IMAGE_ACCESS_RANDOM);
+        if (image_format(evidence_image) == IMAGE_FORMAT_RAW &&
+            image_view(evidence_image, 0, MAX_HEX_DISPLAY, &view) == 0) {
+            // Zero-copy: point straight into the mapped image
+            preview_bytes = view.data;
+            preview_length = (int)view.length;
+        } else {
+            // E01 views only live until the chunk is evicted, so copy
+            long n = image_read(evidence_image, 0, preview_data, MAX_HEX_DISPLAY);
+            preview_bytes = preview_data;
+            preview_length = n > 0 ? (int)n : 0;
+        }
+        return;
+    }
+    
+    // Files with data runs show, and are classified by, their real first bytes
+    int run_count;
+    const ImageRun* runs = file_table_runs(file_table, file_index, &run_count);
+    if (evidence_image && runs) {
+        hex_view_set_runs(hex_view, runs, run_count, file_table_size(file_table, file_index));
+        scroll_hex_view(0);
+        long n = image_read_runs(evidence_image, runs, run_count, 0, preview_data, MAX_HEX_DISPLAY);
+        preview_bytes = preview_data;
+        preview_length = n > 0 ? (int)n : 0;
+        classify_file(file_index, preview_bytes, preview_length);
+        return;
+    }
     
-    FileEntry* file = &files[file_index];
+    unsigned char* hex_data = preview_data;
+    preview_bytes = preview_data;
     
     // Simulate different hex patterns based on file type
-    switch (file->type) {
+    switch (file_table_type(file_table, file_index)) {
         case FILE_TYPE_EXECUTABLE:
             // PE header pattern
-            file->hex_data[0] = 0x4D; file->hex_data[1] = 0x5A; // MZ
-            file->hex_data[2] = 0x90; file->hex_data[3] = 0x00;
-            file->hex_data[4] = 0x03; file->hex_data[5] = 0x00;
+            hex_data[0] = 0x4D; hex_data[1] = 0x5A; // MZ
+            hex_data[2] = 0x90; hex_data[3] = 0x00;
+            hex_data[4] = 0x03; hex_data[5] = 0x00;
             for (int i = 6; i < MAX_HEX_DISPLAY; i++) {
-                file->hex_data[i] = (unsigned char)(rand() % 256);
+                hex_data[i] = (unsigned char)(rand() % 256);
             }
             break;
         case FILE_TYPE_IMAGE:
             // JPEG header pattern
-            file->hex_data[0] = 0xFF; file->hex_data[1] = 0xD8; // JPEG SOI
-            file->hex_data[2] = 0xFF; file->hex_data[3] = 0xE0; // JFIF marker
+            hex_data[0] = 0xFF; hex_data[1] = 0xD8; // JPEG SOI
+            hex_data[2] = 0xFF; hex_data[3] = 0xE0; // JFIF marker
             for (int i = 4; i < MAX_HEX_DISPLAY; i++) {
-                file->hex_data[i] = (unsigned char)(rand() % 256);
+                hex_data[i] = (unsigned char)(rand() % 256);
             }
             break;
         case FILE_TYPE_DOCUMENT:
             // PDF header pattern
-            file->hex_data[0] = 0x25; file->hex_data[1] = 0x50; // %P
-            file->hex_data[2] = 0x44; file->hex_data[3] = 0x46; // DF
-            file->hex_data[4] = 0x2D; file->hex_data[5] = 0x31; // -1
+            hex_data[0] = 0x25; hex_data[1] = 0x50; // %P
+            hex_data[2] = 0x44; hex_data[3] = 0x46; // DF
+            hex_data[4] = 0x2D; hex_data[5] = 0x31; // -1
             for (int i = 6; i < MAX_HEX_DISPLAY; i++) {
-                file->hex_data[i] = (unsigned char)(rand() % 256);
+                hex_data[i] = (unsigned char)(rand() % 256);
             }
             break;
         case FILE_TYPE_TEXT:
@@ -278,9 +541,9 @@ void generate_hex_data(int file_index) {
             // Text file pattern
             for (int i = 0; i < MAX_HEX_DISPLAY; i++) {
                 if (i % 16 < 12) {
-                    file->hex_data[i] = (unsigned char)(0x41 + (rand() % 26)); // A-Z
+                    hex_data[i] = (unsigned char)(0x41 + (rand() % 26)); // A-Z
                 } else {
-                    file->hex_data[i] = (unsigned char)(rand() % 256);
+                    hex_data[i] = (unsigned char)(rand() % 256);
                 }
             }
             break;
@@ -289,20 +552,43 @@ void generate_hex_data(int file_index) {
         default:
             // Random data for other types
             for (int i = 0; i < MAX_HEX_DISPLAY; i++) {
-                file->hex_data[i] = (unsigned char)(rand() % 256);
+                hex_data[i] = (unsigned char)(rand() % 256);
             }
             break;
     }
     
-    file->hex_length = MAX_HEX_DISPLAY;
+    preview_length = MAX_HEX_DISPLAY;
+    hex_view_set_memory(hex_view, preview_data, preview_length);
+    scroll_hex_view(0);
+    classify_file(file_index, preview_bytes, preview_length);
+}
+
+// Classify a file by its first bytes
+void classify_file(int file_index, const unsigned char* header, int length) {
+    if (file_table_type(file_table, file_index) == FILE_TYPE_FOLDER) return;
+    apply_signature(file_index, sig_format_id(sig_classify(header, (size_t)length)));
+}
+
+// Fill format and type from a detected signature and check the name's
+// extension against it. Unrecognised content keeps its current type.
+void apply_signature(int file_index, int format_id) {
+    FileRecord* record = file_table_record(file_table, file_index);
+    record->signature = (unsigned short)format_id;
+    record->flags = (unsigned short)((record->flags & ~FILE_FLAG_EXTENSION_MISMATCH) | FILE_FLAG_CLASSIFIED);
+    
+    const SigFormat* format = sig_format(format_id);
+    if (!format) return;
+    record->format = file_table_intern(file_table, format->name);
+    file_table_set_type(file_table, file_index, format->type);
+    if (sig_extension_check(format, file_table_name(file_table, file_index)) == 0) {
+        record->flags |= FILE_FLAG_EXTENSION_MISMATCH;
+    }
 }
 
 // Initialize OpenGL
 void init_opengl(void) {
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
+    glEnable(GL_LIGHT0); // render_3d_model turns on lighting and depth for itself
     
     GLfloat light_position[] = {1.0f, 1.0f, 1.0f, 0.0f};
     GLfloat light_ambient[] = {0.2f, 0.2f, 0.2f, 1.0f};
@@ -311,6 +597,12 @@ void init_opengl(void) {
     glLightfv(GL_LIGHT0, GL_POSITION, light_position);
     glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
     glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
+    glEnable(GL_COLOR_MATERIAL); // Cube colors feed ambient and diffuse
+    model_init(&model_view);
+    if (font_atlas_init(&font_atlas) != 0) {
+        fprintf(stderr, "Warning: No glyph atlas, drawing text as bitmaps\n");
+    }
+    init_ui_cache();
     
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -318,25 +610,91 @@ void init_opengl(void) {
     glMatrixMode(GL_MODELVIEW);
 }
 
+// Offscreen copy of the window. Panels are rendered into it only when
+// marked dirty and the whole of it is copied to the window on each
+// redisplay, so an idle window costs nothing and a rotating 3D view
+// re-renders only the right panel.
+void init_ui_cache(void) {
+    int major = 0;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (!version || sscanf(version, "%d", &major) != 1 || major < 3) return;
+    
+    GLuint buffers[2];
+    glGenRenderbuffers(2, buffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, buffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, buffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &ui_cache);
+    glBindFramebuffer(GL_FRAMEBUFFER, ui_cache);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, buffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, buffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Warning: No panel cache, redrawing the whole window\n");
+        glDeleteFramebuffers(1, &ui_cache);
+        glDeleteRenderbuffers(2, buffers);
+        ui_cache = 0;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Render the given panels again at the next redisplay
+void mark_dirty(unsigned int panels) {
+    dirty_panels |= panels;
+    glutPostRedisplay();
+}
+
 // Display callback
 void display_callback(void) {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    
-    // Set viewport for entire window
-    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
-    
-    // Render UI components
-    render_menu_bar();
-    render_file_tree();
-    render_center_panel();
-    render_right_panel();
-    render_status_bar();
-    
+    // Window regions of the panels, disjoint so each can be redrawn alone
+    static const struct {
+        unsigned int bit;
+        float x, y, width, height;
+        void (*render)(void);
+    } panels[] = {
+        {PANEL_MENU, 0, WINDOW_HEIGHT - 100, WINDOW_WIDTH, 100, render_menu_bar},
+        {PANEL_TREE, 0, 100, WINDOW_WIDTH * 0.25f, WINDOW_HEIGHT - 200, render_file_tree},
+        {PANEL_CENTER, WINDOW_WIDTH * 0.25f, 100, WINDOW_WIDTH * 0.42f, WINDOW_HEIGHT - 200, render_center_panel},
+        {PANEL_RIGHT, WINDOW_WIDTH * 0.67f, 100, WINDOW_WIDTH * 0.33f, WINDOW_HEIGHT - 200, render_right_panel},
+        {PANEL_STATUS, 0, 0, WINDOW_WIDTH, 100, render_status_bar},
+    };
+    
+    // The back buffer is undefined after a swap; only the cache keeps panels
+    if (ui_cache) glBindFramebuffer(GL_FRAMEBUFFER, ui_cache);
+    else dirty_panels = PANEL_ALL;
+    
+    set_2d_projection();
+    batch_begin(&ui_batch);
+    glEnable(GL_SCISSOR_TEST);
+    for (size_t i = 0; i < sizeof(panels) / sizeof(panels[0]); i++) {
+        if (!(dirty_panels & panels[i].bit)) continue;
+        // Rounded the same way on both sides so neighbouring regions meet exactly
+        int x0 = (int)panels[i].x, x1 = (int)(panels[i].x + panels[i].width);
+        int y0 = (int)panels[i].y, y1 = (int)(panels[i].y + panels[i].height);
+        glScissor(x0, y0, x1 - x0, y1 - y0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        panels[i].render();
+        flush_ui();
+        font_flush(&font_atlas); // Text goes over the panel
+    }
+    glDisable(GL_SCISSOR_TEST);
+    dirty_panels = 0;
+    
+    if (ui_cache) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
     glutSwapBuffers();
 }
 
 // Render 3D model in right panel
 void render_3d_model(void) {
+    // Panel rectangles queued so far belong to the 2D projection
+    flush_ui();
+    
     // Set viewport for 3D area (right panel, upper section)
     glViewport((int)(WINDOW_WIDTH * 0.67f), (int)(WINDOW_HEIGHT * 0.4f), 
                (int)(WINDOW_WIDTH * 0.33f), (int)(WINDOW_HEIGHT * 0.35f));
@@ -358,108 +716,22 @@ void render_3d_model(void) {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_LIGHTING);
     
-    // Draw 3D representation of file structure
-    float x = 0.0f, y = 0.0f, z = 0.0f;
-    for (int i = 0; i < file_count && i < 20; i++) { // Limit for performance
-        FileEntry* file = &files[i];
-        float size_factor = (float)(log10((double)file->size + 1) * 0.1f);
-        
-        // Color based on file type
-        float r = 0.5f, g = 0.5f, b = 0.5f;
-        switch (file->type) {
-            case FILE_TYPE_FOLDER: r = 1.0f; g = 1.0f; b = 0.0f; break;
-            case FILE_TYPE_EXECUTABLE: r = 1.0f; g = 0.0f; b = 0.0f; break;
-            case FILE_TYPE_IMAGE: r = 0.0f; g = 1.0f; b = 0.0f; break;
-            case FILE_TYPE_DOCUMENT: r = 0.0f; g = 0.0f; b = 1.0f; break;
-            case FILE_TYPE_DELETED: r = 1.0f; g = 0.0f; b = 1.0f; break;
-            case FILE_TYPE_TEXT: r = 0.5f; g = 0.5f; b = 1.0f; break;
-            case FILE_TYPE_UNKNOWN: r = 0.7f; g = 0.7f; b = 0.7f; break;
-        }
-        
-        if (i == selected_file_index) {
-            r += 0.3f; g += 0.3f; b += 0.3f;
-        }
-        
-        draw_3d_cube(x, y, z, size_factor, r, g, b);
-        
-        // Arrange in spiral pattern
-        float angle = i * 0.5f;
-        float radius = 1.0f + i * 0.2f;
-        x = radius * (float)cos(angle);
-        z = radius * (float)sin(angle);
-        y = file->depth * 0.5f;
-    }
+    // Whole hierarchy as instanced cubes, distant subtrees collapsed
+    float eye[3] = {
+        camera_distance * (float)(cos(camera_angle * M_PI / 180.0f) * cos(camera_elevation * M_PI / 180.0f)),
+        camera_distance * (float)sin(camera_elevation * M_PI / 180.0f),
+        camera_distance * (float)(sin(camera_angle * M_PI / 180.0f) * cos(camera_elevation * M_PI / 180.0f)),
+    };
+    model_build(&model_view, file_table, selected_file_index, eye);
+    model_draw(&model_view, &model_batch);
     
     glDisable(GL_LIGHTING);
     glDisable(GL_DEPTH_TEST);
-}
-
-// Draw 3D cube
-void draw_3d_cube(float x, float y, float z, float size, float r, float g, float b) {
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glScalef(size, size, size);
-    
-    glColor3f(r, g, b);
-    
-    // Draw cube faces
-    glBegin(GL_QUADS);
-    
-    // Front face
-    glNormal3f(0.0f, 0.0f, 1.0f);
-    glVertex3f(-0.5f, -0.5f,  0.5f);
-    glVertex3f( 0.5f, -0.5f,  0.5f);
-    glVertex3f( 0.5f,  0.5f,  0.5f);
-    glVertex3f(-0.5f,  0.5f,  0.5f);
-    
-    // Back face
-    glNormal3f(0.0f, 0.0f, -1.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    glVertex3f(-0.5f,  0.5f, -0.5f);
-    glVertex3f( 0.5f,  0.5f, -0.5f);
-    glVertex3f( 0.5f, -0.5f, -0.5f);
-    
-    // Top face
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    glVertex3f(-0.5f,  0.5f, -0.5f);
-    glVertex3f(-0.5f,  0.5f,  0.5f);
-    glVertex3f( 0.5f,  0.5f,  0.5f);
-    glVertex3f( 0.5f,  0.5f, -0.5f);
-    
-    // Bottom face
-    glNormal3f(0.0f, -1.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    glVertex3f( 0.5f, -0.5f, -0.5f);
-    glVertex3f( 0.5f, -0.5f,  0.5f);
-    glVertex3f(-0.5f, -0.5f,  0.5f);
-    
-    // Right face
-    glNormal3f(1.0f, 0.0f, 0.0f);
-    glVertex3f( 0.5f, -0.5f, -0.5f);
-    glVertex3f( 0.5f,  0.5f, -0.5f);
-    glVertex3f( 0.5f,  0.5f,  0.5f);
-    glVertex3f( 0.5f, -0.5f,  0.5f);
-    
-    // Left face
-    glNormal3f(-1.0f, 0.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    glVertex3f(-0.5f, -0.5f,  0.5f);
-    glVertex3f(-0.5f,  0.5f,  0.5f);
-    glVertex3f(-0.5f,  0.5f, -0.5f);
-    
-    glEnd();
-    glPopMatrix();
+    set_2d_projection();
 }
 
 // Render file tree (left panel)
 void render_file_tree(void) {
-    // Set 2D rendering mode
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    
     // Draw left panel background
     draw_rect(0, 100, WINDOW_WIDTH * 0.25f, WINDOW_HEIGHT - 150, 0.15f, 0.15f, 0.15f);
     
@@ -468,10 +740,14 @@ void render_file_tree(void) {
     glColor3f(0.9f, 0.9f, 0.9f);
     draw_text(10, WINDOW_HEIGHT - 135, "File Structure", GLUT_BITMAP_HELVETICA_12);
     
-    // Draw file entries
-    float y_pos = WINDOW_HEIGHT - 180;
-    for (int i = 0; i < file_count; i++) {
-        FileEntry* file = &files[i];
+    // Only the rows inside the scroll window are visited and formatted
+    file_tree_sync(file_tree);
+    int row_count = file_tree_row_count(file_tree);
+    scroll_file_tree(tree_scroll);
+    const FileColumns* columns = file_table_columns(file_table);
+    float y_pos = TREE_FIRST_ROW_Y;
+    for (int row = tree_scroll; row < row_count && row < tree_scroll + TREE_ROWS; row++) {
+        int i = file_tree_row_entry(file_tree, row);
         
         // Highlight selected file
         if (i == selected_file_index) {
@@ -479,35 +755,263 @@ void render_file_tree(void) {
         }
         
         // Set color based on file type and status
-        if (file->is_deleted) {
+        if (columns->deleted[i]) {
             glColor3f(1.0f, 0.4f, 0.4f); // Red for deleted files
         } else {
             glColor3f(0.9f, 0.9f, 0.9f); // White for normal files
         }
         
         // Indent based on depth
-        float indent = file->depth * 15.0f;
-        
-        // Draw file icon and name
-        const char* icon;
-        switch (file->type) {
-            case FILE_TYPE_FOLDER: icon = "[DIR]"; break;
-            case FILE_TYPE_EXECUTABLE: icon = "[EXE]"; break;
-            case FILE_TYPE_IMAGE: icon = "[IMG]"; break;
-            case FILE_TYPE_DOCUMENT: icon = "[DOC]"; break;
-            case FILE_TYPE_DELETED: icon = "[DEL]"; break;
-            case FILE_TYPE_TEXT: icon = "[TXT]"; break;
-            case FILE_TYPE_UNKNOWN: 
-            default: icon = "[?]"; break;
+        float indent = columns->depth[i] * 15.0f;
+        draw_text(10 + indent, y_pos, tree_row_label(i), GLUT_BITMAP_HELVETICA_10);
+        y_pos -= TREE_ROW_HEIGHT;
+    }
+    
+    // Scroll bar when the rows overflow the panel
+    if (row_count > TREE_ROWS) {
+        float track = TREE_ROWS * TREE_ROW_HEIGHT;
+        float thumb = track * TREE_ROWS / row_count;
+        if (thumb < 10) thumb = 10;
+        float top = TREE_FIRST_ROW_Y + 5 - (track - thumb) * tree_scroll / (row_count - TREE_ROWS);
+        draw_rect(WINDOW_WIDTH * 0.25f - 6, top - thumb, 4, thumb, 0.4f, 0.4f, 0.4f);
+    }
+}
+
+// Icon, expand marker and name of a tree row, formatted again only when
+// the entry's type, name or expansion changed since it was last drawn
+const char* tree_row_label(int index) {
+    TreeLabel* label = &tree_labels[index & (TREE_LABEL_CACHE - 1)];
+    const FileColumns* columns = file_table_columns(file_table);
+    unsigned char marker = !file_tree_has_children(file_tree, index) ? ' '
+                         : file_tree_is_expanded(file_tree, index) ? '-' : '+';
+    if (label->index == index && label->name == columns->name[index] &&
+        label->type == columns->type[index] && label->marker == marker) {
+        return label->text;
+    }
+    
+    const char* icon;
+    switch ((FileType)columns->type[index]) {
+        case FILE_TYPE_FOLDER: icon = "[DIR]"; break;
+        case FILE_TYPE_EXECUTABLE: icon = "[EXE]"; break;
+        case FILE_TYPE_IMAGE: icon = "[IMG]"; break;
+        case FILE_TYPE_DOCUMENT: icon = "[DOC]"; break;
+        case FILE_TYPE_DELETED: icon = "[DEL]"; break;
+        case FILE_TYPE_TEXT: icon = "[TXT]"; break;
+        case FILE_TYPE_UNKNOWN: 
+        default: icon = "[?]"; break;
+    }
+    snprintf(label->text, sizeof(label->text), "%c %s %s", marker, icon, file_table_name(file_table, index));
+    label->index = index;
+    label->name = columns->name[index];
+    label->type = columns->type[index];
+    label->marker = marker;
+    return label->text;
+}
+
+// Set the first drawn row, kept inside the row range
+void scroll_file_tree(int first_row) {
+    int last = file_tree_row_count(file_tree) - TREE_ROWS;
+    if (first_row > last) first_row = last;
+    if (first_row < 0) first_row = 0;
+    tree_scroll = first_row;
+}
+
+// Put offset on the top row of the hex tab
+void scroll_hex_view(long long offset) {
+    hex_view_scroll(hex_view, offset, HEX_SCREEN_BYTES);
+    mark_dirty(PANEL_CENTER);
+}
+
+// Start the text tab's strings over for a new selection
+void reset_text_strings(void) {
+    string_scanner_init(&text_scanner, 0, STRING_MIN_LENGTH);
+    text_strings.count = 0;
+    text_scanned = 0;
+    text_scroll = 0;
+}
+
+// Search the selected file for strings, a step per tick and only as far
+// as the shown page and the one after it need
+void extend_text_strings(void) {
+    static unsigned char block[1 << 18];
+    long long length = hex_view_length(hex_view);
+    if (current_tab != 1 || search_active || scan_shown || text_scanned >= length) return;
+    
+    size_t wanted = (size_t)text_scroll + 2 * HEX_ROWS;
+    if (text_strings.count >= wanted) return;
+    long long step_end = text_scanned + TEXT_SCAN_STEP;
+    while (text_strings.count < wanted && text_scanned < length && text_scanned < step_end) {
+        long n = hex_view_read_direct(hex_view, text_scanned, block, sizeof(block));
+        if (n <= 0 || string_scan(&text_scanner, block, (size_t)n, &text_strings) != 0) {
+            text_scanned = length; // Show what was found before the failure
+            break;
         }
+        text_scanned += n;
+    }
+    if (text_scanned >= length) string_scan_finish(&text_scanner, &text_strings);
+    mark_dirty(PANEL_CENTER);
+}
+
+// Put string first on the top row of the text tab
+void scroll_text_strings(int first) {
+    size_t count = search_active ? search_hits.count : scan_shown ? scan_hits.count : text_strings.count;
+    int last = (int)count - HEX_ROWS;
+    if (first > last) first = last;
+    if (first < 0) first = 0;
+    text_scroll = first;
+    mark_dirty(PANEL_CENTER);
+}
+
+// Keyword hits in place of the text tab's strings: image offset, file
+// and offset in it, and the string from the hit on
+void render_search_hits(float panel_x, float preview_y) {
+    char line[256];
+    int digits = hex_dump_digits(evidence_image ? image_size(evidence_image) : 0);
+    for (int i = 0; i < HEX_ROWS && (size_t)(text_scroll + i) < search_hits.count; i++) {
+        const TextHit* hit = &search_hits.hits[text_scroll + i];
+        const char* text;
+        size_t length = text_index_string_text(text_index, hit->string, &text);
+        int shown = (int)(length - hit->position) < 40 ? (int)(length - hit->position) : 40;
+        char where[40];
+        if (hit->file_index >= 0 && hit->file_index < file_table_count(file_table)) {
+            snprintf(where, sizeof(where), "%.14s+%llX", file_table_name(file_table, hit->file_index),
+                     hit->file_offset);
+        } else {
+            snprintf(where, sizeof(where), "(unallocated)");
+        }
+        snprintf(line, sizeof(line), "%0*llX %-34s %.*s", digits, hit->image_offset, where,
+                 shown, text + hit->position);
+        draw_text(panel_x + 20, HEX_FIRST_ROW_Y - i * HEX_ROW_HEIGHT, line, GLUT_BITMAP_8_BY_13);
+    }
+    
+    if (entering_keywords) {
+        glColor3f(1.0f, 1.0f, 0.4f);
+        snprintf(line, sizeof(line), "Keywords: %.60s_", keyword_entry);
+    } else {
+        snprintf(line, sizeof(line), "%zu hits for %d keywords (K: search again)",
+                 search_hits.count, search_keywords);
+    }
+    draw_text(panel_x + 270, preview_y - 45, line, GLUT_BITMAP_HELVETICA_10);
+}
+
+// Raw scan hits in the text tab: image offset, file and offset in it,
+// the keyword or pattern, and the matched bytes read back from the image
+void render_scan_hits(float panel_x, float preview_y) {
+    char line[256];
+    int digits = hex_dump_digits(evidence_image ? image_size(evidence_image) : 0);
+    for (int i = 0; i < HEX_ROWS && (size_t)(text_scroll + i) < scan_hits.count; i++) {
+        const KeywordHit* hit = &scan_hits.hits[text_scroll + i];
+        unsigned char bytes[2 * 16];
+        size_t want = hit->length < (int)sizeof(bytes) ? (size_t)hit->length : sizeof(bytes);
+        long n = evidence_image ? image_read(evidence_image, hit->offset, bytes, want) : -1;
         
-        char display_text[300];
-        snprintf(display_text, sizeof(display_text), "%s %s", icon, file->name);
-        draw_text(10 + indent, y_pos, display_text, GLUT_BITMAP_HELVETICA_10);
+        // UTF-16LE matches are shown narrowed
+        char text[17];
+        int shown = 0;
+        for (long j = 0; j < n && shown < 16; j++) {
+            if (bytes[j] == 0) continue;
+            text[shown++] = bytes[j] >= 32 && bytes[j] < 127 ? (char)bytes[j] : '.';
+        }
+        text[shown] = '\0';
         
-        y_pos -= 25;
-        if (y_pos < 120) break; // Don't overflow panel
+        char where[40];
+        if (hit->file_index >= 0 && hit->file_index < file_table_count(file_table)) {
+            snprintf(where, sizeof(where), "%.14s+%llX", file_table_name(file_table, hit->file_index),
+                     hit->file_offset);
+        } else {
+            snprintf(where, sizeof(where), "(unallocated)");
+        }
+        snprintf(line, sizeof(line), "%0*llX %-22s %-10.10s %s", digits, hit->offset, where,
+                 keyword_pattern_name(keyword_scanner, hit->pattern), text);
+        draw_text(panel_x + 20, HEX_FIRST_ROW_Y - i * HEX_ROW_HEIGHT, line, GLUT_BITMAP_8_BY_13);
     }
+    
+    snprintf(line, sizeof(line), "%zu raw hits for %d patterns%s", scan_hits.count,
+             keyword_pattern_count(keyword_scanner), scan_next >= 0 ? ", scanning" : " (K, Enter: strings)");
+    draw_text(panel_x + 270, preview_y - 45, line, GLUT_BITMAP_HELVETICA_10);
+}
+
+// Seconds since the epoch as UTC date and time, "-" when unknown
+void format_time(time_t seconds, char* out, size_t size) {
+    struct tm parts;
+    if (seconds == 0 || !gmtime_r(&seconds, &parts) || strftime(out, size, "%Y-%m-%d %H:%M:%S", &parts) == 0) {
+        snprintf(out, size, "-");
+    }
+}
+
+// Event counts of the histogram window, log scaled so that quiet
+// stretches still show beside busy ones. The pyramid level is picked for
+// the zoom, so drawing costs the same over a decade as over a minute.
+void render_timeline_histogram(float panel_x, long long top_time) {
+    static const char* level_names[TIMELINE_LEVELS] = {"year", "day", "hour", "minute", "second"};
+    unsigned long long counts[HISTOGRAM_COLUMNS];
+    int level = timeline_histogram(timeline, timeline_view_from, timeline_view_to, HISTOGRAM_COLUMNS, counts);
+    if (level < 0) return;
+    
+    unsigned long long peak = 0;
+    for (int i = 0; i < HISTOGRAM_COLUMNS; i++) {
+        if (counts[i] > peak) peak = counts[i];
+    }
+    float left = panel_x + 20;
+    draw_rect(left, HISTOGRAM_Y, HISTOGRAM_COLUMNS * 2, HISTOGRAM_HEIGHT, 0.1f, 0.1f, 0.1f);
+    for (int i = 0; i < HISTOGRAM_COLUMNS && peak > 0; i++) {
+        if (counts[i] == 0) continue;
+        float height = HISTOGRAM_HEIGHT * (float)(log1p((double)counts[i]) / log1p((double)peak));
+        draw_rect(left + i * 2, HISTOGRAM_Y, 2, height < 1 ? 1 : height, 0.2f, 0.6f, 0.9f);
+    }
+    // The top row of the list
+    if (top_time >= timeline_view_from && top_time < timeline_view_to) {
+        double fraction = (double)(top_time - timeline_view_from) / (double)(timeline_view_to - timeline_view_from);
+        draw_rect(left + (float)(fraction * HISTOGRAM_COLUMNS * 2), HISTOGRAM_Y, 1, HISTOGRAM_HEIGHT, 1.0f, 1.0f, 0.4f);
+    }
+    
+    char line[256], from[32], to[32];
+    format_time((time_t)timeline_view_from, from, sizeof(from));
+    format_time((time_t)timeline_view_to, to, sizeof(to));
+    snprintf(line, sizeof(line), "%s to %s, per %s, peak %llu", from, to, level_names[level], peak);
+    glColor3f(0.8f, 0.8f, 0.8f);
+    draw_text(left, HEX_FIRST_ROW_Y, line, GLUT_BITMAP_HELVETICA_10);
+}
+
+// A page of the super-timeline in time order under its histogram: when,
+// MACB and the file; the selected file's events stand out
+void render_timeline(float panel_x, float preview_y) {
+    char line[256];
+    size_t count = 0;
+    const TimelineEvent* events = timeline ? timeline_run(timeline, 0, &count) : NULL;
+    if (count == 0) {
+        draw_text(panel_x + 20, HEX_FIRST_ROW_Y, timeline ? "No file timestamps in this image" :
+                  "No timeline: no file system was loaded", GLUT_BITMAP_HELVETICA_10);
+        return;
+    }
+    
+    render_timeline_histogram(panel_x, events[timeline_top].time);
+    
+    for (int i = 0; i < TIMELINE_ROWS && timeline_top + (size_t)i < count; i++) {
+        const TimelineEvent* event = &events[timeline_top + (size_t)i];
+        char when[32], macb[5], path[MAX_PATH_LENGTH];
+        format_time((time_t)event->time, when, sizeof(when));
+        timeline_format_macb(event->macb, macb);
+        if (event->kind == TIMELINE_SOURCE_FILE && (int)event->source < file_table_count(file_table)) {
+            file_table_path(file_table, (int)event->source, path, sizeof(path));
+        } else {
+            snprintf(path, sizeof(path), "?");
+        }
+        if ((int)event->source == selected_file_index) glColor3f(1.0f, 1.0f, 0.4f);
+        else glColor3f(0.8f, 0.8f, 0.8f);
+        // Long paths keep their end, where the name is
+        size_t length = strlen(path);
+        snprintf(line, sizeof(line), "%s %s %s%.34s", when, macb, length > 34 ? "..." : "",
+                 length > 34 ? path + length - 31 : path);
+        draw_text(panel_x + 20, TIMELINE_FIRST_ROW_Y - i * HEX_ROW_HEIGHT, line, GLUT_BITMAP_8_BY_13);
+    }
+    
+    glColor3f(0.8f, 0.8f, 0.8f);
+    char first[32], last[32];
+    format_time((time_t)events[0].time, first, sizeof(first));
+    format_time((time_t)events[count - 1].time, last, sizeof(last));
+    snprintf(line, sizeof(line), "%zu events, %.10s to %.10s (UTC)", count, first, last);
+    draw_text(panel_x + 270, preview_y - 45, line, GLUT_BITMAP_HELVETICA_10);
 }
 
 // Render center panel (file format info and preview)
@@ -518,7 +1022,7 @@ void render_center_panel(void) {
     // Draw center panel background
     draw_rect(panel_x, 100, panel_width, WINDOW_HEIGHT - 150, 0.12f, 0.12f, 0.12f);
     
-    FileEntry* selected_file = &files[selected_file_index];
+    FileRecord* selected_file = file_table_record(file_table, selected_file_index);
     
     // File format section
     draw_rect(panel_x, WINDOW_HEIGHT - 250, panel_width, 100, 0.15f, 0.15f, 0.15f);
@@ -529,16 +1033,30 @@ void render_center_panel(void) {
     char info_text[256];
     glColor3f(0.0f, 0.8f, 1.0f);
     
-    snprintf(info_text, sizeof(info_text), "Format: %s", selected_file->format);
+    const SigFormat* signature = sig_format(selected_file->signature);
+    int mismatch = (selected_file->flags & FILE_FLAG_EXTENSION_MISMATCH) != 0;
+    snprintf(info_text, sizeof(info_text), "Format: %s%s%s%s",
+             file_table_string(file_table, selected_file->format),
+             signature ? " (" : "", signature ? signature->description : "", signature ? ")" : "");
     draw_text(panel_x + 20, WINDOW_HEIGHT - 190, info_text, GLUT_BITMAP_HELVETICA_10);
+    if (mismatch) {
+        glColor3f(1.0f, 0.3f, 0.3f);
+        draw_text(panel_x + 300, WINDOW_HEIGHT - 190, "Extension mismatch", GLUT_BITMAP_HELVETICA_10);
+        glColor3f(0.0f, 0.8f, 1.0f);
+    }
     
-    snprintf(info_text, sizeof(info_text), "Size: %ld bytes", selected_file->size);
+    snprintf(info_text, sizeof(info_text), "Size: %lld bytes",
+             file_table_size(file_table, selected_file_index));
     draw_text(panel_x + 20, WINDOW_HEIGHT - 205, info_text, GLUT_BITMAP_HELVETICA_10);
     
-    snprintf(info_text, sizeof(info_text), "MD5: %s", selected_file->md5_hash);
+    char digest_hex[65];
+    format_digest(selected_file_index, HASH_MD5, digest_hex);
+    snprintf(info_text, sizeof(info_text), "MD5: %s", digest_hex);
     draw_text(panel_x + 20, WINDOW_HEIGHT - 220, info_text, GLUT_BITMAP_HELVETICA_10);
     
-    snprintf(info_text, sizeof(info_text), "Path: %s", selected_file->full_path);
+    char path[MAX_PATH_LENGTH];
+    file_table_path(file_table, selected_file_index, path, sizeof(path));
+    snprintf(info_text, sizeof(info_text), "Path: %.240s", path);
     draw_text(panel_x + 20, WINDOW_HEIGHT - 235, info_text, GLUT_BITMAP_HELVETICA_10);
     
     // Preview section
@@ -571,49 +1089,97 @@ void render_center_panel(void) {
     float content_y = preview_y - 80;
     
     switch (current_tab) {
-        case 0: // Hex view
-            for (int i = 0; i < 8 && i * 16 < selected_file->hex_length; i++) {
-                char hex_line[128];
-                char ascii_line[20];
-                
-                snprintf(hex_line, sizeof(hex_line), "%08X: ", i * 16);
-                
-                for (int j = 0; j < 16 && (i * 16 + j) < selected_file->hex_length; j++) {
-                    char byte_hex[4];
-                    unsigned char byte = selected_file->hex_data[i * 16 + j];
-                    snprintf(byte_hex, sizeof(byte_hex), "%02X ", byte);
-                    strcat(hex_line, byte_hex);
-                    
-                    ascii_line[j] = (byte >= 32 && byte <= 126) ? (char)byte : '.';
-                }
-                ascii_line[16] = '\0';
-                
-                strcat(hex_line, " | ");
-                strcat(hex_line, ascii_line);
-                
-                draw_text(panel_x + 20, content_y - i * 15, hex_line, GLUT_BITMAP_8_BY_13);
+        case 0: { // Hex view
+            // Only the shown screen is read, through the page cache
+            unsigned char screen[HEX_SCREEN_BYTES];
+            long long top = hex_view_offset(hex_view);
+            long long length = hex_view_length(hex_view);
+            long shown = hex_view_read(hex_view, top, screen, sizeof(screen));
+            int digits = hex_dump_digits(length);
+            for (int i = 0; i < HEX_ROWS && i * 16 < shown; i++) {
+                char hex_line[HEX_DUMP_ROW_MAX];
+                int count = shown - i * 16 < 16 ? (int)(shown - i * 16) : 16;
+                hex_dump_row(hex_line, top + i * 16, digits, screen + i * 16, count);
+                draw_text(panel_x + 20, HEX_FIRST_ROW_Y - i * HEX_ROW_HEIGHT, hex_line, GLUT_BITMAP_8_BY_13);
+            }
+            
+            // Position, or the offset being typed
+            if (entering_offset) {
+                glColor3f(1.0f, 1.0f, 0.4f);
+                snprintf(info_text, sizeof(info_text), "Go to offset: 0x%s_", offset_entry);
+            } else {
+                snprintf(info_text, sizeof(info_text), "0x%llX of 0x%llX (G: go to)", top, length);
+            }
+            draw_text(panel_x + 270, preview_y - 45, info_text, GLUT_BITMAP_HELVETICA_10);
+            
+            // Scrollbar thumb sized to one screen of the file
+            if (length > HEX_SCREEN_BYTES) {
+                float track_y = HEX_FIRST_ROW_Y - HEX_ROWS * HEX_ROW_HEIGHT + 10;
+                float track_height = HEX_ROWS * HEX_ROW_HEIGHT;
+                float thumb_height = track_height * (float)HEX_SCREEN_BYTES / (float)length;
+                if (thumb_height < 10) thumb_height = 10;
+                float fraction = (float)top / (float)(length - HEX_SCREEN_BYTES);
+                draw_rect(panel_x + panel_width - 10, track_y, 4, track_height, 0.15f, 0.15f, 0.15f);
+                draw_rect(panel_x + panel_width - 10, track_y + (track_height - thumb_height) * (1.0f - fraction),
+                          4, thumb_height, 0.4f, 0.4f, 0.4f);
             }
             break;
+        }
+            
+        case 1: { // Text view: extracted strings, read through the hex tab's page cache
+            long long length = hex_view_length(hex_view);
+            if (search_active || entering_keywords) {
+                render_search_hits(panel_x, preview_y);
+                break;
+            }
+            if (scan_shown) {
+                render_scan_hits(panel_x, preview_y);
+                break;
+            }
+            int digits = hex_dump_digits(length);
+            for (int i = 0; i < HEX_ROWS && (size_t)(text_scroll + i) < text_strings.count; i++) {
+                const FoundString* string = &text_strings.strings[text_scroll + i];
+                unsigned char bytes[2 * TEXT_COLUMNS];
+                char text[TEXT_COLUMNS + 1];
+                size_t want = string->length < (int)sizeof(bytes) ? (size_t)string->length : sizeof(bytes);
+                long n = hex_view_read(hex_view, string->offset, bytes, want);
+                string_text(string, bytes, n > 0 ? (size_t)n : 0, text, sizeof(text));
+                snprintf(info_text, sizeof(info_text), "%0*llX %c %s", digits, string->offset,
+                         string->encoding == STRING_UTF16LE ? 'U' : 'A', text);
+                draw_text(panel_x + 20, HEX_FIRST_ROW_Y - i * HEX_ROW_HEIGHT, info_text, GLUT_BITMAP_8_BY_13);
+            }
             
-        case 1: // Text view
-            draw_text(panel_x + 20, content_y, "Text representation of file content...", GLUT_BITMAP_HELVETICA_10);
-            draw_text(panel_x + 20, content_y - 20, "Binary files may show extracted strings.", GLUT_BITMAP_HELVETICA_10);
+            if (text_scanned < length) {
+                snprintf(info_text, sizeof(info_text), "%zu strings in the first %.0f%%",
+                         text_strings.count, 100.0 * (double)text_scanned / (double)length);
+            } else {
+                snprintf(info_text, sizeof(info_text), "%zu strings (A: ASCII, U: UTF-16LE)", text_strings.count);
+            }
+            draw_text(panel_x + 270, preview_y - 45, info_text, GLUT_BITMAP_HELVETICA_10);
             break;
+        }
             
-        case 2: // Metadata
-            snprintf(info_text, sizeof(info_text), "Created: %s", ctime(&selected_file->created));
-            // Remove newline from ctime
-            info_text[strlen(info_text)-1] = '\0';
-            draw_text(panel_x + 20, content_y, info_text, GLUT_BITMAP_HELVETICA_10);
-            snprintf(info_text, sizeof(info_text), "Modified: %s", ctime(&selected_file->modified));
-            info_text[strlen(info_text)-1] = '\0';
-            draw_text(panel_x + 20, content_y - 20, info_text, GLUT_BITMAP_HELVETICA_10);
+        case 2: { // Metadata: MACB times as the file system records them, UTC
+            const char* labels[4] = {"Modified", "Accessed", "Changed", "Born"};
+            const time_t times[4] = {selected_file->modified, selected_file->accessed,
+                                     selected_file->changed, selected_file->created};
+            for (int i = 0; i < 4; i++) {
+                char when[32];
+                format_time(times[i], when, sizeof(when));
+                snprintf(info_text, sizeof(info_text), "%s: %s", labels[i], when);
+                draw_text(panel_x + 20, content_y - i * 20, info_text, GLUT_BITMAP_HELVETICA_10);
+            }
+            format_digest(selected_file_index, HASH_SHA1, digest_hex);
+            snprintf(info_text, sizeof(info_text), "SHA-1: %s", digest_hex);
+            draw_text(panel_x + 20, content_y - 80, info_text, GLUT_BITMAP_HELVETICA_10);
+            format_digest(selected_file_index, HASH_SHA256, digest_hex);
+            snprintf(info_text, sizeof(info_text), "SHA-256: %s", digest_hex);
+            draw_text(panel_x + 20, content_y - 100, info_text, GLUT_BITMAP_HELVETICA_10);
             break;
+        }
             
         case 3: // Timeline
-            draw_text(panel_x + 20, content_y, "[DATE] File creation event", GLUT_BITMAP_HELVETICA_10);
-            draw_text(panel_x + 20, content_y - 20, "[DATE] Last modification", GLUT_BITMAP_HELVETICA_10);
-            draw_text(panel_x + 20, content_y - 40, "[DATE] Forensic analysis started", GLUT_BITMAP_HELVETICA_10);
+            render_timeline(panel_x, preview_y);
             break;
     }
 }
@@ -643,7 +1209,7 @@ void render_right_panel(void) {
     render_3d_model();
     
     // Analysis section
-    FileEntry* selected_file = &files[selected_file_index];
+    FileType selected_type = file_table_type(file_table, selected_file_index);
     
     glColor3f(0.0f, 0.8f, 1.0f);
     draw_text(panel_x + 10, viz_y - 20, "File Analysis", GLUT_BITMAP_HELVETICA_12);
@@ -653,7 +1219,7 @@ void render_right_panel(void) {
     glColor3f(0.8f, 0.8f, 0.8f);
     
     const char* file_type_str;
-    switch (selected_file->type) {
+    switch (selected_type) {
         case FILE_TYPE_EXECUTABLE: file_type_str = "PE Executable"; break;
         case FILE_TYPE_IMAGE: file_type_str = "JPEG Image"; break;
         case FILE_TYPE_DOCUMENT: file_type_str = "PDF Document"; break;
@@ -664,41 +1230,92 @@ void render_right_panel(void) {
         default: file_type_str = "Unknown"; break;
     }
     
+    const SigFormat* signature = sig_format(file_table_record(file_table, selected_file_index)->signature);
+    if (signature) file_type_str = signature->description;
     snprintf(analysis_text, sizeof(analysis_text), "File Type: %s", file_type_str);
     draw_text(panel_x + 15, viz_y - 45, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
     snprintf(analysis_text, sizeof(analysis_text), "Architecture: %s", 
-             selected_file->type == FILE_TYPE_EXECUTABLE ? "x86-64" : "N/A");
+             selected_type == FILE_TYPE_EXECUTABLE ? "x86-64" : "N/A");
     draw_text(panel_x + 15, viz_y - 65, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
-    float entropy = ((float)(selected_file->size % 100)) / 100.0f * 8.0f;
-    snprintf(analysis_text, sizeof(analysis_text), "Entropy: %.1f/8.0", entropy);
+    // Verdicts from the measured entropy: packed when the whole file, or
+    // most of its windows, look compressed or encrypted
+    double entropy = entropy_profile.entropy;
+    int packed = entropy_valid && (entropy >= ENTROPY_HIGH ||
+                 (entropy_profile.window_count >= 4 &&
+                  entropy_profile.high_windows * 2 >= entropy_profile.window_count));
+    if (entropy_valid) {
+        snprintf(analysis_text, sizeof(analysis_text), "Entropy: %.2f/8.0%s", entropy,
+                 entropy_from_preview ? " (preview)" : "");
+    } else {
+        snprintf(analysis_text, sizeof(analysis_text), "Entropy: %s",
+                 entropy_pending ? "analysing..." : "N/A");
+    }
     draw_text(panel_x + 15, viz_y - 85, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
     snprintf(analysis_text, sizeof(analysis_text), "Packed: %s", 
-             entropy > 7.5f ? "Yes" : "No");
+             !entropy_valid ? "N/A" : packed ? "Yes" : "No");
     draw_text(panel_x + 15, viz_y - 105, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
     snprintf(analysis_text, sizeof(analysis_text), "Digital Signature: %s",
-             selected_file->type == FILE_TYPE_EXECUTABLE ? "Valid" : "N/A");
+             selected_type == FILE_TYPE_EXECUTABLE ? "Valid" : "N/A");
     draw_text(panel_x + 15, viz_y - 125, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
-    // Threat level
-    glColor3f(entropy > 7.0f ? 1.0f : 0.0f, entropy < 6.0f ? 1.0f : 0.0f, 0.0f);
-    const char* threat_level = entropy > 7.0f ? "High" : (entropy > 5.0f ? "Medium" : "Low");
-    snprintf(analysis_text, sizeof(analysis_text), "Threat Level: %s", threat_level);
+    // Threat level: a packed executable is the strong signal; compressed
+    // media is expected to be high entropy, encrypted-looking text is not
+    int threat = 0; // 0 low, 1 medium, 2 high
+    if (entropy_valid) {
+        if (selected_type == FILE_TYPE_EXECUTABLE) {
+            threat = packed ? 2 : entropy_profile.high_windows > 0 ? 1 : 0;
+        } else if (packed && selected_type != FILE_TYPE_IMAGE && selected_type != FILE_TYPE_DOCUMENT) {
+            threat = 1;
+        }
+    }
+    glColor3f(threat > 0 ? 1.0f : 0.0f, threat < 2 ? 1.0f : 0.0f, 0.0f);
+    const char* threat_levels[] = {"Low", "Medium", "High"};
+    snprintf(analysis_text, sizeof(analysis_text), "Threat Level: %s",
+             entropy_valid ? threat_levels[threat] : "N/A");
     draw_text(panel_x + 15, viz_y - 145, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
     glColor3f(0.8f, 0.8f, 0.8f);
-    snprintf(analysis_text, sizeof(analysis_text), "File System: NTFS");
+    snprintf(analysis_text, sizeof(analysis_text), "File System: %s", current_image.file_system);
     draw_text(panel_x + 15, viz_y - 165, analysis_text, GLUT_BITMAP_HELVETICA_10);
     
+    // Entropy map: peak window entropy per pixel column
+    if (entropy_valid && entropy_profile.window_count > 0) {
+        float plot_x = panel_x + 15;
+        float plot_y = 195;
+        float plot_width = panel_width - 30;
+        float plot_height = 28;
+        draw_rect(plot_x, plot_y, plot_width, plot_height, 0.08f, 0.08f, 0.08f);
+        
+        float high_y = plot_y + plot_height * (float)(ENTROPY_HIGH / 8.0);
+        draw_rect(plot_x, high_y, plot_width, 1, 0.4f, 0.15f, 0.15f);
+        
+        int columns = (int)plot_width;
+        int count = entropy_profile.window_count;
+        flush_ui();
+        for (int col = 0; col < columns; col++) {
+            int first = (int)((long long)col * count / columns);
+            int last = (int)((long long)(col + 1) * count / columns);
+            if (last <= first) last = first + 1;
+            float peak = 0.0f;
+            for (int w = first; w < last && w < count; w++) {
+                if (entropy_profile.windows[w] > peak) peak = entropy_profile.windows[w];
+            }
+            batch_vertex(&ui_batch, plot_x + col, plot_y + plot_height * peak / 8.0f, 0.0f, 0.8f, 1.0f);
+        }
+        batch_flush(&ui_batch, GL_LINE_STRIP);
+    }
+    
     // Controls info
     glColor3f(0.6f, 0.6f, 0.6f);
     draw_text(panel_x + 10, 180, "3D Controls:", GLUT_BITMAP_HELVETICA_10);
     draw_text(panel_x + 10, 165, "Mouse: Rotate view", GLUT_BITMAP_8_BY_13);
     draw_text(panel_x + 10, 150, "Scroll: Zoom in/out", GLUT_BITMAP_8_BY_13);
     draw_text(panel_x + 10, 135, "Arrows: Navigate files", GLUT_BITMAP_8_BY_13);
+    draw_text(panel_x + 10, 120, auto_rotate ? "P: Pause rotation" : "P: Resume rotation", GLUT_BITMAP_8_BY_13);
 }
 
 // Render menu bar
@@ -735,13 +1352,13 @@ void render_status_bar(void) {
     glColor3f(0.8f, 0.8f, 0.8f);
     
     snprintf(status_text, sizeof(status_text), 
-             "Processing: %s | Files analyzed: %d | Evidence: %s", 
-             current_image.image_path, file_count, current_image.evidence_number);
+             "Processing: %.400s | Files analyzed: %d | Evidence: %s", 
+             current_image.image_path, file_table_count(file_table), current_image.evidence_number);
     draw_text(20, 70, status_text, GLUT_BITMAP_HELVETICA_10);
     
     snprintf(status_text, sizeof(status_text), 
-             "Current operation: File signature analysis | Selected: %s", 
-             files[selected_file_index].name);
+             "Current operation: %s | Selected: %s", 
+             operation_status, file_table_name(file_table, selected_file_index));
     draw_text(20, 50, status_text, GLUT_BITMAP_HELVETICA_10);
     
     // Progress bar
@@ -752,10 +1369,8 @@ void render_status_bar(void) {
     // Progress bar background
     draw_rect(20, progress_y, progress_width, progress_height, 0.1f, 0.1f, 0.1f);
     
-    // Progress bar fill (simulate progress)
-    static float progress = 0.45f;
-    progress += 0.001f;
-    if (progress > 1.0f) progress = 0.0f;
+    // Progress bar fill
+    float progress = image_verify ? (float)verify_progress(image_verify) : operation_progress;
     
     draw_rect(20, progress_y, progress_width * progress, progress_height, 0.0f, 0.8f, 1.0f);
     
@@ -767,72 +1382,174 @@ void render_status_bar(void) {
 
 // Update file selection and related data
 void update_file_selection(int index) {
-    if (index < 0 || index >= file_count) return;
+    if (index < 0 || index >= file_table_count(file_table)) return;
     
     selected_file_index = index;
+    selection_generation++;
     
     // Generate new hex data for selected file
     generate_hex_data(index);
+    analyze_file_entropy(index);
     
-    // Update timestamps
-    files[index].created = time(NULL) - (rand() % 86400 * 30); // Random time in last 30 days
-    files[index].modified = files[index].created + (rand() % 86400); // Modified after creation
-    files[index].accessed = time(NULL) - (rand() % 86400); // Recently accessed
+    show_file_in_timeline(index);
     
-    // Calculate file hash (simulate)
+    // Calculate file hash
     calculate_file_hash(index);
     
     // Trigger display update
-    glutPostRedisplay();
+    mark_dirty(PANEL_TREE | PANEL_CENTER | PANEL_RIGHT | PANEL_STATUS);
 }
 
-// Calculate file hash (simulated)
-void calculate_file_hash(int file_index) {
-    if (file_index < 0 || file_index >= file_count) return;
-    
-    // Simulate MD5 hash calculation based on file name and size
-    unsigned int hash = 0;
-    FileEntry* file = &files[file_index];
+// Expand or collapse a directory in the file tree panel
+void toggle_directory(int index) {
+    if (!file_tree_has_children(file_tree, index)) return;
+    if (file_tree_set_expanded(file_tree, index, !file_tree_is_expanded(file_tree, index)) != 0) {
+        snprintf(operation_status, sizeof(operation_status), "Out of memory expanding %s",
+                 file_table_name(file_table, index));
+    }
+    mark_dirty(PANEL_TREE | PANEL_STATUS);
+}
+
+// Hash the whole evidence image in the background, or cancel a running
+// verification
+void start_image_verification(void) {
+    if (image_verify) {
+        verify_cancel(image_verify);
+        verify_cancelled = 1;
+        snprintf(operation_status, sizeof(operation_status), "Cancelling verification");
+        return;
+    }
+    if (!evidence_image) return;
     
-    for (int i = 0; file->name[i]; i++) {
-        hash = hash * 31 + (unsigned int)file->name[i];
+    verify_cancelled = 0;
+    image_verify = verify_start(current_image.image_path, 0);
+    if (!image_verify) {
+        snprintf(operation_status, sizeof(operation_status), "Verification failed to start");
+        return;
+    }
+    operation_progress = 0.0f;
+    snprintf(operation_status, sizeof(operation_status), "Verifying image (MD5/SHA-1, SHA-256 tree)");
+}
+
+// Collect a finished verification and write the acquisition log lines
+void finish_image_verification(void) {
+    VerifyResult result;
+    int status = verify_finish(image_verify, &result);
+    image_verify = NULL;
+    if (status != 0) {
+        operation_progress = 0.0f;
+        snprintf(operation_status, sizeof(operation_status), "Verification %s",
+                 verify_cancelled ? "cancelled" : "failed");
+        return;
     }
-    hash ^= (unsigned int)file->size;
     
-    snprintf(file->md5_hash, sizeof(file->md5_hash), 
-             "%08x%08x%08x%08x", hash, hash ^ 0x12345678u, 
-             hash ^ 0xabcdefabu, hash ^ 0x87654321u);
+    char md5[33], sha1[41], tree[65];
+    hash_format(result.linear.md5, 16, md5);
+    hash_format(result.linear.sha1, 20, sha1);
+    hash_format(result.tree_sha256, 32, tree);
+    printf("Verification of %s\n", current_image.image_path);
+    printf("  Media size:      %lld bytes, %lld segments, %d threads, %.2f s\n",
+           result.media_size, result.segment_count, result.threads, result.seconds);
+    printf("  MD5:             %s%s\n", md5,
+           result.md5_match < 0 ? "" : result.md5_match ? " (matches acquisition)" : " (MISMATCH)");
+    printf("  SHA-1:           %s%s\n", sha1,
+           result.sha1_match < 0 ? "" : result.sha1_match ? " (matches acquisition)" : " (MISMATCH)");
+    printf("  SHA-256 tree:    %s\n", tree);
+    
+    const char* verdict = "computed";
+    if (result.md5_match == 0 || result.sha1_match == 0) verdict = "MISMATCH";
+    else if (result.md5_match > 0 || result.sha1_match > 0) verdict = "verified";
+    operation_progress = 1.0f;
+    snprintf(operation_status, sizeof(operation_status), "Image hash %s: MD5 %s", verdict, md5);
+}
+
+// Calculate file hashes from the file's data runs in the background
+void calculate_file_hash(int file_index) {
+    if (file_index < 0 || file_index >= file_table_count(file_table)) return;
+    if (file_table_digests(file_table, file_index)) return;
+    submit_analysis(file_index, ANALYSIS_HASH, 0);
 }
 
 // Draw text helper function
 void draw_text(float x, float y, const char* text, void* font) {
+    // Queued with the color set for it, as glRasterPos would latch it
+    float color[4];
+    glGetFloatv(GL_CURRENT_COLOR, color);
+    if (font_text(&font_atlas, font, x, y, text, color) == 0) return;
+    
+    flush_ui(); // Text goes over the rectangles queued before it
     glRasterPos2f(x, y);
     while (*text) {
         glutBitmapCharacter(font, *text++);
     }
 }
 
-// Draw rectangle helper function
+// Queue a rectangle; it is drawn at the next flush
 void draw_rect(float x, float y, float width, float height, float r, float g, float b) {
-    glColor3f(r, g, b);
-    glBegin(GL_QUADS);
-    glVertex2f(x, y);
-    glVertex2f(x + width, y);
-    glVertex2f(x + width, y + height);
-    glVertex2f(x, y + height);
-    glEnd();
+    batch_rect(&ui_batch, x, y, width, height, r, g, b);
+}
+
+// Draw the rectangles queued since the last flush
+void flush_ui(void) {
+    batch_flush(&ui_batch, GL_TRIANGLES);
+}
+
+// Whole-window orthographic projection used by every panel
+void set_2d_projection(void) {
+    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
 }
 
 // Reshape callback
 void reshape_callback(int width, int height) {
     glViewport(0, 0, width, height);
-    glutPostRedisplay();
+    mark_dirty(PANEL_ALL);
 }
 
 // Keyboard callback
 void keyboard_callback(unsigned char key, int x, int y) {
     (void)x; (void)y; // Suppress unused parameter warnings
     
+    // Typing a hex offset for the hex tab takes every key until Enter or ESC
+    if (entering_offset) {
+        size_t used = strlen(offset_entry);
+        if (key == 13) {
+            if (used) scroll_hex_view(strtoll(offset_entry, NULL, 16));
+            entering_offset = 0;
+        } else if (key == 27) {
+            entering_offset = 0;
+        } else if ((key == 8 || key == 127) && used) {
+            offset_entry[used - 1] = '\0';
+        } else if (isxdigit(key) && used < 15) { // Up to 0xFFF... within a long long
+            offset_entry[used] = (char)toupper(key);
+            offset_entry[used + 1] = '\0';
+        }
+        mark_dirty(PANEL_CENTER);
+        return;
+    }
+    
+    // Keywords for the index take every key until Enter or ESC
+    if (entering_keywords) {
+        size_t used = strlen(keyword_entry);
+        if (key == 13) {
+            entering_keywords = 0;
+            search_keywords_entry();
+        } else if (key == 27) {
+            entering_keywords = 0;
+        } else if ((key == 8 || key == 127) && used) {
+            keyword_entry[used - 1] = '\0';
+        } else if (key >= 32 && key <= 126 && used + 1 < sizeof(keyword_entry)) {
+            keyword_entry[used] = (char)key;
+            keyword_entry[used + 1] = '\0';
+        }
+        mark_dirty(PANEL_CENTER | PANEL_STATUS);
+        return;
+    }
+    
     switch (key) {
         case 27: // ESC key
             exit(0);
@@ -842,7 +1559,7 @@ void keyboard_callback(unsigned char key, int x, int y) {
         case '3':
         case '4':
             current_tab = key - '1';
-            glutPostRedisplay();
+            mark_dirty(PANEL_CENTER);
             break;
         case 'r':
         case 'R':
@@ -850,48 +1567,136 @@ void keyboard_callback(unsigned char key, int x, int y) {
             camera_angle = 0.0f;
             camera_elevation = 0.0f;
             camera_distance = 10.0f;
-            glutPostRedisplay();
+            mark_dirty(PANEL_RIGHT);
             break;
         case 'f':
         case 'F':
             // Toggle fullscreen (if supported)
             glutFullScreen();
             break;
+        case 'v':
+        case 'V':
+            start_image_verification();
+            mark_dirty(PANEL_STATUS);
+            break;
+        case 'a':
+        case 'A':
+            start_bulk_analysis();
+            mark_dirty(PANEL_STATUS);
+            break;
+        case 'c':
+        case 'C':
+            start_file_carving();
+            mark_dirty(PANEL_STATUS);
+            break;
+        case 's':
+        case 'S':
+            start_string_index();
+            mark_dirty(PANEL_STATUS);
+            break;
+        case 'k':
+        case 'K':
+            current_tab = 1;
+            entering_keywords = 1;
+            keyword_entry[0] = '\0';
+            mark_dirty(PANEL_CENTER);
+            break;
+        case 'l':
+        case 'L':
+            start_keyword_scan();
+            mark_dirty(PANEL_CENTER | PANEL_STATUS);
+            break;
+        case 'x':
+        case 'X':
+            start_hex_export();
+            mark_dirty(PANEL_STATUS);
+            break;
+        case 'g':
+        case 'G':
+            current_tab = 0;
+            entering_offset = 1;
+            offset_entry[0] = '\0';
+            mark_dirty(PANEL_CENTER);
+            break;
+        case 'p':
+        case 'P':
+            auto_rotate = !auto_rotate;
+            mark_dirty(PANEL_RIGHT);
+            break;
+        case '+':
+        case '=':
+        case '-':
+            // Zoom the timeline histogram about its middle
+            if (current_tab == 3) zoom_timeline(key == '-' ? 2.0 : 0.5, 0.5);
+            break;
+        case '[':
+        case ']':
+            if (current_tab == 3) {
+                long long step = (timeline_view_to - timeline_view_from) / 4;
+                set_timeline_view(timeline_view_from + (key == '[' ? -step : step),
+                                  timeline_view_to + (key == '[' ? -step : step));
+            }
+            break;
+        case 13: // Enter
+        case ' ':
+            toggle_directory(selected_file_index);
+            break;
     }
 }
 
 // Special keys callback (arrow keys, etc.)
 void special_callback(int key, int x, int y) {
-    (void)x; (void)y; // Suppress unused parameter warnings
+    (void)y; // Suppress unused parameter warning
     
     switch (key) {
         case GLUT_KEY_UP:
-            if (selected_file_index > 0) {
-                update_file_selection(selected_file_index - 1);
+        case GLUT_KEY_DOWN: {
+            // Step through the shown rows, not the whole table
+            int row = file_tree_entry_row(file_tree, selected_file_index) + (key == GLUT_KEY_UP ? -1 : 1);
+            if (row >= 0 && row < file_tree_row_count(file_tree)) {
+                update_file_selection(file_tree_row_entry(file_tree, row));
+                // Keep the selection inside the scroll window
+                if (row < tree_scroll) scroll_file_tree(row);
+                else if (row >= tree_scroll + TREE_ROWS) scroll_file_tree(row - TREE_ROWS + 1);
             }
             break;
-        case GLUT_KEY_DOWN:
-            if (selected_file_index < file_count - 1) {
-                update_file_selection(selected_file_index + 1);
+        }
+        case GLUT_KEY_HOME:
+        case GLUT_KEY_END: {
+            int row = key == GLUT_KEY_HOME ? 0 : file_tree_row_count(file_tree) - 1;
+            if (row >= 0) {
+                update_file_selection(file_tree_row_entry(file_tree, row));
+                scroll_file_tree(key == GLUT_KEY_HOME ? 0 : row);
             }
             break;
+        }
         case GLUT_KEY_LEFT:
             camera_angle -= 5.0f;
-            glutPostRedisplay();
+            mark_dirty(PANEL_RIGHT);
             break;
         case GLUT_KEY_RIGHT:
             camera_angle += 5.0f;
-            glutPostRedisplay();
+            mark_dirty(PANEL_RIGHT);
             break;
         case GLUT_KEY_PAGE_UP:
-            camera_elevation += 5.0f;
-            if (camera_elevation > 89.0f) camera_elevation = 89.0f;
-            glutPostRedisplay();
-            break;
         case GLUT_KEY_PAGE_DOWN:
-            camera_elevation -= 5.0f;
-            if (camera_elevation < -89.0f) camera_elevation = -89.0f;
-            glutPostRedisplay();
+            // Over the hex tab they page through the file
+            if (current_tab == 0 && x > WINDOW_WIDTH * 0.25f && x < WINDOW_WIDTH * 0.67f) {
+                int step = key == GLUT_KEY_PAGE_UP ? -HEX_SCREEN_BYTES : HEX_SCREEN_BYTES;
+                scroll_hex_view(hex_view_offset(hex_view) + step);
+            } else if (current_tab == 1 && x > WINDOW_WIDTH * 0.25f && x < WINDOW_WIDTH * 0.67f) {
+                scroll_text_strings(text_scroll + (key == GLUT_KEY_PAGE_UP ? -HEX_ROWS : HEX_ROWS));
+            } else if (current_tab == 3 && x > WINDOW_WIDTH * 0.25f && x < WINDOW_WIDTH * 0.67f) {
+                scroll_timeline((long long)timeline_top + (key == GLUT_KEY_PAGE_UP ? -TIMELINE_ROWS : TIMELINE_ROWS));
+            } else if (key == GLUT_KEY_PAGE_UP) {
+                camera_elevation += 5.0f;
+                if (camera_elevation > 89.0f) camera_elevation = 89.0f;
+                mark_dirty(PANEL_RIGHT);
+            } else {
+                camera_elevation -= 5.0f;
+                if (camera_elevation < -89.0f) camera_elevation = -89.0f;
+                mark_dirty(PANEL_RIGHT);
+            }
             break;
     }
 }
@@ -909,33 +1714,65 @@ void mouse_callback(int button, int state, int x, int y) {
         float normalized_y = 1.0f - (float)y / WINDOW_HEIGHT;
         
         if (normalized_x < 0.25f && normalized_y > 0.2f && normalized_y < 0.88f) {
-            // Calculate which file was clicked
-            int file_index = (int)((0.88f - normalized_y) * file_count / 0.68f);
-            if (file_index >= 0 && file_index < file_count) {
-                update_file_selection(file_index);
+            // Row highlights are centred 5 pixels below each baseline
+            int row = (int)floorf((TREE_FIRST_ROW_Y + 7.5f - normalized_y * WINDOW_HEIGHT) / TREE_ROW_HEIGHT);
+            if (row >= 0 && row < TREE_ROWS) row += tree_scroll;
+            else row = -1;
+            if (row >= 0 && row < file_tree_row_count(file_tree)) {
+                int file_index = file_tree_row_entry(file_tree, row);
+                // A second click on the selected directory opens or closes it
+                if (file_index == selected_file_index) toggle_directory(file_index);
+                else update_file_selection(file_index);
             }
         }
         
+        // A click on the histogram lists the events from that time on
+        long long time;
+        if (current_tab == 3 && timeline_histogram_hit(x, y, &time)) {
+            scroll_timeline((long long)timeline_find(timeline, 0, time));
+        }
+        
         // Check if click is in tab area
         if (normalized_x > 0.25f && normalized_x < 0.67f && 
             normalized_y > 0.55f && normalized_y < 0.6f) {
             int tab_index = (int)((normalized_x - 0.28f) * 4 / 0.25f);
             if (tab_index >= 0 && tab_index < 4) {
                 current_tab = tab_index;
-                glutPostRedisplay();
+                mark_dirty(PANEL_CENTER);
             }
         }
     }
     
-    // Mouse wheel for zooming 3D view
-    if (button == 3) { // Wheel up
+    // Mouse wheel scrolls the file tree or the hex tab over their panels,
+    // zooms the 3D view elsewhere
+    if ((button == 3 || button == 4) && x < WINDOW_WIDTH * 0.25f) {
+        if (state == GLUT_DOWN) {
+            scroll_file_tree(tree_scroll + (button == 3 ? -3 : 3));
+            mark_dirty(PANEL_TREE);
+        }
+    } else if ((button == 3 || button == 4) && x < WINDOW_WIDTH * 0.67f) {
+        if (state == GLUT_DOWN && current_tab == 0) {
+            scroll_hex_view(hex_view_offset(hex_view) + (button == 3 ? -3 : 3) * HEX_VIEW_ROW_BYTES);
+        } else if (state == GLUT_DOWN && current_tab == 1) {
+            scroll_text_strings(text_scroll + (button == 3 ? -3 : 3));
+        } else if (state == GLUT_DOWN && current_tab == 3) {
+            // Over the histogram the wheel zooms around the pointer
+            long long time;
+            if (timeline_histogram_hit(x, y, &time)) {
+                zoom_timeline(button == 3 ? 0.8 : 1.25,
+                              (double)(time - timeline_view_from) / (double)(timeline_view_to - timeline_view_from));
+            } else {
+                scroll_timeline((long long)timeline_top + (button == 3 ? -3 : 3));
+            }
+        }
+    } else if (button == 3) { // Wheel up
         camera_distance -= 1.0f;
         if (camera_distance < 2.0f) camera_distance = 2.0f;
-        glutPostRedisplay();
+        mark_dirty(PANEL_RIGHT);
     } else if (button == 4) { // Wheel down
         camera_distance += 1.0f;
         if (camera_distance > 50.0f) camera_distance = 50.0f;
-        glutPostRedisplay();
+        mark_dirty(PANEL_RIGHT);
     }
     
     // Suppress unused variable warnings
@@ -959,7 +1796,7 @@ void motion_callback(int x, int y) {
             if (camera_elevation > 89.0f) camera_elevation = 89.0f;
             if (camera_elevation < -89.0f) camera_elevation = -89.0f;
             
-            glutPostRedisplay();
+            mark_dirty(PANEL_RIGHT);
         }
     }
     
@@ -971,22 +1808,804 @@ void motion_callback(int x, int y) {
 void timer_callback(int value) {
     (void)value; // Suppress unused parameter warning
     
-    // Update any animations here
-    camera_angle += 0.2f; // Slow auto-rotation of 3D view
-    if (camera_angle >= 360.0f) camera_angle = 0.0f;
+    // Only panels something changed in are redrawn; an idle tick draws nothing
+    if (auto_rotate) {
+        camera_angle += 0.2f; // Slow auto-rotation of 3D view
+        if (camera_angle >= 360.0f) camera_angle = 0.0f;
+        mark_dirty(PANEL_RIGHT);
+    }
+    
+    if (image_verify) {
+        if (verify_done(image_verify)) finish_image_verification();
+        mark_dirty(PANEL_STATUS); // Progress bar
+    }
+    
+    // Read the hex tab's next screen while idle
+    hex_view_prefetch(hex_view, 2);
+    extend_text_strings();
+    
+    // Publish finished background jobs, a bounded batch per tick
+    if (analysis_pool) {
+        pool_drain(analysis_pool, 256);
+        schedule_bulk_analysis();
+        schedule_file_carving();
+        schedule_hex_export();
+        schedule_string_index();
+        schedule_keyword_index();
+        schedule_keyword_scan();
+    }
     
-    glutPostRedisplay();
     glutTimerFunc(50, timer_callback, 0); // 20 FPS
 }
 
-// Unused functions (kept for completeness)
+// Entropy of a file's data runs, or of its preview bytes when the entry
+// has no runs in the image
 void analyze_file_entropy(int file_index) {
-    (void)file_index; // Suppress unused parameter warning
-    // Placeholder for entropy analysis
+    entropy_valid = 0;
+    if (file_index < 0 || file_index >= file_table_count(file_table)) return;
+    
+    // Files with data runs are analysed in the background
+    entropy_pending = submit_analysis(file_index, ANALYSIS_ENTROPY, 0) == 0;
+    if (entropy_pending) return;
+    
+    int status = -1;
+    if (preview_length > 0 &&
+               (file_table_type(file_table, file_index) != FILE_TYPE_FOLDER ||
+                (file_index == 0 && evidence_image))) {
+        status = entropy_profile_bytes(preview_bytes, (size_t)preview_length,
+                                       PREVIEW_ENTROPY_WINDOW, &entropy_profile);
+        entropy_from_preview = 1;
+    }
+    if (status != 0) return;
+    
+    entropy_valid = 1;
+}
+
+// Queue a background job for a file's data runs. Returns -1 when the
+// file has no runs or there is no pool.
+int submit_analysis(int file_index, AnalysisKind kind, int bulk) {
+    int run_count;
+    const ImageRun* runs = file_table_runs(file_table, file_index, &run_count);
+    if (!analysis_pool || !runs) return -1;
+    
+    PoolJob* job = pool_job_new(analysis_work, analysis_done,
+                                sizeof(AnalysisJob) + (size_t)run_count * sizeof(ImageRun));
+    if (!job) return -1;
+    AnalysisJob* analysis = job->data;
+    analysis->kind = kind;
+    analysis->file_index = file_index;
+    analysis->generation = selection_generation;
+    analysis->bulk = bulk;
+    analysis->run_count = run_count;
+    memcpy(analysis->runs, runs, (size_t)run_count * sizeof(ImageRun));
+    
+    // The selected file goes ahead of a running bulk pass
+    pool_submit(analysis_pool, job, !bulk);
+    return 0;
+}
+
+// Queue the small files collected in hash_batch as one bulk job, so MD5
+// runs over them in the multi-buffer lanes. Returns -1 when nothing was
+// queued.
+int submit_hash_batch(void) {
+    int count = hash_batch_count;
+    hash_batch_count = 0;
+    if (!analysis_pool || count == 0) return -1;
+
+    int total = 0;
+    for (int i = 0; i < count; i++) {
+        int run_count;
+        file_table_runs(file_table, hash_batch[i], &run_count);
+        total += run_count;
+    }
+    PoolJob* job = pool_job_new(analysis_work, analysis_done,
+                                sizeof(AnalysisJob) + (size_t)total * sizeof(ImageRun));
+    if (!job) return -1;
+    AnalysisJob* analysis = job->data;
+    analysis->kind = ANALYSIS_HASH_BATCH;
+    analysis->file_index = hash_batch[0];
+    analysis->generation = selection_generation;
+    analysis->bulk = 1;
+    analysis->batch_count = count;
+    analysis->run_count = 0;
+    for (int i = 0; i < count; i++) {
+        int run_count;
+        const ImageRun* runs = file_table_runs(file_table, hash_batch[i], &run_count);
+        analysis->batch_files[i] = hash_batch[i];
+        analysis->batch_run_counts[i] = run_count;
+        memcpy(analysis->runs + analysis->run_count, runs, (size_t)run_count * sizeof(ImageRun));
+        analysis->run_count += run_count;
+    }
+    pool_submit(analysis_pool, job, 0);
+    return 0;
+}
+
+void* open_worker_image(void* path) {
+    return image_open((const char*)path);
+}
+
+void close_worker_image(void* image) {
+    image_close(image);
+}
+
+// Runs on a worker thread with that worker's image handle
+void analysis_work(PoolJob* job, void* worker) {
+    AnalysisJob* analysis = job->data;
+    EvidenceImage* image = worker;
+    analysis->status = -1;
+    if (!image) return;
+    
+    switch (analysis->kind) {
+        case ANALYSIS_HASH:
+            analysis->status = hash_image_runs(image, analysis->runs, analysis->run_count,
+                                               HASH_ALL, &analysis->digests);
+            break;
+        case ANALYSIS_HASH_BATCH: {
+            const ImageRun* runs[HASH_BATCH_LANES];
+            int first = 0;
+            for (int i = 0; i < analysis->batch_count; i++) {
+                runs[i] = analysis->runs + first;
+                first += analysis->batch_run_counts[i];
+            }
+            analysis->status = hash_image_runs_batch(image, runs, analysis->batch_run_counts, analysis->batch_count,
+                                                     HASH_ALL, analysis->batch_digests);
+            break;
+        }
+        case ANALYSIS_ENTROPY:
+            analysis->status = entropy_profile_runs(image, analysis->runs, analysis->run_count,
+                                                    ENTROPY_WINDOW, &analysis->profile);
+            break;
+        case ANALYSIS_SIGNATURE: {
+            unsigned char header[SIG_HEADER_SIZE];
+            long n = image_read_runs(image, analysis->runs, analysis->run_count, 0,
+                                     header, sizeof(header));
+            if (n < 0) break;
+            analysis->signature = sig_format_id(sig_classify(header, (size_t)n));
+            analysis->status = 0;
+            break;
+        }
+        case ANALYSIS_CARVE:
+            analysis->status = carve_scan_extents(image, carve_extents, carve_extent_count,
+                                                  analysis->scan_start, analysis->scan_end,
+                                                  &analysis->carved, &carve_scanned, &carve_cancel);
+            break;
+        case ANALYSIS_STRINGS:
+            analysis->status = string_scan_image(image, analysis->scan_start, analysis->scan_end,
+                                                 STRING_MIN_LENGTH, &analysis->strings,
+                                                 &strings_scanned, &strings_cancel);
+            break;
+        case ANALYSIS_INDEX:
+            analysis->status = text_index_build(index_path, image, &string_index, analysis->extents,
+                                                analysis->extent_count, &index_progress, &strings_cancel);
+            break;
+        case ANALYSIS_KEYWORDS:
+            analysis->status = keyword_scan_image(keyword_scanner, image, analysis->scan_start, analysis->scan_end,
+                                                  &analysis->keyword_hits, &scan_scanned, &scan_cancel);
+            break;
+        case ANALYSIS_EXPORT:
+            analysis->status = hex_dump_export(image, analysis->runs, analysis->run_count, export_length,
+                                               export_path, &export_done, &export_cancel);
+            break;
+    }
+}
+
+// Runs on the UI thread: publish the result to the file table and panels
+void analysis_done(PoolJob* job) {
+    AnalysisJob* analysis = job->data;
+    if (analysis->bulk) bulk_done++;
+    int current = analysis->file_index == selected_file_index &&
+                  analysis->generation == selection_generation;
+    
+    switch (analysis->kind) {
+        case ANALYSIS_HASH:
+            if (analysis->status == 0) {
+                file_table_set_digests(file_table, analysis->file_index, &analysis->digests);
+            }
+            break;
+        case ANALYSIS_HASH_BATCH:
+            for (int i = 0; i < analysis->batch_count && analysis->status == 0; i++) {
+                file_table_set_digests(file_table, analysis->batch_files[i], &analysis->batch_digests[i]);
+                if (analysis->batch_files[i] == selected_file_index) mark_dirty(PANEL_CENTER | PANEL_RIGHT);
+            }
+            break;
+        case ANALYSIS_ENTROPY:
+            if (current) entropy_pending = 0;
+            if (analysis->status == 0) {
+                file_table_record(file_table, analysis->file_index)->entropy =
+                    (float)analysis->profile.entropy;
+            }
+            if (analysis->status == 0 && current) {
+                // Hand the profile over to the panel instead of copying it
+                entropy_profile_free(&entropy_profile);
+                entropy_profile = analysis->profile;
+                entropy_from_preview = 0;
+                entropy_valid = 1;
+            } else {
+                entropy_profile_free(&analysis->profile);
+            }
+            break;
+        case ANALYSIS_SIGNATURE:
+            if (analysis->status == 0) {
+                apply_signature(analysis->file_index, analysis->signature);
+                mark_dirty(PANEL_TREE | PANEL_RIGHT); // Type colors
+            }
+            break;
+        case ANALYSIS_CARVE:
+            carve_jobs--;
+            if (analysis->status == 0 && analysis->carved.count > 0) {
+                add_carved_files(&analysis->carved);
+                mark_dirty(PANEL_TREE | PANEL_RIGHT);
+            }
+            carve_result_free(&analysis->carved);
+            break;
+        case ANALYSIS_STRINGS:
+            strings_jobs--;
+            if (analysis->status == 0 && string_list_append(&string_index, &analysis->strings) != 0) {
+                // Out of memory: stop and report what was indexed
+                __atomic_store_n(&strings_cancel, 1, __ATOMIC_RELAXED);
+            }
+            string_list_free(&analysis->strings);
+            break;
+        case ANALYSIS_KEYWORDS:
+            scan_jobs--;
+            if (analysis->status == 0 && keyword_hit_list_append(&scan_hits, &analysis->keyword_hits) != 0) {
+                __atomic_store_n(&scan_cancel, 1, __ATOMIC_RELAXED);
+            }
+            keyword_hit_list_free(&analysis->keyword_hits);
+            break;
+        case ANALYSIS_INDEX:
+            indexing = 0;
+            free(analysis->extents);
+            if (analysis->status == 0) {
+                // The new file replaced the old one; its mapping stays valid until closed
+                text_index_close(text_index);
+                text_index = text_index_open(index_path, evidence_image);
+            }
+            if (text_index && analysis->status == 0) {
+                snprintf(operation_status, sizeof(operation_status), "Keyword index of %zu strings in %.120s",
+                         text_index_string_count(text_index), index_path);
+            } else {
+                snprintf(operation_status, sizeof(operation_status), "%s",
+                         strings_cancel ? "Keyword index cancelled" : "Keyword index failed");
+            }
+            operation_progress = 1.0f;
+            mark_dirty(PANEL_STATUS);
+            break;
+        case ANALYSIS_EXPORT:
+            exporting = 0;
+            if (analysis->status != 0) {
+                snprintf(operation_status, sizeof(operation_status), "Hex export to %.120s failed", export_path);
+            } else {
+                snprintf(operation_status, sizeof(operation_status), "%s hex to %.120s",
+                         export_cancel ? "Export cancelled, partial" : "Exported", export_path);
+            }
+            operation_progress = 1.0f;
+            mark_dirty(PANEL_STATUS);
+            break;
+    }
+    if (current) mark_dirty(PANEL_CENTER | PANEL_RIGHT);
+}
+
+// Hash and measure the entropy of every file with data runs
+void start_bulk_analysis(void) {
+    if (!analysis_pool || bulk_cursor >= 0) return;
+    bulk_cursor = 0;
+    bulk_done = 0;
+    bulk_total = 0;
+    hash_batch_count = 0;
+    snprintf(operation_status, sizeof(operation_status), "Analysing files (hash: %s; entropy)", hash_engine_name());
+}
+
+// Keep a bounded number of bulk jobs queued so a multi-TB volume does not
+// materialise millions of jobs at once
+void schedule_bulk_analysis(void) {
+    if (bulk_cursor < 0) return;
+    mark_dirty(PANEL_STATUS); // Progress and file count
+    
+    int count = file_table_count(file_table);
+    int limit = pool_thread_count(analysis_pool) * BULK_QUEUE_DEPTH;
+    while (bulk_cursor < count && pool_pending(analysis_pool) < limit) {
+        int index = bulk_cursor++;
+        int run_count;
+        if (!file_table_digests(file_table, index) && file_table_runs(file_table, index, &run_count)) {
+            if (file_table_size(file_table, index) <= HASH_BATCH_SIZE) {
+                hash_batch[hash_batch_count++] = index;
+                if (hash_batch_count == HASH_BATCH_LANES && submit_hash_batch() == 0) bulk_total++;
+            } else if (submit_analysis(index, ANALYSIS_HASH, 1) == 0) {
+                bulk_total++;
+            }
+        }
+        if (file_table_record(file_table, index)->entropy < 0.0f &&
+            submit_analysis(index, ANALYSIS_ENTROPY, 1) == 0) bulk_total++;
+        if (!(file_table_record(file_table, index)->flags & FILE_FLAG_CLASSIFIED) &&
+            file_table_type(file_table, index) != FILE_TYPE_FOLDER &&
+            submit_analysis(index, ANALYSIS_SIGNATURE, 1) == 0) bulk_total++;
+    }
+    // The last few small files go out as a short batch
+    if (bulk_cursor >= count && submit_hash_batch() == 0) bulk_total++;
+    
+    if (bulk_cursor >= count && bulk_done >= bulk_total) {
+        bulk_cursor = -1;
+        operation_progress = 1.0f;
+        snprintf(operation_status, sizeof(operation_status), "Analysed %d files", count);
+    } else {
+        // Scheduled share of the table, scaled by how much of it has completed
+        float scheduled = (float)bulk_cursor / (float)count;
+        operation_progress = bulk_total ? scheduled * (float)bulk_done / (float)bulk_total : scheduled;
+    }
+}
+
+// Carve files out of unallocated space, or cancel a running pass. Space
+// the parsed file systems allocate, to metadata or to live files, is left
+// out; with no file system parsed the whole image is unallocated.
+void start_file_carving(void) {
+    if (!analysis_pool) return;
+    if (carve_next >= 0) {
+        __atomic_store_n(&carve_cancel, 1, __ATOMIC_RELAXED);
+        carve_extent_next = carve_extent_count;
+        return;
+    }
+    // The extents are read by the jobs, so they are only replaced between passes
+    free(carve_extents);
+    carve_extents = NULL;
+    carve_extent_count = carve_unallocated(file_table, allocated_space.runs, allocated_space.count,
+                                           image_size(evidence_image), &carve_extents);
+    if (carve_extent_count < 0) {
+        carve_extent_count = 0;
+        snprintf(operation_status, sizeof(operation_status), "Carving failed: out of memory");
+        return;
+    }
+    carve_total = 0;
+    for (int i = 0; i < carve_extent_count; i++) carve_total += carve_extents[i].length;
+    carve_extent_next = 0;
+    carve_next = 0;
+    carve_scanned = 0;
+    carve_cancel = 0;
+    snprintf(operation_status, sizeof(operation_status), "Carving %.1f MB of unallocated space (%s)",
+             (double)carve_total / (1024.0 * 1024.0), carve_engine_name());
+}
+
+// Split the image into jobs, a bounded number queued at a time, skipping
+// allocated space. Each job owns the headers in the unallocated parts of
+// its range and follows their footers past the end.
+void schedule_file_carving(void) {
+    if (carve_next < 0) return;
+    mark_dirty(PANEL_STATUS);
+    
+    int limit = pool_thread_count(analysis_pool) * BULK_QUEUE_DEPTH;
+    while (carve_extent_next < carve_extent_count && pool_pending(analysis_pool) < limit) {
+        const ImageRun* extent = &carve_extents[carve_extent_next];
+        if (carve_next < extent->offset) carve_next = extent->offset;
+        PoolJob* job = pool_job_new(analysis_work, analysis_done, sizeof(AnalysisJob));
+        if (!job) break;
+        AnalysisJob* analysis = job->data;
+        analysis->kind = ANALYSIS_CARVE;
+        analysis->file_index = -1;
+        analysis->scan_start = carve_next;
+        analysis->scan_end = carve_next + CARVE_JOB_SIZE;
+        carve_next = analysis->scan_end;
+        while (carve_extent_next < carve_extent_count &&
+               carve_extents[carve_extent_next].offset + carve_extents[carve_extent_next].length <= carve_next) {
+            carve_extent_next++;
+        }
+        carve_jobs++;
+        pool_submit(analysis_pool, job, 0);
+    }
+    
+    if (carve_extent_next >= carve_extent_count && carve_jobs == 0) {
+        carve_next = -1;
+        operation_progress = 1.0f;
+        snprintf(operation_status, sizeof(operation_status), "%s %d files from unallocated space",
+                 carve_cancel ? "Carving cancelled," : "Carved", carved_count);
+    } else {
+        long long scanned = __atomic_load_n(&carve_scanned, __ATOMIC_RELAXED);
+        operation_progress = carve_total ? (float)scanned / (float)carve_total : 0.0f;
+    }
+}
+
+// Write the selected file, or the whole image for the root, as a hex dump
+// report next to the working directory, or cancel a running export
+void start_hex_export(void) {
+    if (!analysis_pool) return;
+    if (exporting) {
+        __atomic_store_n(&export_cancel, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    int run_count;
+    const ImageRun* runs = file_table_runs(file_table, selected_file_index, &run_count);
+    ImageRun whole = {0, evidence_image ? image_size(evidence_image) : 0};
+    long long length = file_table_size(file_table, selected_file_index);
+    if (!runs && selected_file_index == 0 && whole.length > 0) {
+        runs = &whole;
+        run_count = 1;
+        length = whole.length;
+    }
+    if (!runs) {
+        snprintf(operation_status, sizeof(operation_status), "No image data to export for %s",
+                 file_table_name(file_table, selected_file_index));
+        return;
+    }
+    
+    PoolJob* job = pool_job_new(analysis_work, analysis_done,
+                                sizeof(AnalysisJob) + (size_t)run_count * sizeof(ImageRun));
+    if (!job) return;
+    AnalysisJob* analysis = job->data;
+    analysis->kind = ANALYSIS_EXPORT;
+    analysis->file_index = -1;
+    analysis->run_count = run_count;
+    memcpy(analysis->runs, runs, (size_t)run_count * sizeof(ImageRun));
+    
+    // Named after the file, with path separators kept out of the name
+    snprintf(export_path, sizeof(export_path), "%s.hex.txt", file_table_name(file_table, selected_file_index));
+    for (char* c = export_path; *c; c++) {
+        if (*c == '/' || *c == '\\') *c = '_';
+    }
+    export_length = length;
+    export_done = 0;
+    export_cancel = 0;
+    exporting = 1;
+    snprintf(operation_status, sizeof(operation_status), "Exporting hex to %.120s (X to cancel)", export_path);
+    pool_submit(analysis_pool, job, 1);
+}
+
+void schedule_hex_export(void) {
+    if (!exporting) return;
+    mark_dirty(PANEL_STATUS);
+    operation_progress = export_length ?
+        (float)__atomic_load_n(&export_done, __ATOMIC_RELAXED) / (float)export_length : 0.0f;
 }
 
-void simulate_file_analysis(void) {
-    // Placeholder for file analysis simulation
+// Find the strings of the whole image for the index, or cancel a running pass
+void start_string_index(void) {
+    if (!analysis_pool) return;
+    if (indexing) {
+        __atomic_store_n(&strings_cancel, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (strings_next >= 0) {
+        __atomic_store_n(&strings_cancel, 1, __ATOMIC_RELAXED);
+        strings_next = image_size(evidence_image);
+        return;
+    }
+    string_list_free(&string_index);
+    strings_next = 0;
+    strings_scanned = 0;
+    strings_cancel = 0;
+    snprintf(operation_status, sizeof(operation_status), "Indexing strings of the image (%s)",
+             string_engine_name());
+}
+
+// Split the image into jobs like carving. Each job owns the strings that
+// start in its range; their order is restored once all are in.
+void schedule_string_index(void) {
+    if (strings_next < 0) return;
+    mark_dirty(PANEL_STATUS);
+    
+    long long size = image_size(evidence_image);
+    int limit = pool_thread_count(analysis_pool) * BULK_QUEUE_DEPTH;
+    while (strings_next < size && pool_pending(analysis_pool) < limit) {
+        PoolJob* job = pool_job_new(analysis_work, analysis_done, sizeof(AnalysisJob));
+        if (!job) break;
+        AnalysisJob* analysis = job->data;
+        analysis->kind = ANALYSIS_STRINGS;
+        analysis->file_index = -1;
+        analysis->scan_start = strings_next;
+        analysis->scan_end = strings_next + STRINGS_JOB_SIZE < size ? strings_next + STRINGS_JOB_SIZE : size;
+        strings_next = analysis->scan_end;
+        strings_jobs++;
+        pool_submit(analysis_pool, job, 0);
+    }
+    
+    if (strings_next >= size && strings_jobs == 0) {
+        strings_next = -1;
+        string_list_sort(&string_index);
+        operation_progress = 1.0f;
+        snprintf(operation_status, sizeof(operation_status), "%s %zu strings in the image",
+                 strings_cancel ? "Indexing cancelled," : "Indexed", string_index.count);
+        if (!strings_cancel) start_keyword_index();
+    } else {
+        operation_progress = size ? (float)__atomic_load_n(&strings_scanned, __ATOMIC_RELAXED) / (float)size : 0.0f;
+    }
+}
+
+// Write the keyword index of the strings just found. The strings stay
+// untouched until the job is done: S cancels rather than restarts.
+void start_keyword_index(void) {
+    PoolJob* job = pool_job_new(analysis_work, analysis_done, sizeof(AnalysisJob));
+    if (!job) return;
+    AnalysisJob* analysis = job->data;
+    analysis->kind = ANALYSIS_INDEX;
+    analysis->file_index = -1;
+    analysis->extents = text_index_extents(file_table, &analysis->extent_count);
+    index_progress = 0;
+    indexing = 1;
+    snprintf(operation_status, sizeof(operation_status), "Writing keyword index of %zu strings",
+             string_index.count);
+    pool_submit(analysis_pool, job, 1);
+}
+
+void schedule_keyword_index(void) {
+    if (!indexing) return;
+    mark_dirty(PANEL_STATUS);
+    operation_progress = string_index.count ?
+        (float)__atomic_load_n(&index_progress, __ATOMIC_RELAXED) / (float)(2 * string_index.count) : 0.0f;
+}
+
+// Search the index for the comma-separated keywords typed after K; an
+// empty entry goes back to the selected file's strings
+void search_keywords_entry(void) {
+    char* keywords[64];
+    int count = 0;
+    for (char* keyword = strtok(keyword_entry, ","); keyword && count < 64; keyword = strtok(NULL, ",")) {
+        while (*keyword == ' ') keyword++;
+        size_t length = strlen(keyword);
+        while (length > 0 && keyword[length - 1] == ' ') keyword[--length] = '\0';
+        if (length > 0) keywords[count++] = keyword;
+    }
+    
+    search_hits.count = 0;
+    search_active = count > 0 && text_index;
+    if (count == 0) scan_shown = 0;
+    search_keywords = count;
+    text_scroll = 0;
+    if (count > 0 && !text_index) {
+        snprintf(operation_status, sizeof(operation_status), "No keyword index yet: press S to build it");
+        return;
+    }
+    if (!search_active) return;
+    
+    double start = glutGet(GLUT_ELAPSED_TIME);
+    if (text_index_search(text_index, (const char* const*)keywords, count, &search_hits) != 0) {
+        snprintf(operation_status, sizeof(operation_status), "Out of memory searching keywords");
+    } else {
+        snprintf(operation_status, sizeof(operation_status), "%zu keyword hits in %.0f ms",
+                 search_hits.count, glutGet(GLUT_ELAPSED_TIME) - start);
+    }
+}
+
+// Keywords for the raw scan, one per line; blank lines and lines
+// starting with # are skipped. The regex subset is always scanned for.
+void load_keyword_list(const char* path) {
+    char** keywords = NULL;
+    int count = 0, capacity = 0;
+    FILE* file = path ? fopen(path, "r") : NULL;
+    if (path && !file) printf("Cannot read keyword list %s\n", path);
+    
+    char line[512];
+    while (file && fgets(line, sizeof(line), file)) {
+        size_t length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        if (length == 0 || line[0] == '#') continue;
+        if (length > KEYWORD_MAX_LENGTH) {
+            printf("Keyword too long, skipped: %.40s...\n", line);
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            char** grown = realloc(keywords, (size_t)capacity * sizeof(char*));
+            if (!grown) break;
+            keywords = grown;
+        }
+        keywords[count] = strdup(line);
+        if (!keywords[count]) break;
+        count++;
+    }
+    if (file) fclose(file);
+    
+    keyword_scanner = keyword_scanner_create((const char* const*)keywords, count, KEYWORD_PATTERN_ALL);
+    for (int i = 0; i < count; i++) free(keywords[i]);
+    free(keywords);
+    if (keyword_scanner) printf("Raw keyword scan: %d keywords and %d patterns\n", count,
+                                keyword_pattern_count(keyword_scanner) - count);
+}
+
+// Scan the raw image for the keyword list, or cancel a running scan
+void start_keyword_scan(void) {
+    if (!analysis_pool || !keyword_scanner) return;
+    if (scan_next >= 0) {
+        __atomic_store_n(&scan_cancel, 1, __ATOMIC_RELAXED);
+        scan_next = image_size(evidence_image);
+        return;
+    }
+    keyword_hit_list_free(&scan_hits);
+    scan_next = 0;
+    scan_scanned = 0;
+    scan_cancel = 0;
+    current_tab = 1;
+    search_active = 0;
+    scan_shown = 1;
+    text_scroll = 0;
+    snprintf(operation_status, sizeof(operation_status), "Scanning the image for %d patterns (%s)",
+             keyword_pattern_count(keyword_scanner), keyword_engine_name());
+}
+
+// Split the image into jobs like carving. Each job owns the hits that
+// start in its range; once all are in they are sorted and tied to files.
+void schedule_keyword_scan(void) {
+    if (scan_next < 0) return;
+    mark_dirty(PANEL_STATUS);
+    
+    long long size = image_size(evidence_image);
+    int limit = pool_thread_count(analysis_pool) * BULK_QUEUE_DEPTH;
+    while (scan_next < size && pool_pending(analysis_pool) < limit) {
+        PoolJob* job = pool_job_new(analysis_work, analysis_done, sizeof(AnalysisJob));
+        if (!job) break;
+        AnalysisJob* analysis = job->data;
+        analysis->kind = ANALYSIS_KEYWORDS;
+        analysis->file_index = -1;
+        analysis->scan_start = scan_next;
+        analysis->scan_end = scan_next + KEYWORD_JOB_SIZE < size ? scan_next + KEYWORD_JOB_SIZE : size;
+        scan_next = analysis->scan_end;
+        scan_jobs++;
+        pool_submit(analysis_pool, job, 0);
+    }
+    
+    if (scan_next >= size && scan_jobs == 0) {
+        scan_next = -1;
+        keyword_hit_list_sort(&scan_hits);
+        int extent_count = 0;
+        TextIndexExtent* extents = text_index_extents(file_table, &extent_count);
+        for (size_t i = 0; i < scan_hits.count; i++) {
+            KeywordHit* hit = &scan_hits.hits[i];
+            const TextIndexExtent* extent = text_index_find_extent(extents, extent_count, hit->offset);
+            if (!extent) continue;
+            hit->file_index = extent->file_index;
+            hit->file_offset = extent->file_offset + (hit->offset - extent->image_offset);
+        }
+        free(extents);
+        operation_progress = 1.0f;
+        snprintf(operation_status, sizeof(operation_status), "%s %zu raw keyword hits",
+                 scan_cancel ? "Scan cancelled," : "Found", scan_hits.count);
+        mark_dirty(PANEL_CENTER);
+    } else {
+        operation_progress = size ? (float)__atomic_load_n(&scan_scanned, __ATOMIC_RELAXED) / (float)size : 0.0f;
+    }
+}
+
+// Turn every file's MACB times into timeline events and store them
+// sorted next to the keyword index. The file table is parsed again each
+// session, so the timeline is too.
+void build_timeline(void) {
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    const char* base = strrchr(current_image.image_path, '/');
+    snprintf(timeline_path, sizeof(timeline_path), "%.1000s.timeline", base ? base + 1 : current_image.image_path);
+    timeline = timeline_create(timeline_path);
+    if (!timeline) {
+        fprintf(stderr, "Warning: cannot write timeline %s\n", timeline_path);
+        return;
+    }
+    
+    int status = 0;
+    int count = file_table_count(file_table);
+    for (int i = 0; i < count && status == 0; i++) {
+        const FileRecord* record = file_table_record(file_table, i);
+        status = timeline_add_macb(timeline, TIMELINE_SOURCE_FILE, (unsigned int)i, record->modified,
+                                   record->accessed, record->changed, record->created);
+    }
+    if (status == 0) status = timeline_merge(timeline, NULL, NULL);
+    if (status != 0) {
+        fprintf(stderr, "Warning: timeline %s could not be written\n", timeline_path);
+        timeline_close(timeline);
+        timeline = NULL;
+        return;
+    }
+    long long first, last;
+    if (timeline_bounds(timeline, &first, &last) == 0) set_timeline_view(first, last + 1);
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    printf("Timeline: %zu events in %.2f s\n", timeline_count(timeline),
+           (double)(finished.tv_sec - started.tv_sec) + (double)(finished.tv_nsec - started.tv_nsec) / 1e9);
+}
+
+// Put event first on the top row of the timeline tab, panning the
+// histogram to it when it is out of view
+void scroll_timeline(long long first) {
+    long long last = timeline ? (long long)timeline_count(timeline) - TIMELINE_ROWS : 0;
+    if (first > last) first = last;
+    if (first < 0) first = 0;
+    timeline_top = (size_t)first;
+    size_t count;
+    const TimelineEvent* events = timeline ? timeline_run(timeline, 0, &count) : NULL;
+    if (events && timeline_top < count &&
+        (events[timeline_top].time < timeline_view_from || events[timeline_top].time >= timeline_view_to)) {
+        long long half = (timeline_view_to - timeline_view_from) / 2;
+        set_timeline_view(events[timeline_top].time - half, events[timeline_top].time + half);
+    }
+    mark_dirty(PANEL_CENTER);
+}
+
+// Show [from, to) in the histogram: at least a minute, at most the whole
+// timeline with half of it to spare on either side, never off the events
+void set_timeline_view(long long from, long long to) {
+    long long first, last;
+    if (!timeline || timeline_bounds(timeline, &first, &last) != 0) return;
+    long long span = last + 1 - first;
+    long long widest = span * 2 > 60 ? span * 2 : 60;
+    long long width = to - from;
+    if (width < 60) width = 60;
+    if (width > widest) width = widest;
+    long long middle = from + (to - from) / 2;
+    from = middle - width / 2;
+    if (from > last) from = last;
+    if (from + width <= first) from = first - width + 1;
+    timeline_view_from = from;
+    timeline_view_to = from + width;
+    mark_dirty(PANEL_CENTER);
+}
+
+// Scale the histogram window keeping the time at anchor, a fraction of
+// its width, where it is
+void zoom_timeline(double factor, double anchor) {
+    double width = (double)(timeline_view_to - timeline_view_from);
+    long long pinned = timeline_view_from + (long long)(anchor * width);
+    long long from = pinned - (long long)(anchor * width * factor);
+    set_timeline_view(from, from + (long long)(width * factor));
+}
+
+// Time under a window position when it is over the histogram
+int timeline_histogram_hit(int x, int y, long long* time) {
+    float left = WINDOW_WIDTH * 0.25f + 20;
+    float bottom = WINDOW_HEIGHT - (float)y;
+    if (!timeline || x < left || x >= left + HISTOGRAM_COLUMNS * 2 ||
+        bottom < HISTOGRAM_Y || bottom >= HISTOGRAM_Y + HISTOGRAM_HEIGHT) {
+        return 0;
+    }
+    double fraction = (x - left) / (HISTOGRAM_COLUMNS * 2.0);
+    *time = timeline_view_from + (long long)(fraction * (double)(timeline_view_to - timeline_view_from));
+    return 1;
+}
+
+// Scroll the timeline to the earliest event of a file
+void show_file_in_timeline(int index) {
+    if (!timeline || timeline_count(timeline) == 0) return;
+    const FileRecord* record = file_table_record(file_table, index);
+    const time_t times[4] = {record->modified, record->accessed, record->changed, record->created};
+    time_t earliest = 0;
+    for (int i = 0; i < 4; i++) {
+        if (times[i] != 0 && (earliest == 0 || times[i] < earliest)) earliest = times[i];
+    }
+    if (earliest == 0) return;
+    
+    // Events of one second are few; find the file's among them
+    size_t count;
+    const TimelineEvent* events = timeline_run(timeline, 0, &count);
+    size_t first = timeline_find(timeline, 0, (long long)earliest);
+    for (size_t i = first; i < count && events[i].time == (long long)earliest; i++) {
+        if ((int)events[i].source == index) {
+            first = i;
+            break;
+        }
+    }
+    scroll_timeline((long long)first);
+}
+
+// Add carved files as recovered entries under a folder of the root
+void add_carved_files(const CarveResult* carved) {
+    if (carved->count == 0) return;
+    if (carved_folder < 0) {
+        carved_folder = file_table_add(file_table, "$Carved", 0, FILE_TYPE_FOLDER, 0);
+        if (carved_folder < 0) return;
+    }
+    
+    for (int i = 0; i < carved->count; i++) {
+        const CarvedFile* file = &carved->files[i];
+        const CarveType* type = carve_type(file->type);
+        char name[MAX_FILENAME];
+        
+        // Named by starting sector, as carvers conventionally do
+        snprintf(name, sizeof(name), "f%010lld.%s", file->offset / 512, type->extension);
+        int index = file_table_add(file_table, name, carved_folder, type->type, file->length);
+        if (index < 0) return;
+        
+        ImageRun run = {file->offset, file->length};
+        file_table_set_runs(file_table, index, &run, 1);
+        file_table_set_deleted(file_table, index, 1);
+        file_table_record(file_table, index)->format = file_table_intern(file_table, type->name);
+        file_table_set_size(file_table, carved_folder,
+                            file_table_size(file_table, carved_folder) + file->length);
+        carved_count++;
+    }
 }
 
 // Main function
@@ -999,7 +2618,8 @@ int main(int argc, char** argv) {
     
     // Initialize application data
     srand((unsigned int)time(NULL));
-    init_forensic_data();
+    init_forensic_data(argc > 1 ? argv[1] : "evidence/disk_image.E01");
+    load_keyword_list(argc > 2 ? argv[2] : NULL);
     init_opengl();
     
     // Set callback functions
@@ -1013,14 +2633,28 @@ int main(int argc, char** argv) {
     
     // Print usage instructions
     printf("=== Charon Digital Forensics Tool ===\n");
+    printf("Usage: %s [image.E01] [keywords.txt]\n", argv[0]);
     printf("Controls:\n");
     printf("- Arrow Keys: Navigate file selection / Rotate 3D view\n");
     printf("- Page Up/Down: Adjust 3D view elevation\n");
     printf("- Mouse: Click files to select, drag in 3D area to rotate\n");
-    printf("- Mouse Wheel: Zoom 3D view in/out\n");
+    printf("- Enter/Space or click again: Expand or collapse the selected folder\n");
+    printf("- Mouse Wheel: Scroll the file tree / Zoom 3D view in/out\n");
+    printf("- Home/End: Jump to the first or last file tree row\n");
     printf("- Keys 1-4: Switch preview tabs (Hex/Text/Meta/Timeline)\n");
+    printf("- Wheel/Page Up/Down over the preview: Scroll the hex, text or timeline tab\n");
+    printf("- +/- or wheel over the timeline histogram: Zoom; [ ]: Pan; click: List events from there\n");
+    printf("- S: Index the strings of the whole image for keyword search (again to cancel)\n");
+    printf("- K: Search the keyword index (comma-separated, empty to clear)\n");
+    printf("- L: Scan the raw image for the keyword list, e-mails, cards and IPs (again to cancel)\n");
+    printf("- X: Export the selected file as a hex dump (again to cancel)\n");
+    printf("- G: Go to a hex offset in the hex view (type digits, Enter)\n");
     printf("- R: Reset 3D camera position\n");
+    printf("- P: Pause or resume 3D auto-rotation\n");
     printf("- F: Toggle fullscreen\n");
+    printf("- V: Verify whole-image hashes (MD5/SHA-1 and SHA-256 tree, again to cancel)\n");
+    printf("- A: Hash and analyse every file in the background\n");
+    printf("- C: Carve files from unallocated space (again to cancel)\n");
     printf("- ESC: Exit application\n");
     printf("\nStarting forensic analysis...\n");
     
@@ -0,0 +1,735 @@
+#define _GNU_SOURCE
+#include "hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HASH_X86 1
+#endif
+
+#define HASH_STEP (64 * 1024)
+
+typedef void (*BlockFunction)(uint32_t* state, const unsigned char* data, size_t blocks);
+
+static BlockFunction sha1_blocks;
+static BlockFunction sha256_blocks;
+static int md5_x8_available;
+
+static uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static uint32_t rotr32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static uint32_t load_be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint32_t load_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// MD5
+
+static const uint32_t md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+#define MD5_F(b, c, d) (((b) & (c)) | (~(b) & (d)))
+#define MD5_G(b, c, d) (((d) & (b)) | (~(d) & (c)))
+#define MD5_H(b, c, d) ((b) ^ (c) ^ (d))
+#define MD5_I(b, c, d) ((c) ^ ((b) | ~(d)))
+#define MD5_STEP(f, a, b, c, d, m, i, s) a = b + rotl32(a + f(b, c, d) + md5_k[i] + (m), s)
+
+static void md5_blocks(uint32_t* state, const unsigned char* data, size_t blocks) {
+    while (blocks--) {
+        uint32_t m[16];
+        for (int i = 0; i < 16; i++) m[i] = load_le32(data + i * 4);
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        MD5_STEP(MD5_F, a, b, c, d, m[0], 0, 7);
+        MD5_STEP(MD5_F, d, a, b, c, m[1], 1, 12);
+        MD5_STEP(MD5_F, c, d, a, b, m[2], 2, 17);
+        MD5_STEP(MD5_F, b, c, d, a, m[3], 3, 22);
+        MD5_STEP(MD5_F, a, b, c, d, m[4], 4, 7);
+        MD5_STEP(MD5_F, d, a, b, c, m[5], 5, 12);
+        MD5_STEP(MD5_F, c, d, a, b, m[6], 6, 17);
+        MD5_STEP(MD5_F, b, c, d, a, m[7], 7, 22);
+        MD5_STEP(MD5_F, a, b, c, d, m[8], 8, 7);
+        MD5_STEP(MD5_F, d, a, b, c, m[9], 9, 12);
+        MD5_STEP(MD5_F, c, d, a, b, m[10], 10, 17);
+        MD5_STEP(MD5_F, b, c, d, a, m[11], 11, 22);
+        MD5_STEP(MD5_F, a, b, c, d, m[12], 12, 7);
+        MD5_STEP(MD5_F, d, a, b, c, m[13], 13, 12);
+        MD5_STEP(MD5_F, c, d, a, b, m[14], 14, 17);
+        MD5_STEP(MD5_F, b, c, d, a, m[15], 15, 22);
+
+        MD5_STEP(MD5_G, a, b, c, d, m[1], 16, 5);
+        MD5_STEP(MD5_G, d, a, b, c, m[6], 17, 9);
+        MD5_STEP(MD5_G, c, d, a, b, m[11], 18, 14);
+        MD5_STEP(MD5_G, b, c, d, a, m[0], 19, 20);
+        MD5_STEP(MD5_G, a, b, c, d, m[5], 20, 5);
+        MD5_STEP(MD5_G, d, a, b, c, m[10], 21, 9);
+        MD5_STEP(MD5_G, c, d, a, b, m[15], 22, 14);
+        MD5_STEP(MD5_G, b, c, d, a, m[4], 23, 20);
+        MD5_STEP(MD5_G, a, b, c, d, m[9], 24, 5);
+        MD5_STEP(MD5_G, d, a, b, c, m[14], 25, 9);
+        MD5_STEP(MD5_G, c, d, a, b, m[3], 26, 14);
+        MD5_STEP(MD5_G, b, c, d, a, m[8], 27, 20);
+        MD5_STEP(MD5_G, a, b, c, d, m[13], 28, 5);
+        MD5_STEP(MD5_G, d, a, b, c, m[2], 29, 9);
+        MD5_STEP(MD5_G, c, d, a, b, m[7], 30, 14);
+        MD5_STEP(MD5_G, b, c, d, a, m[12], 31, 20);
+
+        MD5_STEP(MD5_H, a, b, c, d, m[5], 32, 4);
+        MD5_STEP(MD5_H, d, a, b, c, m[8], 33, 11);
+        MD5_STEP(MD5_H, c, d, a, b, m[11], 34, 16);
+        MD5_STEP(MD5_H, b, c, d, a, m[14], 35, 23);
+        MD5_STEP(MD5_H, a, b, c, d, m[1], 36, 4);
+        MD5_STEP(MD5_H, d, a, b, c, m[4], 37, 11);
+        MD5_STEP(MD5_H, c, d, a, b, m[7], 38, 16);
+        MD5_STEP(MD5_H, b, c, d, a, m[10], 39, 23);
+        MD5_STEP(MD5_H, a, b, c, d, m[13], 40, 4);
+        MD5_STEP(MD5_H, d, a, b, c, m[0], 41, 11);
+        MD5_STEP(MD5_H, c, d, a, b, m[3], 42, 16);
+        MD5_STEP(MD5_H, b, c, d, a, m[6], 43, 23);
+        MD5_STEP(MD5_H, a, b, c, d, m[9], 44, 4);
+        MD5_STEP(MD5_H, d, a, b, c, m[12], 45, 11);
+        MD5_STEP(MD5_H, c, d, a, b, m[15], 46, 16);
+        MD5_STEP(MD5_H, b, c, d, a, m[2], 47, 23);
+
+        MD5_STEP(MD5_I, a, b, c, d, m[0], 48, 6);
+        MD5_STEP(MD5_I, d, a, b, c, m[7], 49, 10);
+        MD5_STEP(MD5_I, c, d, a, b, m[14], 50, 15);
+        MD5_STEP(MD5_I, b, c, d, a, m[5], 51, 21);
+        MD5_STEP(MD5_I, a, b, c, d, m[12], 52, 6);
+        MD5_STEP(MD5_I, d, a, b, c, m[3], 53, 10);
+        MD5_STEP(MD5_I, c, d, a, b, m[10], 54, 15);
+        MD5_STEP(MD5_I, b, c, d, a, m[1], 55, 21);
+        MD5_STEP(MD5_I, a, b, c, d, m[8], 56, 6);
+        MD5_STEP(MD5_I, d, a, b, c, m[15], 57, 10);
+        MD5_STEP(MD5_I, c, d, a, b, m[6], 58, 15);
+        MD5_STEP(MD5_I, b, c, d, a, m[13], 59, 21);
+        MD5_STEP(MD5_I, a, b, c, d, m[4], 60, 6);
+        MD5_STEP(MD5_I, d, a, b, c, m[11], 61, 10);
+        MD5_STEP(MD5_I, c, d, a, b, m[2], 62, 15);
+        MD5_STEP(MD5_I, b, c, d, a, m[9], 63, 21);
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        data += 64;
+    }
+}
+
+// SHA-1
+
+static void sha1_blocks_portable(uint32_t* state, const unsigned char* data, size_t blocks) {
+    while (blocks--) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) w[i] = load_be32(data + i * 4);
+        for (int i = 16; i < 80; i++) w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            uint32_t t = rotl32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl32(b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        data += 64;
+    }
+}
+
+// SHA-256
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void sha256_blocks_portable(uint32_t* state, const unsigned char* data, size_t blocks) {
+    while (blocks--) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) w[i] = load_be32(data + i * 4);
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+            uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        data += 64;
+    }
+}
+
+#ifdef HASH_X86
+
+// SHA-NI kernels
+
+__attribute__((target("sha,sse4.1")))
+static void sha1_blocks_shani(uint32_t* state, const unsigned char* data, size_t blocks) {
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+    while (blocks--) {
+        __m128i abcd_save = abcd;
+        __m128i e_save = e0;
+        __m128i w[4];
+        __m128i e_next = e0;
+        __m128i e_prev = e0;
+
+        #pragma GCC unroll 20
+        for (int g = 0; g < 20; g++) {
+            if (g < 4) {
+                w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + g * 16)), mask);
+            } else {
+                __m128i t = _mm_sha1msg1_epu32(w[g & 3], w[(g + 1) & 3]);
+                t = _mm_xor_si128(t, w[(g + 2) & 3]);
+                w[g & 3] = _mm_sha1msg2_epu32(t, w[(g + 3) & 3]);
+            }
+
+            e_next = g == 0 ? _mm_add_epi32(e0, w[0]) : _mm_sha1nexte_epu32(e_prev, w[g & 3]);
+            e_prev = abcd;
+            switch (g / 5) {
+                case 0: abcd = _mm_sha1rnds4_epu32(abcd, e_next, 0); break;
+                case 1: abcd = _mm_sha1rnds4_epu32(abcd, e_next, 1); break;
+                case 2: abcd = _mm_sha1rnds4_epu32(abcd, e_next, 2); break;
+                default: abcd = _mm_sha1rnds4_epu32(abcd, e_next, 3); break;
+            }
+        }
+
+        e0 = _mm_sha1nexte_epu32(e_prev, e_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_blocks_shani(uint32_t* state, const unsigned char* data, size_t blocks) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1); // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B); // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);    // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);         // CDGH
+
+    while (blocks--) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+        __m128i w[4];
+
+        #pragma GCC unroll 16
+        for (int g = 0; g < 16; g++) {
+            if (g < 4) {
+                w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + g * 16)), mask);
+            } else {
+                __m128i t = _mm_sha256msg1_epu32(w[g & 3], w[(g + 1) & 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[(g + 3) & 3], w[(g + 2) & 3], 4));
+                w[g & 3] = _mm_sha256msg2_epu32(t, w[(g + 3) & 3]);
+            }
+
+            __m128i k = _mm_add_epi32(w[g & 3], _mm_loadu_si128((const __m128i*)&sha256_k[g * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, k);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(k, 0x0E));
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);               // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);            // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);         // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);            // ABEF
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+// Eight independent MD5 streams, one per 32-bit AVX2 lane
+
+#define MD5X8_ROTL(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+#define MD5X8_STEP(f, a, b, c, d, m, i, s)                                          \
+    a = _mm256_add_epi32(a, _mm256_add_epi32(f(b, c, d),                            \
+            _mm256_add_epi32(m, _mm256_set1_epi32((int)md5_k[i]))));                \
+    a = _mm256_add_epi32(b, MD5X8_ROTL(a, s))
+#define MD5X8_F(b, c, d) _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d))
+#define MD5X8_G(b, c, d) _mm256_or_si256(_mm256_and_si256(d, b), _mm256_andnot_si256(d, c))
+#define MD5X8_H(b, c, d) _mm256_xor_si256(_mm256_xor_si256(b, c), d)
+#define MD5X8_I(b, c, d) _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, ones)))
+
+__attribute__((target("avx2")))
+static void md5_blocks_x8(uint32_t* const states[HASH_BATCH_LANES],
+                          const unsigned char* const data[HASH_BATCH_LANES], size_t blocks) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i a = _mm256_setr_epi32((int)states[0][0], (int)states[1][0], (int)states[2][0], (int)states[3][0],
+                                  (int)states[4][0], (int)states[5][0], (int)states[6][0], (int)states[7][0]);
+    __m256i b = _mm256_setr_epi32((int)states[0][1], (int)states[1][1], (int)states[2][1], (int)states[3][1],
+                                  (int)states[4][1], (int)states[5][1], (int)states[6][1], (int)states[7][1]);
+    __m256i c = _mm256_setr_epi32((int)states[0][2], (int)states[1][2], (int)states[2][2], (int)states[3][2],
+                                  (int)states[4][2], (int)states[5][2], (int)states[6][2], (int)states[7][2]);
+    __m256i d = _mm256_setr_epi32((int)states[0][3], (int)states[1][3], (int)states[2][3], (int)states[3][3],
+                                  (int)states[4][3], (int)states[5][3], (int)states[6][3], (int)states[7][3]);
+
+    for (size_t block = 0; block < blocks; block++) {
+        // Transpose: m[i] holds message word i of every lane
+        __m256i m[16];
+        size_t base = block * 64;
+        for (int i = 0; i < 16; i++) {
+            m[i] = _mm256_setr_epi32((int)load_le32(data[0] + base + i * 4), (int)load_le32(data[1] + base + i * 4),
+                                     (int)load_le32(data[2] + base + i * 4), (int)load_le32(data[3] + base + i * 4),
+                                     (int)load_le32(data[4] + base + i * 4), (int)load_le32(data[5] + base + i * 4),
+                                     (int)load_le32(data[6] + base + i * 4), (int)load_le32(data[7] + base + i * 4));
+        }
+
+        __m256i aa = a, bb = b, cc = c, dd = d;
+
+        MD5X8_STEP(MD5X8_F, a, b, c, d, m[0], 0, 7);
+        MD5X8_STEP(MD5X8_F, d, a, b, c, m[1], 1, 12);
+        MD5X8_STEP(MD5X8_F, c, d, a, b, m[2], 2, 17);
+        MD5X8_STEP(MD5X8_F, b, c, d, a, m[3], 3, 22);
+        MD5X8_STEP(MD5X8_F, a, b, c, d, m[4], 4, 7);
+        MD5X8_STEP(MD5X8_F, d, a, b, c, m[5], 5, 12);
+        MD5X8_STEP(MD5X8_F, c, d, a, b, m[6], 6, 17);
+        MD5X8_STEP(MD5X8_F, b, c, d, a, m[7], 7, 22);
+        MD5X8_STEP(MD5X8_F, a, b, c, d, m[8], 8, 7);
+        MD5X8_STEP(MD5X8_F, d, a, b, c, m[9], 9, 12);
+        MD5X8_STEP(MD5X8_F, c, d, a, b, m[10], 10, 17);
+        MD5X8_STEP(MD5X8_F, b, c, d, a, m[11], 11, 22);
+        MD5X8_STEP(MD5X8_F, a, b, c, d, m[12], 12, 7);
+        MD5X8_STEP(MD5X8_F, d, a, b, c, m[13], 13, 12);
+        MD5X8_STEP(MD5X8_F, c, d, a, b, m[14], 14, 17);
+        MD5X8_STEP(MD5X8_F, b, c, d, a, m[15], 15, 22);
+
+        MD5X8_STEP(MD5X8_G, a, b, c, d, m[1], 16, 5);
+        MD5X8_STEP(MD5X8_G, d, a, b, c, m[6], 17, 9);
+        MD5X8_STEP(MD5X8_G, c, d, a, b, m[11], 18, 14);
+        MD5X8_STEP(MD5X8_G, b, c, d, a, m[0], 19, 20);
+        MD5X8_STEP(MD5X8_G, a, b, c, d, m[5], 20, 5);
+        MD5X8_STEP(MD5X8_G, d, a, b, c, m[10], 21, 9);
+        MD5X8_STEP(MD5X8_G, c, d, a, b, m[15], 22, 14);
+        MD5X8_STEP(MD5X8_G, b, c, d, a, m[4], 23, 20);
+        MD5X8_STEP(MD5X8_G, a, b, c, d, m[9], 24, 5);
+        MD5X8_STEP(MD5X8_G, d, a, b, c, m[14], 25, 9);
+        MD5X8_STEP(MD5X8_G, c, d, a, b, m[3], 26, 14);
+        MD5X8_STEP(MD5X8_G, b, c, d, a, m[8], 27, 20);
+        MD5X8_STEP(MD5X8_G, a, b, c, d, m[13], 28, 5);
+        MD5X8_STEP(MD5X8_G, d, a, b, c, m[2], 29, 9);
+        MD5X8_STEP(MD5X8_G, c, d, a, b, m[7], 30, 14);
+        MD5X8_STEP(MD5X8_G, b, c, d, a, m[12], 31, 20);
+
+        MD5X8_STEP(MD5X8_H, a, b, c, d, m[5], 32, 4);
+        MD5X8_STEP(MD5X8_H, d, a, b, c, m[8], 33, 11);
+        MD5X8_STEP(MD5X8_H, c, d, a, b, m[11], 34, 16);
+        MD5X8_STEP(MD5X8_H, b, c, d, a, m[14], 35, 23);
+        MD5X8_STEP(MD5X8_H, a, b, c, d, m[1], 36, 4);
+        MD5X8_STEP(MD5X8_H, d, a, b, c, m[4], 37, 11);
+        MD5X8_STEP(MD5X8_H, c, d, a, b, m[7], 38, 16);
+        MD5X8_STEP(MD5X8_H, b, c, d, a, m[10], 39, 23);
+        MD5X8_STEP(MD5X8_H, a, b, c, d, m[13], 40, 4);
+        MD5X8_STEP(MD5X8_H, d, a, b, c, m[0], 41, 11);
+        MD5X8_STEP(MD5X8_H, c, d, a, b, m[3], 42, 16);
+        MD5X8_STEP(MD5X8_H, b, c, d, a, m[6], 43, 23);
+        MD5X8_STEP(MD5X8_H, a, b, c, d, m[9], 44, 4);
+        MD5X8_STEP(MD5X8_H, d, a, b, c, m[12], 45, 11);
+        MD5X8_STEP(MD5X8_H, c, d, a, b, m[15], 46, 16);
+        MD5X8_STEP(MD5X8_H, b, c, d, a, m[2], 47, 23);
+
+        MD5X8_STEP(MD5X8_I, a, b, c, d, m[0], 48, 6);
+        MD5X8_STEP(MD5X8_I, d, a, b, c, m[7], 49, 10);
+        MD5X8_STEP(MD5X8_I, c, d, a, b, m[14], 50, 15);
+        MD5X8_STEP(MD5X8_I, b, c, d, a, m[5], 51, 21);
+        MD5X8_STEP(MD5X8_I, a, b, c, d, m[12], 52, 6);
+        MD5X8_STEP(MD5X8_I, d, a, b, c, m[3], 53, 10);
+        MD5X8_STEP(MD5X8_I, c, d, a, b, m[10], 54, 15);
+        MD5X8_STEP(MD5X8_I, b, c, d, a, m[1], 55, 21);
+        MD5X8_STEP(MD5X8_I, a, b, c, d, m[8], 56, 6);
+        MD5X8_STEP(MD5X8_I, d, a, b, c, m[15], 57, 10);
+        MD5X8_STEP(MD5X8_I, c, d, a, b, m[6], 58, 15);
+        MD5X8_STEP(MD5X8_I, b, c, d, a, m[13], 59, 21);
+        MD5X8_STEP(MD5X8_I, a, b, c, d, m[4], 60, 6);
+        MD5X8_STEP(MD5X8_I, d, a, b, c, m[11], 61, 10);
+        MD5X8_STEP(MD5X8_I, c, d, a, b, m[2], 62, 15);
+        MD5X8_STEP(MD5X8_I, b, c, d, a, m[9], 63, 21);
+
+        a = _mm256_add_epi32(a, aa);
+        b = _mm256_add_epi32(b, bb);
+        c = _mm256_add_epi32(c, cc);
+        d = _mm256_add_epi32(d, dd);
+    }
+
+    uint32_t out[4][HASH_BATCH_LANES];
+    _mm256_storeu_si256((__m256i*)out[0], a);
+    _mm256_storeu_si256((__m256i*)out[1], b);
+    _mm256_storeu_si256((__m256i*)out[2], c);
+    _mm256_storeu_si256((__m256i*)out[3], d);
+    for (int lane = 0; lane < HASH_BATCH_LANES; lane++) {
+        for (int i = 0; i < 4; i++) states[lane][i] = out[i][lane];
+    }
+}
+
+#endif
+
+// Pick kernels once at startup
+__attribute__((constructor))
+static void hash_select_kernels(void) {
+    hash_force_portable(0);
+}
+
+void hash_force_portable(int portable) {
+    sha1_blocks = sha1_blocks_portable;
+    sha256_blocks = sha256_blocks_portable;
+    md5_x8_available = 0;
+    if (portable) return;
+
+#ifdef HASH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) {
+        sha1_blocks = sha1_blocks_shani;
+        sha256_blocks = sha256_blocks_shani;
+    }
+    md5_x8_available = __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+const char* hash_engine_name(void) {
+    int shani = sha256_blocks != sha256_blocks_portable;
+    if (shani && md5_x8_available) return "SHA-NI, AVX2 x8";
+    if (shani) return "SHA-NI";
+    if (md5_x8_available) return "AVX2 x8";
+    return "portable";
+}
+
+void hash_init(HashContext* context, int algorithms) {
+    static const uint32_t md5_iv[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+    static const uint32_t sha1_iv[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    static const uint32_t sha256_iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(context->md5, md5_iv, sizeof(md5_iv));
+    memcpy(context->sha1, sha1_iv, sizeof(sha1_iv));
+    memcpy(context->sha256, sha256_iv, sizeof(sha256_iv));
+    context->length = 0;
+    context->buffered = 0;
+    context->algorithms = algorithms & HASH_ALL;
+}
+
+static void process_blocks(HashContext* context, const unsigned char* data, size_t blocks, int skip_md5) {
+    if ((context->algorithms & HASH_MD5) && !skip_md5) md5_blocks(context->md5, data, blocks);
+    if (context->algorithms & HASH_SHA1) sha1_blocks(context->sha1, data, blocks);
+    if (context->algorithms & HASH_SHA256) sha256_blocks(context->sha256, data, blocks);
+}
+
+void hash_update(HashContext* context, const void* data, size_t length) {
+    const unsigned char* p = data;
+    context->length += length;
+
+    if (context->buffered > 0) {
+        size_t n = 64 - context->buffered;
+        if (n > length) n = length;
+        memcpy(context->buffer + context->buffered, p, n);
+        context->buffered += n;
+        p += n;
+        length -= n;
+        if (context->buffered < 64) return;
+        process_blocks(context, context->buffer, 1, 0);
+        context->buffered = 0;
+    }
+
+    size_t blocks = length / 64;
+    if (blocks > 0) {
+        process_blocks(context, p, blocks, 0);
+        p += blocks * 64;
+        length -= blocks * 64;
+    }
+
+    if (length > 0) {
+        memcpy(context->buffer, p, length);
+        context->buffered = length;
+    }
+}
+
+void hash_update_batch(HashContext* const contexts[], const unsigned char* const data[],
+                       size_t length, int count) {
+    size_t blocks = length / 64;
+    int lanes[HASH_BATCH_LANES];
+    int lane_count = 0;
+
+#ifdef HASH_X86
+    // Aligned MD5 streams go through the multi-buffer kernel together
+    if (md5_x8_available && blocks > 0) {
+        for (int i = 0; i < count && lane_count < HASH_BATCH_LANES; i++) {
+            if (contexts[i]->buffered == 0 && (contexts[i]->algorithms & HASH_MD5)) {
+                lanes[lane_count++] = i;
+            }
+        }
+        if (lane_count >= 2) {
+            uint32_t* states[HASH_BATCH_LANES];
+            const unsigned char* inputs[HASH_BATCH_LANES];
+            uint32_t spare[HASH_BATCH_LANES][4];
+            for (int lane = 0; lane < HASH_BATCH_LANES; lane++) {
+                if (lane < lane_count) {
+                    states[lane] = contexts[lanes[lane]]->md5;
+                    inputs[lane] = data[lanes[lane]];
+                } else {
+                    // Idle lanes recompute lane 0 into scratch state
+                    memcpy(spare[lane], contexts[lanes[0]]->md5, sizeof(spare[lane]));
+                    states[lane] = spare[lane];
+                    inputs[lane] = data[lanes[0]];
+                }
+            }
+            md5_blocks_x8(states, inputs, blocks);
+        } else {
+            lane_count = 0;
+        }
+    }
+#endif
+
+    for (int i = 0; i < count; i++) {
+        int batched = 0;
+        for (int lane = 0; lane < lane_count; lane++) {
+            if (lanes[lane] == i) batched = 1;
+        }
+
+        if (!batched) {
+            hash_update(contexts[i], data[i], length);
+            continue;
+        }
+
+        process_blocks(contexts[i], data[i], blocks, 1);
+        contexts[i]->length += blocks * 64;
+        if (length > blocks * 64) hash_update(contexts[i], data[i] + blocks * 64, length - blocks * 64);
+    }
+}
+
+void hash_final(HashContext* context, HashDigests* digests) {
+    unsigned long long bits = context->length * 8;
+    unsigned char pad[72];
+    size_t pad_length = (context->buffered < 56 ? 56 : 120) - context->buffered;
+    memset(pad, 0, sizeof(pad));
+    pad[0] = 0x80;
+
+    // Padding is identical for all three; only the length byte order
+    // differs, so MD5 finishes in context and the SHAs in a copy
+    int algorithms = context->algorithms;
+    HashContext be = *context;
+    context->algorithms = algorithms & HASH_MD5;
+    be.algorithms = algorithms & (HASH_SHA1 | HASH_SHA256);
+
+    unsigned char le_length[8], be_length[8];
+    for (int i = 0; i < 8; i++) {
+        le_length[i] = (unsigned char)(bits >> (8 * i));
+        be_length[i] = (unsigned char)(bits >> (56 - 8 * i));
+    }
+    hash_update(context, pad, pad_length);
+    hash_update(context, le_length, 8);
+    hash_update(&be, pad, pad_length);
+    hash_update(&be, be_length, 8);
+    context->algorithms = algorithms;
+
+    memset(digests, 0, sizeof(HashDigests));
+    digests->valid = (unsigned char)algorithms;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) digests->md5[i * 4 + j] = (unsigned char)(context->md5[i] >> (8 * j));
+    }
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 4; j++) digests->sha1[i * 4 + j] = (unsigned char)(be.sha1[i] >> (24 - 8 * j));
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++) digests->sha256[i * 4 + j] = (unsigned char)(be.sha256[i] >> (24 - 8 * j));
+    }
+}
+
+void hash_format(const unsigned char* digest, size_t length, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < length; i++) {
+        out[i * 2] = digits[digest[i] >> 4];
+        out[i * 2 + 1] = digits[digest[i] & 15];
+    }
+    out[length * 2] = '\0';
+}
+
+int hash_image_runs(EvidenceImage* image, const ImageRun* runs, int run_count,
+                    int algorithms, HashDigests* digests) {
+    static const unsigned char zeros[HASH_STEP];
+    HashContext context;
+    hash_init(&context, algorithms);
+
+    for (int r = 0; r < run_count; r++) {
+        long long done = 0;
+        if (runs[r].offset != IMAGE_RUN_SPARSE) {
+            image_advise(image, runs[r].offset, runs[r].length, IMAGE_ACCESS_SEQUENTIAL);
+        }
+        while (done < runs[r].length) {
+            size_t want = runs[r].length - done < HASH_STEP ? (size_t)(runs[r].length - done) : HASH_STEP;
+            if (runs[r].offset == IMAGE_RUN_SPARSE) {
+                hash_update(&context, zeros, want);
+                done += (long long)want;
+                continue;
+            }
+
+            ImageView view;
+            if (image_view(image, runs[r].offset + done, want, &view) != 0) return -1;
+            hash_update(&context, view.data, view.length);
+            done += (long long)view.length;
+        }
+    }
+
+    hash_final(&context, digests);
+    return 0;
+}
+
+// Sequential reader over one file's runs
+typedef struct {
+    const ImageRun* runs;
+    int run_count;
+    int run;
+    long long within;
+} RunCursor;
+
+static long fill_from_runs(EvidenceImage* image, RunCursor* cursor, unsigned char* buffer, size_t length) {
+    size_t filled = 0;
+    while (filled < length && cursor->run < cursor->run_count) {
+        const ImageRun* run = &cursor->runs[cursor->run];
+        long long left = run->length - cursor->within;
+        size_t n = left < (long long)(length - filled) ? (size_t)left : length - filled;
+
+        if (run->offset == IMAGE_RUN_SPARSE) {
+            memset(buffer + filled, 0, n);
+        } else if (image_read(image, run->offset + cursor->within, buffer + filled, n) != (long)n) {
+            return -1;
+        }
+
+        filled += n;
+        cursor->within += (long long)n;
+        if (cursor->within == run->length) {
+            cursor->run++;
+            cursor->within = 0;
+        }
+    }
+    return (long)filled;
+}
+
+int hash_image_runs_batch(EvidenceImage* image, const ImageRun* const runs[],
+                          const int run_counts[], int count, int algorithms,
+                          HashDigests digests[]) {
+    if (count > HASH_BATCH_LANES) return -1;
+
+    HashContext contexts[HASH_BATCH_LANES];
+    RunCursor cursors[HASH_BATCH_LANES];
+    unsigned char* buffers = malloc((size_t)HASH_BATCH_LANES * HASH_STEP);
+    if (!buffers) return -1;
+
+    for (int i = 0; i < count; i++) {
+        hash_init(&contexts[i], algorithms);
+        cursors[i].runs = runs[i];
+        cursors[i].run_count = run_counts[i];
+        cursors[i].run = 0;
+        cursors[i].within = 0;
+    }
+
+    // Each step feeds HASH_STEP bytes to every lane that still has data;
+    // short lanes drop out of the batch as they finish
+    int status = 0;
+    for (;;) {
+        HashContext* active[HASH_BATCH_LANES];
+        const unsigned char* inputs[HASH_BATCH_LANES];
+        int active_count = 0;
+
+        for (int i = 0; i < count; i++) {
+            unsigned char* buffer = buffers + (size_t)i * HASH_STEP;
+            long n = fill_from_runs(image, &cursors[i], buffer, HASH_STEP);
+            if (n < 0) {
+                status = -1;
+                break;
+            }
+            if (n == 0) continue;
+            if (n < HASH_STEP) {
+                // Final partial step goes through on its own
+                hash_update(&contexts[i], buffer, (size_t)n);
+                continue;
+            }
+            active[active_count] = &contexts[i];
+            inputs[active_count++] = buffer;
+        }
+        if (status != 0 || active_count == 0) break;
+
+        hash_update_batch(active, inputs, HASH_STEP, active_count);
+    }
+
+    for (int i = 0; i < count; i++) hash_final(&contexts[i], &digests[i]);
+    free(buffers);
+    return status;
+}
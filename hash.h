@@ -0,0 +1,68 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image.h"
+
+// Streaming MD5 / SHA-1 / SHA-256 engine
+//
+// All selected digests are computed in one pass over the data. SHA-1 and
+// SHA-256 use the SHA-NI instructions when the CPU has them; MD5 has no
+// hardware support, so several files are hashed side by side in AVX2
+// lanes by the batch interface. Everything falls back to portable C.
+
+#define HASH_MD5 0x01
+#define HASH_SHA1 0x02
+#define HASH_SHA256 0x04
+#define HASH_ALL (HASH_MD5 | HASH_SHA1 | HASH_SHA256)
+
+#define HASH_BATCH_LANES 8
+
+typedef struct {
+    unsigned char valid; // HASH_* bits of the digests that are set
+    unsigned char md5[16];
+    unsigned char sha1[20];
+    unsigned char sha256[32];
+} HashDigests;
+
+typedef struct {
+    uint32_t md5[4];
+    uint32_t sha1[5];
+    uint32_t sha256[8];
+    unsigned long long length;
+    unsigned char buffer[64];
+    size_t buffered;
+    int algorithms;
+} HashContext;
+
+void hash_init(HashContext* context, int algorithms);
+void hash_update(HashContext* context, const void* data, size_t length);
+void hash_final(HashContext* context, HashDigests* digests);
+
+// Feed the same number of bytes to each of count contexts. Contexts that
+// are block-aligned share the multi-buffer kernels.
+void hash_update_batch(HashContext* const contexts[], const unsigned char* const data[],
+                       size_t length, int count);
+
+// Kernels selected at startup, e.g. "SHA-NI, AVX2 x8"
+const char* hash_engine_name(void);
+
+// Switch to the portable kernels, or back to the fastest the CPU has, so
+// tests can check one against the other. Not safe while hashing.
+void hash_force_portable(int portable);
+
+// Lower-case hex of a digest; out must hold 2 * length + 1 bytes
+void hash_format(const unsigned char* digest, size_t length, char* out);
+
+// Hash the data runs of one file
+int hash_image_runs(EvidenceImage* image, const ImageRun* runs, int run_count,
+                    int algorithms, HashDigests* digests);
+
+// Hash up to HASH_BATCH_LANES files in lockstep
+int hash_image_runs_batch(EvidenceImage* image, const ImageRun* const runs[],
+                          const int run_counts[], int count, int algorithms,
+                          HashDigests digests[]);
+
+#endif
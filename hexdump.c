@@ -0,0 +1,122 @@
+#include "hexdump.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEX_DUMP_BLOCK (1 << 20) // Source bytes formatted per write
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// Both digits of every byte value, so each byte is one two-character copy
+static const char hex_pairs[513] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+// Printable ASCII as itself, everything else as a dot
+static inline char ascii_of(unsigned char byte) {
+    return byte >= 32 && byte <= 126 ? (char)byte : '.';
+}
+
+int hex_dump_digits(long long length) {
+    int digits = 8;
+    while (digits < 16 && (length - 1) >> (digits * 4) > 0) digits += 2;
+    return digits;
+}
+
+// Row text without the NUL; returns its length
+static int format_row(char* out, long long offset, int digits, const unsigned char* bytes, int count) {
+    char* p = out;
+    unsigned long long value = (unsigned long long)offset;
+    for (int i = digits - 1; i >= 0; i--) {
+        p[i] = hex_digits[value & 15];
+        value >>= 4;
+    }
+    p += digits;
+    *p++ = ':';
+    *p++ = ' ';
+
+    int i;
+    for (i = 0; i < count; i++) {
+        memcpy(p, hex_pairs + 2 * bytes[i], 2);
+        p[2] = ' ';
+        p += 3;
+    }
+    for (; i < HEX_DUMP_ROW_BYTES; i++) {
+        p[0] = p[1] = p[2] = ' ';
+        p += 3;
+    }
+
+    *p++ = ' ';
+    *p++ = '|';
+    *p++ = ' ';
+    for (i = 0; i < count; i++) *p++ = ascii_of(bytes[i]);
+    return (int)(p - out);
+}
+
+int hex_dump_row(char* out, long long offset, int digits, const unsigned char* bytes, int count) {
+    if (count > HEX_DUMP_ROW_BYTES) count = HEX_DUMP_ROW_BYTES;
+    int length = format_row(out, offset, digits, bytes, count);
+    out[length] = '\0';
+    return length;
+}
+
+size_t hex_dump(char* out, long long offset, int digits, const unsigned char* bytes, size_t length) {
+    char* p = out;
+    for (size_t done = 0; done < length; done += HEX_DUMP_ROW_BYTES) {
+        int count = length - done < HEX_DUMP_ROW_BYTES ? (int)(length - done) : HEX_DUMP_ROW_BYTES;
+        p += format_row(p, offset + (long long)done, digits, bytes + done, count);
+        *p++ = '\n';
+    }
+    return (size_t)(p - out);
+}
+
+int hex_dump_export(EvidenceImage* image, const ImageRun* runs, int run_count, long long length,
+                    const char* path, long long* done, const int* cancel) {
+    FILE* file = fopen(path, "w");
+    if (!file) return -1;
+    unsigned char* block = malloc(HEX_DUMP_BLOCK);
+    char* text = malloc((size_t)(HEX_DUMP_BLOCK / HEX_DUMP_ROW_BYTES) * HEX_DUMP_ROW_MAX);
+    int status = block && text ? 0 : -1;
+
+    for (int r = 0; r < run_count; r++) {
+        if (runs[r].offset != IMAGE_RUN_SPARSE) {
+            image_advise(image, runs[r].offset, runs[r].length, IMAGE_ACCESS_SEQUENTIAL);
+        }
+    }
+
+    int digits = hex_dump_digits(length);
+    long long offset = 0;
+    while (status == 0 && offset < length) {
+        if (cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) break;
+        size_t want = length - offset < HEX_DUMP_BLOCK ? (size_t)(length - offset) : HEX_DUMP_BLOCK;
+        long n = image_read_runs(image, runs, run_count, offset, block, want);
+        if (n <= 0) {
+            status = -1;
+            break;
+        }
+        size_t written = hex_dump(text, offset, digits, block, (size_t)n);
+        if (fwrite(text, 1, written, file) != written) status = -1;
+        offset += n;
+        if (done) __atomic_fetch_add(done, (long long)n, __ATOMIC_RELAXED);
+    }
+
+    if (fclose(file) != 0) status = -1;
+    free(text);
+    free(block);
+    return status;
+}
@@ -0,0 +1,38 @@
+#ifndef HEXDUMP_H
+#define HEXDUMP_H
+
+#include <stddef.h>
+
+#include "image.h"
+
+// Hex dump formatting
+//
+// Rows look like "0000A3F0: 4D 5A 90 00 ... 00  | MZ..............":
+// offset, sixteen byte pairs and the printable ASCII. Every output byte
+// comes from a table lookup and is stored straight into the caller's
+// buffer, so a whole block of rows is formatted in one pass with no
+// snprintf or strcat. The hex tab formats its screen with it and the
+// export streams whole files through it.
+
+#define HEX_DUMP_ROW_BYTES 16
+#define HEX_DUMP_ROW_MAX 88 // Longest row with a 16-digit offset, newline and NUL
+
+// Hex digits an offset column needs to show every offset below length
+int hex_dump_digits(long long length);
+
+// Format one row of up to 16 bytes, padded so the ASCII column lines up.
+// Returns the row length; out is NUL-terminated and has no newline.
+int hex_dump_row(char* out, long long offset, int digits, const unsigned char* bytes, int count);
+
+// Format length bytes as newline-terminated rows, the first at offset.
+// out must hold HEX_DUMP_ROW_MAX bytes per row. Returns the characters
+// written, without a terminating NUL.
+size_t hex_dump(char* out, long long offset, int digits, const unsigned char* bytes, size_t length);
+
+// Write a file's content, given its data runs, as a hex dump text file.
+// done counts bytes exported and cancel stops it early; both may be
+// shared with another thread. Returns 0, or -1 on a read or write error.
+int hex_dump_export(EvidenceImage* image, const ImageRun* runs, int run_count, long long length,
+                    const char* path, long long* done, const int* cancel);
+
+#endif
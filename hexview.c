@@ -0,0 +1,172 @@
+#include "hexview.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    long long page;     // Page index in the source, -1 when free
+    unsigned int used;  // Use stamp for least-recently-used replacement
+    int length;         // Bytes held; short on the last page or a failed read
+    unsigned char data[HEX_VIEW_PAGE_SIZE];
+} HexPage;
+
+struct HexView {
+    EvidenceImage* image;
+    ImageRun* runs;
+    int run_count;
+    int run_capacity;
+    const unsigned char* memory; // In-memory source, instead of runs
+    long long length;
+    long long offset;
+    int screen_bytes;
+    int direction;               // Last scroll: 1 forward, -1 back
+    unsigned int clock;
+    HexPage pages[HEX_VIEW_PAGES];
+};
+
+HexView* hex_view_create(EvidenceImage* image) {
+    HexView* view = calloc(1, sizeof(HexView));
+    if (!view) return NULL;
+    view->image = image;
+    view->direction = 1;
+    for (int i = 0; i < HEX_VIEW_PAGES; i++) view->pages[i].page = -1;
+    return view;
+}
+
+void hex_view_destroy(HexView* view) {
+    if (!view) return;
+    free(view->runs);
+    free(view);
+}
+
+static void reset(HexView* view, long long length) {
+    view->length = length > 0 ? length : 0;
+    view->offset = 0;
+    view->direction = 1;
+    for (int i = 0; i < HEX_VIEW_PAGES; i++) view->pages[i].page = -1;
+}
+
+int hex_view_set_runs(HexView* view, const ImageRun* runs, int run_count, long long length) {
+    if (run_count > view->run_capacity) {
+        ImageRun* copy = realloc(view->runs, (size_t)run_count * sizeof(ImageRun));
+        if (!copy) return -1;
+        view->runs = copy;
+        view->run_capacity = run_count;
+    }
+    if (run_count > 0) memcpy(view->runs, runs, (size_t)run_count * sizeof(ImageRun));
+    view->run_count = run_count;
+    view->memory = NULL;
+    reset(view, view->image ? length : 0);
+    return 0;
+}
+
+void hex_view_set_memory(HexView* view, const unsigned char* bytes, long long length) {
+    view->run_count = 0;
+    view->memory = bytes;
+    reset(view, length);
+}
+
+long long hex_view_length(const HexView* view) {
+    return view->length;
+}
+
+long long hex_view_offset(const HexView* view) {
+    return view->offset;
+}
+
+void hex_view_scroll(HexView* view, long long offset, int screen_bytes) {
+    // Keep the last screen full rather than scrolling past the end
+    long long last = view->length - screen_bytes;
+    if (offset > last) offset = last;
+    if (offset < 0) offset = 0;
+    offset -= offset % HEX_VIEW_ROW_BYTES;
+    if (offset != view->offset) view->direction = offset > view->offset ? 1 : -1;
+    view->offset = offset;
+    view->screen_bytes = screen_bytes;
+}
+
+static HexPage* find_page(HexView* view, long long page) {
+    for (int i = 0; i < HEX_VIEW_PAGES; i++) {
+        if (view->pages[i].page == page) return &view->pages[i];
+    }
+    return NULL;
+}
+
+static HexPage* load_page(HexView* view, long long page) {
+    HexPage* slot = &view->pages[0];
+    for (int i = 1; i < HEX_VIEW_PAGES && slot->page >= 0; i++) {
+        if (view->pages[i].page < 0 || view->pages[i].used < slot->used) slot = &view->pages[i];
+    }
+
+    long long start = page * HEX_VIEW_PAGE_SIZE;
+    size_t length = HEX_VIEW_PAGE_SIZE;
+    if (start + (long long)length > view->length) length = (size_t)(view->length - start);
+    long n;
+    if (view->memory) {
+        memcpy(slot->data, view->memory + start, length);
+        n = (long)length;
+    } else {
+        n = image_read_runs(view->image, view->runs, view->run_count, start, slot->data, length);
+    }
+    slot->page = page;
+    slot->length = n > 0 ? (int)n : 0; // Failed reads stay cached as empty, not retried each frame
+    slot->used = view->clock;
+    return slot;
+}
+
+long hex_view_read(HexView* view, long long offset, unsigned char* buffer, size_t length) {
+    view->clock++;
+    long copied = 0;
+    while (length > 0 && offset < view->length) {
+        long long page = offset / HEX_VIEW_PAGE_SIZE;
+        HexPage* cached = find_page(view, page);
+        if (!cached) cached = load_page(view, page);
+        cached->used = view->clock;
+
+        int within = (int)(offset - page * HEX_VIEW_PAGE_SIZE);
+        if (within >= cached->length) break;
+        size_t n = (size_t)(cached->length - within);
+        if (n > length) n = length;
+        memcpy(buffer + copied, cached->data + within, n);
+        copied += (long)n;
+        offset += (long long)n;
+        length -= n;
+        if (cached->length < HEX_VIEW_PAGE_SIZE && offset < view->length) break; // Read error
+    }
+    return copied;
+}
+
+long hex_view_read_direct(HexView* view, long long offset, unsigned char* buffer, size_t length) {
+    if (offset < 0 || offset >= view->length) return 0;
+    if ((long long)length > view->length - offset) length = (size_t)(view->length - offset);
+    if (view->memory) {
+        memcpy(buffer, view->memory + offset, length);
+        return (long)length;
+    }
+    return image_read_runs(view->image, view->runs, view->run_count, offset, buffer, length);
+}
+
+// Load missing pages of [start, end); returns how many were read
+static int prefetch_range(HexView* view, long long start, long long end, int budget) {
+    if (start < 0) start = 0;
+    if (end > view->length) end = view->length;
+    int loaded = 0;
+    for (long long page = start / HEX_VIEW_PAGE_SIZE;
+         loaded < budget && page * HEX_VIEW_PAGE_SIZE < end; page++) {
+        if (find_page(view, page)) continue;
+        // Older than anything on screen, so it is replaced before them
+        load_page(view, page)->used = view->clock - 1;
+        loaded++;
+    }
+    return loaded;
+}
+
+int hex_view_prefetch(HexView* view, int budget) {
+    if (view->memory || view->length == 0 || view->screen_bytes <= 0) return 0;
+    long long screen = view->screen_bytes;
+    long long ahead = view->direction > 0 ? view->offset + screen : view->offset - screen;
+    long long behind = view->direction > 0 ? view->offset - screen : view->offset + screen;
+    int loaded = prefetch_range(view, ahead, ahead + screen, budget);
+    loaded += prefetch_range(view, behind, behind + screen, budget - loaded);
+    return loaded;
+}
@@ -0,0 +1,53 @@
+#ifndef HEXVIEW_H
+#define HEXVIEW_H
+
+#include "image.h"
+
+// Paged hex viewer source
+//
+// The viewer never holds a whole file: bytes are read from the image
+// through the file's data runs one page at a time, into a small cache of
+// recently used pages. Moving the view only reads the pages of the new
+// screen, so a jump anywhere in a multi-GB file costs a screen's worth of
+// reads. Between frames the pages one screen ahead in the scroll
+// direction, then one screen behind, are read in small batches so
+// steady scrolling finds them cached.
+
+#define HEX_VIEW_PAGE_SIZE 4096
+#define HEX_VIEW_PAGES 64 // Cached pages, a quarter MiB
+#define HEX_VIEW_ROW_BYTES 16
+
+typedef struct HexView HexView;
+
+// Viewer reading from image, which may be NULL for in-memory sources only
+HexView* hex_view_create(EvidenceImage* image);
+void hex_view_destroy(HexView* view);
+
+// Show a file's content through its data runs, or length bytes held by
+// the caller, which must stay valid while shown. Either resets the view
+// to the start. Returns 0, or -1 when out of memory.
+int hex_view_set_runs(HexView* view, const ImageRun* runs, int run_count, long long length);
+void hex_view_set_memory(HexView* view, const unsigned char* bytes, long long length);
+
+long long hex_view_length(const HexView* view);
+
+// First shown byte, always a multiple of HEX_VIEW_ROW_BYTES
+long long hex_view_offset(const HexView* view);
+
+// Move the view so offset is on the top row, clamped to keep a screen of
+// screen_bytes filled where the source allows
+void hex_view_scroll(HexView* view, long long offset, int screen_bytes);
+
+// Copy shown bytes, reading missing pages. Returns the bytes copied,
+// short at the end of the source or on a read error.
+long hex_view_read(HexView* view, long long offset, unsigned char* buffer, size_t length);
+
+// Copy bytes straight from the source, leaving the page cache alone.
+// For consumers streaming through the file, such as strings extraction.
+long hex_view_read_direct(HexView* view, long long offset, unsigned char* buffer, size_t length);
+
+// Read up to budget missing pages around the current screen; returns the
+// number read. Meant for idle time between frames.
+int hex_view_prefetch(HexView* view, int budget);
+
+#endif
@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+#include "image.h"
+#include "ewf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct EvidenceImage {
+    ImageFormat format;
+    long long size;
+
+    // Raw backend
+    int fd;
+    unsigned char* map;
+    long page_size;
+
+    // E01 backend
+    EwfImage* ewf;
+};
+
+static int open_raw(EvidenceImage* image, const char* path) {
+    image->fd = open(path, O_RDONLY);
+    if (image->fd < 0) return -1;
+
+    // lseek also reports the size of block devices
+    off_t size = lseek(image->fd, 0, SEEK_END);
+    if (size <= 0) return -1;
+    image->size = (long long)size;
+
+    void* map = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, image->fd, 0);
+    if (map == MAP_FAILED) return -1;
+    image->map = map;
+    image->page_size = sysconf(_SC_PAGESIZE);
+    return 0;
+}
+
+EvidenceImage* image_open(const char* path) {
+    EvidenceImage* image = calloc(1, sizeof(EvidenceImage));
+    if (!image) return NULL;
+    image->fd = -1;
+
+    // Detect the format by content, not by extension
+    unsigned char magic[3] = {0};
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        free(image);
+        return NULL;
+    }
+    ssize_t n = read(fd, magic, sizeof(magic));
+    close(fd);
+
+    if (n == (ssize_t)sizeof(magic) && memcmp(magic, "EVF", 3) == 0) {
+        image->format = IMAGE_FORMAT_EWF;
+        image->ewf = ewf_open(path, EWF_DEFAULT_CACHE_CHUNKS);
+        if (!image->ewf) {
+            image_close(image);
+            return NULL;
+        }
+        image->size = ewf_media_size(image->ewf);
+        return image;
+    }
+
+    image->format = IMAGE_FORMAT_RAW;
+    if (open_raw(image, path) != 0) {
+        image_close(image);
+        return NULL;
+    }
+    return image;
+}
+
+void image_close(EvidenceImage* image) {
+    if (!image) return;
+    if (image->map) munmap(image->map, (size_t)image->size);
+    if (image->fd >= 0) close(image->fd);
+    ewf_close(image->ewf);
+    free(image);
+}
+
+ImageFormat image_format(const EvidenceImage* image) {
+    return image->format;
+}
+
+const char* image_format_name(const EvidenceImage* image) {
+    return image->format == IMAGE_FORMAT_EWF ? "E01" : "RAW";
+}
+
+const char* image_compression_name(const EvidenceImage* image) {
+    return image->format == IMAGE_FORMAT_EWF ? "ZLIB" : "None";
+}
+
+long long image_size(const EvidenceImage* image) {
+    return image->size;
+}
+
+int image_view(EvidenceImage* image, long long offset, size_t length, ImageView* view) {
+    view->data = NULL;
+    view->length = 0;
+    if (offset < 0 || offset >= image->size) return -1;
+    if ((long long)length > image->size - offset) length = (size_t)(image->size - offset);
+
+    if (image->format == IMAGE_FORMAT_RAW) {
+        view->data = image->map + offset;
+        view->length = length;
+        return 0;
+    }
+
+    unsigned int chunk_size = ewf_chunk_size(image->ewf);
+    unsigned int chunk_length;
+    const unsigned char* chunk = ewf_chunk_data(image->ewf, offset / chunk_size, &chunk_length);
+    unsigned int within = (unsigned int)(offset % chunk_size);
+    if (!chunk || within >= chunk_length) return -1;
+
+    view->data = chunk + within;
+    view->length = chunk_length - within < length ? chunk_length - within : length;
+    return 0;
+}
+
+long image_read(EvidenceImage* image, long long offset, void* buffer, size_t length) {
+    if (image->format == IMAGE_FORMAT_EWF) return ewf_read(image->ewf, offset, buffer, length);
+
+    if (offset < 0 || offset > image->size) return -1;
+    if ((long long)length > image->size - offset) length = (size_t)(image->size - offset);
+    memcpy(buffer, image->map + offset, length);
+    return (long)length;
+}
+
+long image_read_runs(EvidenceImage* image, const ImageRun* runs, int run_count,
+                     long long offset, void* buffer, size_t length) {
+    unsigned char* out = buffer;
+    size_t done = 0;
+    for (int i = 0; i < run_count && done < length; i++) {
+        if (offset >= runs[i].length) {
+            offset -= runs[i].length;
+            continue;
+        }
+        size_t n = (size_t)(runs[i].length - offset);
+        if (n > length - done) n = length - done;
+        if (runs[i].offset == IMAGE_RUN_SPARSE) {
+            memset(out + done, 0, n);
+        } else if (image_read(image, runs[i].offset + offset, out + done, n) != (long)n) {
+            return -1;
+        }
+        done += n;
+        offset = 0;
+    }
+    return (long)done;
+}
+
+int image_stored_hashes(const EvidenceImage* image, unsigned char md5[16], unsigned char sha1[20]) {
+    return image->ewf ? ewf_stored_hashes(image->ewf, md5, sha1) : 0;
+}
+
+void image_advise(EvidenceImage* image, long long offset, long long length, ImageAccess access) {
+    // Only the mapping benefits from hints; the EWF cache is its own policy
+    if (image->format != IMAGE_FORMAT_RAW || offset < 0 || offset >= image->size) return;
+    if (length > image->size - offset) length = image->size - offset;
+
+    long long start = offset & ~((long long)image->page_size - 1);
+    length += offset - start;
+
+    int advice = MADV_NORMAL;
+    switch (access) {
+        case IMAGE_ACCESS_SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+        case IMAGE_ACCESS_RANDOM: advice = MADV_RANDOM; break;
+        case IMAGE_ACCESS_WILLNEED: advice = MADV_WILLNEED; break;
+        case IMAGE_ACCESS_DONTNEED: advice = MADV_DONTNEED; break;
+        case IMAGE_ACCESS_NORMAL: default: advice = MADV_NORMAL; break;
+    }
+    madvise(image->map + start, (size_t)length, advice);
+}
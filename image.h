@@ -0,0 +1,71 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stddef.h>
+
+// Evidence image backends
+//
+// Raw/dd images are memory-mapped and handed out as zero-copy views into
+// the mapping, so consumers share the page cache instead of copying.
+// E01 images are served from the EWF chunk cache.
+
+typedef enum {
+    IMAGE_FORMAT_RAW,
+    IMAGE_FORMAT_EWF
+} ImageFormat;
+
+typedef enum {
+    IMAGE_ACCESS_NORMAL,
+    IMAGE_ACCESS_SEQUENTIAL, // Hashing, carving: stream and read ahead
+    IMAGE_ACCESS_RANDOM,     // Hex preview: no read-ahead
+    IMAGE_ACCESS_WILLNEED,   // Prefetch a range that is about to be read
+    IMAGE_ACCESS_DONTNEED    // Drop a range already consumed
+} ImageAccess;
+
+// Read-only view of image bytes. For raw images the pointer is into the
+// mapping and lives as long as the image; for E01 images it is into the
+// chunk cache and lives until the next view or read on the same image.
+typedef struct {
+    const unsigned char* data;
+    size_t length;
+} ImageView;
+
+// Extent of file data inside the image
+typedef struct {
+    long long offset; // IMAGE_RUN_SPARSE for holes that read as zeros
+    long long length;
+} ImageRun;
+
+#define IMAGE_RUN_SPARSE (-1LL)
+
+typedef struct EvidenceImage EvidenceImage;
+
+EvidenceImage* image_open(const char* path);
+void image_close(EvidenceImage* image);
+
+ImageFormat image_format(const EvidenceImage* image);
+const char* image_format_name(const EvidenceImage* image);
+const char* image_compression_name(const EvidenceImage* image);
+long long image_size(const EvidenceImage* image);
+
+// Map [offset, offset + length) without copying. The view may be shorter
+// than requested (E01 views stop at a chunk boundary); returns 0 on success.
+int image_view(EvidenceImage* image, long long offset, size_t length, ImageView* view);
+
+// Copy bytes out; returns the number of bytes read or -1 on error
+long image_read(EvidenceImage* image, long long offset, void* buffer, size_t length);
+
+// Copy bytes of a file's content, given its data runs, starting at a
+// logical offset into the file. Sparse runs read as zeros. Returns the
+// number of bytes read or -1 on error.
+long image_read_runs(EvidenceImage* image, const ImageRun* runs, int run_count,
+                     long long offset, void* buffer, size_t length);
+
+// Acquisition hashes stored in the image container, if any. Returns a
+// mask: 1 when md5 was filled, 2 when sha1 was filled.
+int image_stored_hashes(const EvidenceImage* image, unsigned char md5[16], unsigned char sha1[20]);
+
+// Page-cache hint for a consumer's access pattern over a range
+void image_advise(EvidenceImage* image, long long offset, long long length, ImageAccess access);
+
+#endif
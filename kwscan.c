@@ -0,0 +1,662 @@
+#include "kwscan.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KWSCAN_X86 1
+#endif
+
+#define KEYWORD_BLOCK (1 << 20)  // Owned image bytes per step
+#define KEYWORD_MARGIN 512       // Context read on both sides of a block; longer than any match
+#define TRIPLE_BITS 18           // log2 of the hashed three-byte prefilter's size
+#define EMAIL_LOCAL_MAX 64
+#define EMAIL_DOMAIN_MAX 253
+
+enum { REGEX_EMAIL, REGEX_CARD, REGEX_IPV4, REGEX_COUNT };
+
+static const char* regex_names[REGEX_COUNT] = {"<e-mail>", "<card>", "<IPv4>"};
+
+// Exact byte set membership with two shuffle lookups per nibble pair:
+// bytes below 0x80 use the first table pair, the rest the second
+typedef struct {
+    unsigned char low[2][16];    // By low nibble: bit h for high nibble h (h - 8 in table 1)
+    unsigned char high[2][16];   // By high nibble: its bit in the matching table, else 0
+    unsigned char member[256];
+} ByteSet;
+
+// Bit i set when data[i] is in the set, for 64 bytes
+typedef uint64_t (*MaskFunction)(const ByteSet* set, const unsigned char* data);
+
+static MaskFunction member_mask;
+
+struct KeywordScanner {
+    int keyword_count;
+    int pattern_count;
+    char** names;
+    int regex_ids[REGEX_COUNT];  // Pattern id of each regex, -1 when not selected
+    int max_length;              // Longest keyword form in bytes
+
+    // Automaton: delta[state * class_count + class], state 0 the root
+    unsigned char classes[256];
+    int class_count;
+    int state_count;
+    uint32_t* delta;
+    int* output;                 // Keyword ending at the state, -1
+    int* output_length;
+    int* report;                 // First state along the failure chain with an output, -1
+    int* report_next;            // The one after it
+    ByteSet first;               // Bytes that leave the root
+    ByteSet second;              // Bytes that can follow them
+    uint64_t pairs[1024];        // Bit a << 8 | b when the bytes a, b can begin a keyword form
+    uint64_t triples[(1 << TRIPLE_BITS) / 64]; // The same for three bytes, hashed
+    ByteSet at_signs;            // Anchors of the regex subset: '@',
+    ByteSet digits;              // digit runs,
+    ByteSet follows;             // and what must come after a run's first digit
+};
+
+static inline unsigned char fold(unsigned char byte) {
+    return byte >= 'A' && byte <= 'Z' ? (unsigned char)(byte + 32) : byte;
+}
+
+static inline int is_digit(unsigned char byte) {
+    return byte >= '0' && byte <= '9';
+}
+
+static inline int is_alnum(unsigned char byte) {
+    unsigned char folded = fold(byte);
+    return is_digit(byte) || (folded >= 'a' && folded <= 'z');
+}
+
+static void byte_set_add(ByteSet* set, unsigned char byte) {
+    int table = byte >> 7;
+    set->low[table][byte & 15] |= (unsigned char)(1 << ((byte >> 4) & 7));
+    set->member[byte] = 1;
+}
+
+static void byte_set_finish(ByteSet* set) {
+    for (int nibble = 0; nibble < 16; nibble++) {
+        set->high[0][nibble] = nibble < 8 ? (unsigned char)(1 << nibble) : 0;
+        set->high[1][nibble] = nibble >= 8 ? (unsigned char)(1 << (nibble - 8)) : 0;
+    }
+}
+
+static uint64_t member_mask_portable(const ByteSet* set, const unsigned char* data) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i++) mask |= (uint64_t)set->member[data[i]] << i;
+    return mask;
+}
+
+#ifdef KWSCAN_X86
+
+__attribute__((target("avx2")))
+static inline uint32_t member_mask32_avx2(const ByteSet* set, const unsigned char* data) {
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    const __m256i low0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->low[0]));
+    const __m256i low1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->low[1]));
+    const __m256i high0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->high[0]));
+    const __m256i high1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->high[1]));
+
+    __m256i v = _mm256_loadu_si256((const __m256i*)data);
+    __m256i low = _mm256_and_si256(v, low_nibble);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble);
+    __m256i hits = _mm256_or_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(low0, low), _mm256_shuffle_epi8(high0, high)),
+        _mm256_and_si256(_mm256_shuffle_epi8(low1, low), _mm256_shuffle_epi8(high1, high)));
+    return ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hits, _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx2")))
+static uint64_t member_mask_avx2(const ByteSet* set, const unsigned char* data) {
+    return (uint64_t)member_mask32_avx2(set, data) | (uint64_t)member_mask32_avx2(set, data + 32) << 32;
+}
+
+#endif
+
+__attribute__((constructor))
+static void kwscan_select_kernel(void) {
+    member_mask = member_mask_portable;
+#ifdef KWSCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) member_mask = member_mask_avx2;
+#endif
+}
+
+const char* keyword_engine_name(void) {
+#ifdef KWSCAN_X86
+    if (member_mask == member_mask_avx2) return "AVX2";
+#endif
+    return "portable";
+}
+
+static inline uint32_t triple_hash(uint32_t bytes) {
+    return (bytes * 0x9E3779B1u) >> (32 - TRIPLE_BITS);
+}
+
+// Trie of every keyword form, turned into the automaton in place
+typedef struct {
+    uint32_t* next;
+    int* output;
+    int* output_length;
+    int count;
+    int capacity;
+    int class_count;
+} Trie;
+
+static int trie_new_state(Trie* trie) {
+    if (trie->count == trie->capacity) {
+        int capacity = trie->capacity ? trie->capacity * 2 : 256;
+        uint32_t* next = realloc(trie->next, (size_t)capacity * (size_t)trie->class_count * sizeof(uint32_t));
+        if (next) trie->next = next;
+        int* output = realloc(trie->output, (size_t)capacity * sizeof(int));
+        if (output) trie->output = output;
+        int* output_length = realloc(trie->output_length, (size_t)capacity * sizeof(int));
+        if (output_length) trie->output_length = output_length;
+        if (!next || !output || !output_length) return -1;
+        trie->capacity = capacity;
+    }
+    int state = trie->count++;
+    memset(trie->next + (size_t)state * (size_t)trie->class_count, 0, (size_t)trie->class_count * sizeof(uint32_t));
+    trie->output[state] = -1;
+    trie->output_length[state] = 0;
+    return state;
+}
+
+static int trie_insert(Trie* trie, const unsigned char* classes, const unsigned char* bytes, int length,
+                       int pattern) {
+    int state = 0;
+    for (int i = 0; i < length; i++) {
+        uint32_t* slot = &trie->next[(size_t)state * (size_t)trie->class_count + classes[bytes[i]]];
+        if (*slot == 0) {
+            int child = trie_new_state(trie);
+            if (child < 0) return -1;
+            // The table may have moved
+            slot = &trie->next[(size_t)state * (size_t)trie->class_count + classes[bytes[i]]];
+            *slot = (uint32_t)child;
+        }
+        state = (int)*slot;
+    }
+    if (trie->output[state] < 0) { // The first of duplicate keywords reports
+        trie->output[state] = pattern;
+        trie->output_length[state] = length;
+    }
+    return 0;
+}
+
+// Fill in failure transitions breadth first, so every state has a move
+// for every class
+static int build_automaton(KeywordScanner* scanner, Trie* trie) {
+    int states = trie->count;
+    int classes = trie->class_count;
+    int* fail = malloc((size_t)states * sizeof(int));
+    int* queue = malloc((size_t)states * sizeof(int));
+    scanner->report = malloc((size_t)states * sizeof(int));
+    scanner->report_next = malloc((size_t)states * sizeof(int));
+    if (!fail || !queue || !scanner->report || !scanner->report_next) {
+        free(fail);
+        free(queue);
+        return -1;
+    }
+
+    int head = 0, tail = 0;
+    fail[0] = 0;
+    scanner->report[0] = -1;
+    scanner->report_next[0] = -1;
+    for (int c = 0; c < classes; c++) {
+        int child = (int)trie->next[c];
+        if (child) {
+            fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        int state = queue[head++];
+        int suffix = fail[state];
+        scanner->report[state] = trie->output[state] >= 0 ? state : scanner->report[suffix];
+        scanner->report_next[state] = scanner->report[suffix];
+
+        uint32_t* row = &trie->next[(size_t)state * (size_t)classes];
+        const uint32_t* fallback = &trie->next[(size_t)suffix * (size_t)classes];
+        for (int c = 0; c < classes; c++) {
+            if (row[c]) {
+                fail[row[c]] = (int)fallback[c];
+                queue[tail++] = (int)row[c];
+            } else {
+                row[c] = fallback[c];
+            }
+        }
+    }
+    free(fail);
+    free(queue);
+
+    scanner->delta = trie->next;
+    scanner->output = trie->output;
+    scanner->output_length = trie->output_length;
+    scanner->state_count = states;
+    return 0;
+}
+
+KeywordScanner* keyword_scanner_create(const char* const* keywords, int count, int patterns) {
+    KeywordScanner* scanner = calloc(1, sizeof(KeywordScanner));
+    if (!scanner) return NULL;
+    scanner->names = calloc((size_t)count + REGEX_COUNT, sizeof(char*));
+    if (!scanner->names) {
+        free(scanner);
+        return NULL;
+    }
+    scanner->keyword_count = count;
+
+    // Byte classes: one per folded byte some keyword uses, 0 for the rest.
+    // UTF-16LE forms add the zero byte.
+    int usable = 0;
+    scanner->class_count = 1;
+    for (int k = 0; k < count; k++) {
+        size_t length = strlen(keywords[k]);
+        if (length == 0 || length > KEYWORD_MAX_LENGTH) continue;
+        usable++;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char byte = fold((unsigned char)keywords[k][i]);
+            if (!scanner->classes[byte] && byte != 0) scanner->classes[byte] = (unsigned char)scanner->class_count++;
+        }
+    }
+    if (usable > 0) scanner->classes[0] = (unsigned char)scanner->class_count++;
+    for (int byte = 'A'; byte <= 'Z'; byte++) scanner->classes[byte] = scanner->classes[byte + 32];
+
+    Trie trie = {NULL, NULL, NULL, 0, 0, scanner->class_count};
+    int status = trie_new_state(&trie) < 0 ? -1 : 0;
+    unsigned char wide[2 * KEYWORD_MAX_LENGTH];
+    for (int k = 0; k < count && status == 0; k++) {
+        size_t length = strlen(keywords[k]);
+        scanner->names[k] = malloc(length + 1);
+        if (!scanner->names[k]) {
+            status = -1;
+            break;
+        }
+        memcpy(scanner->names[k], keywords[k], length + 1);
+        if (length == 0 || length > KEYWORD_MAX_LENGTH) continue;
+
+        const unsigned char* bytes = (const unsigned char*)keywords[k];
+        for (size_t i = 0; i < length; i++) {
+            wide[2 * i] = bytes[i];
+            wide[2 * i + 1] = 0;
+        }
+        status = trie_insert(&trie, scanner->classes, bytes, (int)length, k);
+        if (status == 0) status = trie_insert(&trie, scanner->classes, wide, (int)(2 * length), k);
+        if (2 * (int)length > scanner->max_length) scanner->max_length = 2 * (int)length;
+    }
+    scanner->pattern_count = count;
+
+    // Prefilter from the trie's own edges, before failure moves fill it in:
+    // first bytes, and the pairs and triples a keyword form can open with
+    for (int first = 0; first < 256 && status == 0; first++) {
+        uint32_t child = trie.next[scanner->classes[first]];
+        if (child == 0) continue;
+        byte_set_add(&scanner->first, (unsigned char)first);
+        const uint32_t* row = &trie.next[(size_t)child * (size_t)trie.class_count];
+        for (int second = 0; second < 256; second++) {
+            uint32_t grandchild = row[scanner->classes[second]];
+            if (trie.output[child] < 0 && grandchild == 0) continue;
+            unsigned pair = (unsigned)first << 8 | (unsigned)second;
+            scanner->pairs[pair >> 6] |= 1ULL << (pair & 63);
+            byte_set_add(&scanner->second, (unsigned char)second);
+
+            // A form ending within the pair admits any third byte
+            int open = trie.output[child] >= 0 || trie.output[grandchild] >= 0;
+            const uint32_t* next = &trie.next[(size_t)grandchild * (size_t)trie.class_count];
+            for (int third = 0; third < 256; third++) {
+                if (!open && next[scanner->classes[third]] == 0) continue;
+                uint32_t triple = triple_hash((unsigned)pair << 8 | (unsigned)third);
+                scanner->triples[triple >> 6] |= 1ULL << (triple & 63);
+            }
+        }
+    }
+    byte_set_finish(&scanner->first);
+    byte_set_finish(&scanner->second);
+
+    if (status == 0) status = build_automaton(scanner, &trie);
+    if (status != 0) {
+        free(trie.next);
+        free(trie.output);
+        free(trie.output_length);
+        keyword_scanner_destroy(scanner);
+        return NULL;
+    }
+
+    for (int r = 0; r < REGEX_COUNT; r++) {
+        scanner->regex_ids[r] = -1;
+        if (!(patterns & (1 << r))) continue;
+        scanner->regex_ids[r] = scanner->pattern_count;
+        scanner->names[scanner->pattern_count++] = (char*)regex_names[r];
+    }
+    byte_set_add(&scanner->at_signs, '@');
+    byte_set_finish(&scanner->at_signs);
+    for (int digit = '0'; digit <= '9'; digit++) {
+        byte_set_add(&scanner->digits, (unsigned char)digit);
+        byte_set_add(&scanner->follows, (unsigned char)digit);
+    }
+    byte_set_finish(&scanner->digits);
+    byte_set_add(&scanner->follows, '.');
+    byte_set_add(&scanner->follows, ' ');
+    byte_set_add(&scanner->follows, '-');
+    byte_set_finish(&scanner->follows);
+
+    if (usable == 0 && !(patterns & KEYWORD_PATTERN_ALL)) {
+        keyword_scanner_destroy(scanner);
+        return NULL;
+    }
+    return scanner;
+}
+
+void keyword_scanner_destroy(KeywordScanner* scanner) {
+    if (!scanner) return;
+    // Regex names are static
+    for (int k = 0; k < scanner->keyword_count; k++) free(scanner->names[k]);
+    free(scanner->names);
+    free(scanner->delta);
+    free(scanner->output);
+    free(scanner->output_length);
+    free(scanner->report);
+    free(scanner->report_next);
+    free(scanner);
+}
+
+int keyword_pattern_count(const KeywordScanner* scanner) {
+    return scanner->pattern_count;
+}
+
+const char* keyword_pattern_name(const KeywordScanner* scanner, int pattern) {
+    if (pattern < 0 || pattern >= scanner->pattern_count) return NULL;
+    return scanner->names[pattern];
+}
+
+static int add_hit(KeywordHitList* hits, long long offset, int length, int pattern) {
+    if (hits->count == hits->capacity) {
+        size_t capacity = hits->capacity ? hits->capacity * 2 : 256;
+        KeywordHit* grown = realloc(hits->hits, capacity * sizeof(KeywordHit));
+        if (!grown) return -1;
+        hits->hits = grown;
+        hits->capacity = capacity;
+    }
+    KeywordHit* hit = &hits->hits[hits->count++];
+    hit->offset = offset;
+    hit->length = length;
+    hit->pattern = pattern;
+    hit->file_index = -1;
+    hit->file_offset = -1;
+    return 0;
+}
+
+// Regex recognizers. Each gets the block with its margins and a position,
+// and returns the match length with *start set, or 0.
+
+static inline int email_local(unsigned char byte) {
+    return is_alnum(byte) || byte == '.' || byte == '_' || byte == '%' || byte == '+' || byte == '-';
+}
+
+static int match_email(const unsigned char* data, size_t length, size_t at, size_t* start) {
+    size_t local = at;
+    while (local > 0 && at - local < EMAIL_LOCAL_MAX && email_local(data[local - 1])) local--;
+    if (local > 0 && email_local(data[local - 1])) return 0; // Local part too long
+    while (local < at && data[local] == '.') local++;
+    if (local == at) return 0;
+
+    size_t end = at + 1;
+    while (end < length && end - at <= EMAIL_DOMAIN_MAX &&
+           (is_alnum(data[end]) || data[end] == '-' || data[end] == '.')) end++;
+    while (end > at + 1 && (data[end - 1] == '.' || data[end - 1] == '-')) end--;
+    if (end <= at + 1 || !is_alnum(data[at + 1])) return 0;
+
+    // At least one dot, and a top-level label of two or more letters
+    size_t label = end;
+    while (label > at + 1 && data[label - 1] != '.') label--;
+    if (label == at + 1 || end - label < 2) return 0;
+    for (size_t i = label; i < end; i++) {
+        if (is_digit(data[i]) || data[i] == '-') return 0;
+    }
+    *start = local;
+    return (int)(end - local);
+}
+
+static int match_ipv4(const unsigned char* data, size_t length, size_t at) {
+    size_t i = at;
+    for (int octet = 0; octet < 4; octet++) {
+        if (octet > 0) {
+            if (i >= length || data[i] != '.') return 0;
+            i++;
+        }
+        size_t first = i;
+        int value = 0;
+        while (i < length && is_digit(data[i]) && i - first < 3) value = value * 10 + (data[i++] - '0');
+        if (i == first || value > 255 || (i - first > 1 && data[first] == '0')) return 0;
+    }
+    if (i < length && (is_alnum(data[i]) || (data[i] == '.' && i + 1 < length && is_digit(data[i + 1])))) {
+        return 0;
+    }
+    return (int)(i - at);
+}
+
+// 13 to 19 digits, optionally grouped by single spaces or dashes, with a
+// valid Luhn check digit and an issuer prefix of 2 to 6
+static int match_card(const unsigned char* data, size_t length, size_t at) {
+    unsigned char digits[19];
+    int count = 0;
+    size_t i = at;
+    while (i < length) {
+        if (is_digit(data[i])) {
+            if (count == 19) return 0;
+            digits[count++] = (unsigned char)(data[i++] - '0');
+        } else if ((data[i] == ' ' || data[i] == '-') && i + 1 < length && is_digit(data[i + 1])) {
+            i++;
+        } else {
+            break;
+        }
+    }
+    if (count < 13 || digits[0] < 2 || digits[0] > 6) return 0;
+    if (i < length && is_alnum(data[i])) return 0;
+
+    int sum = 0;
+    for (int d = 0; d < count; d++) {
+        int value = digits[count - 1 - d];
+        if (d & 1) {
+            value *= 2;
+            if (value > 9) value -= 9;
+        }
+        sum += value;
+    }
+    return sum % 10 == 0 ? (int)(i - at) : 0;
+}
+
+// Members of set in data[from, to), at most 64 bytes
+static inline uint64_t window_mask(const ByteSet* set, const unsigned char* data, size_t from, size_t to) {
+    if (to - from >= 64) return member_mask(set, data + from);
+    uint64_t mask = 0;
+    for (size_t i = from; i < to; i++) mask |= (uint64_t)set->member[data[i]] << (i - from);
+    return mask;
+}
+
+// Whether a keyword form can start at data[at], by its first two and
+// three bytes
+static inline int may_start(const KeywordScanner* scanner, const unsigned char* data, size_t at, size_t length) {
+    if (at + 1 >= length) return 1;
+    uint32_t pair = (uint32_t)data[at] << 8 | data[at + 1];
+    if (!((scanner->pairs[pair >> 6] >> (pair & 63)) & 1)) return 0;
+    if (at + 2 >= length) return 1;
+    uint32_t triple = triple_hash(pair << 8 | data[at + 2]);
+    return (int)(scanner->triples[triple >> 6] >> (triple & 63)) & 1;
+}
+
+// Matches in data starting in [lead, lead + owned); data holds length
+// bytes, the first at image offset base - lead
+static int scan_block(const KeywordScanner* scanner, const unsigned char* data, size_t length,
+                      size_t lead, size_t owned, long long base, KeywordHitList* hits) {
+    long long origin = base - (long long)lead;
+    size_t owned_end = lead + owned;
+
+    // Keywords: between matches the automaton is at its root, and the
+    // masks skip to the next byte pair that can begin a keyword form
+    size_t limit = owned_end + (size_t)scanner->max_length;
+    if (limit > length) limit = length;
+    const uint32_t* delta = scanner->delta;
+    size_t classes = (size_t)scanner->class_count;
+    size_t i = lead;
+    while (i < owned_end) {
+        size_t candidate = owned_end;
+        for (size_t window = i; window < owned_end && candidate == owned_end; window += 64) {
+            size_t window_end = owned_end - window < 64 ? owned_end : window + 64;
+            uint64_t mask = window_mask(&scanner->first, data, window, window_end);
+            if (mask) {
+                size_t next_end = window_end + 1 < length ? window_end + 1 : length;
+                uint64_t seconds = window_mask(&scanner->second, data, window + 1, next_end);
+                if (next_end == length && next_end - window - 1 < 64) {
+                    seconds |= ~0ULL << (next_end - window - 1); // Nothing follows the last byte
+                }
+                mask &= seconds;
+            }
+            for (; mask; mask &= mask - 1) {
+                size_t at = window + (size_t)__builtin_ctzll(mask);
+                if (may_start(scanner, data, at, length)) {
+                    candidate = at;
+                    break;
+                }
+            }
+        }
+        if (candidate >= owned_end) break;
+
+        uint32_t state = 0;
+        for (i = candidate; i < limit; ) {
+            state = delta[state * classes + scanner->classes[data[i++]]];
+            if (state == 0) break;
+            for (int s = scanner->report[state]; s >= 0; s = scanner->report_next[s]) {
+                size_t start = i - (size_t)scanner->output_length[s];
+                if (start >= owned_end) continue;
+                if (add_hit(hits, origin + (long long)start, scanner->output_length[s], scanner->output[s]) != 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Regex subset, from anchors up to an e-mail's local part past the block
+    int email = scanner->regex_ids[REGEX_EMAIL];
+    int card = scanner->regex_ids[REGEX_CARD];
+    int ipv4 = scanner->regex_ids[REGEX_IPV4];
+    if (email < 0 && card < 0 && ipv4 < 0) return 0;
+    size_t anchor_end = owned_end + EMAIL_LOCAL_MAX + 1;
+    if (anchor_end > length) anchor_end = length;
+    size_t resume = lead; // Past the last digit run matched
+    for (size_t window = lead; window < anchor_end; window += 64) {
+        size_t window_end = anchor_end - window < 64 ? anchor_end : window + 64;
+        uint64_t mask = email >= 0 ? window_mask(&scanner->at_signs, data, window, window_end) : 0;
+        if ((card >= 0 || ipv4 >= 0) && window < owned_end) {
+            // First digits of runs, followed by a digit or a separator
+            uint64_t digits = window_mask(&scanner->digits, data, window, window_end);
+            size_t next_end = window_end + 1 < length ? window_end + 1 : length;
+            uint64_t follows = window_mask(&scanner->follows, data, window + 1, next_end);
+            uint64_t previous = window > 0 && is_digit(data[window - 1]);
+            mask |= digits & ~(digits << 1 | previous) & follows;
+        }
+        for (; mask; mask &= mask - 1) {
+            size_t at = window + (size_t)__builtin_ctzll(mask);
+            if (data[at] == '@') {
+                size_t start;
+                int match = match_email(data, length, at, &start);
+                if (match && start >= lead && start < owned_end &&
+                    add_hit(hits, origin + (long long)start, match, email) != 0) return -1;
+                continue;
+            }
+
+            // Digit runs are tried once, at their first digit
+            if (at < resume || at >= owned_end) continue;
+            unsigned char before = at > 0 ? data[at - 1] : ' ';
+            if (is_alnum(before) || before == '.' || before == '-') continue;
+            int match = ipv4 >= 0 ? match_ipv4(data, length, at) : 0;
+            if (match && add_hit(hits, origin + (long long)at, match, ipv4) != 0) return -1;
+            if (!match && card >= 0) {
+                match = match_card(data, length, at);
+                if (match && add_hit(hits, origin + (long long)at, match, card) != 0) return -1;
+            }
+            resume = at + (size_t)match;
+        }
+    }
+    return 0;
+}
+
+int keyword_scan_image(const KeywordScanner* scanner, EvidenceImage* image, long long start, long long end,
+                       KeywordHitList* hits, long long* progress, const int* cancel) {
+    long long size = image_size(image);
+    if (end > size) end = size;
+    if (start >= end) return 0;
+
+    unsigned char* buffer = malloc(KEYWORD_BLOCK + 2 * KEYWORD_MARGIN);
+    if (!buffer) return -1;
+    image_advise(image, start, end - start, IMAGE_ACCESS_SEQUENTIAL);
+
+    int status = 0;
+    for (long long offset = start; offset < end && status == 0; offset += KEYWORD_BLOCK) {
+        if (cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+            status = -1;
+            break;
+        }
+        size_t owned = end - offset < KEYWORD_BLOCK ? (size_t)(end - offset) : KEYWORD_BLOCK;
+        long long first = offset - KEYWORD_MARGIN > 0 ? offset - KEYWORD_MARGIN : 0;
+        long long last = offset + (long long)owned + KEYWORD_MARGIN < size ?
+                         offset + (long long)owned + KEYWORD_MARGIN : size;
+        size_t length = (size_t)(last - first);
+
+        // Raw images are scanned in place; everything else through the buffer
+        const unsigned char* data;
+        ImageView view;
+        if (image_view(image, first, length, &view) == 0 && view.length >= length) {
+            data = view.data;
+        } else {
+            long got = image_read(image, first, buffer, length);
+            if (got < (long)(offset - first + (long long)owned)) {
+                status = -1;
+                break;
+            }
+            length = (size_t)got;
+            data = buffer;
+        }
+
+        status = scan_block(scanner, data, length, (size_t)(offset - first), owned, offset, hits);
+        if (progress) __atomic_add_fetch(progress, (long long)owned, __ATOMIC_RELAXED);
+    }
+
+    image_advise(image, start, end - start, IMAGE_ACCESS_DONTNEED);
+    free(buffer);
+    return status;
+}
+
+int keyword_hit_list_append(KeywordHitList* hits, const KeywordHitList* other) {
+    if (hits->count + other->count > hits->capacity) {
+        size_t capacity = hits->capacity ? hits->capacity : 256;
+        while (capacity < hits->count + other->count) capacity *= 2;
+        KeywordHit* grown = realloc(hits->hits, capacity * sizeof(KeywordHit));
+        if (!grown) return -1;
+        hits->hits = grown;
+        hits->capacity = capacity;
+    }
+    if (other->count > 0) memcpy(hits->hits + hits->count, other->hits, other->count * sizeof(KeywordHit));
+    hits->count += other->count;
+    return 0;
+}
+
+static int compare_hits(const void* a, const void* b) {
+    const KeywordHit* x = a;
+    const KeywordHit* y = b;
+    if (x->offset != y->offset) return x->offset < y->offset ? -1 : 1;
+    return x->pattern - y->pattern;
+}
+
+void keyword_hit_list_sort(KeywordHitList* hits) {
+    if (hits->count > 1) qsort(hits->hits, hits->count, sizeof(KeywordHit), compare_hits);
+}
+
+void keyword_hit_list_free(KeywordHitList* hits) {
+    free(hits->hits);
+    hits->hits = NULL;
+    hits->count = 0;
+    hits->capacity = 0;
+}
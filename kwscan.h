@@ -0,0 +1,70 @@
+#ifndef KWSCAN_H
+#define KWSCAN_H
+
+#include <stddef.h>
+
+#include "image.h"
+
+// Multi-pattern keyword scanner over raw image bytes
+//
+// One pass over the image finds every keyword of a list, in ASCII and
+// UTF-16LE and without regard to case, along with a fixed regex subset:
+// e-mail addresses, payment card numbers (Luhn-checked) and IPv4
+// addresses. Keywords compile into one Aho-Corasick automaton over byte
+// classes. While the automaton is at its root, a SIMD shuffle lookup
+// skips every byte that cannot start a keyword, so runs of binary or
+// empty space cost a few instructions per 32 bytes. The regex subset is
+// matched by recognizers anchored on '@' and on digit runs, found with
+// the same SIMD lookups. Scanning is unallocated space and files alike;
+// hits carry image offsets.
+
+#define KEYWORD_MAX_LENGTH 128 // Longer keywords are refused
+
+typedef enum {
+    KEYWORD_PATTERN_EMAIL = 1 << 0,
+    KEYWORD_PATTERN_CARD = 1 << 1,
+    KEYWORD_PATTERN_IPV4 = 1 << 2,
+    KEYWORD_PATTERN_ALL = 0x7
+} KeywordPatterns;
+
+typedef struct {
+    long long offset;       // Image offset of the first byte
+    int length;             // Bytes
+    int pattern;            // Keyword index, or a regex pattern after the keywords
+    int file_index;         // Set by the caller; -1 when unknown or unallocated
+    long long file_offset;
+} KeywordHit;
+
+typedef struct {
+    KeywordHit* hits;
+    size_t count;
+    size_t capacity;
+} KeywordHitList;
+
+typedef struct KeywordScanner KeywordScanner;
+
+// Compile keywords and the regex patterns selected by the mask. The
+// scanner is read-only afterwards and may be shared between threads.
+// Returns NULL when out of memory or nothing is left to match.
+KeywordScanner* keyword_scanner_create(const char* const* keywords, int count, int patterns);
+void keyword_scanner_destroy(KeywordScanner* scanner);
+
+// Prefilter kernel selected at startup, e.g. "AVX2"
+const char* keyword_engine_name(void);
+
+// Keywords and regex patterns, in the order hits refer to them
+int keyword_pattern_count(const KeywordScanner* scanner);
+const char* keyword_pattern_name(const KeywordScanner* scanner, int pattern);
+
+// Find the matches that start in [start, end) of the image. Adds the
+// bytes scanned to *progress and stops early once *cancel is set; both
+// may be NULL. Returns 0 on success.
+int keyword_scan_image(const KeywordScanner* scanner, EvidenceImage* image, long long start, long long end,
+                       KeywordHitList* hits, long long* progress, const int* cancel);
+
+// Append another list's hits; returns -1 when out of memory
+int keyword_hit_list_append(KeywordHitList* hits, const KeywordHitList* other);
+void keyword_hit_list_sort(KeywordHitList* hits);
+void keyword_hit_list_free(KeywordHitList* hits);
+
+#endif
@@ -0,0 +1,262 @@
+#define GL_GLEXT_PROTOTYPES // Shaders and instancing are GL 2.0-3.3 entry points
+#include "model.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MODEL_RADIUS 4.0f      // Outermost ring
+#define MODEL_HEIGHT 3.0f      // Root at the top, deepest ring at the bottom
+#define MODEL_LOD_RATIO 0.01f  // Subtree extent over camera distance below which it aggregates
+#define MODEL_MESH_VERTICES 36
+
+#define ATTRIBUTE_INSTANCE 1   // Generic attribute slots; 0 aliases gl_Vertex
+#define ATTRIBUTE_TINT 2
+
+static const char* vertex_shader =
+    "#version 120\n"
+    "attribute vec4 instance; // xyz position, w scale\n"
+    "attribute vec4 tint;     // Lit like GL_COLOR_MATERIAL does for the batch fallback\n"
+    "varying vec4 color;\n"
+    "void main() {\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(gl_Vertex.xyz * instance.w + instance.xyz, 1.0);\n"
+    "    vec3 normal = normalize(gl_NormalMatrix * gl_Normal);\n"
+    "    float diffuse = max(dot(normal, normalize(gl_LightSource[0].position.xyz)), 0.0);\n"
+    "    vec3 light = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb + gl_LightSource[0].diffuse.rgb * diffuse;\n"
+    "    color = vec4(tint.rgb * light, 1.0);\n"
+    "}\n";
+
+static const char* fragment_shader =
+    "#version 120\n"
+    "varying vec4 color;\n"
+    "void main() {\n"
+    "    gl_FragColor = color;\n"
+    "}\n";
+
+static const unsigned char type_colors[7][3] = {
+    {255, 255, 0},   // Folder
+    {255, 0, 0},     // Executable
+    {0, 255, 0},     // Image
+    {0, 0, 255},     // Document
+    {128, 128, 255}, // Text
+    {255, 0, 255},   // Deleted
+    {179, 179, 179}, // Unknown
+};
+
+static unsigned int compile_shader(GLenum kind, const char* source) {
+    GLuint shader = glCreateShader(kind);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "Warning: 3D model shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static unsigned int link_program(void) {
+    GLuint vertex = compile_shader(GL_VERTEX_SHADER, vertex_shader);
+    GLuint fragment = compile_shader(GL_FRAGMENT_SHADER, fragment_shader);
+    GLuint program = 0;
+    if (vertex && fragment) {
+        program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glBindAttribLocation(program, ATTRIBUTE_INSTANCE, "instance");
+        glBindAttribLocation(program, ATTRIBUTE_TINT, "tint");
+        glLinkProgram(program);
+        GLint ok = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (vertex) glDeleteShader(vertex);
+    if (fragment) glDeleteShader(fragment);
+    return program;
+}
+
+void model_init(ModelView* model) {
+    memset(model, 0, sizeof(*model));
+
+    // Instanced arrays need GL 3.3
+    int major = 0, minor = 0;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 33) return;
+    model->program = link_program();
+    if (!model->program) return;
+
+    // One unit cube shared by every instance
+    RenderBatch mesh;
+    memset(&mesh, 0, sizeof(mesh));
+    batch_cube(&mesh, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+    if (mesh.count != MODEL_MESH_VERTICES) {
+        free(mesh.vertices);
+        free(mesh.uploaded);
+        return;
+    }
+    glGenBuffers(1, &model->mesh_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, model->mesh_buffer);
+    glBufferData(GL_ARRAY_BUFFER, MODEL_MESH_VERTICES * sizeof(RenderVertex), mesh.vertices, GL_STATIC_DRAW);
+    glGenBuffers(1, &model->instance_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    free(mesh.vertices);
+    free(mesh.uploaded);
+    model->instanced = 1;
+}
+
+void model_free(ModelView* model) {
+    if (model->program) glDeleteProgram(model->program);
+    if (model->mesh_buffer) glDeleteBuffers(1, &model->mesh_buffer);
+    if (model->instance_buffer) glDeleteBuffers(1, &model->instance_buffer);
+    free(model->instances);
+    free(model->uploaded);
+    memset(model, 0, sizeof(*model));
+}
+
+static int grow_instances(ModelView* model) {
+    int capacity = model->capacity ? model->capacity * 2 : 4096;
+    if (capacity > MODEL_MAX_INSTANCES) capacity = MODEL_MAX_INSTANCES;
+    ModelInstance* instances = realloc(model->instances, (size_t)capacity * sizeof(ModelInstance));
+    if (!instances) return -1;
+    model->instances = instances;
+    ModelInstance* uploaded = realloc(model->uploaded, (size_t)capacity * sizeof(ModelInstance));
+    if (!uploaded) return -1;
+    model->uploaded = uploaded;
+    model->capacity = capacity;
+    return 0;
+}
+
+int model_build(ModelView* model, const FileTable* table, int selected, const float eye[3]) {
+    model->count = 0;
+    model->aggregates = 0;
+    const FileColumns* columns = file_table_columns(table);
+    int count = file_table_count(table);
+    if (count == 0) return 0;
+
+    // Ring spacing follows the deepest entry; only new entries can deepen it
+    if (count < model->layout_count) model->layout_count = model->max_depth = 0;
+    for (int i = model->layout_count; i < count; i++) {
+        if (columns->depth[i] > model->max_depth) model->max_depth = columns->depth[i];
+    }
+    model->layout_count = count;
+    float levels = model->max_depth > 0 ? (float)model->max_depth : 1.0f;
+    float spacing = MODEL_RADIUS / levels;
+    float base_scale = spacing < 0.8f ? spacing : 0.8f;
+    float sector = (float)(2.0 * M_PI) / (float)count;
+
+    for (int i = 0; i < count;) {
+        if (model->count == model->capacity && (model->count == MODEL_MAX_INSTANCES || grow_instances(model) != 0)) break;
+
+        int depth = columns->depth[i];
+        int last = columns->last[i];
+        float ring = MODEL_RADIUS * depth / levels;
+        float angle = sector * 0.5f * (float)(i + last + 1);
+        ModelInstance* instance = &model->instances[model->count++];
+        instance->position[0] = ring * cosf(angle);
+        instance->position[1] = MODEL_HEIGHT * (0.5f - depth / levels);
+        instance->position[2] = ring * sinf(angle);
+
+        // A subtree aggregates when its wedge is small on screen, or once
+        // the budget is nearly spent, unless it leads to the selection
+        int aggregate = 0;
+        float extent = MODEL_RADIUS * sector * (float)(last - i + 1);
+        if (extent > MODEL_RADIUS) extent = MODEL_RADIUS;
+        if (last > i && !(selected >= i && selected <= last)) {
+            float dx = instance->position[0] - eye[0];
+            float dy = instance->position[1] - eye[1];
+            float dz = instance->position[2] - eye[2];
+            float distance = sqrtf(dx * dx + dy * dy + dz * dz) + 1e-3f;
+            aggregate = extent / distance < MODEL_LOD_RATIO || model->count >= MODEL_MAX_INSTANCES - depth - 1;
+        }
+
+        const unsigned char* rgb = type_colors[columns->type[i] < 7 ? columns->type[i] : 6];
+        float shade = 1.0f;
+        if (aggregate) {
+            // Grows with the number of entries it stands for but stays inside
+            // its wedge, dimmed to tell it apart
+            instance->scale = base_scale * (0.3f + 0.15f * log10f((float)(last - i + 1)));
+            if (instance->scale > extent) instance->scale = extent > 0.05f ? extent : 0.05f;
+            shade = 0.6f;
+            model->aggregates++;
+        } else {
+            instance->scale = base_scale * (0.3f + 0.07f * log10f((float)columns->size[i] + 1.0f));
+        }
+        for (int c = 0; c < 3; c++) {
+            float value = rgb[c] * shade + (i == selected ? 77.0f : 0.0f);
+            instance->color[c] = (unsigned char)(value > 255.0f ? 255.0f : value);
+        }
+        instance->color[3] = 255;
+
+        i = aggregate ? last + 1 : i + 1;
+    }
+    return model->count;
+}
+
+static void draw_instanced(ModelView* model) {
+    glBindBuffer(GL_ARRAY_BUFFER, model->instance_buffer);
+    // Camera moves rarely change which boxes are drawn; upload only when they do
+    size_t bytes = (size_t)model->count * sizeof(ModelInstance);
+    if (model->count != model->uploaded_count || memcmp(model->instances, model->uploaded, bytes) != 0) {
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, model->instances, GL_STREAM_DRAW);
+        memcpy(model->uploaded, model->instances, bytes);
+        model->uploaded_count = model->count;
+    }
+    glEnableVertexAttribArray(ATTRIBUTE_INSTANCE);
+    glEnableVertexAttribArray(ATTRIBUTE_TINT);
+    glVertexAttribPointer(ATTRIBUTE_INSTANCE, 4, GL_FLOAT, GL_FALSE, sizeof(ModelInstance),
+                          (const void*)offsetof(ModelInstance, position));
+    glVertexAttribPointer(ATTRIBUTE_TINT, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ModelInstance),
+                          (const void*)offsetof(ModelInstance, color));
+    glVertexAttribDivisor(ATTRIBUTE_INSTANCE, 1);
+    glVertexAttribDivisor(ATTRIBUTE_TINT, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, model->mesh_buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RenderVertex), (const void*)offsetof(RenderVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(RenderVertex), (const void*)offsetof(RenderVertex, normal));
+
+    glUseProgram(model->program);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, MODEL_MESH_VERTICES, model->count);
+    glUseProgram(0);
+
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glVertexAttribDivisor(ATTRIBUTE_INSTANCE, 0);
+    glVertexAttribDivisor(ATTRIBUTE_TINT, 0);
+    glDisableVertexAttribArray(ATTRIBUTE_INSTANCE);
+    glDisableVertexAttribArray(ATTRIBUTE_TINT);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void model_draw(ModelView* model, RenderBatch* fallback) {
+    if (model->count == 0) return;
+    if (model->instanced) {
+        draw_instanced(model);
+        return;
+    }
+
+    batch_begin(fallback);
+    for (int i = 0; i < model->count; i++) {
+        const ModelInstance* instance = &model->instances[i];
+        batch_cube(fallback, instance->position[0], instance->position[1], instance->position[2], instance->scale,
+                   instance->color[0] / 255.0f, instance->color[1] / 255.0f, instance->color[2] / 255.0f);
+    }
+    batch_flush(fallback, GL_TRIANGLES);
+}
@@ -0,0 +1,53 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+#include "batch.h"
+#include "filetable.h"
+
+// 3D file structure model
+//
+// Every entry gets a fixed place in a radial layout: depth sets the ring
+// and the entry's preorder index range (itself through its last
+// descendant) sets its angular sector, so a subtree always occupies one
+// wedge and positions need no layout pass. Each frame the tree is walked
+// in preorder and any subtree too small on screen to tell apart is drawn
+// as one aggregate box, skipping its entries in a single jump. The boxes
+// are drawn as instances of one cube mesh, with per-instance position,
+// scale and color, or through a vertex batch where instancing is missing.
+
+#define MODEL_MAX_INSTANCES 200000 // Budget; later subtrees aggregate once it is reached
+
+typedef struct {
+    float position[3];
+    float scale;
+    unsigned char color[4];
+} ModelInstance;
+
+typedef struct {
+    ModelInstance* instances;
+    ModelInstance* uploaded;   // What the instance buffer holds
+    int count;
+    int capacity;
+    int uploaded_count;
+    int aggregates;            // Boxes standing in for whole subtrees
+    int layout_count;          // Entries the layout was sized for
+    int max_depth;
+    int instanced;             // Shader instancing available
+    unsigned int program;
+    unsigned int mesh_buffer;
+    unsigned int instance_buffer;
+} ModelView;
+
+// Set up GL resources; needs a current context. Falls back to vertex
+// batches when the driver lacks GL 3.3 instancing.
+void model_init(ModelView* model);
+void model_free(ModelView* model);
+
+// Choose the boxes to draw for a camera at eye, keeping the selected
+// entry's ancestors expanded. Returns the number of instances.
+int model_build(ModelView* model, const FileTable* table, int selected, const float eye[3]);
+
+// Draw the built instances; fallback receives cubes without instancing
+void model_draw(ModelView* model, RenderBatch* fallback);
+
+#endif
@@ -0,0 +1,830 @@
+#define _GNU_SOURCE
+#include "ntfs.h"
+#include "sig.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define NTFS_BATCH_BYTES (4 << 20) // MFT bytes read per batch
+#define NTFS_MAX_THREADS 16
+#define NTFS_MIN_RECORDS_PER_THREAD 4096
+#define NTFS_SECTOR 512            // Update sequence stride
+#define NTFS_EPOCH_DELTA 11644473600LL // Seconds from 1601 to 1970
+#define NTFS_BITMAP_RECORD 6       // $Bitmap
+
+#define ATTR_STANDARD_INFORMATION 0x10
+#define ATTR_FILE_NAME 0x30
+#define ATTR_DATA 0x80
+#define ATTR_END 0xFFFFFFFFu
+
+#define NAMESPACE_DOS 2
+
+// NtfsEntry flags
+#define ENTRY_VALID 0x01      // Base record with a file name
+#define ENTRY_IN_USE 0x02
+#define ENTRY_DIRECTORY 0x04
+#define ENTRY_ANOMALY 0x08    // $STANDARD_INFORMATION creation predates $FILE_NAME
+#define ENTRY_RESIDENT 0x10   // Content lives inside the record
+#define ENTRY_VISITED 0x20    // Placed in the tree
+
+#define NO_RECORD UINT32_MAX
+
+typedef struct {
+    ImageRun* runs;
+    uint32_t count;
+    uint32_t capacity;
+} RunArray;
+
+// One MFT base record
+typedef struct {
+    uint32_t parent;
+    uint16_t parent_sequence;
+    uint16_t sequence;
+    uint16_t flags;
+    uint16_t worker;      // Worker whose arena holds the name
+    uint32_t name;        // Offset into that arena
+    long long size;
+    time_t created;
+    time_t modified;
+    time_t accessed;
+    time_t changed;
+} NtfsEntry;
+
+// Runs of one unnamed $DATA attribute, from a base or extension record
+typedef struct {
+    uint32_t owner;       // Base record
+    uint16_t worker;
+    long long vcn;        // First cluster of the stream it covers
+    long long real_size;  // Stream size; valid on the VCN 0 fragment
+    uint32_t first;       // Runs in the worker's run array
+    uint32_t count;
+} NtfsFragment;
+
+typedef struct NtfsLoader NtfsLoader;
+
+typedef struct {
+    NtfsLoader* loader;
+    int index;
+    pthread_t thread;
+    uint32_t first;       // Record range [first, end)
+    uint32_t end;
+    char* names;
+    size_t names_used;
+    size_t names_capacity;
+    RunArray runs;
+    NtfsFragment* fragments;
+    size_t fragment_count;
+    size_t fragment_capacity;
+    int status;
+} NtfsWorker;
+
+struct NtfsLoader {
+    EvidenceImage* image;   // Worker 0 reads through the caller's handle
+    const char* path;
+    long long offset;       // Volume start in the image
+    long long cluster_size;
+    long long cluster_count;
+    unsigned record_size;
+    uint32_t record_count;
+    RunArray mft;
+    NtfsEntry* entries;
+    NtfsWorker workers[NTFS_MAX_THREADS];
+    int worker_count;
+
+    // Merged data runs per record
+    RunArray runs;
+    uint32_t* run_first;
+    uint32_t* run_count;
+};
+
+// Child of a directory, sorted for display
+typedef struct {
+    const char* name;
+    uint32_t record;
+    int directory;
+} NtfsChild;
+
+static uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t le32(const unsigned char* p) { return (uint32_t)le16(p) | (uint32_t)le16(p + 2) << 16; }
+static uint64_t le64(const unsigned char* p) { return (uint64_t)le32(p) | (uint64_t)le32(p + 4) << 32; }
+
+static time_t filetime_to_time(uint64_t filetime) {
+    if (filetime == 0) return 0;
+    return (time_t)((long long)(filetime / 10000000ULL) - NTFS_EPOCH_DELTA);
+}
+
+static int run_append(RunArray* array, long long offset, long long length) {
+    if (array->count == array->capacity) {
+        uint32_t capacity = array->capacity ? array->capacity * 2 : 256;
+        ImageRun* runs = realloc(array->runs, capacity * sizeof(ImageRun));
+        if (!runs) return -1;
+        array->runs = runs;
+        array->capacity = capacity;
+    }
+    array->runs[array->count].offset = offset;
+    array->runs[array->count].length = length;
+    array->count++;
+    return 0;
+}
+
+static int read_boot(EvidenceImage* image, long long offset, unsigned char boot[512]) {
+    if (image_read(image, offset, boot, 512) != 512) return -1;
+    if (memcmp(boot + 3, "NTFS    ", 8) != 0 || boot[510] != 0x55 || boot[511] != 0xAA) return -1;
+
+    unsigned sector = le16(boot + 0x0B);
+    if (sector < 256 || sector > 4096 || (sector & (sector - 1)) || boot[0x0D] == 0) return -1;
+    // Sectors per cluster above 0x80 are 2^(256 - n): 0xE1 and up fit a
+    // 32-bit shift, 0x81 to 0xE0 do not
+    if (boot[0x0D] > 0x80 && boot[0x0D] < 0xE1) return -1;
+    return 0;
+}
+
+int ntfs_probe(EvidenceImage* image, long long offset) {
+    unsigned char boot[512];
+    return read_boot(image, offset, boot) == 0;
+}
+
+// Undo the update sequence: the last two bytes of every sector were
+// replaced by the sequence number when the record was written
+static int apply_fixups(unsigned char* record, unsigned size) {
+    unsigned usa = le16(record + 4);
+    unsigned count = le16(record + 6);
+    if (count != size / NTFS_SECTOR + 1 || usa + count * 2 > size) return -1;
+
+    for (unsigned i = 1; i < count; i++) {
+        unsigned char* tail = record + i * NTFS_SECTOR - 2;
+        if (tail[0] != record[usa] || tail[1] != record[usa + 1]) return -1;
+        tail[0] = record[usa + i * 2];
+        tail[1] = record[usa + i * 2 + 1];
+    }
+    return 0;
+}
+
+// Decode a runlist into image runs; returns -1 on a malformed list
+static int decode_runlist(const NtfsLoader* loader, const unsigned char* p, const unsigned char* end,
+                          RunArray* out, uint32_t* count) {
+    long long lcn = 0;
+    uint32_t first = out->count;
+    while (p < end && *p) {
+        int length_bytes = *p & 15;
+        int offset_bytes = *p >> 4;
+        if (length_bytes == 0 || length_bytes > 8 || offset_bytes > 8 ||
+            p + 1 + length_bytes + offset_bytes > end) return -1;
+
+        long long clusters = 0;
+        for (int i = length_bytes - 1; i >= 0; i--) clusters = clusters << 8 | p[1 + i];
+        long long delta = 0;
+        if (offset_bytes) {
+            delta = (signed char)p[length_bytes + offset_bytes]; // Sign of the top byte
+            for (int i = offset_bytes - 2; i >= 0; i--) delta = delta * 256 + p[1 + length_bytes + i];
+        }
+        p += 1 + length_bytes + offset_bytes;
+        if (clusters <= 0 || clusters > loader->cluster_count) return -1;
+
+        long long offset = IMAGE_RUN_SPARSE;
+        if (offset_bytes) {
+            lcn += delta;
+            if (lcn < 0 || lcn + clusters > loader->cluster_count) return -1;
+            offset = loader->offset + lcn * loader->cluster_size;
+        }
+        long long length = clusters * loader->cluster_size;
+
+        // Merge with the previous run when contiguous
+        ImageRun* last = out->count > first ? &out->runs[out->count - 1] : NULL;
+        if (last && ((offset == IMAGE_RUN_SPARSE && last->offset == IMAGE_RUN_SPARSE) ||
+                     (offset != IMAGE_RUN_SPARSE && last->offset != IMAGE_RUN_SPARSE &&
+                      last->offset + last->length == offset))) {
+            last->length += length;
+        } else if (run_append(out, offset, length) != 0) {
+            return -1;
+        }
+    }
+    *count = out->count - first;
+    return 0;
+}
+
+// UTF-16LE name to UTF-8 in the worker's arena; returns its offset
+static int store_name(NtfsWorker* worker, const unsigned char* utf16, unsigned length, uint32_t* offset) {
+    size_t needed = worker->names_used + (size_t)length * 3 + 1;
+    if (needed > worker->names_capacity) {
+        size_t capacity = worker->names_capacity ? worker->names_capacity : 1 << 16;
+        while (capacity < needed) capacity *= 2;
+        char* names = realloc(worker->names, capacity);
+        if (!names) return -1;
+        worker->names = names;
+        worker->names_capacity = capacity;
+    }
+
+    *offset = (uint32_t)worker->names_used;
+    unsigned char* out = (unsigned char*)worker->names + worker->names_used;
+    for (unsigned i = 0; i < length; i++) {
+        uint32_t c = le16(utf16 + i * 2);
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < length) {
+            uint32_t low = le16(utf16 + (i + 1) * 2);
+            if (low >= 0xDC00 && low < 0xE000) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            }
+        }
+        if (c >= 0xD800 && c < 0xE000) c = 0xFFFD; // Unpaired surrogate
+        if (c == 0) c = 0xFFFD;
+
+        if (c < 0x80) {
+            *out++ = (unsigned char)c;
+        } else if (c < 0x800) {
+            *out++ = (unsigned char)(0xC0 | c >> 6);
+            *out++ = (unsigned char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            *out++ = (unsigned char)(0xE0 | c >> 12);
+            *out++ = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+            *out++ = (unsigned char)(0x80 | (c & 0x3F));
+        } else {
+            // Four bytes, but the surrogate pair took two UTF-16 units
+            *out++ = (unsigned char)(0xF0 | c >> 18);
+            *out++ = (unsigned char)(0x80 | (c >> 12 & 0x3F));
+            *out++ = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+            *out++ = (unsigned char)(0x80 | (c & 0x3F));
+        }
+    }
+    *out++ = '\0';
+    worker->names_used = (size_t)(out - (unsigned char*)worker->names);
+    return 0;
+}
+
+static int add_fragment(NtfsWorker* worker, uint32_t owner, const unsigned char* attribute, unsigned length) {
+    NtfsLoader* loader = worker->loader;
+    unsigned runlist = le16(attribute + 0x20);
+    if (length < 0x40 || runlist >= length) return -1;
+
+    if (worker->fragment_count == worker->fragment_capacity) {
+        size_t capacity = worker->fragment_capacity ? worker->fragment_capacity * 2 : 1024;
+        NtfsFragment* fragments = realloc(worker->fragments, capacity * sizeof(NtfsFragment));
+        if (!fragments) return -1;
+        worker->fragments = fragments;
+        worker->fragment_capacity = capacity;
+    }
+    NtfsFragment* fragment = &worker->fragments[worker->fragment_count];
+    fragment->owner = owner;
+    fragment->worker = (uint16_t)worker->index;
+    fragment->vcn = (long long)le64(attribute + 0x10);
+    fragment->real_size = (long long)le64(attribute + 0x30);
+    fragment->first = worker->runs.count;
+    if (decode_runlist(loader, attribute + runlist, attribute + length, &worker->runs, &fragment->count) != 0) {
+        worker->runs.count = fragment->first;
+        return -1;
+    }
+    worker->fragment_count++;
+    return 0;
+}
+
+static void parse_record(NtfsWorker* worker, uint32_t number, unsigned char* record) {
+    NtfsLoader* loader = worker->loader;
+    unsigned size = loader->record_size;
+    if (memcmp(record, "FILE", 4) != 0 || apply_fixups(record, size) != 0) return;
+
+    unsigned used = le32(record + 0x18);
+    if (used > size) used = size;
+    uint16_t record_flags = le16(record + 0x16);
+    uint64_t base = le64(record + 0x20) & 0xFFFFFFFFFFFFULL;
+    uint32_t owner = base ? (uint32_t)base : number;
+
+    const unsigned char* standard = NULL;
+    const unsigned char* file_name = NULL;
+    long long resident_size = -1;
+
+    unsigned position = le16(record + 0x14);
+    while (position + 16 <= used) {
+        const unsigned char* attribute = record + position;
+        uint32_t type = le32(attribute);
+        uint32_t length = le32(attribute + 4);
+        if (type == ATTR_END || length < 16 || position + length > used) break;
+        position += length;
+
+        int resident = attribute[8] == 0;
+        const unsigned char* value = NULL;
+        uint32_t value_length = 0;
+        if (resident) {
+            value_length = le32(attribute + 0x10);
+            unsigned value_offset = le16(attribute + 0x14);
+            if (value_offset + value_length > length) continue;
+            value = attribute + value_offset;
+        }
+
+        switch (type) {
+            case ATTR_STANDARD_INFORMATION:
+                if (resident && value_length >= 0x20) standard = value;
+                break;
+            case ATTR_FILE_NAME:
+                if (!resident || value_length < 0x42 || 0x42u + value[0x40] * 2u > value_length) break;
+                // Prefer the long name over its DOS 8.3 alias
+                if (!file_name || (file_name[0x41] == NAMESPACE_DOS && value[0x41] != NAMESPACE_DOS)) {
+                    file_name = value;
+                }
+                break;
+            case ATTR_DATA:
+                if (attribute[9] != 0) break; // Alternate data stream
+                if (resident) resident_size = value_length;
+                else add_fragment(worker, owner, attribute, length);
+                break;
+        }
+    }
+    if (base || !file_name) return;
+
+    NtfsEntry* entry = &loader->entries[number];
+    if (store_name(worker, file_name + 0x42, file_name[0x40], &entry->name) != 0) return;
+    entry->worker = (uint16_t)worker->index;
+    entry->sequence = le16(record + 0x10);
+    entry->parent = (uint32_t)(le64(file_name) & 0xFFFFFFFF);
+    entry->parent_sequence = le16(file_name + 6);
+    entry->size = resident_size >= 0 ? resident_size : (long long)le64(file_name + 0x30);
+
+    time_t name_created = filetime_to_time(le64(file_name + 0x08));
+    if (standard) {
+        entry->created = filetime_to_time(le64(standard));
+        entry->modified = filetime_to_time(le64(standard + 0x08));
+        entry->accessed = filetime_to_time(le64(standard + 0x18));
+        entry->changed = filetime_to_time(le64(standard + 0x10));
+    } else {
+        entry->created = name_created;
+        entry->modified = filetime_to_time(le64(file_name + 0x10));
+        entry->accessed = filetime_to_time(le64(file_name + 0x20));
+        entry->changed = filetime_to_time(le64(file_name + 0x18));
+    }
+
+    uint16_t flags = ENTRY_VALID;
+    if (record_flags & 0x01) flags |= ENTRY_IN_USE;
+    if (record_flags & 0x02) flags |= ENTRY_DIRECTORY;
+    if (resident_size >= 0) flags |= ENTRY_RESIDENT;
+    // Tools that rewrite timestamps usually only reach $STANDARD_INFORMATION
+    if (standard && entry->created < name_created) flags |= ENTRY_ANOMALY;
+    entry->flags = flags;
+}
+
+static void* worker_main(void* arg) {
+    NtfsWorker* worker = arg;
+    NtfsLoader* loader = worker->loader;
+    EvidenceImage* image = worker->index == 0 ? loader->image : image_open(loader->path);
+    uint32_t batch = NTFS_BATCH_BYTES / loader->record_size;
+    unsigned char* buffer = malloc((size_t)batch * loader->record_size);
+
+    worker->status = image && buffer ? 0 : -1;
+    for (uint32_t first = worker->first; worker->status == 0 && first < worker->end; first += batch) {
+        uint32_t count = worker->end - first < batch ? worker->end - first : batch;
+        long got = image_read_runs(image, loader->mft.runs, (int)loader->mft.count,
+                                   (long long)first * loader->record_size, buffer,
+                                   (size_t)count * loader->record_size);
+        if (got < 0) {
+            worker->status = -1;
+            break;
+        }
+        // Records past a short read stay invalid
+        uint32_t records = (uint32_t)(got / loader->record_size);
+        for (uint32_t i = 0; i < records; i++) {
+            parse_record(worker, first + i, buffer + (size_t)i * loader->record_size);
+        }
+    }
+
+    free(buffer);
+    if (image && image != loader->image) image_close(image);
+    return NULL;
+}
+
+// Runs of the unnamed, non-resident $DATA attribute of a fixed-up base
+// record, starting at VCN 0; *real_size is trimmed to the runs
+static int record_data_runs(const NtfsLoader* loader, const unsigned char* record, RunArray* out,
+                            uint32_t* count, long long* real_size) {
+    unsigned used = le32(record + 0x18);
+    if (used > loader->record_size) used = loader->record_size;
+    unsigned position = le16(record + 0x14);
+    while (position + 16 <= used) {
+        const unsigned char* attribute = record + position;
+        uint32_t length = le32(attribute + 4);
+        if (le32(attribute) == ATTR_END || length < 0x40 || position + length > used) break;
+        if (le32(attribute) == ATTR_DATA && attribute[8] && attribute[9] == 0 && le64(attribute + 0x10) == 0) {
+            unsigned runlist = le16(attribute + 0x20);
+            *real_size = (long long)le64(attribute + 0x30);
+            if (runlist >= length || decode_runlist(loader, attribute + runlist, attribute + length, out, count) != 0) {
+                return -1;
+            }
+            long long covered = 0;
+            for (uint32_t i = 0; i < *count; i++) covered += out->runs[out->count - *count + i].length;
+            if (*real_size > covered) *real_size = covered;
+            return 0;
+        }
+        position += length;
+    }
+    return -1;
+}
+
+// Runs of $MFT itself, from the $DATA attribute of record 0
+static int load_mft_runs(NtfsLoader* loader, long long mft_offset) {
+    unsigned char* record = malloc(loader->record_size);
+    if (!record) return -1;
+
+    int status = -1;
+    uint32_t count;
+    long long real_size;
+    if (image_read(loader->image, mft_offset, record, loader->record_size) == (long)loader->record_size &&
+        memcmp(record, "FILE", 4) == 0 && apply_fixups(record, loader->record_size) == 0 &&
+        record_data_runs(loader, record, &loader->mft, &count, &real_size) == 0) {
+        loader->record_count = (uint32_t)(real_size / loader->record_size);
+        status = loader->record_count > NTFS_ROOT_RECORD ? 0 : -1;
+    }
+    free(record);
+    return status;
+}
+
+static int compare_fragments(const void* a, const void* b) {
+    const NtfsFragment* x = a;
+    const NtfsFragment* y = b;
+    if (x->owner != y->owner) return x->owner < y->owner ? -1 : 1;
+    return (x->vcn > y->vcn) - (x->vcn < y->vcn);
+}
+
+// Join each record's $DATA fragments in VCN order and trim them to the
+// stream size; the slack of the last cluster is not file content
+static int merge_runs(NtfsLoader* loader) {
+    size_t total = 0;
+    for (int w = 0; w < loader->worker_count; w++) total += loader->workers[w].fragment_count;
+
+    NtfsFragment* fragments = malloc((total ? total : 1) * sizeof(NtfsFragment));
+    loader->run_first = calloc(loader->record_count, sizeof(uint32_t));
+    loader->run_count = calloc(loader->record_count, sizeof(uint32_t));
+    if (!fragments || !loader->run_first || !loader->run_count) {
+        free(fragments);
+        return -1;
+    }
+    size_t n = 0;
+    for (int w = 0; w < loader->worker_count; w++) {
+        memcpy(fragments + n, loader->workers[w].fragments,
+               loader->workers[w].fragment_count * sizeof(NtfsFragment));
+        n += loader->workers[w].fragment_count;
+    }
+    qsort(fragments, n, sizeof(NtfsFragment), compare_fragments);
+
+    int status = 0;
+    for (size_t i = 0; i < n && status == 0;) {
+        uint32_t owner = fragments[i].owner;
+        size_t group_end = i;
+        while (group_end < n && fragments[group_end].owner == owner) group_end++;
+
+        NtfsEntry* entry = owner < loader->record_count ? &loader->entries[owner] : NULL;
+        if (entry && (entry->flags & ENTRY_VALID) && !(entry->flags & ENTRY_RESIDENT) && fragments[i].vcn == 0) {
+            long long remaining = fragments[i].real_size;
+            long long next_vcn = 0;
+            uint32_t first = loader->runs.count;
+            entry->size = remaining;
+
+            for (size_t f = i; f < group_end && remaining > 0 && status == 0; f++) {
+                if (fragments[f].vcn != next_vcn) break; // Missing extension record
+                const RunArray* source = &loader->workers[fragments[f].worker].runs;
+                for (uint32_t r = 0; r < fragments[f].count && remaining > 0; r++) {
+                    ImageRun run = source->runs[fragments[f].first + r];
+                    next_vcn += run.length / loader->cluster_size;
+                    if (run.length > remaining) run.length = remaining;
+                    remaining -= run.length;
+                    if (run_append(&loader->runs, run.offset, run.length) != 0) status = -1;
+                }
+            }
+            loader->run_first[owner] = first;
+            loader->run_count[owner] = loader->runs.count - first;
+        }
+        i = group_end;
+    }
+    free(fragments);
+    return status;
+}
+
+static const char* entry_name(const NtfsLoader* loader, const NtfsEntry* entry) {
+    return loader->workers[entry->worker].names + entry->name;
+}
+
+// Directory record that a record hangs from, or NO_RECORD for an orphan
+static uint32_t tree_parent(const NtfsLoader* loader, uint32_t record) {
+    const NtfsEntry* entry = &loader->entries[record];
+    uint32_t parent = entry->parent;
+    if (parent >= loader->record_count || parent == record) return NO_RECORD;
+
+    const NtfsEntry* directory = &loader->entries[parent];
+    if ((directory->flags & (ENTRY_VALID | ENTRY_DIRECTORY)) != (ENTRY_VALID | ENTRY_DIRECTORY)) return NO_RECORD;
+
+    // A reused record has moved on; deletion also bumps the sequence once
+    if (entry->parent_sequence && directory->sequence != entry->parent_sequence &&
+        ((directory->flags & ENTRY_IN_USE) || directory->sequence != (uint16_t)(entry->parent_sequence + 1))) {
+        return NO_RECORD;
+    }
+    return parent;
+}
+
+static int compare_children(const void* a, const void* b) {
+    const NtfsChild* x = a;
+    const NtfsChild* y = b;
+    if (x->directory != y->directory) return y->directory - x->directory;
+    int order = strcasecmp(x->name, y->name);
+    if (order) return order;
+    return (x->record > y->record) - (x->record < y->record);
+}
+
+static int add_entry(NtfsLoader* loader, FileTable* table, uint32_t record, int parent, VolumeStats* stats) {
+    NtfsEntry* entry = &loader->entries[record];
+    const char* name = entry_name(loader, entry);
+    int directory = (entry->flags & ENTRY_DIRECTORY) != 0;
+    int in_use = (entry->flags & ENTRY_IN_USE) != 0;
+
+    FileType type = directory ? FILE_TYPE_FOLDER : in_use ? sig_type_from_name(name) : FILE_TYPE_DELETED;
+    int index = file_table_add(table, name, parent, type, directory ? 0 : entry->size);
+    if (index < 0) return -1;
+
+    FileRecord* file = file_table_record(table, index);
+    file->created = entry->created;
+    file->modified = entry->modified;
+    file->accessed = entry->accessed;
+    file->changed = entry->changed;
+    if (entry->flags & ENTRY_ANOMALY) file->flags |= FILE_FLAG_TIMESTAMP_ANOMALY;
+    if (!in_use) {
+        file_table_set_deleted(table, index, 1);
+        stats->deleted++;
+    }
+    if (!directory && loader->run_count[record] &&
+        file_table_set_runs(table, index, loader->runs.runs + loader->run_first[record],
+                            (int)loader->run_count[record]) != 0) return -1;
+    stats->entries++;
+    return index;
+}
+
+// Append the subtrees below the given records in preorder. Children are
+// grouped by parent, directories first, then by name.
+static int add_subtrees(NtfsLoader* loader, FileTable* table, const uint32_t* roots, uint32_t root_count,
+                        int parent, const uint32_t* child_start, const NtfsChild* children,
+                        VolumeStats* stats) {
+    typedef struct { uint32_t record; int parent; } Pending;
+    size_t capacity = 1024;
+    size_t depth = 0;
+    Pending* stack = malloc(capacity * sizeof(Pending));
+    if (!stack) return -1;
+
+    int status = 0;
+    for (uint32_t r = root_count; r-- > 0;) {
+        if (loader->entries[roots[r]].flags & ENTRY_VISITED) continue;
+        loader->entries[roots[r]].flags |= ENTRY_VISITED;
+        if (depth == capacity) {
+            Pending* grown = realloc(stack, (capacity *= 2) * sizeof(Pending));
+            if (!grown) { status = -1; break; }
+            stack = grown;
+        }
+        stack[depth].record = roots[r];
+        stack[depth++].parent = parent;
+    }
+
+    while (depth > 0 && status == 0) {
+        Pending item = stack[--depth];
+        int index = add_entry(loader, table, item.record, item.parent, stats);
+        if (index < 0) {
+            status = -1;
+            break;
+        }
+        // Push in reverse so the first child is added next
+        for (uint32_t c = child_start[item.record + 1]; c-- > child_start[item.record];) {
+            uint32_t child = children[c].record;
+            if (loader->entries[child].flags & ENTRY_VISITED) continue;
+            loader->entries[child].flags |= ENTRY_VISITED;
+            if (depth == capacity) {
+                Pending* grown = realloc(stack, (capacity *= 2) * sizeof(Pending));
+                if (!grown) { status = -1; break; }
+                stack = grown;
+            }
+            stack[depth].record = child;
+            stack[depth++].parent = index;
+        }
+    }
+    free(stack);
+    return status;
+}
+
+static int build_tree(NtfsLoader* loader, FileTable* table, int parent, VolumeStats* stats) {
+    uint32_t count = loader->record_count;
+    uint32_t* parents = malloc(count * sizeof(uint32_t));
+    uint32_t* child_start = calloc((size_t)count + 2, sizeof(uint32_t));
+    NtfsChild* children = malloc(((size_t)count + 1) * sizeof(NtfsChild));
+    uint32_t* orphans = malloc(((size_t)count + 1) * sizeof(uint32_t));
+    int status = -1;
+    if (!parents || !child_start || !children || !orphans) goto done;
+
+    // Group children by parent record
+    for (uint32_t r = 0; r < count; r++) {
+        parents[r] = NO_RECORD;
+        if (r == NTFS_ROOT_RECORD || !(loader->entries[r].flags & ENTRY_VALID)) continue;
+        parents[r] = tree_parent(loader, r);
+        if (parents[r] != NO_RECORD) child_start[parents[r] + 2]++;
+    }
+    for (uint32_t r = 0; r < count; r++) child_start[r + 2] += child_start[r + 1];
+    for (uint32_t r = 0; r < count; r++) {
+        if (parents[r] == NO_RECORD) continue;
+        NtfsChild* child = &children[child_start[parents[r] + 1]++];
+        child->name = entry_name(loader, &loader->entries[r]);
+        child->record = r;
+        child->directory = (loader->entries[r].flags & ENTRY_DIRECTORY) != 0;
+    }
+    for (uint32_t r = 0; r < count; r++) {
+        uint32_t n = child_start[r + 1] - child_start[r];
+        if (n > 1) qsort(children + child_start[r], n, sizeof(NtfsChild), compare_children);
+    }
+
+    // The root directory's children go directly under the volume entry
+    if (!(loader->entries[NTFS_ROOT_RECORD].flags & ENTRY_VALID)) goto done;
+    loader->entries[NTFS_ROOT_RECORD].flags |= ENTRY_VISITED;
+    uint32_t root_children = child_start[NTFS_ROOT_RECORD + 1] - child_start[NTFS_ROOT_RECORD];
+    uint32_t* roots = orphans; // Borrowed until the orphans are collected
+    for (uint32_t c = 0; c < root_children; c++) roots[c] = children[child_start[NTFS_ROOT_RECORD] + c].record;
+    if (add_subtrees(loader, table, roots, root_children, parent, child_start, children, stats) != 0) goto done;
+
+    // Whatever was not reached hangs from a vanished directory, or from a
+    // loop of directories that never leads back to the root
+    uint32_t orphan_count = 0;
+    for (uint32_t r = 0; r < count; r++) {
+        if ((loader->entries[r].flags & (ENTRY_VALID | ENTRY_VISITED)) == ENTRY_VALID &&
+            parents[r] == NO_RECORD) orphans[orphan_count++] = r;
+    }
+    long long before = stats->entries;
+    int folder = -1;
+    status = 0;
+    for (uint32_t r = 0; r < count && status == 0; r++) {
+        if ((loader->entries[r].flags & (ENTRY_VALID | ENTRY_VISITED)) != ENTRY_VALID) continue;
+        if (folder < 0) {
+            folder = file_table_add(table, "$OrphanFiles", parent, FILE_TYPE_FOLDER, 0);
+            if (folder < 0) {
+                status = -1;
+                break;
+            }
+            status = add_subtrees(loader, table, orphans, orphan_count, folder, child_start, children, stats);
+            r = (uint32_t)-1; // Rescan for loops the orphans did not cover
+            continue;
+        }
+        status = add_subtrees(loader, table, &r, 1, folder, child_start, children, stats);
+    }
+    stats->orphans = stats->entries - before;
+
+done:
+    free(parents);
+    free(child_start);
+    free(children);
+    free(orphans);
+    return status;
+}
+
+static void free_loader(NtfsLoader* loader) {
+    for (int w = 0; w < loader->worker_count; w++) {
+        free(loader->workers[w].names);
+        free(loader->workers[w].runs.runs);
+        free(loader->workers[w].fragments);
+    }
+    free(loader->mft.runs);
+    free(loader->runs.runs);
+    free(loader->run_first);
+    free(loader->run_count);
+    free(loader->entries);
+}
+
+// Volume geometry from the boot sector
+static int open_loader(NtfsLoader* loader, EvidenceImage* image, long long offset, const unsigned char* boot) {
+    memset(loader, 0, sizeof(*loader));
+    loader->image = image;
+    loader->offset = offset;
+
+    unsigned sector = le16(boot + 0x0B);
+    unsigned sectors_per_cluster = boot[0x0D] <= 0x80 ? boot[0x0D] : 1u << (256 - boot[0x0D]);
+    loader->cluster_size = (long long)sector * sectors_per_cluster;
+    loader->cluster_count = (long long)(le64(boot + 0x28) / sectors_per_cluster);
+    signed char record_clusters = (signed char)boot[0x40];
+    if (record_clusters < -16) return -1;  // 2^-n bytes, past the 64 KiB limit
+    loader->record_size = record_clusters > 0 ? (unsigned)(record_clusters * loader->cluster_size)
+                                              : 1u << -record_clusters;
+    if (loader->record_size < NTFS_SECTOR || loader->record_size > 65536 ||
+        (loader->record_size & (loader->record_size - 1))) return -1;
+    return 0;
+}
+
+int ntfs_load(EvidenceImage* image, const char* path, long long offset,
+              FileTable* table, int parent, int threads, VolumeStats* stats) {
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    memset(stats, 0, sizeof(*stats));
+
+    unsigned char boot[512];
+    if (read_boot(image, offset, boot) != 0) return -1;
+
+    NtfsLoader loader;
+    if (open_loader(&loader, image, offset, boot) != 0) return -1;
+    loader.path = path;
+
+    if (load_mft_runs(&loader, offset + (long long)le64(boot + 0x30) * loader.cluster_size) != 0) {
+        free_loader(&loader);
+        return -1;
+    }
+    loader.entries = calloc(loader.record_count, sizeof(NtfsEntry));
+    if (!loader.entries) {
+        free_loader(&loader);
+        return -1;
+    }
+
+    // Split the records into contiguous ranges, one per thread
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if (threads > NTFS_MAX_THREADS) threads = NTFS_MAX_THREADS;
+    uint32_t by_size = loader.record_count / NTFS_MIN_RECORDS_PER_THREAD;
+    if ((uint32_t)threads > by_size) threads = by_size ? (int)by_size : 1;
+    loader.worker_count = threads;
+
+    for (int w = 0; w < threads; w++) {
+        NtfsWorker* worker = &loader.workers[w];
+        worker->loader = &loader;
+        worker->index = w;
+        worker->first = (uint32_t)((unsigned long long)loader.record_count * w / threads);
+        worker->end = (uint32_t)((unsigned long long)loader.record_count * (w + 1) / threads);
+    }
+    // The calling thread takes the first range itself, and any range whose
+    // thread could not be started
+    int running[NTFS_MAX_THREADS] = {0};
+    int started_threads = 1;
+    for (int w = 1; w < threads; w++) {
+        running[w] = pthread_create(&loader.workers[w].thread, NULL, worker_main, &loader.workers[w]) == 0;
+        started_threads += running[w];
+    }
+    worker_main(&loader.workers[0]);
+    for (int w = 1; w < threads; w++) {
+        if (!running[w]) worker_main(&loader.workers[w]);
+    }
+
+    int status = 0;
+    for (int w = 0; w < threads; w++) {
+        if (running[w]) pthread_join(loader.workers[w].thread, NULL);
+        if (loader.workers[w].status != 0) status = -1;
+    }
+    if (status == 0) status = merge_runs(&loader);
+    if (status == 0) status = build_tree(&loader, table, parent, stats);
+
+    stats->records = loader.record_count;
+    stats->threads = started_threads;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    stats->seconds = (double)(finished.tv_sec - started.tv_sec) +
+                     (double)(finished.tv_nsec - started.tv_nsec) / 1e9;
+    free_loader(&loader);
+    return status;
+}
+
+// Clusters $Bitmap marks in use, which covers the boot sectors and the
+// MFT, plus the backup boot sector past the last cluster
+static int ntfs_allocated(EvidenceImage* image, long long offset, VolumeExtents* extents) {
+    unsigned char boot[512];
+    if (read_boot(image, offset, boot) != 0) return -1;
+
+    NtfsLoader loader;
+    if (open_loader(&loader, image, offset, boot) != 0) return -1;
+    unsigned char* record = NULL;
+    unsigned char* bitmap = NULL;
+    RunArray runs = {0};
+    uint32_t count;
+    long long size;
+    int status = -1;
+    if (load_mft_runs(&loader, offset + (long long)le64(boot + 0x30) * loader.cluster_size) != 0 ||
+        loader.record_count <= NTFS_BITMAP_RECORD) goto done;
+
+    record = malloc(loader.record_size);
+    bitmap = malloc(NTFS_BATCH_BYTES);
+    if (!record || !bitmap ||
+        image_read_runs(image, loader.mft.runs, (int)loader.mft.count, (long long)NTFS_BITMAP_RECORD * loader.record_size,
+                        record, loader.record_size) != (long)loader.record_size ||
+        memcmp(record, "FILE", 4) != 0 || apply_fixups(record, loader.record_size) != 0 ||
+        record_data_runs(&loader, record, &runs, &count, &size) != 0 ||
+        size < (loader.cluster_count + 7) / 8) goto done;
+
+    status = 0;
+    for (long long done = 0; done < loader.cluster_count && status == 0;) {
+        long long bits = loader.cluster_count - done < NTFS_BATCH_BYTES * 8LL ? loader.cluster_count - done
+                                                                             : NTFS_BATCH_BYTES * 8LL;
+        size_t bytes = (size_t)((bits + 7) / 8);
+        if (image_read_runs(image, runs.runs, (int)runs.count, done / 8, bitmap, bytes) != (long)bytes) {
+            status = -1;
+            break;
+        }
+        status = volume_extents_add_bits(extents, bitmap, bits, offset + done * loader.cluster_size,
+                                         loader.cluster_size);
+        done += bits;
+    }
+    unsigned sector = le16(boot + 0x0B);
+    if (status == 0) status = volume_extents_add(extents, offset + (long long)le64(boot + 0x28) * sector, sector);
+
+done:
+    free(record);
+    free(bitmap);
+    free(runs.runs);
+    free_loader(&loader);
+    return status;
+}
+
+const FsBackend ntfs_backend = {"NTFS", ntfs_probe, ntfs_load, ntfs_allocated};
@@ -0,0 +1,29 @@
+#ifndef NTFS_H
+#define NTFS_H
+
+#include "volume.h"
+
+// NTFS volume parser
+//
+// Locates $MFT from the boot sector and walks its records in large
+// sequential batches, split by record range across threads. Each record
+// yields its best $FILE_NAME, $STANDARD_INFORMATION timestamps and the
+// data runs of the unnamed $DATA stream, including fragments held in
+// extension records. The directory tree is then rebuilt from parent
+// references and appended to the file table in preorder; deleted entries
+// whose parent is gone are collected under $OrphanFiles.
+
+#define NTFS_ROOT_RECORD 5
+
+extern const FsBackend ntfs_backend;
+
+// Whether the sector at offset is an NTFS boot sector
+int ntfs_probe(EvidenceImage* image, long long offset);
+
+// Parse the volume starting at offset and add its tree under parent.
+// Worker threads open their own handles on path; threads <= 0 uses every
+// online CPU. Returns 0 on success.
+int ntfs_load(EvidenceImage* image, const char* path, long long offset,
+              FileTable* table, int parent, int threads, VolumeStats* stats);
+
+#endif
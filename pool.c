@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Intrusive multi-producer, single-consumer queue. Producers only swap
+// the head; the consumer owns the tail. A stub node keeps the queue
+// non-empty so push never has to touch the tail.
+typedef struct {
+    PoolJob* head;
+    PoolJob* tail;
+    PoolJob stub;
+} CompletionQueue;
+
+struct WorkerPool {
+    pthread_t* threads;
+    int thread_count;
+    PoolWorkerInit init;
+    PoolWorkerFini fini;
+    void* context;
+
+    // Job queue, guarded by lock
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    PoolJob* first;
+    PoolJob* last;
+    int stop;
+
+    CompletionQueue completed;
+    int pending;
+};
+
+static void completion_init(CompletionQueue* q) {
+    q->stub.next = NULL;
+    q->head = &q->stub;
+    q->tail = &q->stub;
+}
+
+static void completion_push(CompletionQueue* q, PoolJob* job) {
+    __atomic_store_n(&job->next, NULL, __ATOMIC_RELAXED);
+    PoolJob* prev = __atomic_exchange_n(&q->head, job, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, job, __ATOMIC_RELEASE);
+}
+
+// NULL when empty or when a producer is between its two steps
+static PoolJob* completion_pop(CompletionQueue* q) {
+    PoolJob* tail = q->tail;
+    PoolJob* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &q->stub) {
+        if (!next) return NULL;
+        q->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+
+    // tail is the last node: re-queue the stub behind it before taking it
+    if (tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) return NULL;
+    completion_push(q, &q->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+static void* worker_main(void* arg) {
+    WorkerPool* pool = arg;
+    void* worker = pool->init ? pool->init(pool->context) : NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->first && !pool->stop) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        PoolJob* job = pool->first;
+        pool->first = job->next;
+        if (!pool->first) pool->last = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        job->work(job, worker);
+        completion_push(&pool->completed, job);
+    }
+
+    if (pool->fini) pool->fini(worker);
+    return NULL;
+}
+
+WorkerPool* pool_create(int threads, PoolWorkerInit init, PoolWorkerFini fini, void* context) {
+    WorkerPool* pool = calloc(1, sizeof(WorkerPool));
+    if (!pool) return NULL;
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    pool->threads = calloc((size_t)threads, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    pool->init = init;
+    pool->fini = fini;
+    pool->context = context;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    completion_init(&pool->completed);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) break;
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void pool_destroy(WorkerPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->thread_count; i++) pthread_join(pool->threads[i], NULL);
+
+    while (pool->first) {
+        PoolJob* job = pool->first;
+        pool->first = job->next;
+        free(job);
+    }
+    PoolJob* job;
+    while ((job = completion_pop(&pool->completed)) != NULL) free(job);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool->threads);
+    free(pool);
+}
+
+int pool_thread_count(const WorkerPool* pool) {
+    return pool->thread_count;
+}
+
+PoolJob* pool_job_new(PoolWork work, PoolDone done, size_t payload) {
+    // Payload follows the job, aligned for any type
+    size_t header = (sizeof(PoolJob) + sizeof(long double) - 1) / sizeof(long double) * sizeof(long double);
+    PoolJob* job = calloc(1, header + payload);
+    if (!job) return NULL;
+    job->work = work;
+    job->done = done;
+    job->data = payload ? (unsigned char*)job + header : NULL;
+    return job;
+}
+
+void pool_submit(WorkerPool* pool, PoolJob* job, int urgent) {
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&pool->lock);
+    if (urgent) {
+        job->next = pool->first;
+        pool->first = job;
+        if (!pool->last) pool->last = job;
+    } else {
+        job->next = NULL;
+        if (pool->last) pool->last->next = job;
+        else pool->first = job;
+        pool->last = job;
+    }
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int pool_drain(WorkerPool* pool, int max) {
+    int drained = 0;
+    PoolJob* job;
+    while (drained < max && (job = completion_pop(&pool->completed)) != NULL) {
+        if (job->done) job->done(job);
+        free(job);
+        drained++;
+    }
+    if (drained) __atomic_sub_fetch(&pool->pending, drained, __ATOMIC_RELAXED);
+    return drained;
+}
+
+int pool_pending(const WorkerPool* pool) {
+    return __atomic_load_n(&pool->pending, __ATOMIC_RELAXED);
+}
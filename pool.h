@@ -0,0 +1,53 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// Background worker pool
+//
+// Jobs run on worker threads and are then handed back to the UI thread
+// through a lock-free completion queue, where the UI drains them from its
+// timer. Work functions must not touch UI state; they read the inputs
+// copied into the job payload and write results there. The completion
+// function runs on the draining thread and publishes the results.
+
+typedef struct WorkerPool WorkerPool;
+typedef struct PoolJob PoolJob;
+
+// worker is the per-thread state returned by the pool's worker_init
+typedef void (*PoolWork)(PoolJob* job, void* worker);
+typedef void (*PoolDone)(PoolJob* job);
+
+struct PoolJob {
+    PoolWork work;
+    PoolDone done;
+    void* data;      // Payload, allocated with the job
+    PoolJob* next;   // Queue link, owned by the pool
+};
+
+// Per-thread setup, e.g. a private image handle; may be NULL
+typedef void* (*PoolWorkerInit)(void* context);
+typedef void (*PoolWorkerFini)(void* worker);
+
+// threads <= 0 uses every online CPU
+WorkerPool* pool_create(int threads, PoolWorkerInit init, PoolWorkerFini fini, void* context);
+
+// Stop the workers; queued jobs are dropped without running done
+void pool_destroy(WorkerPool* pool);
+
+int pool_thread_count(const WorkerPool* pool);
+
+// Allocate a job with payload bytes of zeroed storage at job->data
+PoolJob* pool_job_new(PoolWork work, PoolDone done, size_t payload);
+
+// Queue a job; urgent jobs go ahead of queued bulk work
+void pool_submit(WorkerPool* pool, PoolJob* job, int urgent);
+
+// Run done for up to max completed jobs on the calling thread and free
+// them; returns the number drained
+int pool_drain(WorkerPool* pool, int max);
+
+// Jobs submitted but not yet drained
+int pool_pending(const WorkerPool* pool);
+
+#endif
@@ -0,0 +1,639 @@
+#include "sig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIG_MAX_PATTERNS 512
+#define SIG_MAX_GROUPS 32
+#define SIG_PATTERN_BYTES 16384
+#define SIG_EXTENSION_MAX 32
+#define SIG_EXTENSION_SLOTS 1024 // Power of two, well above the listed extensions
+
+// Formats. Patterns below refer to them by name.
+static const SigFormat sig_formats[] = {
+    // Executables and code
+    {"PE", "Windows PE/DOS executable", FILE_TYPE_EXECUTABLE, "exe|dll|sys|scr|ocx|cpl|drv|efi|com|mui|ax|acm|tsp|winmd"},
+    {"ELF", "ELF executable", FILE_TYPE_EXECUTABLE, "so|o|ko|elf|bin|axf|prx|out|mod"},
+    {"MACHO", "Mach-O executable", FILE_TYPE_EXECUTABLE, "dylib|bundle|o|kext"},
+    {"CLASS", "Java class or Mach-O universal binary", FILE_TYPE_EXECUTABLE, "class|dylib|bundle"},
+    {"DEX", "Android Dalvik executable", FILE_TYPE_EXECUTABLE, "dex|odex"},
+    {"WASM", "WebAssembly module", FILE_TYPE_EXECUTABLE, "wasm"},
+    {"SCRIPT", "Script with interpreter line", FILE_TYPE_TEXT, "sh|bash|ksh|zsh|csh|py|pl|pm|rb|php|cgi|awk|sed|tcl|lua|js|run"},
+    {"PYC", "Python bytecode", FILE_TYPE_EXECUTABLE, "pyc|pyo"},
+    {"LNK", "Windows shortcut", FILE_TYPE_UNKNOWN, "lnk"},
+    {"PF", "Windows prefetch file", FILE_TYPE_UNKNOWN, "pf"},
+    {"PDB", "Program database", FILE_TYPE_UNKNOWN, "pdb"},
+    {"AR", "Unix archive / Debian package", FILE_TYPE_UNKNOWN, "a|lib|deb|udeb"},
+    {"RPM", "RPM package", FILE_TYPE_UNKNOWN, "rpm"},
+    {"CHM", "Compiled HTML help", FILE_TYPE_DOCUMENT, "chm"},
+
+    // Documents
+    {"PDF", "PDF document", FILE_TYPE_DOCUMENT, "pdf|ai"},
+    {"PS", "PostScript document", FILE_TYPE_DOCUMENT, "ps|eps|ai"},
+    {"EPS", "DOS EPS binary", FILE_TYPE_DOCUMENT, "eps|epsf"},
+    {"RTF", "Rich Text Format document", FILE_TYPE_DOCUMENT, "rtf|doc|wri"},
+    {"OLE2", "Microsoft Compound File (DOC/XLS/PPT/MSI)", FILE_TYPE_DOCUMENT,
+     "doc|dot|xls|xlt|ppt|pot|pps|msi|msp|msg|vsd|pub|mpp|db|wps|sldprt|automaticdestinations-ms"},
+    {"OOXML", "Office Open XML document", FILE_TYPE_DOCUMENT,
+     "docx|docm|dotx|dotm|xlsx|xlsm|xltx|xltm|pptx|pptm|potx|ppsx|vsdx"},
+    {"ODF", "OpenDocument file", FILE_TYPE_DOCUMENT, "odt|ods|odp|odg|odf|ott|ots|otp"},
+    {"EPUB", "EPUB e-book", FILE_TYPE_DOCUMENT, "epub"},
+    {"DJVU", "DjVu document", FILE_TYPE_DOCUMENT, "djvu|djv"},
+    {"MDB", "Microsoft Access database", FILE_TYPE_DOCUMENT, "mdb|mde"},
+    {"ACCDB", "Microsoft Access 2007+ database", FILE_TYPE_DOCUMENT, "accdb|accde"},
+    {"PST", "Outlook personal folders", FILE_TYPE_DOCUMENT, "pst|ost"},
+
+    // Images
+    {"JPEG", "JPEG image", FILE_TYPE_IMAGE, "jpg|jpeg|jpe|jfif|jif|thm"},
+    {"PNG", "PNG image", FILE_TYPE_IMAGE, "png|apng"},
+    {"GIF", "GIF image", FILE_TYPE_IMAGE, "gif"},
+    {"BMP", "Windows bitmap", FILE_TYPE_IMAGE, "bmp|dib"},
+    {"TIFF", "TIFF image", FILE_TYPE_IMAGE, "tif|tiff|nef|dng|arw|orf|pef|sr2|srw|rw2"},
+    {"CR2", "Canon raw image", FILE_TYPE_IMAGE, "cr2"},
+    {"ICO", "Windows icon", FILE_TYPE_IMAGE, "ico"},
+    {"CUR", "Windows cursor", FILE_TYPE_IMAGE, "cur"},
+    {"WEBP", "WebP image", FILE_TYPE_IMAGE, "webp"},
+    {"PSD", "Photoshop image", FILE_TYPE_IMAGE, "psd|psb"},
+    {"JP2", "JPEG 2000 image", FILE_TYPE_IMAGE, "jp2|j2k|jpf|jpx|jpm"},
+    {"HEIC", "HEIF/HEIC image", FILE_TYPE_IMAGE, "heic|heif|hif"},
+    {"AVIF", "AVIF image", FILE_TYPE_IMAGE, "avif"},
+    {"EXR", "OpenEXR image", FILE_TYPE_IMAGE, "exr"},
+    {"HDR", "Radiance HDR image", FILE_TYPE_IMAGE, "hdr|pic"},
+    {"XCF", "GIMP image", FILE_TYPE_IMAGE, "xcf"},
+    {"DDS", "DirectDraw surface", FILE_TYPE_IMAGE, "dds"},
+    {"SVG", "SVG image", FILE_TYPE_IMAGE, "svg|svgz"},
+
+    // Audio and video
+    {"MP3", "MP3 audio", FILE_TYPE_UNKNOWN, "mp3|mp2|mpga"},
+    {"WAV", "WAVE audio", FILE_TYPE_UNKNOWN, "wav|wave"},
+    {"AVI", "AVI video", FILE_TYPE_UNKNOWN, "avi|divx"},
+    {"AIFF", "AIFF audio", FILE_TYPE_UNKNOWN, "aif|aiff|aifc"},
+    {"OGG", "Ogg media", FILE_TYPE_UNKNOWN, "ogg|oga|ogv|ogx|opus|spx"},
+    {"FLAC", "FLAC audio", FILE_TYPE_UNKNOWN, "flac"},
+    {"MKV", "Matroska/WebM media", FILE_TYPE_UNKNOWN, "mkv|mka|mks|mk3d|webm"},
+    {"ASF", "Windows Media file", FILE_TYPE_UNKNOWN, "asf|wmv|wma"},
+    {"FLV", "Flash video", FILE_TYPE_UNKNOWN, "flv|f4v"},
+    {"MPEG", "MPEG program stream", FILE_TYPE_UNKNOWN, "mpg|mpeg|vob|m2p|mpe"},
+    {"MP4", "MPEG-4 media", FILE_TYPE_UNKNOWN, "mp4|m4v|m4a|m4b|m4p|f4v|mp4v|3gp|3g2|mov"},
+    {"MOV", "QuickTime movie", FILE_TYPE_UNKNOWN, "mov|qt"},
+    {"3GP", "3GPP media", FILE_TYPE_UNKNOWN, "3gp|3gpp|3g2"},
+    {"MIDI", "MIDI sequence", FILE_TYPE_UNKNOWN, "mid|midi|kar"},
+    {"AU", "Sun audio", FILE_TYPE_UNKNOWN, "au|snd"},
+    {"AMR", "AMR audio", FILE_TYPE_UNKNOWN, "amr"},
+
+    // Archives and compression
+    {"ZIP", "ZIP archive", FILE_TYPE_UNKNOWN,
+     "zip|jar|war|ear|apk|aab|aar|ipa|xpi|crx|kmz|whl|nupkg|vsix|docx|xlsx|pptx|odt|ods|odp|epub|xps|cbz|zipx"},
+    {"JAR", "Java archive", FILE_TYPE_EXECUTABLE, "jar|war|ear|apk|aar"},
+    {"GZIP", "gzip compressed data", FILE_TYPE_UNKNOWN, "gz|tgz|gzip|svgz|emz|wmz"},
+    {"BZIP2", "bzip2 compressed data", FILE_TYPE_UNKNOWN, "bz2|tbz|tbz2|bz"},
+    {"XZ", "xz compressed data", FILE_TYPE_UNKNOWN, "xz|txz|lzma"},
+    {"ZSTD", "Zstandard compressed data", FILE_TYPE_UNKNOWN, "zst|tzst"},
+    {"LZ4", "LZ4 compressed data", FILE_TYPE_UNKNOWN, "lz4"},
+    {"LZIP", "lzip compressed data", FILE_TYPE_UNKNOWN, "lz"},
+    {"Z", "compress'd data", FILE_TYPE_UNKNOWN, "z|taz"},
+    {"7Z", "7-Zip archive", FILE_TYPE_UNKNOWN, "7z"},
+    {"RAR", "RAR archive", FILE_TYPE_UNKNOWN, "rar|r00|cbr"},
+    {"TAR", "tar archive", FILE_TYPE_UNKNOWN, "tar|gem|ova"},
+    {"CAB", "Microsoft cabinet", FILE_TYPE_UNKNOWN, "cab|msu"},
+    {"ARJ", "ARJ archive", FILE_TYPE_UNKNOWN, "arj"},
+    {"XAR", "XAR archive", FILE_TYPE_UNKNOWN, "xar|pkg|xip"},
+    {"WIM", "Windows imaging file", FILE_TYPE_UNKNOWN, "wim|esd|swm"},
+
+    // Disk images and volumes
+    {"EWF", "Expert Witness image", FILE_TYPE_UNKNOWN, "e01|s01|l01|ewf"},
+    {"EWF2", "Expert Witness 2 image", FILE_TYPE_UNKNOWN, "ex01|lx01"},
+    {"VMDK", "VMware disk", FILE_TYPE_UNKNOWN, "vmdk"},
+    {"VDI", "VirtualBox disk", FILE_TYPE_UNKNOWN, "vdi"},
+    {"VHD", "Virtual PC disk", FILE_TYPE_UNKNOWN, "vhd"},
+    {"VHDX", "Hyper-V disk", FILE_TYPE_UNKNOWN, "vhdx|avhdx"},
+    {"QCOW", "QEMU copy-on-write disk", FILE_TYPE_UNKNOWN, "qcow|qcow2|img"},
+    {"NTFS", "NTFS volume", FILE_TYPE_UNKNOWN, "dd|raw|img|bin|001"},
+    {"FAT32", "FAT32 volume", FILE_TYPE_UNKNOWN, "dd|raw|img|bin|001|ima"},
+    {"EXFAT", "exFAT volume", FILE_TYPE_UNKNOWN, "dd|raw|img|bin|001"},
+    {"BITLOCKER", "BitLocker volume", FILE_TYPE_UNKNOWN, "dd|raw|img|bin|001"},
+    {"LUKS", "LUKS encrypted volume", FILE_TYPE_UNKNOWN, "luks|img|bin"},
+    {"HIBER", "Windows hibernation file", FILE_TYPE_UNKNOWN, "sys"},
+    {"DMP", "Windows crash dump", FILE_TYPE_UNKNOWN, "dmp|mdmp|hdmp"},
+
+    // Databases, logs and system artefacts
+    {"SQLITE", "SQLite database", FILE_TYPE_DOCUMENT,
+     "db|sqlite|sqlite3|db3|sdb|sqlitedb|localstorage|storedata|sqlite-wal"},
+    {"REGF", "Windows registry hive", FILE_TYPE_UNKNOWN, "dat|hve|hiv|sav|reg"},
+    {"EVTX", "Windows event log", FILE_TYPE_UNKNOWN, "evtx"},
+    {"EVT", "Windows legacy event log", FILE_TYPE_UNKNOWN, "evt"},
+    {"ESEDB", "Extensible Storage Engine database", FILE_TYPE_UNKNOWN, "edb|dat|sdb|jfm"},
+    {"MFT", "NTFS MFT record", FILE_TYPE_UNKNOWN, NULL},
+    {"THUMBCACHE", "Windows thumbnail cache", FILE_TYPE_UNKNOWN, "db"},
+    {"BPLIST", "Binary property list", FILE_TYPE_UNKNOWN, "plist|bplist|binarycookies"},
+    {"JKS", "Java keystore", FILE_TYPE_UNKNOWN, "jks|keystore"},
+    {"ABACKUP", "Android backup", FILE_TYPE_UNKNOWN, "ab"},
+    {"GITPACK", "Git pack file", FILE_TYPE_UNKNOWN, "pack"},
+    {"TZIF", "Time zone data", FILE_TYPE_UNKNOWN, NULL},
+    {"BLEND", "Blender scene", FILE_TYPE_UNKNOWN, "blend"},
+    {"TORRENT", "BitTorrent metainfo", FILE_TYPE_UNKNOWN, "torrent"},
+
+    // Fonts
+    {"TTF", "TrueType font", FILE_TYPE_UNKNOWN, "ttf|tte|dfont"},
+    {"OTF", "OpenType font", FILE_TYPE_UNKNOWN, "otf"},
+    {"TTC", "TrueType collection", FILE_TYPE_UNKNOWN, "ttc"},
+    {"WOFF", "WOFF web font", FILE_TYPE_UNKNOWN, "woff"},
+    {"WOFF2", "WOFF2 web font", FILE_TYPE_UNKNOWN, "woff2"},
+
+    // Structured text
+    {"XML", "XML document", FILE_TYPE_TEXT,
+     "xml|xsl|xslt|xsd|plist|rss|atom|config|manifest|resx|csproj|vcxproj|kml|gpx|xaml|svg|dae|nuspec"},
+    {"HTML", "HTML document", FILE_TYPE_TEXT, "html|htm|xhtml|shtml|mht|hta|php|asp|aspx|jsp"},
+    {"EMAIL", "Email message", FILE_TYPE_TEXT, "eml|msg|mbox|txt"},
+    {"VCARD", "vCard contact", FILE_TYPE_TEXT, "vcf|vcard"},
+    {"ICAL", "iCalendar data", FILE_TYPE_TEXT, "ics|ical|ifb"},
+    {"PEM", "PEM certificate or key", FILE_TYPE_TEXT, "pem|crt|cer|key|csr|pub|der|p7b"},
+    {"PGP", "PGP armored data", FILE_TYPE_TEXT, "asc|pgp|gpg|sig|key"},
+    {"VMDKDESC", "VMware disk descriptor", FILE_TYPE_TEXT, "vmdk"},
+    {"UTF8BOM", "UTF-8 text with BOM", FILE_TYPE_TEXT, NULL},
+    {"UTF16", "UTF-16 text", FILE_TYPE_TEXT, NULL},
+    {"TXT", "Text", FILE_TYPE_TEXT, NULL}, // Content heuristic, no pattern
+};
+
+#define SIG_FORMAT_COUNT ((int)(sizeof(sig_formats) / sizeof(sig_formats[0])))
+
+// Patterns: space-separated hex bytes, ?? for any byte, *N for N any
+// bytes and "..." for literal text
+typedef struct {
+    const char* format;
+    int offset;
+    const char* pattern;
+} SigPattern;
+
+static const SigPattern sig_patterns[] = {
+    {"PE", 0, "4D 5A"},
+    {"PE", 0, "4D 5A 90 00 03 00 00 00"},
+    {"ELF", 0, "7F \"ELF\""},
+    {"MACHO", 0, "FE ED FA CE"},
+    {"MACHO", 0, "FE ED FA CF"},
+    {"MACHO", 0, "CE FA ED FE"},
+    {"MACHO", 0, "CF FA ED FE"},
+    {"CLASS", 0, "CA FE BA BE"},
+    {"DEX", 0, "\"dex\" 0A ?? ?? ?? 00"},
+    {"WASM", 0, "00 \"asm\""},
+    {"SCRIPT", 0, "\"#!/\""},
+    {"SCRIPT", 0, "\"#! /\""},
+    {"PYC", 2, "0D 0A 00 00"},
+    {"LNK", 0, "4C 00 00 00 01 14 02 00"},
+    {"PF", 4, "\"SCCA\""},
+    {"PF", 0, "\"MAM\" 04"},
+    {"PDB", 0, "\"Microsoft C/C++ MSF 7.00\""},
+    {"AR", 0, "\"!<arch>\" 0A"},
+    {"RPM", 0, "ED AB EE DB"},
+    {"CHM", 0, "\"ITSF\" 03 00 00 00"},
+
+    {"PDF", 0, "\"%PDF-\""},
+    {"PS", 0, "\"%!PS\""},
+    {"EPS", 0, "C5 D0 D3 C6"},
+    {"RTF", 0, "\"{\\rtf\""},
+    {"OLE2", 0, "D0 CF 11 E0 A1 B1 1A E1"},
+    {"OOXML", 0, "50 4B 03 04 *26 \"[Content_Types].xml\""},
+    {"OOXML", 0, "50 4B 03 04 *26 \"_rels/.rels\""},
+    {"OOXML", 0, "50 4B 03 04 *26 \"docProps/\""},
+    {"OOXML", 0, "50 4B 03 04 *26 \"word/\""},
+    {"OOXML", 0, "50 4B 03 04 *26 \"xl/\""},
+    {"OOXML", 0, "50 4B 03 04 *26 \"ppt/\""},
+    {"ODF", 0, "50 4B 03 04 *26 \"mimetypeapplication/vnd.oasis.opendocument\""},
+    {"EPUB", 0, "50 4B 03 04 *26 \"mimetypeapplication/epub+zip\""},
+    {"JAR", 0, "50 4B 03 04 *26 \"META-INF/\""},
+    {"DJVU", 0, "\"AT&TFORM\""},
+    {"MDB", 0, "00 01 00 00 \"Standard Jet DB\""},
+    {"ACCDB", 0, "00 01 00 00 \"Standard ACE DB\""},
+    {"PST", 0, "\"!BDN\""},
+
+    {"JPEG", 0, "FF D8 FF"},
+    {"PNG", 0, "89 \"PNG\" 0D 0A 1A 0A"},
+    {"GIF", 0, "\"GIF87a\""},
+    {"GIF", 0, "\"GIF89a\""},
+    {"BMP", 0, "\"BM\" ?? ?? ?? ?? 00 00 00 00"},
+    {"TIFF", 0, "\"II\" 2A 00"},
+    {"TIFF", 0, "\"MM\" 00 2A"},
+    {"TIFF", 0, "\"MM\" 00 2B"},
+    {"TIFF", 0, "\"II\" 2B 00"},
+    {"CR2", 0, "\"II\" 2A 00 10 00 00 00 \"CR\""},
+    {"ICO", 0, "00 00 01 00 ?? 00"},
+    {"CUR", 0, "00 00 02 00 ?? 00"},
+    {"WEBP", 0, "\"RIFF\" ?? ?? ?? ?? \"WEBP\""},
+    {"PSD", 0, "\"8BPS\" 00"},
+    {"JP2", 0, "00 00 00 0C \"jP  \" 0D 0A 87 0A"},
+    {"JP2", 0, "FF 4F FF 51"},
+    {"HEIC", 4, "\"ftypheic\""},
+    {"HEIC", 4, "\"ftypheix\""},
+    {"HEIC", 4, "\"ftyphevc\""},
+    {"HEIC", 4, "\"ftypmif1\""},
+    {"HEIC", 4, "\"ftypmsf1\""},
+    {"AVIF", 4, "\"ftypavif\""},
+    {"EXR", 0, "76 2F 31 01"},
+    {"HDR", 0, "\"#?RADIANCE\""},
+    {"XCF", 0, "\"gimp xcf \""},
+    {"DDS", 0, "\"DDS \" 7C 00 00 00"},
+    {"SVG", 0, "\"<svg\""},
+
+    {"MP3", 0, "\"ID3\""},
+    {"MP3", 0, "FF FB"},
+    {"MP3", 0, "FF F3"},
+    {"MP3", 0, "FF F2"},
+    {"WAV", 0, "\"RIFF\" ?? ?? ?? ?? \"WAVE\""},
+    {"AVI", 0, "\"RIFF\" ?? ?? ?? ?? \"AVI \""},
+    {"AIFF", 0, "\"FORM\" ?? ?? ?? ?? \"AIFF\""},
+    {"AIFF", 0, "\"FORM\" ?? ?? ?? ?? \"AIFC\""},
+    {"OGG", 0, "\"OggS\" 00"},
+    {"FLAC", 0, "\"fLaC\""},
+    {"MKV", 0, "1A 45 DF A3"},
+    {"ASF", 0, "30 26 B2 75 8E 66 CF 11"},
+    {"FLV", 0, "\"FLV\" 01"},
+    {"MPEG", 0, "00 00 01 BA"},
+    {"MPEG", 0, "00 00 01 B3"},
+    {"MP4", 4, "\"ftyp\""},
+    {"MP4", 4, "\"ftypisom\""},
+    {"MP4", 4, "\"ftypmp41\""},
+    {"MP4", 4, "\"ftypmp42\""},
+    {"MP4", 4, "\"ftypM4A \""},
+    {"MP4", 4, "\"ftypM4V \""},
+    {"MOV", 4, "\"ftypqt  \""},
+    {"MOV", 4, "\"moov\""},
+    {"MOV", 4, "\"mdat\""},
+    {"MOV", 4, "\"wide\""},
+    {"3GP", 4, "\"ftyp3gp\""},
+    {"3GP", 4, "\"ftyp3g2\""},
+    {"MIDI", 0, "\"MThd\" 00 00 00 06"},
+    {"AU", 0, "\".snd\""},
+    {"AMR", 0, "\"#!AMR\""},
+
+    {"ZIP", 0, "\"PK\" 03 04"},
+    {"ZIP", 0, "\"PK\" 05 06"},
+    {"ZIP", 0, "\"PK\" 07 08"},
+    {"GZIP", 0, "1F 8B 08"},
+    {"BZIP2", 0, "\"BZh\""},
+    {"XZ", 0, "FD \"7zXZ\" 00"},
+    {"ZSTD", 0, "28 B5 2F FD"},
+    {"LZ4", 0, "04 22 4D 18"},
+    {"LZIP", 0, "\"LZIP\""},
+    {"Z", 0, "1F 9D"},
+    {"7Z", 0, "\"7z\" BC AF 27 1C"},
+    {"RAR", 0, "\"Rar!\" 1A 07 00"},
+    {"RAR", 0, "\"Rar!\" 1A 07 01 00"},
+    {"TAR", 257, "\"ustar\""},
+    {"CAB", 0, "\"MSCF\" 00 00 00 00"},
+    {"ARJ", 0, "60 EA"},
+    {"XAR", 0, "\"xar!\""},
+    {"WIM", 0, "\"MSWIM\" 00 00 00"},
+
+    {"EWF", 0, "\"EVF\" 09 0D 0A FF 00"},
+    {"EWF", 0, "\"LVF\" 09 0D 0A FF 00"},
+    {"EWF2", 0, "\"EVF2\" 0D 0A 81 00"},
+    {"VMDK", 0, "\"KDMV\""},
+    {"VDI", 64, "7F 10 DA BE"},
+    {"VDI", 0, "\"<<< \""},
+    {"VHD", 0, "\"conectix\""},
+    {"VHDX", 0, "\"vhdxfile\""},
+    {"QCOW", 0, "\"QFI\" FB"},
+    {"NTFS", 3, "\"NTFS    \""},
+    {"FAT32", 82, "\"FAT32   \""},
+    {"EXFAT", 3, "\"EXFAT   \""},
+    {"BITLOCKER", 3, "\"-FVE-FS-\""},
+    {"LUKS", 0, "\"LUKS\" BA BE"},
+    {"HIBER", 0, "\"hibr\""},
+    {"HIBER", 0, "\"HIBR\""},
+    {"HIBER", 0, "\"wake\""},
+    {"DMP", 0, "\"PAGEDUMP\""},
+    {"DMP", 0, "\"PAGEDU64\""},
+    {"DMP", 0, "\"MDMP\" 93 A7"},
+
+    {"SQLITE", 0, "\"SQLite format 3\" 00"},
+    {"REGF", 0, "\"regf\""},
+    {"EVTX", 0, "\"ElfFile\" 00"},
+    {"EVT", 4, "\"LfLe\""},
+    {"ESEDB", 4, "EF CD AB 89"},
+    {"MFT", 0, "\"FILE0\""},
+    {"MFT", 0, "\"FILE\" 2A 00"},
+    {"THUMBCACHE", 0, "\"CMMM\""},
+    {"THUMBCACHE", 0, "\"IMMM\""},
+    {"BPLIST", 0, "\"bplist0\""},
+    {"JKS", 0, "FE ED FE ED"},
+    {"ABACKUP", 0, "\"ANDROID BACKUP\" 0A"},
+    {"GITPACK", 0, "\"PACK\" 00 00 00"},
+    {"TZIF", 0, "\"TZif\""},
+    {"BLEND", 0, "\"BLENDER\""},
+    {"TORRENT", 0, "\"d8:announce\""},
+
+    {"TTF", 0, "00 01 00 00 00"},
+    {"TTF", 0, "\"true\" 00"},
+    {"OTF", 0, "\"OTTO\" 00"},
+    {"TTC", 0, "\"ttcf\" 00"},
+    {"WOFF", 0, "\"wOFF\""},
+    {"WOFF2", 0, "\"wOF2\""},
+
+    {"XML", 0, "\"<?xml \""},
+    {"XML", 0, "EF BB BF \"<?xml \""},
+    {"HTML", 0, "\"<!DOCTYPE html\""},
+    {"HTML", 0, "\"<!DOCTYPE HTML\""},
+    {"HTML", 0, "\"<!doctype html\""},
+    {"HTML", 0, "\"<html\""},
+    {"HTML", 0, "\"<HTML\""},
+    {"HTML", 0, "\"<head\""},
+    {"EMAIL", 0, "\"Return-Path: \""},
+    {"EMAIL", 0, "\"Received: \""},
+    {"EMAIL", 0, "\"From \""},
+    {"EMAIL", 0, "\"MIME-Version: \""},
+    {"VCARD", 0, "\"BEGIN:VCARD\""},
+    {"ICAL", 0, "\"BEGIN:VCALENDAR\""},
+    {"PEM", 0, "\"-----BEGIN \""},
+    {"PGP", 0, "\"-----BEGIN PGP\""},
+    {"VMDKDESC", 0, "\"# Disk DescriptorFile\""},
+    {"UTF8BOM", 0, "EF BB BF"},
+    {"UTF16", 0, "FF FE"},
+    {"UTF16", 0, "FE FF"},
+};
+
+#define SIG_PATTERN_COUNT ((int)(sizeof(sig_patterns) / sizeof(sig_patterns[0])))
+
+// A pattern compiled to fixed bytes and a mask, anchored at its first
+// fixed byte
+typedef struct {
+    unsigned short offset;      // Header offset of the first pattern byte
+    unsigned short length;
+    unsigned short specificity; // Number of fixed bytes
+    unsigned short format;      // Index into sig_formats
+    unsigned int bytes;         // Start of bytes and mask in sig_bytes
+    short next;                 // Next pattern in the same bucket, -1 at the end
+} SigCompiled;
+
+typedef struct {
+    unsigned short anchor;      // Offset of the dispatch byte
+    short heads[256];
+} SigGroup;
+
+static SigCompiled sig_compiled[SIG_MAX_PATTERNS];
+static SigGroup sig_groups[SIG_MAX_GROUPS];
+static int sig_group_count;
+static unsigned char sig_bytes[SIG_PATTERN_BYTES];
+static unsigned char sig_mask[SIG_PATTERN_BYTES];
+static unsigned int sig_bytes_used;
+static int sig_text_format;
+
+// Extension to file type, open addressing; the first format to list an
+// extension owns it
+typedef struct {
+    char extension[SIG_EXTENSION_MAX];
+    unsigned char type;
+} SigExtension;
+
+static SigExtension sig_extensions[SIG_EXTENSION_SLOTS];
+
+static int find_format(const char* name) {
+    for (int i = 0; i < SIG_FORMAT_COUNT; i++) {
+        if (strcmp(sig_formats[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Append the pattern to sig_bytes/sig_mask; returns its length or -1
+static int parse_pattern(const char* p) {
+    unsigned int start = sig_bytes_used;
+    while (*p) {
+        if (*p == ' ') {
+            p++;
+        } else if (*p == '"') {
+            for (p++; *p && *p != '"'; p++) {
+                if (sig_bytes_used >= SIG_PATTERN_BYTES) return -1;
+                sig_bytes[sig_bytes_used] = (unsigned char)*p;
+                sig_mask[sig_bytes_used++] = 0xFF;
+            }
+            if (*p != '"') return -1;
+            p++;
+        } else if (*p == '*') {
+            int count = atoi(p + 1);
+            for (p++; *p >= '0' && *p <= '9'; p++) {}
+            for (int i = 0; i < count; i++) {
+                if (sig_bytes_used >= SIG_PATTERN_BYTES) return -1;
+                sig_bytes[sig_bytes_used] = 0;
+                sig_mask[sig_bytes_used++] = 0;
+            }
+        } else if (p[0] == '?' && p[1] == '?') {
+            if (sig_bytes_used >= SIG_PATTERN_BYTES) return -1;
+            sig_bytes[sig_bytes_used] = 0;
+            sig_mask[sig_bytes_used++] = 0;
+            p += 2;
+        } else {
+            int hi = hex_value(p[0]);
+            int lo = hex_value(p[1]);
+            if (hi < 0 || lo < 0 || sig_bytes_used >= SIG_PATTERN_BYTES) return -1;
+            sig_bytes[sig_bytes_used] = (unsigned char)(hi << 4 | lo);
+            sig_mask[sig_bytes_used++] = 0xFF;
+            p += 2;
+        }
+    }
+    return (int)(sig_bytes_used - start);
+}
+
+static SigGroup* group_for(int anchor) {
+    for (int i = 0; i < sig_group_count; i++) {
+        if (sig_groups[i].anchor == anchor) return &sig_groups[i];
+    }
+    if (sig_group_count == SIG_MAX_GROUPS) return NULL;
+    SigGroup* group = &sig_groups[sig_group_count++];
+    group->anchor = (unsigned short)anchor;
+    for (int v = 0; v < 256; v++) group->heads[v] = -1;
+    return group;
+}
+
+// Compile the pattern table into the dispatch groups. Buckets are kept
+// sorted by specificity so the first match in a bucket is its best.
+__attribute__((constructor))
+static void sig_compile(void) {
+    sig_text_format = find_format("TXT");
+
+    for (int i = 0; i < SIG_PATTERN_COUNT; i++) {
+        const SigPattern* source = &sig_patterns[i];
+        SigCompiled* compiled = &sig_compiled[i];
+        int format = find_format(source->format);
+        unsigned int start = sig_bytes_used;
+        int length = parse_pattern(source->pattern);
+        if (format < 0 || length <= 0 || source->offset + length > SIG_HEADER_SIZE) {
+            fprintf(stderr, "sig: bad pattern for %s\n", source->format);
+            sig_bytes_used = start;
+            continue;
+        }
+
+        int first = 0;
+        int specificity = 0;
+        while (first < length && sig_mask[start + first] == 0) first++;
+        for (int j = 0; j < length; j++) specificity += sig_mask[start + j] != 0;
+
+        compiled->offset = (unsigned short)source->offset;
+        compiled->length = (unsigned short)length;
+        compiled->specificity = (unsigned short)specificity;
+        compiled->format = (unsigned short)format;
+        compiled->bytes = start;
+
+        SigGroup* group = group_for(source->offset + first);
+        if (!group) continue;
+        short* link = &group->heads[sig_bytes[start + first]];
+        while (*link >= 0 && sig_compiled[*link].specificity >= specificity) {
+            link = &sig_compiled[*link].next;
+        }
+        compiled->next = *link;
+        *link = (short)i;
+    }
+}
+
+static int pattern_matches(const SigCompiled* pattern, const unsigned char* header, size_t length) {
+    if ((size_t)pattern->offset + pattern->length > length) return 0;
+    const unsigned char* h = header + pattern->offset;
+    const unsigned char* bytes = sig_bytes + pattern->bytes;
+    const unsigned char* mask = sig_mask + pattern->bytes;
+    for (int i = 0; i < pattern->length; i++) {
+        if ((h[i] & mask[i]) != bytes[i]) return 0;
+    }
+    return 1;
+}
+
+// Plain text: no NULs, and nearly all bytes printable, whitespace or UTF-8
+static int looks_like_text(const unsigned char* header, size_t length) {
+    if (length == 0) return 0;
+    size_t printable = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = header[i];
+        if (c == 0) return 0;
+        printable += (c >= 0x20 && c != 0x7F) || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+    return printable * 100 >= length * 95;
+}
+
+const SigFormat* sig_classify(const unsigned char* header, size_t length) {
+    if (length > SIG_HEADER_SIZE) length = SIG_HEADER_SIZE;
+
+    const SigCompiled* best = NULL;
+    for (int g = 0; g < sig_group_count; g++) {
+        const SigGroup* group = &sig_groups[g];
+        if (group->anchor >= length) continue;
+        for (int i = group->heads[header[group->anchor]]; i >= 0; i = sig_compiled[i].next) {
+            const SigCompiled* pattern = &sig_compiled[i];
+            if (best && pattern->specificity <= best->specificity) break;
+            if (pattern_matches(pattern, header, length)) {
+                best = pattern;
+                break;
+            }
+        }
+    }
+
+    if (best) return &sig_formats[best->format];
+    if (looks_like_text(header, length)) return &sig_formats[sig_text_format];
+    return NULL;
+}
+
+int sig_format_id(const SigFormat* format) {
+    return format ? (int)(format - sig_formats) + 1 : 0;
+}
+
+const SigFormat* sig_format(int id) {
+    return id >= 1 && id <= SIG_FORMAT_COUNT ? &sig_formats[id - 1] : NULL;
+}
+
+int sig_format_count(void) {
+    return SIG_FORMAT_COUNT;
+}
+
+static int list_contains(const char* list, const char* extension, size_t length) {
+    while (list && *list) {
+        const char* end = strchr(list, '|');
+        size_t n = end ? (size_t)(end - list) : strlen(list);
+        if (n == length) {
+            size_t i = 0;
+            while (i < n && list[i] == extension[i]) i++;
+            if (i == n) return 1;
+        }
+        list = end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+// Lower-case a name's extension up to the first non-alphanumeric
+// character; returns its length, 0 when there is none
+static size_t extension_of(const char* filename, char extension[SIG_EXTENSION_MAX]) {
+    const char* dot = strrchr(filename, '.');
+    if (!dot || dot == filename) return 0;
+
+    size_t length = 0;
+    for (const char* p = dot + 1; *p && length < SIG_EXTENSION_MAX - 1; p++) {
+        char c = *p;
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-')) break;
+        extension[length++] = c;
+    }
+    extension[length] = '\0';
+    return length;
+}
+
+int sig_extension_check(const SigFormat* format, const char* filename) {
+    if (!format || !filename) return -1;
+    char extension[SIG_EXTENSION_MAX];
+    size_t length = extension_of(filename, extension);
+    if (length == 0) return -1;
+
+    if (format->extensions) return list_contains(format->extensions, extension, length);
+
+    // Generic content such as plain text fits any extension that no
+    // binary format claims for itself
+    for (int i = 0; i < SIG_FORMAT_COUNT; i++) {
+        if (sig_formats[i].type == FILE_TYPE_TEXT || !sig_formats[i].extensions) continue;
+        if (list_contains(sig_formats[i].extensions, extension, length)) return 0;
+    }
+    return -1;
+}
+
+static unsigned extension_hash(const char* extension) {
+    unsigned hash = 2166136261u;
+    for (; *extension; extension++) hash = (hash ^ (unsigned char)*extension) * 16777619u;
+    return hash;
+}
+
+__attribute__((constructor))
+static void sig_index_extensions(void) {
+    for (int i = 0; i < SIG_FORMAT_COUNT; i++) {
+        const char* list = sig_formats[i].extensions;
+        while (list && *list) {
+            const char* end = strchr(list, '|');
+            size_t n = end ? (size_t)(end - list) : strlen(list);
+            char extension[SIG_EXTENSION_MAX];
+            if (n < SIG_EXTENSION_MAX) {
+                memcpy(extension, list, n);
+                extension[n] = '\0';
+                unsigned slot = extension_hash(extension);
+                SigExtension* entry;
+                while ((entry = &sig_extensions[slot & (SIG_EXTENSION_SLOTS - 1)])->extension[0] &&
+                       strcmp(entry->extension, extension) != 0) slot++;
+                if (!entry->extension[0]) {
+                    memcpy(entry->extension, extension, n + 1);
+                    entry->type = (unsigned char)sig_formats[i].type;
+                }
+            }
+            list = end ? end + 1 : NULL;
+        }
+    }
+}
+
+FileType sig_type_from_name(const char* filename) {
+    char extension[SIG_EXTENSION_MAX];
+    if (!filename || extension_of(filename, extension) == 0) return FILE_TYPE_UNKNOWN;
+
+    for (unsigned slot = extension_hash(extension);; slot++) {
+        const SigExtension* entry = &sig_extensions[slot & (SIG_EXTENSION_SLOTS - 1)];
+        if (!entry->extension[0]) return FILE_TYPE_UNKNOWN;
+        if (strcmp(entry->extension, extension) == 0) return (FileType)entry->type;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SIG_H
+#define SIG_H
+
+#include <stddef.h>
+
+#include "filetable.h"
+
+// Magic-byte file signature engine
+//
+// Classifies a file by its first bytes against a table of known headers.
+// Patterns are compiled once at startup into dispatch tables keyed by the
+// offset and value of each pattern's first fixed byte, so a lookup costs
+// one bucket per distinct offset plus a few compares, independent of the
+// table size. The most specific matching pattern wins.
+
+#define SIG_HEADER_SIZE 512 // Bytes of file header the patterns may look at
+
+typedef struct {
+    const char* name;        // Short format name, e.g. "PDF"
+    const char* description;
+    FileType type;
+    const char* extensions;  // '|'-separated, NULL when any extension fits
+} SigFormat;
+
+// Classify a header; NULL when nothing matches
+const SigFormat* sig_classify(const unsigned char* header, size_t length);
+
+// Formats are numbered from 1 so 0 can mean unclassified
+int sig_format_id(const SigFormat* format);
+const SigFormat* sig_format(int id);
+int sig_format_count(void);
+
+// Whether a file name's extension fits the detected format: 1 when it
+// does, 0 on a mismatch, -1 when there is nothing to compare
+int sig_extension_check(const SigFormat* format, const char* filename);
+
+// Type implied by a file name's extension, for listing files before their
+// content is read; FILE_TYPE_UNKNOWN when no format claims it
+FileType sig_type_from_name(const char* filename);
+
+#endif
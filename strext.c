@@ -0,0 +1,352 @@
+#include "strext.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STREXT_X86 1
+#endif
+
+#define STRING_BLOCK (1 << 20)   // Image bytes read per step
+#define STRING_BATCH 256         // Chunks classified per kernel call
+
+#define EVEN_BITS 0x5555555555555555ULL
+
+typedef void (*ClassifyFunction)(const unsigned char* data, size_t chunks,
+                                 uint64_t* printable, uint64_t* zero);
+
+static ClassifyFunction classify;
+
+static inline int printable_byte(unsigned char byte) {
+    return (byte >= 32 && byte <= 126) || byte == '\t';
+}
+
+static void classify_portable(const unsigned char* data, size_t chunks,
+                              uint64_t* printable, uint64_t* zero) {
+    for (size_t c = 0; c < chunks; c++) {
+        const unsigned char* chunk = data + c * 64;
+        uint64_t p = 0, z = 0;
+        for (int i = 0; i < 64; i++) {
+            p |= (uint64_t)printable_byte(chunk[i]) << i;
+            z |= (uint64_t)(chunk[i] == 0) << i;
+        }
+        printable[c] = p;
+        zero[c] = z;
+    }
+}
+
+#ifdef STREXT_X86
+
+// Printable is 0x20..0x7E or tab. Adding 0x60 moves 0x20..0x7E to the
+// bottom of the signed range, so one signed compare bounds both ends.
+__attribute__((target("avx2")))
+static inline uint32_t printable_mask_avx2(__m256i v) {
+    const __m256i shift = _mm256_set1_epi8(0x60);
+    const __m256i limit = _mm256_set1_epi8((char)0xDF);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    __m256i in_range = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(in_range, _mm256_cmpeq_epi8(v, tab)));
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const unsigned char* data, size_t chunks,
+                          uint64_t* printable, uint64_t* zero) {
+    const __m256i nul = _mm256_setzero_si256();
+    for (size_t c = 0; c < chunks; c++) {
+        __m256i low = _mm256_loadu_si256((const __m256i*)(data + c * 64));
+        __m256i high = _mm256_loadu_si256((const __m256i*)(data + c * 64 + 32));
+        printable[c] = (uint64_t)printable_mask_avx2(low) | (uint64_t)printable_mask_avx2(high) << 32;
+        zero[c] = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, nul)) |
+                  (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, nul)) << 32;
+    }
+}
+
+#endif
+
+__attribute__((constructor))
+static void strext_select_kernel(void) {
+    classify = classify_portable;
+#ifdef STREXT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) classify = classify_avx2;
+#endif
+}
+
+const char* string_engine_name(void) {
+#ifdef STREXT_X86
+    if (classify == classify_avx2) return "AVX2";
+#endif
+    return "portable";
+}
+
+void string_scanner_init(StringScanner* scanner, long long offset, int min_length) {
+    memset(scanner, 0, sizeof(*scanner));
+    scanner->min_length = min_length > 0 ? min_length : 1;
+    scanner->offset = offset;
+    scanner->ascii_start = -1;
+    scanner->wide_start[0] = -1;
+    scanner->wide_start[1] = -1;
+}
+
+static void add_string(StringScanner* scanner, StringList* list, long long start, long long end,
+                       StringEncoding encoding) {
+    int width = encoding == STRING_UTF16LE ? 2 : 1;
+    if (end - start < (long long)scanner->min_length * width) return;
+
+    while (start < end) {
+        long long length = end - start < STRING_SPLIT_BYTES ? end - start : STRING_SPLIT_BYTES;
+        if (list->count == list->capacity) {
+            size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+            FoundString* strings = realloc(list->strings, capacity * sizeof(FoundString));
+            if (!strings) {
+                scanner->error = 1;
+                return;
+            }
+            list->strings = strings;
+            list->capacity = capacity;
+        }
+        FoundString* string = &list->strings[list->count++];
+        string->offset = start;
+        string->length = (int)length;
+        string->encoding = encoding;
+        start += length;
+    }
+}
+
+// Bit i set when bits i .. i+length-1 are all set, counting bits past
+// the chunk as set since the next chunk may continue the run
+static inline uint64_t run_heads(uint64_t bits, int length) {
+    if (length > 64) length = 64;
+    uint64_t heads = bits;
+    for (int have = 1; have < length;) {
+        int shift = have < length - have ? have : length - have;
+        heads &= heads >> shift | ~(~0ULL >> shift);
+        have += shift;
+    }
+    return heads;
+}
+
+// Walk the runs of set bits of a chunk at base; *start is the run open
+// from earlier chunks, or -1. Runs too short to report are stepped over
+// without stopping at them.
+static void walk_runs(StringScanner* scanner, StringList* list, uint64_t bits, int length,
+                      long long base, long long* start, StringEncoding encoding) {
+    uint64_t heads = run_heads(bits, length);
+    int position = 0;
+    for (;;) {
+        if (*start >= 0) {
+            uint64_t gaps = ~bits & (~0ULL << position);
+            if (!gaps) return;
+            position = __builtin_ctzll(gaps);
+            add_string(scanner, list, *start, base + position, encoding);
+            *start = -1;
+        } else {
+            uint64_t set = heads & (~0ULL << position);
+            if (!set) return;
+            position = __builtin_ctzll(set);
+            // The run starts after the last gap below its head
+            uint64_t below = ~bits & ((1ULL << position) - 1);
+            position = below ? 64 - __builtin_clzll(below) : 0;
+            *start = base + position;
+        }
+    }
+}
+
+// Find the runs of one chunk; next_zero is whether the byte after it is zero
+static void scan_chunk(StringScanner* scanner, StringList* list, uint64_t printable, uint64_t zero,
+                       uint64_t next_zero) {
+    long long base = scanner->offset;
+    int length = scanner->min_length;
+    walk_runs(scanner, list, printable, length, base, &scanner->ascii_start, STRING_ASCII);
+
+    // Bit i: a printable byte at i followed by a zero. Each character
+    // then covers its two bits, so runs at one parity become runs of bits.
+    uint64_t wide = printable & (zero >> 1 | next_zero << 63);
+    uint64_t even = wide & EVEN_BITS;
+    uint64_t odd = wide & ~EVEN_BITS;
+    walk_runs(scanner, list, even | even << 1, 2 * length, base, &scanner->wide_start[0],
+              STRING_UTF16LE);
+    walk_runs(scanner, list, odd | odd << 1 | scanner->wide_carry, 2 * length, base,
+              &scanner->wide_start[1], STRING_UTF16LE);
+    scanner->wide_carry = odd >> 63;
+    scanner->offset += 64;
+}
+
+// Scan the pending chunk now that the one after it is known
+static void push_chunk(StringScanner* scanner, StringList* list, uint64_t printable, uint64_t zero) {
+    if (scanner->pending) {
+        scan_chunk(scanner, list, scanner->pending_printable, scanner->pending_zero, zero & 1);
+    }
+    scanner->pending_printable = printable;
+    scanner->pending_zero = zero;
+    scanner->pending = 1;
+}
+
+int string_scan(StringScanner* scanner, const unsigned char* data, size_t length, StringList* list) {
+    uint64_t printable[STRING_BATCH], zero[STRING_BATCH];
+
+    if (scanner->tail_length > 0) {
+        size_t fill = 64 - (size_t)scanner->tail_length;
+        if (fill > length) fill = length;
+        memcpy(scanner->tail + scanner->tail_length, data, fill);
+        scanner->tail_length += (int)fill;
+        data += fill;
+        length -= fill;
+        if (scanner->tail_length < 64) return scanner->error ? -1 : 0;
+        classify(scanner->tail, 1, printable, zero);
+        push_chunk(scanner, list, printable[0], zero[0]);
+        scanner->tail_length = 0;
+    }
+
+    while (length >= 64) {
+        size_t chunks = length / 64 < STRING_BATCH ? length / 64 : STRING_BATCH;
+        classify(data, chunks, printable, zero);
+        for (size_t c = 0; c < chunks; c++) push_chunk(scanner, list, printable[c], zero[c]);
+        data += chunks * 64;
+        length -= chunks * 64;
+    }
+
+    memcpy(scanner->tail, data, length);
+    scanner->tail_length = (int)length;
+    return scanner->error ? -1 : 0;
+}
+
+int string_scan_finish(StringScanner* scanner, StringList* list) {
+    long long end = scanner->offset + (scanner->pending ? 64 : 0) + scanner->tail_length;
+    if (scanner->tail_length > 0) {
+        // Bits past the input stay clear, so they close every run
+        uint64_t printable = 0, zero = 0;
+        for (int i = 0; i < scanner->tail_length; i++) {
+            printable |= (uint64_t)printable_byte(scanner->tail[i]) << i;
+            zero |= (uint64_t)(scanner->tail[i] == 0) << i;
+        }
+        push_chunk(scanner, list, printable, zero);
+        scanner->tail_length = 0;
+    }
+    if (scanner->pending) {
+        scan_chunk(scanner, list, scanner->pending_printable, scanner->pending_zero, 0);
+        scanner->pending = 0;
+    }
+
+    // A run reaching the last chunk's final bit is still open
+    if (scanner->ascii_start >= 0) add_string(scanner, list, scanner->ascii_start, end, STRING_ASCII);
+    for (int parity = 0; parity < 2; parity++) {
+        long long start = scanner->wide_start[parity];
+        if (start >= 0) add_string(scanner, list, start, start + ((end - start) & ~1LL), STRING_UTF16LE);
+    }
+    scanner->ascii_start = scanner->wide_start[0] = scanner->wide_start[1] = -1;
+    scanner->offset = end;
+    return scanner->error ? -1 : 0;
+}
+
+// Earliest start of a run still open, -1 when none
+static long long open_start(const StringScanner* scanner) {
+    long long start = scanner->ascii_start;
+    for (int parity = 0; parity < 2; parity++) {
+        long long wide = scanner->wide_start[parity];
+        if (wide >= 0 && (start < 0 || wide < start)) start = wide;
+    }
+    return start;
+}
+
+int string_scan_image(EvidenceImage* image, long long start, long long end, int min_length,
+                      StringList* list, long long* progress, const int* cancel) {
+    long long size = image_size(image);
+    if (end > size) end = size;
+    if (start >= end) return 0;
+
+    // Scanning from two bytes before start opens a string running into
+    // start, of either encoding and parity, before start: one starting at
+    // start or later then starts there in a single pass too
+    unsigned char before[2];
+    int lead = start >= 2 ? 2 : (int)start;
+    if (lead > 0 && image_read(image, start - lead, before, (size_t)lead) != lead) return -1;
+
+    unsigned char* block = malloc(STRING_BLOCK);
+    if (!block) return -1;
+    image_advise(image, start, end - start, IMAGE_ACCESS_SEQUENTIAL);
+
+    StringScanner scanner;
+    string_scanner_init(&scanner, start - lead, min_length);
+    size_t first = list->count;
+    int status = string_scan(&scanner, before, (size_t)lead, list);
+    long long offset = start;
+    while (offset < size && status == 0) {
+        // Past end, only strings that started before it are followed
+        if (offset > end) {
+            long long open = open_start(&scanner);
+            if (open < 0 || open >= end) break;
+        }
+        if (cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) break;
+
+        size_t want = size - offset < STRING_BLOCK ? (size_t)(size - offset) : STRING_BLOCK;
+        if (offset < end && end - offset < (long long)want) want = (size_t)(end - offset);
+        long n = image_read(image, offset, block, want);
+        if (n <= 0 || string_scan(&scanner, block, (size_t)n, list) != 0) {
+            status = -1;
+            break;
+        }
+        if (progress && offset < end) __atomic_fetch_add(progress, (long long)n, __ATOMIC_RELAXED);
+        offset += n;
+    }
+    if (string_scan_finish(&scanner, list) != 0) status = -1;
+    free(block);
+
+    // Keep only strings this range owns
+    size_t kept = first;
+    for (size_t i = first; i < list->count; i++) {
+        const FoundString* string = &list->strings[i];
+        if (string->offset < start || string->offset >= end) continue;
+        list->strings[kept++] = *string;
+    }
+    list->count = kept;
+    return status;
+}
+
+int string_list_append(StringList* list, const StringList* other) {
+    if (list->count + other->count > list->capacity) {
+        size_t capacity = list->capacity ? list->capacity : 1024;
+        while (capacity < list->count + other->count) capacity *= 2;
+        FoundString* strings = realloc(list->strings, capacity * sizeof(FoundString));
+        if (!strings) return -1;
+        list->strings = strings;
+        list->capacity = capacity;
+    }
+    if (other->count > 0) {
+        memcpy(list->strings + list->count, other->strings, other->count * sizeof(FoundString));
+    }
+    list->count += other->count;
+    return 0;
+}
+
+static int compare_strings(const void* a, const void* b) {
+    const FoundString* x = a;
+    const FoundString* y = b;
+    if (x->offset != y->offset) return x->offset < y->offset ? -1 : 1;
+    return x->encoding - y->encoding;
+}
+
+void string_list_sort(StringList* list) {
+    if (list->count > 1) qsort(list->strings, list->count, sizeof(FoundString), compare_strings);
+}
+
+void string_list_free(StringList* list) {
+    free(list->strings);
+    list->strings = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+int string_text(const FoundString* string, const unsigned char* bytes, size_t available,
+                char* out, size_t size) {
+    if (size == 0) return 0;
+    int step = string->encoding == STRING_UTF16LE ? 2 : 1;
+    size_t limit = available < (size_t)string->length ? available : (size_t)string->length;
+    int written = 0;
+    for (size_t i = 0; i < limit && (size_t)written + 1 < size; i += (size_t)step) {
+        out[written++] = bytes[i] == '\t' ? ' ' : (char)bytes[i];
+    }
+    out[written] = '\0';
+    return written;
+}
@@ -0,0 +1,84 @@
+#ifndef STREXT_H
+#define STREXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image.h"
+
+// Strings extraction
+//
+// Finds runs of at least a minimum number of printable characters, both
+// ASCII and UTF-16LE. Bytes are classified 64 at a time into printable
+// and zero bit masks with SIMD compares; runs are then walked over the
+// masks with bit scans, so long stretches of binary or of text cost a
+// few instructions per 64 bytes. A UTF-16LE character is a printable
+// byte followed by a zero byte, at either byte parity. The scanner takes
+// its input in arbitrary pieces, so callers stream a file or image
+// through it block by block.
+
+#define STRING_MIN_LENGTH 4           // Default minimum characters
+#define STRING_SPLIT_BYTES (1 << 30)  // Longer runs are reported in pieces
+
+typedef enum {
+    STRING_ASCII,
+    STRING_UTF16LE
+} StringEncoding;
+
+typedef struct {
+    long long offset;        // Offset of the first byte
+    int length;              // Bytes, twice the characters for UTF-16LE
+    int encoding;            // StringEncoding
+} FoundString;
+
+typedef struct {
+    FoundString* strings;    // In the order they end, for one scanner
+    size_t count;
+    size_t capacity;
+} StringList;
+
+typedef struct {
+    int min_length;
+    int error;               // Out of memory while adding strings
+    long long offset;        // Offset of the next chunk to classify
+    long long ascii_start;   // Open runs, -1 when none
+    long long wide_start[2]; // By parity of the first byte
+    uint64_t wide_carry;     // Odd-parity character spilling into the next chunk
+    uint64_t pending_printable; // Chunk classified, waiting for the next one's first byte
+    uint64_t pending_zero;
+    int pending;
+    int tail_length;         // Bytes fed but not yet a whole chunk
+    unsigned char tail[64];
+} StringScanner;
+
+// Kernel selected at startup, e.g. "AVX2"
+const char* string_engine_name(void);
+
+// Scanner whose first byte fed is at offset
+void string_scanner_init(StringScanner* scanner, long long offset, int min_length);
+
+// Feed the next bytes; strings that end inside them are added to list.
+// Returns 0, or -1 when the list could not grow.
+int string_scan(StringScanner* scanner, const unsigned char* data, size_t length, StringList* list);
+
+// Close the strings still open at the end of the input
+int string_scan_finish(StringScanner* scanner, StringList* list);
+
+// Find the strings that start in [start, end) of the image. Strings are
+// followed past end; a string running into start belongs to the range
+// before. Adds the bytes scanned in [start, end) to *progress and stops
+// early once *cancel is set; both may be NULL. Returns 0 on success.
+int string_scan_image(EvidenceImage* image, long long start, long long end, int min_length,
+                      StringList* list, long long* progress, const int* cancel);
+
+// Append another list's strings; returns -1 when out of memory
+int string_list_append(StringList* list, const StringList* other);
+void string_list_sort(StringList* list);
+void string_list_free(StringList* list);
+
+// Printable text of a string from its first bytes, as many as fit in
+// size including the NUL. Returns the characters written.
+int string_text(const FoundString* string, const unsigned char* bytes, size_t available,
+                char* out, size_t size);
+
+#endif
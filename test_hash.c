@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+// Known-answer test: the standard MD5, SHA-1 and SHA-256 vectors through
+// the portable kernels and through the fastest the CPU has, fed whole,
+// in uneven pieces, and side by side through the multi-buffer batch.
+
+#define MILLION 1000000
+#define BATCH_LENGTH (64 * 37 + 13) // Whole blocks plus a tail
+#define BATCH_STEP 512
+
+typedef struct {
+    const char* name;
+    const char* md5;
+    const char* sha1;
+    const char* sha256;
+} Vector;
+
+static const Vector vectors[] = {
+    {"", "d41d8cd98f00b204e9800998ecf8427e", "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+     "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc", "900150983cd24fb0d6963f7d28e17f72", "a9993e364706816aba3e25717850c26c9cd0d89d",
+     "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "8215ef0796a20bcaaae116d3876c664a",
+     "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    // No name: a million 'a'
+    {NULL, "7707d6ae4e027c70eea2a935c2296f21", "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+     "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+};
+
+static unsigned char million[MILLION];
+
+static int check_digests(const HashDigests* digests, const Vector* vector, const char* label) {
+    char hex[65];
+    int failures = 0;
+    hash_format(digests->md5, sizeof(digests->md5), hex);
+    failures += strcmp(hex, vector->md5) != 0;
+    hash_format(digests->sha1, sizeof(digests->sha1), hex);
+    failures += strcmp(hex, vector->sha1) != 0;
+    hash_format(digests->sha256, sizeof(digests->sha256), hex);
+    failures += strcmp(hex, vector->sha256) != 0;
+    if (failures) printf("%s: \"%.20s\" digests differ\n", label, vector->name ? vector->name : "a x 1000000");
+    return failures;
+}
+
+static void hash_pieces(const unsigned char* data, size_t length, size_t piece, HashDigests* digests) {
+    HashContext context;
+    hash_init(&context, HASH_ALL);
+    for (size_t done = 0; done < length; done += piece) {
+        hash_update(&context, data + done, length - done < piece ? length - done : piece);
+    }
+    hash_final(&context, digests);
+}
+
+// Each vector whole and in pieces that straddle block boundaries
+static int test_vectors(const char* label) {
+    static const size_t pieces[] = {1, 7, 63, 64, 65, 4096, MILLION};
+    int failures = 0;
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+        const unsigned char* data = vectors[v].name ? (const unsigned char*)vectors[v].name : million;
+        size_t length = vectors[v].name ? strlen(vectors[v].name) : MILLION;
+        for (size_t p = 0; p < sizeof(pieces) / sizeof(pieces[0]); p++) {
+            if (!vectors[v].name && pieces[p] < 63) continue; // Slow and adds nothing
+            HashDigests digests;
+            hash_pieces(data, length, pieces[p], &digests);
+            failures += check_digests(&digests, &vectors[v], label);
+        }
+    }
+    return failures;
+}
+
+// Lanes of different data through hash_update_batch must match hashing
+// each alone, for every lane count. One lane starts a byte in, so it is
+// unaligned and takes the single-buffer path beside the others.
+static int test_batch(const char* label, const HashDigests expected[HASH_BATCH_LANES]) {
+    static unsigned char data[HASH_BATCH_LANES][BATCH_LENGTH];
+    for (int lane = 0; lane < HASH_BATCH_LANES; lane++) {
+        for (int i = 0; i < BATCH_LENGTH; i++) data[lane][i] = (unsigned char)(i * (lane + 3) + lane);
+    }
+
+    int failures = 0;
+    for (int count = 1; count <= HASH_BATCH_LANES; count++) {
+        HashContext contexts[HASH_BATCH_LANES];
+        HashContext* active[HASH_BATCH_LANES];
+        for (int lane = 0; lane < count; lane++) {
+            hash_init(&contexts[lane], HASH_ALL);
+            active[lane] = &contexts[lane];
+        }
+        // Lane count - 1 takes its first byte alone
+        if (count > 2) hash_update(&contexts[count - 1], data[count - 1], 1);
+        for (int done = 0; done < BATCH_LENGTH; done += BATCH_STEP) {
+            const unsigned char* inputs[HASH_BATCH_LANES];
+            size_t length = BATCH_LENGTH - done < BATCH_STEP ? (size_t)(BATCH_LENGTH - done) : BATCH_STEP;
+            for (int lane = 0; lane < count; lane++) {
+                int skip = count > 2 && lane == count - 1;
+                inputs[lane] = data[lane] + done + skip;
+            }
+            // The unaligned lane has one byte less left at the end
+            if (count > 2 && done + (int)length == BATCH_LENGTH) {
+                hash_update_batch(active, inputs, length, count - 1);
+                hash_update(active[count - 1], inputs[count - 1], length - 1);
+            } else {
+                hash_update_batch(active, inputs, length, count);
+            }
+        }
+        for (int lane = 0; lane < count; lane++) {
+            HashDigests digests;
+            hash_final(&contexts[lane], &digests);
+            if (memcmp(&digests, &expected[lane], sizeof(digests)) != 0) {
+                printf("%s: batch of %d, lane %d differs\n", label, count, lane);
+                failures++;
+            }
+        }
+    }
+
+    // Eight copies of the million 'a' in lockstep
+    HashContext contexts[HASH_BATCH_LANES];
+    HashContext* active[HASH_BATCH_LANES];
+    const unsigned char* inputs[HASH_BATCH_LANES];
+    for (int lane = 0; lane < HASH_BATCH_LANES; lane++) {
+        hash_init(&contexts[lane], HASH_ALL);
+        active[lane] = &contexts[lane];
+    }
+    for (int done = 0; done < MILLION; done += 4096) {
+        for (int lane = 0; lane < HASH_BATCH_LANES; lane++) inputs[lane] = million + done;
+        hash_update_batch(active, inputs, MILLION - done < 4096 ? (size_t)(MILLION - done) : 4096, HASH_BATCH_LANES);
+    }
+    for (int lane = 0; lane < HASH_BATCH_LANES; lane++) {
+        HashDigests digests;
+        hash_final(&contexts[lane], &digests);
+        failures += check_digests(&digests, &vectors[3], label);
+    }
+    return failures;
+}
+
+int main(void) {
+    memset(million, 'a', sizeof(million));
+
+    // Batch references from the portable kernels, one lane at a time
+    hash_force_portable(1);
+    HashDigests expected[HASH_BATCH_LANES];
+    static unsigned char data[BATCH_LENGTH];
+    for (int lane = 0; lane < HASH_BATCH_LANES; lane++) {
+        for (int i = 0; i < BATCH_LENGTH; i++) data[i] = (unsigned char)(i * (lane + 3) + lane);
+        hash_pieces(data, BATCH_LENGTH, BATCH_LENGTH, &expected[lane]);
+    }
+
+    int failures = 0;
+    for (int portable = 1; portable >= 0; portable--) {
+        hash_force_portable(portable);
+        const char* label = hash_engine_name();
+        int engine_failures = test_vectors(label) + test_batch(label, expected);
+        printf("Hash engine %s: %d failures\n", label, engine_failures);
+        failures += engine_failures;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
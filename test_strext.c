@@ -0,0 +1,216 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "strext.h"
+
+// Range test: the strings of an image scanned as two ranges, split at
+// every offset, must be the strings of one pass over it. Splits land
+// inside ASCII runs and inside UTF-16LE runs at both byte parities.
+// Reference test: one pass must find what a byte-by-byte extractor
+// finds, also when the bytes are streamed in uneven pieces.
+
+#define TEST_SIZE 256
+#define STREAM_ROUNDS 300
+#define STREAM_MAX 5000
+
+static int compare_found(const FoundString* a, const FoundString* b) {
+    return a->offset == b->offset && a->length == b->length && a->encoding == b->encoding;
+}
+
+static void put_wide(unsigned char* image, int offset, const char* text) {
+    for (int i = 0; text[i]; i++) {
+        image[offset + 2 * i] = (unsigned char)text[i];
+        image[offset + 2 * i + 1] = 0;
+    }
+}
+
+static int printable(unsigned char c) {
+    return (c >= 32 && c <= 126) || c == '\t';
+}
+
+static void add_string(StringList* list, long long offset, long long length, StringEncoding encoding) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->strings = realloc(list->strings, list->capacity * sizeof(FoundString));
+        if (!list->strings) exit(1);
+    }
+    FoundString* string = &list->strings[list->count++];
+    string->offset = offset;
+    string->length = (int)length;
+    string->encoding = encoding;
+}
+
+// The strings of bytes found one byte at a time, sorted
+static void reference_strings(const unsigned char* bytes, long long size, int min_length, StringList* list) {
+    for (long long i = 0; i < size;) {
+        long long end = i;
+        while (end < size && printable(bytes[end])) end++;
+        if (end - i >= min_length) add_string(list, i, end - i, STRING_ASCII);
+        i = end > i ? end : i + 1;
+    }
+    for (int parity = 0; parity < 2; parity++) {
+        for (long long i = parity; i + 1 < size;) {
+            long long end = i;
+            while (end + 1 < size && printable(bytes[end]) && bytes[end + 1] == 0) end += 2;
+            if (end - i >= 2LL * min_length) add_string(list, i, end - i, STRING_UTF16LE);
+            i = end > i ? end : i + 2;
+        }
+    }
+    string_list_sort(list);
+}
+
+static int same_strings(const StringList* a, const StringList* b) {
+    if (a->count != b->count) return 0;
+    for (size_t i = 0; i < a->count; i++) {
+        if (!compare_found(&a->strings[i], &b->strings[i])) return 0;
+    }
+    return 1;
+}
+
+// Compare split scans with the whole one; returns the failures
+static int check_splits(EvidenceImage* image, const char* label) {
+    long long size = image_size(image);
+    StringList whole = {0};
+    if (string_scan_image(image, 0, size, STRING_MIN_LENGTH, &whole, NULL, NULL) != 0) {
+        printf("%s: scan failed\n", label);
+        return 1;
+    }
+    string_list_sort(&whole);
+
+    int failures = 0;
+    unsigned char bytes[TEST_SIZE];
+    StringList reference = {0};
+    if (image_read(image, 0, bytes, TEST_SIZE) != TEST_SIZE) failures++;
+    reference_strings(bytes, TEST_SIZE, STRING_MIN_LENGTH, &reference);
+    if (!same_strings(&whole, &reference)) {
+        printf("%s: one pass finds %zu strings, the reference %zu\n", label, whole.count, reference.count);
+        failures++;
+    }
+    string_list_free(&reference);
+    for (long long split = 1; split < size; split++) {
+        StringList parts = {0};
+        int status = string_scan_image(image, 0, split, STRING_MIN_LENGTH, &parts, NULL, NULL);
+        if (status == 0) status = string_scan_image(image, split, size, STRING_MIN_LENGTH, &parts, NULL, NULL);
+        string_list_sort(&parts);
+        int same = status == 0 && parts.count == whole.count;
+        for (size_t i = 0; same && i < whole.count; i++) same = compare_found(&parts.strings[i], &whole.strings[i]);
+        if (!same) {
+            if (failures++ < 5) {
+                printf("%s: split at %lld gives %zu strings, one pass %zu\n", label, split, parts.count, whole.count);
+            }
+        }
+        string_list_free(&parts);
+    }
+    printf("%s: %zu strings, %lld splits, %d failures\n", label, whole.count, size - 1, failures);
+    string_list_free(&whole);
+    return failures;
+}
+
+static int test_image(const unsigned char* bytes, const char* label) {
+    char path[] = "/tmp/test_strext_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, bytes, TEST_SIZE) != TEST_SIZE) {
+        printf("%s: cannot write %s\n", label, path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    close(fd);
+    EvidenceImage* image = image_open(path);
+    int failures = image ? check_splits(image, label) : 1;
+    if (!image) printf("%s: cannot open %s\n", label, path);
+    image_close(image);
+    unlink(path);
+    return failures;
+}
+
+// Random buffers with text, UTF-16LE and tabs, fed in random pieces at
+// random minimum lengths; returns the failures
+static int check_streams(void) {
+    static unsigned char bytes[STREAM_MAX];
+    int failures = 0;
+    srand(2);
+    for (int round = 0; round < STREAM_ROUNDS; round++) {
+        long long size = rand() % STREAM_MAX + 1;
+        for (long long i = 0; i < size; i++) {
+            int kind = rand() % 10;
+            bytes[i] = kind < 4 ? (unsigned char)('a' + rand() % 26) : kind < 6 ? 0
+                     : kind < 7 ? '\t' : (unsigned char)rand();
+        }
+        for (int k = 0; k < 5; k++) {
+            long long at = rand() % size;
+            int characters = rand() % 40;
+            for (int c = 0; c < characters && at + 2 * c + 1 < size; c++) {
+                bytes[at + 2 * c] = (unsigned char)('A' + c % 26);
+                bytes[at + 2 * c + 1] = 0;
+            }
+        }
+        // Whole buffers of one run
+        if (round % 7 == 0) memset(bytes, 'x', (size_t)size);
+        if (round % 11 == 0) {
+            for (long long i = 0; i < size; i++) bytes[i] = i & 1 ? 0 : 'y';
+        }
+
+        int min_length = rand() % 6 + 1;
+        StringList reference = {0}, found = {0};
+        reference_strings(bytes, size, min_length, &reference);
+        StringScanner scanner;
+        string_scanner_init(&scanner, 0, min_length);
+        for (long long done = 0; done < size;) {
+            long long piece = rand() % 300;
+            if (piece > size - done) piece = size - done;
+            string_scan(&scanner, bytes + done, (size_t)piece, &found);
+            done += piece;
+        }
+        string_scan_finish(&scanner, &found);
+        string_list_sort(&found);
+        if (!same_strings(&found, &reference)) {
+            if (failures++ < 5) {
+                printf("stream round %d: %lld bytes, minimum %d: %zu strings, the reference %zu\n",
+                       round, size, min_length, found.count, reference.count);
+            }
+        }
+        string_list_free(&reference);
+        string_list_free(&found);
+    }
+    printf("streamed buffers: %d rounds, %d failures\n", STREAM_ROUNDS, failures);
+    return failures;
+}
+
+int main(void) {
+    printf("Strings engine: %s\n", string_engine_name());
+    unsigned char bytes[TEST_SIZE];
+    int failures = 0;
+
+    // Strings apart in binary: UTF-16LE starting at an odd and an even
+    // offset, and ASCII
+    memset(bytes, 0x01, sizeof(bytes));
+    memcpy(bytes + 20, "plain ascii text", 16);
+    put_wide(bytes, 99, "odd aligned");
+    put_wide(bytes, 160, "even aligned");
+    failures += test_image(bytes, "separate strings");
+
+    // Strings back to back, so every split is next to one
+    memset(bytes, 0x01, sizeof(bytes));
+    for (int offset = 1; offset + 18 < TEST_SIZE; offset += 37) {
+        put_wide(bytes, offset, "wide run");
+        memcpy(bytes + offset + 17, "narrow", 6);
+    }
+    failures += test_image(bytes, "adjacent strings");
+
+    // Random text, zeros and binary
+    srand(1);
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < TEST_SIZE; i++) {
+            int kind = rand() % 10;
+            bytes[i] = kind < 4 ? (unsigned char)('a' + rand() % 26) : kind < 7 ? 0 : (unsigned char)rand();
+        }
+        failures += test_image(bytes, "random bytes");
+    }
+    failures += check_streams();
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
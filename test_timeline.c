@@ -0,0 +1,213 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "timeline.h"
+
+// Timeline store test: events added over several runs must come back in
+// time order, equal times in the order they were added, from range
+// queries before and after merging, and from the store reopened. Each
+// event's source is its position in the order added, so the expected
+// order is a sort by time, then source.
+
+#define BASE_TIME 1500000000LL
+#define SPAN 50000               // Seconds; narrow enough for many equal times
+#define RUN_EVENTS 20000
+#define RUNS 5
+#define SMALL_RUNS (TIMELINE_MAX_RUNS + 6) // Enough to force a merge while adding
+#define SMALL_RUN_EVENTS 100
+#define QUERIES 300
+#define MAX_EVENTS (RUNS * RUN_EVENTS + RUN_EVENTS / 2 + SMALL_RUNS * SMALL_RUN_EVENTS)
+
+static TimelineEvent expected[MAX_EVENTS];
+static size_t expected_count;
+static unsigned long long seed = 88172645463325252ULL;
+
+static unsigned long long next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+static int compare_events(const void* a, const void* b) {
+    const TimelineEvent* x = a;
+    const TimelineEvent* y = b;
+    if (x->time != y->time) return x->time < y->time ? -1 : 1;
+    return x->source < y->source ? -1 : x->source > y->source;
+}
+
+static int same_event(const TimelineEvent* a, const TimelineEvent* b) {
+    return a->time == b->time && a->source == b->source && a->macb == b->macb && a->kind == b->kind;
+}
+
+static int add_events(Timeline* timeline, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        TimelineEvent event = {BASE_TIME + (long long)(next_random() % SPAN), (unsigned int)expected_count,
+                               (unsigned short)(1 + next_random() % 15), TIMELINE_SOURCE_FILE};
+        if (timeline_add(timeline, &event) != 0) return -1;
+        expected[expected_count++] = event;
+    }
+    return 0;
+}
+
+static size_t expected_first(long long time) {
+    size_t low = 0, high = expected_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (expected[middle].time < time) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+// Random windows, empty and reversed ones included, walked and counted
+static int check_queries(const Timeline* timeline, const char* label) {
+    qsort(expected, expected_count, sizeof(TimelineEvent), compare_events);
+    int failures = 0;
+    for (int q = 0; q < QUERIES; q++) {
+        long long from = BASE_TIME - 10 + (long long)(next_random() % (SPAN + 20));
+        long long to = from + (long long)(next_random() % (q % 3 == 0 ? 5 : SPAN / 4)) - (q % 50 == 0 ? 3 : 0);
+        size_t first = expected_first(from);
+        size_t end = from < to ? expected_first(to) : first;
+
+        TimelineCursor cursor;
+        timeline_query(timeline, from, to, &cursor);
+        size_t i = first;
+        const TimelineEvent* event;
+        while ((event = timeline_next(&cursor)) != NULL) {
+            if (i >= end || !same_event(event, &expected[i])) break;
+            i++;
+        }
+        if (event != NULL || i != end) {
+            printf("%s: query [%lld, %lld) differs at event %zu of %zu\n", label, from - BASE_TIME, to - BASE_TIME,
+                   i - first, end - first);
+            failures++;
+        }
+        if (timeline_range_count(timeline, from, to) != end - first) {
+            printf("%s: range count of [%lld, %lld) is not %zu\n", label, from - BASE_TIME, to - BASE_TIME, end - first);
+            failures++;
+        }
+    }
+
+    long long first_time, last_time;
+    if (timeline_bounds(timeline, &first_time, &last_time) != 0 || first_time != expected[0].time ||
+        last_time != expected[expected_count - 1].time) {
+        printf("%s: bounds differ\n", label);
+        failures++;
+    }
+    return failures;
+}
+
+// One run holding every event in order, and a pyramid counting them all
+static int check_merged(const Timeline* timeline, const char* label) {
+    int failures = 0;
+    size_t count;
+    const TimelineEvent* events = timeline_run(timeline, 0, &count);
+    if (timeline_run_count(timeline) != 1 || count != expected_count) {
+        printf("%s: %d runs of %zu events after merging\n", label, timeline_run_count(timeline), count);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!same_event(&events[i], &expected[i])) {
+            printf("%s: merged event %zu out of order\n", label, i);
+            failures++;
+            break;
+        }
+    }
+    for (int level = 0; level < TIMELINE_LEVELS; level++) {
+        size_t buckets;
+        const TimelineBucket* bucket = timeline_level(timeline, (TimelineLevel)level, &buckets);
+        unsigned long long total = 0;
+        for (size_t i = 0; i < buckets; i++) total += bucket[i].count;
+        if (!bucket || total != count) {
+            printf("%s: level %d counts %llu events\n", label, level, total);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(void) {
+    char path[] = "/tmp/test_timeline.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    int failures = 0;
+    Timeline* timeline = timeline_create(path);
+    if (!timeline) {
+        printf("cannot create %s\n", path);
+        return 1;
+    }
+    for (int run = 0; run < RUNS; run++) {
+        if (add_events(timeline, RUN_EVENTS) != 0 || timeline_flush(timeline) != 0) failures++;
+    }
+    failures += check_queries(timeline, "runs");
+
+    // A cancelled merge leaves the runs as they were
+    int cancel = 1;
+    if (timeline_merge(timeline, NULL, &cancel) == 0 || timeline_run_count(timeline) != RUNS) {
+        printf("cancelled merge changed the store\n");
+        failures++;
+    }
+    failures += check_queries(timeline, "cancelled");
+
+    // The buffered half run is flushed by the merge
+    long long progress = 0;
+    if (add_events(timeline, RUN_EVENTS / 2) != 0 || timeline_merge(timeline, &progress, NULL) != 0) failures++;
+    if (progress != (long long)expected_count) {
+        printf("merge progress %lld of %zu\n", progress, expected_count);
+        failures++;
+    }
+    failures += check_queries(timeline, "merged") + check_merged(timeline, "merged");
+    timeline_close(timeline);
+
+    timeline = timeline_open(path);
+    if (!timeline) {
+        printf("cannot reopen %s\n", path);
+        return 1;
+    }
+    failures += check_queries(timeline, "reopened") + check_merged(timeline, "reopened");
+
+    // Adding drops the pyramid; more runs than the store holds merge as
+    // they are flushed
+    for (int run = 0; run < SMALL_RUNS; run++) {
+        if (add_events(timeline, SMALL_RUN_EVENTS) != 0 || timeline_flush(timeline) != 0) failures++;
+    }
+    size_t buckets;
+    if (timeline_level(timeline, TIMELINE_LEVEL_DAY, &buckets) != NULL || timeline_run_count(timeline) > TIMELINE_MAX_RUNS) {
+        printf("%d runs and a pyramid after adding\n", timeline_run_count(timeline));
+        failures++;
+    }
+    failures += check_queries(timeline, "added");
+    if (timeline_merge(timeline, NULL, NULL) != 0) failures++;
+    failures += check_merged(timeline, "merged again");
+    timeline_close(timeline);
+
+    timeline = timeline_open(path);
+    if (!timeline) {
+        printf("cannot reopen %s\n", path);
+        return 1;
+    }
+    failures += check_queries(timeline, "reopened again") + check_merged(timeline, "reopened again");
+    timeline_close(timeline);
+
+    // A store cut short is refused
+    if (truncate(path, 4096 + (off_t)(expected_count / 2 * sizeof(TimelineEvent))) != 0 ||
+        (timeline = timeline_open(path)) != NULL) {
+        printf("truncated store opened\n");
+        timeline_close(timeline);
+        failures++;
+    }
+    unlink(path);
+
+    printf("%zu events: %d failures\n", expected_count, failures);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
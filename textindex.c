@@ -0,0 +1,502 @@
+#define _GNU_SOURCE
+#include "textindex.h"
+#include "hash.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEXT_INDEX_MAGIC "CHRNIDX2"
+#define IMAGE_SAMPLE (1 << 20)   // Bytes at each end of the image in its fingerprint
+#define TRIGRAM_ALPHABET 95      // Printable ASCII, with letters folded to lower case
+#define TRIGRAM_KEYS (TRIGRAM_ALPHABET * TRIGRAM_ALPHABET * TRIGRAM_ALPHABET)
+#define WRITE_BUFFER (1 << 20)
+#define NOT_SEEN UINT32_MAX
+
+typedef struct {
+    char magic[8];
+    uint64_t image_size;
+    unsigned char image_hash[32]; // SHA-256 of the size and the bytes at each end
+    uint64_t string_count;
+    uint64_t text_size;
+    uint64_t posting_count;
+    uint64_t strings_offset;     // IndexString[string_count]
+    uint64_t text_offset;        // Text of every string, back to back
+    uint64_t directory_offset;   // uint64_t[TRIGRAM_KEYS + 1], first posting of each key
+    uint64_t postings_offset;    // uint32_t string ids, ascending per key
+    uint64_t file_size;
+} IndexHeader;
+
+typedef struct {
+    uint64_t image_offset;
+    int64_t file_offset;         // -1 outside every file
+    uint64_t text_start;         // Into the text section
+    int32_t file_index;          // -1 in unallocated space
+    uint32_t text_length;        // Characters stored
+    uint32_t length;             // Bytes in the image
+    uint32_t encoding;
+} IndexString;
+
+struct TextIndex {
+    unsigned char* map;
+    size_t size;
+    const IndexHeader* header;
+    const IndexString* strings;
+    const char* text;
+    const uint64_t* directory;
+    const uint32_t* postings;
+};
+
+// Buffered writer for one section of the file
+typedef struct {
+    int fd;
+    off_t offset;
+    size_t used;
+    unsigned char* data;
+    int error;
+} SectionWriter;
+
+static inline char fold(char c) {
+    return c >= 'A' && c <= 'Z' ? (char)(c + 32) : c;
+}
+
+static inline uint32_t trigram_code(char c) {
+    unsigned char folded = (unsigned char)fold(c);
+    return folded >= 32 && folded <= 126 ? folded - 32u : 0;
+}
+
+static inline uint32_t trigram(const char* text) {
+    return (trigram_code(text[0]) * TRIGRAM_ALPHABET + trigram_code(text[1])) * TRIGRAM_ALPHABET +
+           trigram_code(text[2]);
+}
+
+static int write_all(int fd, const void* data, size_t length, off_t offset) {
+    const unsigned char* bytes = data;
+    while (length > 0) {
+        ssize_t n = pwrite(fd, bytes, length, offset);
+        if (n <= 0) return -1;
+        bytes += n;
+        length -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+static void section_flush(SectionWriter* writer) {
+    if (writer->used == 0) return;
+    if (write_all(writer->fd, writer->data, writer->used, writer->offset) != 0) writer->error = 1;
+    writer->offset += (off_t)writer->used;
+    writer->used = 0;
+}
+
+static void section_write(SectionWriter* writer, const void* data, size_t length) {
+    if (writer->used + length > WRITE_BUFFER) section_flush(writer);
+    if (length > WRITE_BUFFER) {
+        if (write_all(writer->fd, data, length, writer->offset) != 0) writer->error = 1;
+        writer->offset += (off_t)length;
+        return;
+    }
+    memcpy(writer->data + writer->used, data, length);
+    writer->used += length;
+}
+
+// Fingerprint of the image the index was built from: the size and the
+// first and last IMAGE_SAMPLE bytes, which differ between acquisitions
+// even of the same size
+static int image_fingerprint(EvidenceImage* image, unsigned char hash[32]) {
+    long long size = image_size(image);
+    unsigned char* buffer = malloc(IMAGE_SAMPLE);
+    if (!buffer) return -1;
+
+    HashContext context;
+    hash_init(&context, HASH_SHA256);
+    unsigned char size_bytes[8];
+    for (int i = 0; i < 8; i++) size_bytes[i] = (unsigned char)((unsigned long long)size >> (8 * i));
+    hash_update(&context, size_bytes, sizeof(size_bytes));
+    long long sample = size < IMAGE_SAMPLE ? size : IMAGE_SAMPLE;
+    long long starts[2] = {0, size - sample};
+    int status = 0;
+    for (int i = 0; i < 2 && status == 0; i++) {
+        if (image_read(image, starts[i], buffer, (size_t)sample) != (long)sample) status = -1;
+        else hash_update(&context, buffer, (size_t)sample);
+    }
+    free(buffer);
+    HashDigests digests;
+    hash_final(&context, &digests);
+    memcpy(hash, digests.sha256, 32);
+    return status;
+}
+
+// Every section inside the file and in order, without overflow on
+// damaged counts
+static int header_valid(const IndexHeader* header, uint64_t size) {
+    if (memcmp(header->magic, TEXT_INDEX_MAGIC, sizeof(header->magic)) != 0 || header->file_size != size ||
+        header->strings_offset != sizeof(IndexHeader) || header->string_count >= NOT_SEEN ||
+        header->string_count > (size - header->strings_offset) / sizeof(IndexString) ||
+        header->text_offset != header->strings_offset + header->string_count * sizeof(IndexString) ||
+        header->text_size > size - header->text_offset) return 0;
+    uint64_t text_end = header->text_offset + header->text_size;
+    uint64_t directory_size = (TRIGRAM_KEYS + 1) * sizeof(uint64_t);
+    if (header->directory_offset < text_end || header->directory_offset % 8 != 0 ||
+        header->directory_offset > size || directory_size > size - header->directory_offset ||
+        header->postings_offset != header->directory_offset + directory_size ||
+        header->posting_count > (size - header->postings_offset) / sizeof(uint32_t)) return 0;
+    return header->postings_offset + header->posting_count * sizeof(uint32_t) == size;
+}
+
+// Each key's postings and each string's text inside their sections
+static int contents_valid(const TextIndex* index) {
+    const IndexHeader* header = index->header;
+    if (index->directory[0] != 0 || index->directory[TRIGRAM_KEYS] != header->posting_count) return 0;
+    for (uint32_t key = 0; key < TRIGRAM_KEYS; key++) {
+        if (index->directory[key + 1] < index->directory[key]) return 0;
+    }
+    for (uint64_t i = 0; i < header->string_count; i++) {
+        const IndexString* record = &index->strings[i];
+        if (record->text_start > header->text_size ||
+            record->text_length > header->text_size - record->text_start) return 0;
+    }
+    return 1;
+}
+
+static int compare_extents(const void* a, const void* b) {
+    const TextIndexExtent* x = a;
+    const TextIndexExtent* y = b;
+    if (x->image_offset != y->image_offset) return x->image_offset < y->image_offset ? -1 : 1;
+    return x->file_index - y->file_index;
+}
+
+TextIndexExtent* text_index_extents(const FileTable* table, int* count) {
+    int capacity = 0;
+    int entries = file_table_count(table);
+    for (int i = 0; i < entries; i++) {
+        int run_count;
+        if (file_table_runs(table, i, &run_count)) capacity += run_count;
+    }
+    *count = 0;
+    if (capacity == 0) return NULL;
+
+    TextIndexExtent* extents = malloc((size_t)capacity * sizeof(TextIndexExtent));
+    if (!extents) return NULL;
+    for (int i = 0; i < entries; i++) {
+        int run_count;
+        const ImageRun* runs = file_table_runs(table, i, &run_count);
+        long long logical = 0;
+        for (int r = 0; runs && r < run_count; r++) {
+            if (runs[r].offset != IMAGE_RUN_SPARSE) {
+                TextIndexExtent* extent = &extents[(*count)++];
+                extent->image_offset = runs[r].offset;
+                extent->length = runs[r].length;
+                extent->file_offset = logical;
+                extent->file_index = i;
+            }
+            logical += runs[r].length;
+        }
+    }
+    qsort(extents, (size_t)*count, sizeof(TextIndexExtent), compare_extents);
+    return extents;
+}
+
+// Extents may nest, so a few before the last one starting at or below
+// offset are tried too
+const TextIndexExtent* text_index_find_extent(const TextIndexExtent* extents, int count, long long offset) {
+    int low = 0, high = count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (extents[middle].image_offset <= offset) low = middle + 1;
+        else high = middle;
+    }
+    for (int i = low - 1; i >= 0 && i >= low - 8; i--) {
+        if (offset < extents[i].image_offset + extents[i].length) return &extents[i];
+    }
+    return NULL;
+}
+
+int text_index_build(const char* path, EvidenceImage* image, const StringList* strings,
+                     const TextIndexExtent* extents, int extent_count,
+                     long long* progress, const int* cancel) {
+    if (strings->count >= NOT_SEEN) return -1;
+    char temporary[4096];
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= (int)sizeof(temporary)) return -1;
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEXT_INDEX_MAGIC, sizeof(header.magic));
+    header.image_size = (uint64_t)image_size(image);
+    if (image_fingerprint(image, header.image_hash) != 0) {
+        close(fd);
+        unlink(temporary);
+        return -1;
+    }
+    header.string_count = strings->count;
+    header.strings_offset = sizeof(IndexHeader);
+    header.text_offset = header.strings_offset + strings->count * sizeof(IndexString);
+
+    uint64_t* counts = calloc(TRIGRAM_KEYS + 1, sizeof(uint64_t));
+    uint32_t* seen = malloc(TRIGRAM_KEYS * sizeof(uint32_t));
+    unsigned char* raw = malloc(2 * TEXT_INDEX_TEXT_MAX);
+    char* text = malloc(TEXT_INDEX_TEXT_MAX + 1);
+    SectionWriter records = {fd, (off_t)header.strings_offset, 0, malloc(WRITE_BUFFER), 0};
+    SectionWriter texts = {fd, (off_t)header.text_offset, 0, malloc(WRITE_BUFFER), 0};
+    int status = counts && seen && raw && text && records.data && texts.data ? 0 : -1;
+    if (seen) memset(seen, 0xFF, TRIGRAM_KEYS * sizeof(uint32_t));
+
+    // Pass one: records and text, and how many strings hold each trigram
+    for (size_t i = 0; status == 0 && i < strings->count; i++) {
+        if ((i & 1023) == 0 && cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) status = -1;
+        const FoundString* string = &strings->strings[i];
+        size_t width = string->encoding == STRING_UTF16LE ? 2 : 1;
+        size_t want = (size_t)string->length < TEXT_INDEX_TEXT_MAX * width ?
+                      (size_t)string->length : TEXT_INDEX_TEXT_MAX * width;
+        long n = image_read(image, string->offset, raw, want);
+        if (n < 0) status = -1;
+        if (status != 0) break;
+        int length = string_text(string, raw, (size_t)n, text, TEXT_INDEX_TEXT_MAX + 1);
+
+        IndexString record;
+        const TextIndexExtent* extent = text_index_find_extent(extents, extent_count, string->offset);
+        record.image_offset = (uint64_t)string->offset;
+        record.file_offset = extent ? extent->file_offset + (string->offset - extent->image_offset) : -1;
+        record.file_index = extent ? extent->file_index : -1;
+        record.text_start = header.text_size;
+        record.text_length = (uint32_t)length;
+        record.length = (uint32_t)string->length;
+        record.encoding = (uint32_t)string->encoding;
+        section_write(&records, &record, sizeof(record));
+        section_write(&texts, text, (size_t)length);
+        header.text_size += (uint64_t)length;
+
+        for (int j = 0; j + 3 <= length; j++) {
+            uint32_t key = trigram(text + j);
+            if (seen[key] == (uint32_t)i) continue;
+            seen[key] = (uint32_t)i;
+            counts[key]++;
+            header.posting_count++;
+        }
+        if (progress) __atomic_fetch_add(progress, 1LL, __ATOMIC_RELAXED);
+    }
+    section_flush(&records);
+    section_flush(&texts);
+    if (records.error || texts.error) status = -1;
+
+    header.directory_offset = (header.text_offset + header.text_size + 7) & ~(uint64_t)7;
+    header.postings_offset = header.directory_offset + (TRIGRAM_KEYS + 1) * sizeof(uint64_t);
+    header.file_size = header.postings_offset + header.posting_count * sizeof(uint32_t);
+
+    unsigned char* map = MAP_FAILED;
+    if (status == 0 && ftruncate(fd, (off_t)header.file_size) == 0) {
+        map = mmap(NULL, (size_t)header.file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED) status = -1;
+
+    // Pass two: postings written in place, in string order so each key's
+    // ids ascend
+    if (status == 0) {
+        uint64_t* directory = (uint64_t*)(map + header.directory_offset);
+        uint32_t* postings = (uint32_t*)(map + header.postings_offset);
+        const IndexString* records_map = (const IndexString*)(map + header.strings_offset);
+        const char* text_map = (const char*)(map + header.text_offset);
+
+        uint64_t position = 0;
+        for (uint32_t key = 0; key < TRIGRAM_KEYS; key++) {
+            directory[key] = position;
+            position += counts[key];
+            counts[key] = directory[key]; // Now the next free posting of the key
+        }
+        directory[TRIGRAM_KEYS] = position;
+        memset(seen, 0xFF, TRIGRAM_KEYS * sizeof(uint32_t));
+
+        for (size_t i = 0; i < strings->count; i++) {
+            if ((i & 1023) == 0 && cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+                status = -1;
+                break;
+            }
+            const char* chars = text_map + records_map[i].text_start;
+            int length = (int)records_map[i].text_length;
+            for (int j = 0; j + 3 <= length; j++) {
+                uint32_t key = trigram(chars + j);
+                if (seen[key] == (uint32_t)i) continue;
+                seen[key] = (uint32_t)i;
+                postings[counts[key]++] = (uint32_t)i;
+            }
+            if (progress) __atomic_fetch_add(progress, 1LL, __ATOMIC_RELAXED);
+        }
+        memcpy(map, &header, sizeof(header));
+        munmap(map, (size_t)header.file_size);
+    }
+
+    if (close(fd) != 0) status = -1;
+    free(texts.data);
+    free(records.data);
+    free(text);
+    free(raw);
+    free(seen);
+    free(counts);
+    // Replace an older index only once this one is complete
+    if (status == 0 && rename(temporary, path) != 0) status = -1;
+    if (status != 0) unlink(temporary);
+    return status;
+}
+
+TextIndex* text_index_open(const char* path, EvidenceImage* image) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(IndexHeader)) {
+        map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const IndexHeader* header = map;
+    uint64_t size = (uint64_t)info.st_size;
+    unsigned char hash[32];
+    int valid = header_valid(header, size) && header->image_size == (uint64_t)image_size(image) &&
+                image_fingerprint(image, hash) == 0 && memcmp(hash, header->image_hash, sizeof(hash)) == 0;
+    TextIndex* index = valid ? calloc(1, sizeof(TextIndex)) : NULL;
+    if (!index) {
+        munmap(map, (size_t)size);
+        return NULL;
+    }
+    index->map = map;
+    index->size = (size_t)size;
+    index->header = header;
+    index->strings = (const IndexString*)(index->map + header->strings_offset);
+    index->text = (const char*)(index->map + header->text_offset);
+    index->directory = (const uint64_t*)(index->map + header->directory_offset);
+    index->postings = (const uint32_t*)(index->map + header->postings_offset);
+    if (!contents_valid(index)) {
+        text_index_close(index);
+        return NULL;
+    }
+    return index;
+}
+
+void text_index_close(TextIndex* index) {
+    if (!index) return;
+    munmap(index->map, index->size);
+    free(index);
+}
+
+size_t text_index_string_count(const TextIndex* index) {
+    return (size_t)index->header->string_count;
+}
+
+size_t text_index_string_text(const TextIndex* index, unsigned int string, const char** text) {
+    const IndexString* record = &index->strings[string];
+    *text = index->text + record->text_start;
+    return record->text_length;
+}
+
+static int add_hit(TextHitList* hits, int keyword, unsigned int string, const IndexString* record,
+                   size_t position) {
+    if (hits->count == hits->capacity) {
+        size_t capacity = hits->capacity ? hits->capacity * 2 : 256;
+        TextHit* grown = realloc(hits->hits, capacity * sizeof(TextHit));
+        if (!grown) return -1;
+        hits->hits = grown;
+        hits->capacity = capacity;
+    }
+    long long delta = (long long)position * (record->encoding == STRING_UTF16LE ? 2 : 1);
+    TextHit* hit = &hits->hits[hits->count++];
+    hit->keyword = keyword;
+    hit->string = string;
+    hit->position = (unsigned int)position;
+    hit->image_offset = (long long)record->image_offset + delta;
+    hit->file_offset = record->file_offset >= 0 ? record->file_offset + delta : -1;
+    hit->file_index = record->file_index;
+    return 0;
+}
+
+// Every occurrence of a folded keyword in one string
+static int search_string(const TextIndex* index, unsigned int string, int keyword,
+                         const char* folded, size_t length, TextHitList* hits) {
+    const IndexString* record = &index->strings[string];
+    const char* text = index->text + record->text_start;
+    for (size_t i = 0; i + length <= record->text_length; i++) {
+        if (fold(text[i]) != folded[0]) continue;
+        size_t j = 1;
+        while (j < length && fold(text[i + j]) == folded[j]) j++;
+        if (j == length && add_hit(hits, keyword, string, record, i) != 0) return -1;
+    }
+    return 0;
+}
+
+int text_index_search(const TextIndex* index, const char* const* keywords, int keyword_count,
+                      TextHitList* hits) {
+    uint32_t strings = (uint32_t)index->header->string_count;
+    for (int k = 0; k < keyword_count; k++) {
+        size_t length = strlen(keywords[k]);
+        if (length == 0) continue;
+        char* folded = malloc(length);
+        if (!folded) return -1;
+        for (size_t i = 0; i < length; i++) folded[i] = fold(keywords[k][i]);
+
+        int status = 0;
+        if (length < 3) {
+            for (uint32_t s = 0; s < strings && status == 0; s++) {
+                status = search_string(index, s, k, folded, length, hits);
+            }
+            free(folded);
+            if (status != 0) return -1;
+            continue;
+        }
+
+        // The two rarest trigrams narrow the candidates the most
+        uint32_t rarest = 0, second = 0;
+        uint64_t rarest_count = UINT64_MAX, second_count = UINT64_MAX;
+        for (size_t i = 0; i + 3 <= length; i++) {
+            uint32_t key = trigram(folded + i);
+            uint64_t count = index->directory[key + 1] - index->directory[key];
+            if ((rarest_count != UINT64_MAX && key == rarest) ||
+                (second_count != UINT64_MAX && key == second)) continue;
+            if (count < rarest_count) {
+                second = rarest;
+                second_count = rarest_count;
+                rarest = key;
+                rarest_count = count;
+            } else if (count < second_count) {
+                second = key;
+                second_count = count;
+            }
+        }
+
+        const uint32_t* a = index->postings + index->directory[rarest];
+        const uint32_t* a_end = a + rarest_count;
+        if (second_count == UINT64_MAX) {
+            for (; a < a_end && status == 0; a++) {
+                if (*a < strings) status = search_string(index, *a, k, folded, length, hits);
+            }
+        } else {
+            const uint32_t* b = index->postings + index->directory[second];
+            const uint32_t* b_end = b + second_count;
+            while (a < a_end && b < b_end && status == 0) {
+                if (*a < *b) a++;
+                else if (*b < *a) b++;
+                else {
+                    if (*a < strings) status = search_string(index, *a, k, folded, length, hits);
+                    a++;
+                    b++;
+                }
+            }
+        }
+        free(folded);
+        if (status != 0) return -1;
+    }
+    return 0;
+}
+
+void text_hit_list_free(TextHitList* hits) {
+    free(hits->hits);
+    hits->hits = NULL;
+    hits->count = 0;
+    hits->capacity = 0;
+}
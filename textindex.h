@@ -0,0 +1,79 @@
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+
+#include <stddef.h>
+
+#include "filetable.h"
+#include "image.h"
+#include "strext.h"
+
+// Keyword index over extracted strings
+//
+// An on-disk trigram index of the image's strings, built once after a
+// strings pass and memory-mapped to answer queries. The file holds each
+// string's image offset with the file and file offset it falls in, the
+// string text, a dense table from every case-folded printable trigram to
+// its postings, and the postings: ascending string ids. A keyword looks
+// up its two rarest trigrams, intersects their postings and checks the
+// few candidates against the stored text, so no query rereads the image.
+// Keywords under three characters fall back to scanning the stored text.
+
+#define TEXT_INDEX_TEXT_MAX 65536 // Characters of a string that are indexed
+
+// Where a file's data lies in the image, for mapping strings to files
+typedef struct {
+    long long image_offset;
+    long long length;
+    long long file_offset;
+    int file_index;
+} TextIndexExtent;
+
+typedef struct {
+    int keyword;             // Index into the query's keyword list
+    unsigned int string;     // Id of the string it was found in
+    unsigned int position;   // Character of the string's text it starts at
+    long long image_offset;
+    long long file_offset;   // -1 outside every file
+    int file_index;          // -1 in unallocated space
+} TextHit;
+
+typedef struct {
+    TextHit* hits;
+    size_t count;
+    size_t capacity;
+} TextHitList;
+
+typedef struct TextIndex TextIndex;
+
+// Extents of every file with data runs, sorted by image offset. Meant
+// for the UI thread, so the build can run while the table changes.
+// Returns NULL when out of memory or no file has runs.
+TextIndexExtent* text_index_extents(const FileTable* table, int* count);
+
+// Extent holding an image offset, or NULL
+const TextIndexExtent* text_index_find_extent(const TextIndexExtent* extents, int count, long long offset);
+
+// Write the index of strings, sorted by offset, to path. Adds 1 to
+// *progress per string in each of the two passes and stops early once
+// *cancel is set; both may be NULL. Returns 0 on success.
+int text_index_build(const char* path, EvidenceImage* image, const StringList* strings,
+                     const TextIndexExtent* extents, int extent_count,
+                     long long* progress, const int* cancel);
+
+// Map an index; NULL when missing, damaged or built for another image.
+// The image is recognised by its size and a hash of the bytes at each end.
+TextIndex* text_index_open(const char* path, EvidenceImage* image);
+void text_index_close(TextIndex* index);
+
+size_t text_index_string_count(const TextIndex* index);
+
+// Text of a string as stored, not NUL-terminated; returns its length
+size_t text_index_string_text(const TextIndex* index, unsigned int string, const char** text);
+
+// Case-insensitive search for every keyword; each occurrence is one hit.
+// Returns 0, or -1 when out of memory.
+int text_index_search(const TextIndex* index, const char* const* keywords, int keyword_count,
+                      TextHitList* hits);
+void text_hit_list_free(TextHitList* hits);
+
+#endif
@@ -0,0 +1,597 @@
+#define _GNU_SOURCE
+#include "timeline.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TIMELINE_MAGIC "CHRNTML1"
+#define EVENTS_OFFSET 4096          // Events start a page into the file
+#define WRITE_EVENTS (1 << 16)      // Events per write while merging
+#define RADIX_BITS 11
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES 6              // Covers the 64-bit key
+#define SECONDS_PER_DAY 86400LL
+
+typedef struct {
+    char magic[8];
+    uint64_t event_count;
+    uint32_t run_count;
+    uint32_t event_size;
+    uint64_t runs[TIMELINE_MAX_RUNS]; // Events in each run, back to back from EVENTS_OFFSET
+    uint64_t pyramid_offset;          // Levels back to back; 0 when there is no pyramid
+    uint64_t levels[TIMELINE_LEVELS]; // Buckets in each level
+} TimelineHeader;
+
+struct Timeline {
+    char* path;
+    int fd;
+    TimelineHeader header;
+    unsigned char* map;
+    size_t map_size;
+    TimelineEvent* buffer;           // Events not yet in a run
+    size_t buffered;
+};
+
+static int write_all(int fd, const void* data, size_t length, off_t offset) {
+    const unsigned char* bytes = data;
+    while (length > 0) {
+        ssize_t n = pwrite(fd, bytes, length, offset);
+        if (n <= 0) return -1;
+        bytes += n;
+        length -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+// Map the whole file: the header, every run and the pyramid
+static int remap(Timeline* timeline) {
+    if (timeline->map) munmap(timeline->map, timeline->map_size);
+    timeline->map = NULL;
+    struct stat info;
+    if (fstat(timeline->fd, &info) != 0) return -1;
+    size_t size = (size_t)info.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, timeline->fd, 0);
+    if (map == MAP_FAILED) return -1;
+    timeline->map = map;
+    timeline->map_size = size;
+    return 0;
+}
+
+static const TimelineEvent* run_start(const Timeline* timeline, int run) {
+    const TimelineEvent* events = (const TimelineEvent*)(timeline->map + EVENTS_OFFSET);
+    for (int i = 0; i < run; i++) events += timeline->header.runs[i];
+    return events;
+}
+
+static Timeline* timeline_new(const char* path, int fd) {
+    Timeline* timeline = calloc(1, sizeof(Timeline));
+    char* copy = strdup(path);
+    if (!timeline || !copy) {
+        free(timeline);
+        free(copy);
+        close(fd);
+        return NULL;
+    }
+    timeline->path = copy;
+    timeline->fd = fd;
+    return timeline;
+}
+
+static int write_header(int fd, const TimelineHeader* header) {
+    unsigned char page[EVENTS_OFFSET];
+    memset(page, 0, sizeof(page));
+    memcpy(page, header, sizeof(*header));
+    return write_all(fd, page, sizeof(page), 0);
+}
+
+Timeline* timeline_create(const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+    Timeline* timeline = timeline_new(path, fd);
+    if (!timeline) return NULL;
+    memcpy(timeline->header.magic, TIMELINE_MAGIC, sizeof(timeline->header.magic));
+    timeline->header.event_size = sizeof(TimelineEvent);
+    if (write_header(fd, &timeline->header) != 0 || remap(timeline) != 0) {
+        timeline_close(timeline);
+        unlink(path);
+        return NULL;
+    }
+    return timeline;
+}
+
+Timeline* timeline_open(const char* path) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return NULL;
+    Timeline* timeline = timeline_new(path, fd);
+    if (!timeline) return NULL;
+
+    struct stat info;
+    TimelineHeader* header = &timeline->header;
+    int valid = fstat(fd, &info) == 0 && pread(fd, header, sizeof(*header), 0) == (ssize_t)sizeof(*header) &&
+                memcmp(header->magic, TIMELINE_MAGIC, sizeof(header->magic)) == 0 &&
+                header->event_size == sizeof(TimelineEvent) &&
+                header->run_count <= TIMELINE_MAX_RUNS &&
+                (uint64_t)info.st_size >= EVENTS_OFFSET + header->event_count * sizeof(TimelineEvent);
+    uint64_t total = 0;
+    for (uint32_t i = 0; valid && i < header->run_count; i++) total += header->runs[i];
+    if (valid && header->pyramid_offset != 0) {
+        uint64_t buckets = 0;
+        for (int level = 0; level < TIMELINE_LEVELS; level++) buckets += header->levels[level];
+        valid = header->pyramid_offset >= EVENTS_OFFSET + header->event_count * sizeof(TimelineEvent) &&
+                (uint64_t)info.st_size >= header->pyramid_offset + buckets * sizeof(TimelineBucket);
+    }
+    if (!valid || total != header->event_count || remap(timeline) != 0) {
+        timeline_close(timeline);
+        return NULL;
+    }
+    return timeline;
+}
+
+void timeline_close(Timeline* timeline) {
+    if (!timeline) return;
+    if (timeline->map) munmap(timeline->map, timeline->map_size);
+    close(timeline->fd);
+    free(timeline->buffer);
+    free(timeline->path);
+    free(timeline);
+}
+
+static inline uint64_t sort_key(const TimelineEvent* event) {
+    return (uint64_t)event->time ^ (1ULL << 63); // Signed order as unsigned
+}
+
+// Stable LSD radix sort by time; passes whose digit is the same for every
+// event, as the high digits of a few years' times are, are skipped
+static int sort_events(TimelineEvent* events, size_t count) {
+    if (count < 2) return 0;
+    TimelineEvent* scratch = malloc(count * sizeof(TimelineEvent));
+    size_t (*counts)[RADIX_BUCKETS] = calloc(RADIX_PASSES, sizeof(*counts));
+    if (!scratch || !counts) {
+        free(scratch);
+        free(counts);
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = sort_key(&events[i]);
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    TimelineEvent* from = events;
+    TimelineEvent* to = scratch;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int shift = pass * RADIX_BITS;
+        if (counts[pass][(sort_key(&events[0]) >> shift) & (RADIX_BUCKETS - 1)] == count) continue;
+        size_t position = 0;
+        for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+            size_t n = counts[pass][bucket];
+            counts[pass][bucket] = position;
+            position += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            to[counts[pass][(sort_key(&from[i]) >> shift) & (RADIX_BUCKETS - 1)]++] = from[i];
+        }
+        TimelineEvent* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != events) memcpy(events, from, count * sizeof(TimelineEvent));
+    free(scratch);
+    free(counts);
+    return 0;
+}
+
+int timeline_add(Timeline* timeline, const TimelineEvent* event) {
+    if (!timeline->buffer) {
+        timeline->buffer = malloc(TIMELINE_RUN_EVENTS * sizeof(TimelineEvent));
+        if (!timeline->buffer) return -1;
+    }
+    timeline->buffer[timeline->buffered++] = *event;
+    return timeline->buffered == TIMELINE_RUN_EVENTS ? timeline_flush(timeline) : 0;
+}
+
+int timeline_add_macb(Timeline* timeline, TimelineSource kind, unsigned int source,
+                      time_t modified, time_t accessed, time_t changed, time_t born) {
+    const time_t times[4] = {modified, accessed, changed, born};
+    unsigned int done = 0;
+    for (int i = 0; i < 4; i++) {
+        if (times[i] == 0 || (done & (1u << i))) continue;
+        TimelineEvent event = {(long long)times[i], source, 0, (unsigned short)kind};
+        for (int j = i; j < 4; j++) {
+            if (times[j] == times[i]) event.macb |= (unsigned short)(1u << j);
+        }
+        done |= event.macb;
+        if (timeline_add(timeline, &event) != 0) return -1;
+    }
+    return 0;
+}
+
+static int merge_runs(Timeline* timeline, long long* progress, const int* cancel);
+
+int timeline_flush(Timeline* timeline) {
+    if (timeline->buffered == 0) return 0;
+    if (timeline->header.run_count == TIMELINE_MAX_RUNS && merge_runs(timeline, NULL, NULL) != 0) return -1;
+    if (sort_events(timeline->buffer, timeline->buffered) != 0) return -1;
+
+    // The new run overwrites the pyramid, so it goes before the events do
+    if (timeline->header.pyramid_offset != 0) {
+        TimelineHeader header = timeline->header;
+        header.pyramid_offset = 0;
+        memset(header.levels, 0, sizeof(header.levels));
+        if (write_header(timeline->fd, &header) != 0) return -1;
+        timeline->header = header;
+    }
+
+    // Events first, then the header that makes them part of the store
+    off_t offset = EVENTS_OFFSET + (off_t)(timeline->header.event_count * sizeof(TimelineEvent));
+    if (write_all(timeline->fd, timeline->buffer, timeline->buffered * sizeof(TimelineEvent), offset) != 0) {
+        return -1;
+    }
+    TimelineHeader header = timeline->header;
+    header.runs[header.run_count++] = timeline->buffered;
+    header.event_count += timeline->buffered;
+    if (write_header(timeline->fd, &header) != 0) return -1;
+    timeline->header = header;
+    timeline->buffered = 0;
+    return remap(timeline);
+}
+
+// Min-heap of run heads, ties broken by run so equal times keep the
+// order they were added in
+typedef struct {
+    const TimelineEvent* next;
+    const TimelineEvent* end;
+    int run;
+} RunHead;
+
+static inline int head_before(const RunHead* a, const RunHead* b) {
+    return a->next->time < b->next->time || (a->next->time == b->next->time && a->run < b->run);
+}
+
+static void heap_down(RunHead* heap, int count, int i) {
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = left + 1;
+        if (left < count && head_before(&heap[left], &heap[smallest])) smallest = left;
+        if (right < count && head_before(&heap[right], &heap[smallest])) smallest = right;
+        if (smallest == i) return;
+        RunHead swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+// Write every run merged into one to a new file and switch to it
+static int merge_runs(Timeline* timeline, long long* progress, const int* cancel) {
+    if (timeline->header.run_count <= 1) {
+        if (progress) __atomic_add_fetch(progress, (long long)timeline->header.event_count, __ATOMIC_RELAXED);
+        return 0;
+    }
+    char temporary[4096];
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", timeline->path) >= (int)sizeof(temporary)) return -1;
+    int fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    TimelineEvent* out = malloc(WRITE_EVENTS * sizeof(TimelineEvent));
+    if (!out) {
+        close(fd);
+        unlink(temporary);
+        return -1;
+    }
+
+    RunHead heap[TIMELINE_MAX_RUNS];
+    int heads = 0;
+    const TimelineEvent* events = run_start(timeline, 0);
+    for (uint32_t run = 0; run < timeline->header.run_count; run++) {
+        size_t count = (size_t)timeline->header.runs[run];
+        if (count > 0) heap[heads++] = (RunHead){events, events + count, (int)run};
+        events += count;
+    }
+    for (int i = heads / 2 - 1; i >= 0; i--) heap_down(heap, heads, i);
+    madvise(timeline->map, timeline->map_size, MADV_SEQUENTIAL);
+
+    int status = 0;
+    size_t used = 0;
+    off_t offset = EVENTS_OFFSET;
+    while (heads > 0 && status == 0) {
+        out[used++] = *heap[0].next++;
+        if (heap[0].next == heap[0].end) heap[0] = heap[--heads];
+        heap_down(heap, heads, 0);
+        if (used == WRITE_EVENTS || heads == 0) {
+            if (cancel && __atomic_load_n(cancel, __ATOMIC_RELAXED)) status = -1;
+            if (status == 0) status = write_all(fd, out, used * sizeof(TimelineEvent), offset);
+            if (progress) __atomic_add_fetch(progress, (long long)used, __ATOMIC_RELAXED);
+            offset += (off_t)(used * sizeof(TimelineEvent));
+            used = 0;
+        }
+    }
+    free(out);
+
+    TimelineHeader header = timeline->header;
+    memset(header.runs, 0, sizeof(header.runs));
+    header.pyramid_offset = 0;
+    memset(header.levels, 0, sizeof(header.levels));
+    header.run_count = 1;
+    header.runs[0] = header.event_count;
+    if (status == 0) status = write_header(fd, &header);
+    // Replace the store only once the merged one is complete
+    if (status == 0 && rename(temporary, timeline->path) != 0) status = -1;
+    if (status != 0) {
+        close(fd);
+        unlink(temporary);
+        return -1;
+    }
+    close(timeline->fd);
+    timeline->fd = fd;
+    timeline->header = header;
+    return remap(timeline);
+}
+
+static inline long long floor_divide(long long a, long long b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// Days since 1970-01-01 of January 1 of a proleptic Gregorian year
+static long long year_start_day(long long year) {
+    long long y = year - 1;  // March-based years, as in days_from_civil
+    long long era = floor_divide(y, 400);
+    long long year_of_era = y - era * 400;
+    long long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + 306;
+    return era * 146097 + day_of_era - 719468;
+}
+
+static long long year_of_day(long long day) {
+    long long z = day + 719468;
+    long long era = floor_divide(z, 146097);
+    long long day_of_era = z - era * 146097;
+    long long year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    long long day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    return year_of_era + era * 400 + (day_of_year >= 306);  // Past February is the next civil year
+}
+
+void timeline_bucket_bounds(TimelineLevel level, long long time, long long* start, long long* end) {
+    static const long long widths[TIMELINE_LEVELS] = {0, SECONDS_PER_DAY, 3600, 60, 1};
+    if (level == TIMELINE_LEVEL_YEAR) {
+        long long year = year_of_day(floor_divide(time, SECONDS_PER_DAY));
+        *start = year_start_day(year) * SECONDS_PER_DAY;
+        *end = year_start_day(year + 1) * SECONDS_PER_DAY;
+        return;
+    }
+    *start = floor_divide(time, widths[level]) * widths[level];
+    *end = *start + widths[level];
+}
+
+typedef struct {
+    long long end;               // End of the open bucket
+    TimelineBucket bucket;
+    TimelineBucket* out;
+    size_t used;
+    off_t offset;
+} LevelWriter;
+
+// Add the open bucket to the buffer, writing the buffer out once full
+// or when done
+static int close_bucket(int fd, LevelWriter* writer, int done) {
+    if (writer->bucket.count > 0) writer->out[writer->used++] = writer->bucket;
+    writer->bucket.count = 0;
+    if (writer->used < WRITE_EVENTS && !(done && writer->used > 0)) return 0;
+    int status = write_all(fd, writer->out, writer->used * sizeof(TimelineBucket), writer->offset);
+    writer->offset += (off_t)(writer->used * sizeof(TimelineBucket));
+    writer->used = 0;
+    return status;
+}
+
+// Count the single run into every level, each written through its own
+// buffer at the place a first counting pass leaves for it
+static int write_pyramid(Timeline* timeline) {
+    size_t count = (size_t)timeline->header.event_count;
+    if (count == 0 || timeline->header.run_count != 1 || timeline->header.pyramid_offset != 0) return 0;
+    const TimelineEvent* events = run_start(timeline, 0);
+
+    TimelineHeader header = timeline->header;
+    long long start, ends[TIMELINE_LEVELS];
+    for (int level = 0; level < TIMELINE_LEVELS; level++) ends[level] = events[0].time;
+    for (size_t i = 0; i < count; i++) {
+        // An event in the open second is in the open bucket of every level
+        if (events[i].time < ends[TIMELINE_LEVEL_SECOND]) continue;
+        for (int level = TIMELINE_LEVEL_SECOND; level >= 0 && events[i].time >= ends[level]; level--) {
+            timeline_bucket_bounds((TimelineLevel)level, events[i].time, &start, &ends[level]);
+            header.levels[level]++;
+        }
+    }
+    header.pyramid_offset = EVENTS_OFFSET + header.event_count * sizeof(TimelineEvent);
+
+    LevelWriter writers[TIMELINE_LEVELS];
+    memset(writers, 0, sizeof(writers));
+    off_t offset = (off_t)header.pyramid_offset;
+    int status = 0;
+    for (int level = 0; level < TIMELINE_LEVELS; level++) {
+        writers[level].end = events[0].time;
+        writers[level].offset = offset;
+        writers[level].out = malloc(WRITE_EVENTS * sizeof(TimelineBucket));
+        if (!writers[level].out) status = -1;
+        offset += (off_t)(header.levels[level] * sizeof(TimelineBucket));
+    }
+    for (size_t i = 0; i < count && status == 0;) {
+        // Events of one second share a bucket in every level
+        long long time = events[i].time;
+        size_t same = 1;
+        while (i + same < count && events[i + same].time == time) same++;
+        i += same;
+        for (int level = TIMELINE_LEVEL_SECOND; level >= 0 && time >= writers[level].end && status == 0; level--) {
+            status = close_bucket(timeline->fd, &writers[level], 0);
+            timeline_bucket_bounds((TimelineLevel)level, time, &writers[level].bucket.start, &writers[level].end);
+        }
+        for (int level = 0; level < TIMELINE_LEVELS; level++) writers[level].bucket.count += same;
+    }
+    for (int level = 0; level < TIMELINE_LEVELS && status == 0; level++) {
+        status = close_bucket(timeline->fd, &writers[level], 1);
+    }
+    for (int level = 0; level < TIMELINE_LEVELS; level++) free(writers[level].out);
+    if (status == 0) status = write_header(timeline->fd, &header);
+    if (status != 0) return -1;
+    timeline->header = header;
+    return remap(timeline);
+}
+
+int timeline_merge(Timeline* timeline, long long* progress, const int* cancel) {
+    if (timeline_flush(timeline) != 0) return -1;
+    if (merge_runs(timeline, progress, cancel) != 0) return -1;
+    return write_pyramid(timeline);
+}
+
+size_t timeline_count(const Timeline* timeline) {
+    return (size_t)timeline->header.event_count;
+}
+
+int timeline_run_count(const Timeline* timeline) {
+    return (int)timeline->header.run_count;
+}
+
+const TimelineEvent* timeline_run(const Timeline* timeline, int run, size_t* count) {
+    if (run < 0 || run >= (int)timeline->header.run_count) {
+        *count = 0;
+        return NULL;
+    }
+    *count = (size_t)timeline->header.runs[run];
+    return run_start(timeline, run);
+}
+
+static size_t lower_bound(const TimelineEvent* events, size_t count, long long time) {
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (events[middle].time < time) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+size_t timeline_find(const Timeline* timeline, int run, long long time) {
+    size_t count;
+    const TimelineEvent* events = timeline_run(timeline, run, &count);
+    return events ? lower_bound(events, count, time) : 0;
+}
+
+int timeline_bounds(const Timeline* timeline, long long* first, long long* last) {
+    int found = 0;
+    const TimelineEvent* events = run_start(timeline, 0);
+    for (uint32_t run = 0; run < timeline->header.run_count; run++) {
+        size_t count = (size_t)timeline->header.runs[run];
+        if (count > 0) {
+            if (!found || events[0].time < *first) *first = events[0].time;
+            if (!found || events[count - 1].time > *last) *last = events[count - 1].time;
+            found = 1;
+        }
+        events += count;
+    }
+    return found ? 0 : -1;
+}
+
+size_t timeline_range_count(const Timeline* timeline, long long from, long long to) {
+    size_t total = 0;
+    const TimelineEvent* events = run_start(timeline, 0);
+    for (uint32_t run = 0; run < timeline->header.run_count && from < to; run++) {
+        size_t count = (size_t)timeline->header.runs[run];
+        total += lower_bound(events, count, to) - lower_bound(events, count, from);
+        events += count;
+    }
+    return total;
+}
+
+void timeline_query(const Timeline* timeline, long long from, long long to, TimelineCursor* cursor) {
+    cursor->run_count = 0;
+    const TimelineEvent* events = run_start(timeline, 0);
+    for (uint32_t run = 0; run < timeline->header.run_count && from < to; run++) {
+        size_t count = (size_t)timeline->header.runs[run];
+        size_t first = lower_bound(events, count, from);
+        size_t end = lower_bound(events, count, to);
+        if (first < end) {
+            cursor->next[cursor->run_count] = events + first;
+            cursor->end[cursor->run_count] = events + end;
+            cursor->run_count++;
+        }
+        events += count;
+    }
+}
+
+// Runs are few and queries short, so the earliest head is found by a scan
+const TimelineEvent* timeline_next(TimelineCursor* cursor) {
+    if (cursor->run_count == 0) return NULL;
+    int best = 0;
+    for (int i = 1; i < cursor->run_count; i++) {
+        if (cursor->next[i]->time < cursor->next[best]->time) best = i;
+    }
+    const TimelineEvent* event = cursor->next[best]++;
+    if (cursor->next[best] == cursor->end[best]) {
+        // Drop the exhausted run, keeping the others in run order
+        cursor->run_count--;
+        memmove(&cursor->next[best], &cursor->next[best + 1], (size_t)(cursor->run_count - best) * sizeof(cursor->next[0]));
+        memmove(&cursor->end[best], &cursor->end[best + 1], (size_t)(cursor->run_count - best) * sizeof(cursor->end[0]));
+    }
+    return event;
+}
+
+const TimelineBucket* timeline_level(const Timeline* timeline, TimelineLevel level, size_t* count) {
+    if (timeline->header.pyramid_offset == 0 || level < 0 || level >= TIMELINE_LEVELS) {
+        *count = 0;
+        return NULL;
+    }
+    const TimelineBucket* buckets = (const TimelineBucket*)(timeline->map + timeline->header.pyramid_offset);
+    for (int i = 0; i < (int)level; i++) buckets += timeline->header.levels[i];
+    *count = (size_t)timeline->header.levels[level];
+    return buckets;
+}
+
+TimelineLevel timeline_level_for(long long from, long long to, int columns) {
+    static const double widths[TIMELINE_LEVELS] = {366.0 * SECONDS_PER_DAY, SECONDS_PER_DAY, 3600, 60, 1};
+    double column = columns > 0 ? (double)(to - from) / columns : 0;
+    int level = 0;
+    while (level < TIMELINE_LEVEL_SECOND && widths[level] > column) level++;
+    return (TimelineLevel)level;
+}
+
+int timeline_histogram(const Timeline* timeline, long long from, long long to, int columns,
+                       unsigned long long* counts) {
+    if (columns <= 0) return -1;
+    memset(counts, 0, (size_t)columns * sizeof(*counts));
+    TimelineLevel level = timeline_level_for(from, to, columns);
+    size_t count;
+    const TimelineBucket* buckets = timeline_level(timeline, level, &count);
+    if (!buckets) return -1;
+    if (from >= to) return (int)level;
+
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (buckets[middle].start < from) low = middle + 1;
+        else high = middle;
+    }
+    // A bucket straddling from counts in the first column
+    if (low > 0) {
+        long long start, end;
+        timeline_bucket_bounds(level, buckets[low - 1].start, &start, &end);
+        if (end > from) low--;
+    }
+    double scale = (double)columns / (double)(to - from);
+    for (size_t i = low; i < count && buckets[i].start < to; i++) {
+        long long column = buckets[i].start > from ? (long long)((double)(buckets[i].start - from) * scale) : 0;
+        counts[column < columns ? column : columns - 1] += buckets[i].count;
+    }
+    return (int)level;
+}
+
+void timeline_format_macb(unsigned int macb, char out[5]) {
+    out[0] = macb & TIMELINE_MODIFIED ? 'M' : '.';
+    out[1] = macb & TIMELINE_ACCESSED ? 'A' : '.';
+    out[2] = macb & TIMELINE_CHANGED ? 'C' : '.';
+    out[3] = macb & TIMELINE_BORN ? 'B' : '.';
+    out[4] = '\0';
+}
@@ -0,0 +1,136 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stddef.h>
+#include <time.h>
+
+// Super-timeline store
+//
+// Every timestamp the tool knows about becomes an event: the MACB times
+// of each file (modified, accessed, metadata changed, born) and, later,
+// times found in other artifacts. Times of one source that are equal
+// form a single event with several MACB bits, as mactime prints them.
+// Events are 16 bytes and live in one file as a list of runs, each
+// sorted by time. Added events collect in a buffer that is radix sorted
+// and appended as a new run; merging combines the runs k-way through a
+// heap over their heads, so a store of any size is sorted with
+// sequential reads and writes. The file is memory-mapped and a range
+// query is a binary search per run: its cost depends on neither the
+// number of events stored nor the number returned.
+//
+// Merging also writes a pyramid of event counts after the events: per
+// calendar year, day, hour, minute and second, only buckets holding
+// events, each level sorted by time. A histogram of any window reads the
+// one level whose buckets are just narrower than a column, so drawing
+// costs about the same at every zoom.
+
+#define TIMELINE_MAX_RUNS 64           // Adding past this merges the runs first
+#define TIMELINE_RUN_EVENTS (1 << 20)  // Events buffered per run
+
+typedef enum {
+    TIMELINE_MODIFIED = 1 << 0,
+    TIMELINE_ACCESSED = 1 << 1,
+    TIMELINE_CHANGED = 1 << 2,  // Metadata change (NTFS MFT entry, ext4 inode)
+    TIMELINE_BORN = 1 << 3
+} TimelineMacb;
+
+// What an event's source refers to
+typedef enum {
+    TIMELINE_SOURCE_FILE   // File table entry
+} TimelineSource;
+
+typedef enum {
+    TIMELINE_LEVEL_YEAR,
+    TIMELINE_LEVEL_DAY,
+    TIMELINE_LEVEL_HOUR,
+    TIMELINE_LEVEL_MINUTE,
+    TIMELINE_LEVEL_SECOND,
+    TIMELINE_LEVELS
+} TimelineLevel;
+
+typedef struct {
+    long long start;         // First second of the bucket, UTC
+    unsigned long long count;
+} TimelineBucket;
+
+typedef struct {
+    long long time;          // Seconds since the epoch, UTC
+    unsigned int source;     // Entry of the source's kind
+    unsigned short macb;     // TimelineMacb bits
+    unsigned short kind;     // TimelineSource
+} TimelineEvent;
+
+typedef struct Timeline Timeline;
+
+// Events of a query, in time order across every run
+typedef struct {
+    const TimelineEvent* next[TIMELINE_MAX_RUNS];
+    const TimelineEvent* end[TIMELINE_MAX_RUNS];
+    int run_count;
+} TimelineCursor;
+
+// Start an empty store at path, replacing any file there; NULL on error
+Timeline* timeline_create(const char* path);
+
+// Map an existing store; NULL when missing or damaged
+Timeline* timeline_open(const char* path);
+void timeline_close(Timeline* timeline);
+
+// Buffer an event; a full buffer is written out as a run. Returns 0, or
+// -1 when the store could not be written.
+int timeline_add(Timeline* timeline, const TimelineEvent* event);
+
+// One event per distinct nonzero time of a source
+int timeline_add_macb(Timeline* timeline, TimelineSource kind, unsigned int source,
+                      time_t modified, time_t accessed, time_t changed, time_t born);
+
+// Write the buffered events as a run
+int timeline_flush(Timeline* timeline);
+
+// Flush, then merge every run into one and count it into the pyramid.
+// Adds 1 to *progress per event written and stops early once *cancel is
+// set, leaving the runs as they were; both may be NULL. Returns 0 on
+// success.
+int timeline_merge(Timeline* timeline, long long* progress, const int* cancel);
+
+// Events written out, not counting the buffer
+size_t timeline_count(const Timeline* timeline);
+int timeline_run_count(const Timeline* timeline);
+
+// Events of one run, sorted by time
+const TimelineEvent* timeline_run(const Timeline* timeline, int run, size_t* count);
+
+// First event of a run at or after time
+size_t timeline_find(const Timeline* timeline, int run, long long time);
+
+// Earliest and latest time stored; -1 when there are no events
+int timeline_bounds(const Timeline* timeline, long long* first, long long* last);
+
+// Events in [from, to)
+size_t timeline_range_count(const Timeline* timeline, long long from, long long to);
+
+// Walk the events in [from, to) with timeline_next, which returns NULL
+// after the last. The cursor reads the mapping: adding events ends it.
+void timeline_query(const Timeline* timeline, long long from, long long to, TimelineCursor* cursor);
+const TimelineEvent* timeline_next(TimelineCursor* cursor);
+
+// Buckets of a level holding events, by start; NULL until the store is
+// merged, and again once events are added
+const TimelineBucket* timeline_level(const Timeline* timeline, TimelineLevel level, size_t* count);
+
+// Start of the bucket holding time, and of the next one
+void timeline_bucket_bounds(TimelineLevel level, long long time, long long* start, long long* end);
+
+// Coarsest level whose buckets are no wider than a column of [from, to)
+TimelineLevel timeline_level_for(long long from, long long to, int columns);
+
+// Event counts of [from, to) in columns of equal width, from the level
+// timeline_level_for picks; a bucket counts in the column it starts in.
+// Returns the level read, or -1 when the store has no pyramid.
+int timeline_histogram(const Timeline* timeline, long long from, long long to, int columns,
+                       unsigned long long* counts);
+
+// "MACB" with a dot for each time the event does not stand for
+void timeline_format_macb(unsigned int macb, char out[5]);
+
+#endif
@@ -0,0 +1,306 @@
+#define _GNU_SOURCE
+#include "verify.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define VERIFY_LINEAR_COUNT 2 // MD5 thread and SHA-1 thread
+
+static const int linear_algorithms[VERIFY_LINEAR_COUNT] = {HASH_MD5, HASH_SHA1};
+
+typedef struct {
+    struct ImageVerify* verify;
+    int index;
+} LinearArgs;
+
+struct ImageVerify {
+    char* path;
+    long long size;
+    long long segment_count;
+    int worker_count;
+    pthread_t* workers;
+    pthread_t linear_threads[VERIFY_LINEAR_COUNT];
+    LinearArgs linear_args[VERIFY_LINEAR_COUNT];
+    struct timespec started;
+
+    // Ring of segment buffers between the workers and the linear threads.
+    // A slot holds segment n at index n % slot_count until every linear
+    // thread has consumed it.
+    pthread_mutex_t lock;
+    pthread_cond_t slot_ready;
+    pthread_cond_t slot_free;
+    int slot_count;
+    unsigned char** buffers;
+    long long* slot_segment; // -1 when free
+    int* slot_filled;
+    int* slot_pending;       // Linear threads yet to consume the slot
+    long long next_segment;
+
+    unsigned char (*segment_digests)[32];
+    HashDigests linear[VERIFY_LINEAR_COUNT];
+    long long consumed[VERIFY_LINEAR_COUNT];
+
+    int running;   // Threads still alive
+    int stop;      // Cancelled or failed
+    double seconds;
+
+    int stored_mask;
+    unsigned char stored_md5[16];
+    unsigned char stored_sha1[20];
+};
+
+static size_t segment_length(const ImageVerify* verify, long long segment) {
+    long long remaining = verify->size - segment * VERIFY_SEGMENT_SIZE;
+    return (size_t)(remaining < VERIFY_SEGMENT_SIZE ? remaining : VERIFY_SEGMENT_SIZE);
+}
+
+static void verify_fail(ImageVerify* verify) {
+    pthread_mutex_lock(&verify->lock);
+    verify->stop = 1;
+    pthread_cond_broadcast(&verify->slot_ready);
+    pthread_cond_broadcast(&verify->slot_free);
+    pthread_mutex_unlock(&verify->lock);
+}
+
+static void thread_exit(ImageVerify* verify) {
+    if (__atomic_sub_fetch(&verify->running, 1, __ATOMIC_ACQ_REL) != 0) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    verify->seconds = (double)(now.tv_sec - verify->started.tv_sec) +
+                      (double)(now.tv_nsec - verify->started.tv_nsec) / 1e9;
+}
+
+// Claim segments in order, read them into the ring and hash each one
+static void* worker_main(void* arg) {
+    ImageVerify* verify = arg;
+    EvidenceImage* image = image_open(verify->path);
+    if (!image || image_size(image) != verify->size) {
+        image_close(image);
+        verify_fail(verify);
+        thread_exit(verify);
+        return NULL;
+    }
+    image_advise(image, 0, verify->size, IMAGE_ACCESS_SEQUENTIAL);
+
+    for (;;) {
+        pthread_mutex_lock(&verify->lock);
+        if (verify->stop || verify->next_segment >= verify->segment_count) {
+            pthread_mutex_unlock(&verify->lock);
+            break;
+        }
+        long long segment = verify->next_segment++;
+        int slot = (int)(segment % verify->slot_count);
+        while (verify->slot_segment[slot] != -1 && !verify->stop) {
+            pthread_cond_wait(&verify->slot_free, &verify->lock);
+        }
+        if (verify->stop) {
+            pthread_mutex_unlock(&verify->lock);
+            break;
+        }
+        verify->slot_segment[slot] = segment;
+        verify->slot_filled[slot] = 0;
+        pthread_mutex_unlock(&verify->lock);
+
+        size_t length = segment_length(verify, segment);
+        long long offset = segment * VERIFY_SEGMENT_SIZE;
+        if (image_read(image, offset, verify->buffers[slot], length) != (long)length) {
+            verify_fail(verify);
+            break;
+        }
+        image_advise(image, offset, (long long)length, IMAGE_ACCESS_DONTNEED);
+
+        HashContext context;
+        HashDigests digests;
+        hash_init(&context, HASH_SHA256);
+        hash_update(&context, verify->buffers[slot], length);
+        hash_final(&context, &digests);
+        memcpy(verify->segment_digests[segment], digests.sha256, 32);
+
+        pthread_mutex_lock(&verify->lock);
+        verify->slot_filled[slot] = 1;
+        verify->slot_pending[slot] = VERIFY_LINEAR_COUNT;
+        pthread_cond_broadcast(&verify->slot_ready);
+        pthread_mutex_unlock(&verify->lock);
+    }
+
+    image_close(image);
+    thread_exit(verify);
+    return NULL;
+}
+
+// Feed the segments to one streaming digest in media order
+static void* linear_main(void* arg) {
+    const LinearArgs* args = arg;
+    ImageVerify* verify = args->verify;
+
+    HashContext context;
+    hash_init(&context, linear_algorithms[args->index]);
+
+    for (long long segment = 0; segment < verify->segment_count; segment++) {
+        int slot = (int)(segment % verify->slot_count);
+
+        pthread_mutex_lock(&verify->lock);
+        while (!(verify->slot_segment[slot] == segment && verify->slot_filled[slot]) &&
+               !verify->stop) {
+            pthread_cond_wait(&verify->slot_ready, &verify->lock);
+        }
+        int stop = verify->stop;
+        pthread_mutex_unlock(&verify->lock);
+        if (stop) break;
+
+        // The slot cannot be reused until this thread releases it
+        size_t length = segment_length(verify, segment);
+        hash_update(&context, verify->buffers[slot], length);
+
+        pthread_mutex_lock(&verify->lock);
+        if (--verify->slot_pending[slot] == 0) {
+            verify->slot_segment[slot] = -1;
+            verify->slot_filled[slot] = 0;
+            pthread_cond_broadcast(&verify->slot_free);
+        }
+        pthread_mutex_unlock(&verify->lock);
+
+        __atomic_store_n(&verify->consumed[args->index],
+                         segment * VERIFY_SEGMENT_SIZE + (long long)length, __ATOMIC_RELEASE);
+    }
+
+    hash_final(&context, &verify->linear[args->index]);
+    thread_exit(verify);
+    return NULL;
+}
+
+static void verify_free(ImageVerify* verify) {
+    if (verify->buffers) {
+        for (int i = 0; i < verify->slot_count; i++) free(verify->buffers[i]);
+    }
+    free(verify->buffers);
+    free(verify->slot_segment);
+    free(verify->slot_filled);
+    free(verify->slot_pending);
+    free(verify->segment_digests);
+    free(verify->workers);
+    free(verify->path);
+    pthread_mutex_destroy(&verify->lock);
+    pthread_cond_destroy(&verify->slot_ready);
+    pthread_cond_destroy(&verify->slot_free);
+    free(verify);
+}
+
+ImageVerify* verify_start(const char* path, int threads) {
+    EvidenceImage* image = image_open(path);
+    if (!image) return NULL;
+
+    ImageVerify* verify = calloc(1, sizeof(ImageVerify));
+    if (!verify) {
+        image_close(image);
+        return NULL;
+    }
+    pthread_mutex_init(&verify->lock, NULL);
+    pthread_cond_init(&verify->slot_ready, NULL);
+    pthread_cond_init(&verify->slot_free, NULL);
+
+    verify->size = image_size(image);
+    verify->stored_mask = image_stored_hashes(image, verify->stored_md5, verify->stored_sha1);
+    image_close(image);
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    verify->segment_count = (verify->size + VERIFY_SEGMENT_SIZE - 1) / VERIFY_SEGMENT_SIZE;
+    if (threads > verify->segment_count) threads = (int)verify->segment_count;
+    verify->worker_count = threads;
+
+    // Two slots per worker lets readers run ahead of the linear digests
+    verify->slot_count = threads * 2;
+    verify->path = strdup(path);
+    verify->workers = calloc((size_t)threads, sizeof(pthread_t));
+    verify->buffers = calloc((size_t)verify->slot_count, sizeof(unsigned char*));
+    verify->slot_segment = malloc((size_t)verify->slot_count * sizeof(long long));
+    verify->slot_filled = calloc((size_t)verify->slot_count, sizeof(int));
+    verify->slot_pending = calloc((size_t)verify->slot_count, sizeof(int));
+    verify->segment_digests = malloc((size_t)verify->segment_count * 32);
+    if (!verify->path || !verify->workers || !verify->buffers || !verify->slot_segment ||
+        !verify->slot_filled || !verify->slot_pending || !verify->segment_digests) {
+        verify_free(verify);
+        return NULL;
+    }
+    for (int i = 0; i < verify->slot_count; i++) {
+        verify->slot_segment[i] = -1;
+        verify->buffers[i] = malloc(VERIFY_SEGMENT_SIZE);
+        if (!verify->buffers[i]) {
+            verify_free(verify);
+            return NULL;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &verify->started);
+    verify->running = threads + VERIFY_LINEAR_COUNT;
+    for (int i = 0; i < VERIFY_LINEAR_COUNT; i++) {
+        verify->linear_args[i].verify = verify;
+        verify->linear_args[i].index = i;
+        pthread_create(&verify->linear_threads[i], NULL, linear_main, &verify->linear_args[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&verify->workers[i], NULL, worker_main, verify);
+    }
+    return verify;
+}
+
+double verify_progress(const ImageVerify* verify) {
+    long long done = verify->size;
+    for (int i = 0; i < VERIFY_LINEAR_COUNT; i++) {
+        long long consumed = __atomic_load_n(&verify->consumed[i], __ATOMIC_ACQUIRE);
+        if (consumed < done) done = consumed;
+    }
+    return verify->size > 0 ? (double)done / (double)verify->size : 1.0;
+}
+
+int verify_done(const ImageVerify* verify) {
+    return __atomic_load_n(&verify->running, __ATOMIC_ACQUIRE) == 0;
+}
+
+void verify_cancel(ImageVerify* verify) {
+    pthread_mutex_lock(&verify->lock);
+    verify->stop = 1;
+    pthread_cond_broadcast(&verify->slot_ready);
+    pthread_cond_broadcast(&verify->slot_free);
+    pthread_mutex_unlock(&verify->lock);
+}
+
+int verify_finish(ImageVerify* verify, VerifyResult* result) {
+    for (int i = 0; i < verify->worker_count; i++) pthread_join(verify->workers[i], NULL);
+    for (int i = 0; i < VERIFY_LINEAR_COUNT; i++) pthread_join(verify->linear_threads[i], NULL);
+
+    int status = verify->stop ? -1 : 0;
+    if (status == 0 && result) {
+        memset(result, 0, sizeof(VerifyResult));
+        memcpy(result->linear.md5, verify->linear[0].md5, 16);
+        memcpy(result->linear.sha1, verify->linear[1].sha1, 20);
+        result->linear.valid = HASH_MD5 | HASH_SHA1;
+
+        HashContext context;
+        HashDigests tree;
+        hash_init(&context, HASH_SHA256);
+        hash_update(&context, verify->segment_digests, (size_t)verify->segment_count * 32);
+        hash_final(&context, &tree);
+        memcpy(result->tree_sha256, tree.sha256, 32);
+
+        result->media_size = verify->size;
+        result->segment_count = verify->segment_count;
+        result->stored_mask = verify->stored_mask;
+        memcpy(result->stored_md5, verify->stored_md5, 16);
+        memcpy(result->stored_sha1, verify->stored_sha1, 20);
+        result->md5_match = verify->stored_mask & 1 ?
+            memcmp(result->stored_md5, result->linear.md5, 16) == 0 : -1;
+        result->sha1_match = verify->stored_mask & 2 ?
+            memcmp(result->stored_sha1, result->linear.sha1, 20) == 0 : -1;
+        result->threads = verify->worker_count;
+        result->seconds = verify->seconds;
+    }
+
+    verify_free(verify);
+    return status;
+}
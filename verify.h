@@ -0,0 +1,47 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "hash.h"
+
+// Whole-image acquisition verification
+//
+// The image is split into fixed-size segments. Worker threads, each with
+// its own image handle, read (and for E01 inflate) segments in parallel
+// and hash each one with SHA-256; the segment digests are combined into a
+// two-level tree hash. MD5 and SHA-1 of the whole stream cannot be split,
+// so one thread per algorithm consumes the segments in order from the
+// workers' buffers to produce the linear digests of the acquisition log.
+
+#define VERIFY_SEGMENT_SIZE (4 << 20)
+
+typedef struct ImageVerify ImageVerify;
+
+typedef struct {
+    HashDigests linear;          // MD5 and SHA-1 over the whole media
+    unsigned char tree_sha256[32]; // SHA-256 over the segment SHA-256s
+    long long media_size;
+    long long segment_count;
+    int stored_mask;             // Acquisition hashes found in the image
+    unsigned char stored_md5[16];
+    unsigned char stored_sha1[20];
+    int md5_match;               // 1 match, 0 mismatch, -1 nothing stored
+    int sha1_match;
+    int threads;
+    double seconds;
+} VerifyResult;
+
+// Start verifying the image at path in the background; threads <= 0 uses
+// every online CPU. NULL if the image cannot be opened.
+ImageVerify* verify_start(const char* path, int threads);
+
+// Fraction of the media both linear digests have consumed, 0..1
+double verify_progress(const ImageVerify* verify);
+int verify_done(const ImageVerify* verify);
+
+// Stop early; verify_finish then fails
+void verify_cancel(ImageVerify* verify);
+
+// Wait for the threads, fill result and free the job; 0 on success
+int verify_finish(ImageVerify* verify, VerifyResult* result);
+
+#endif
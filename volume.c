@@ -0,0 +1,181 @@
+#include "volume.h"
+#include "ext4.h"
+#include "fat.h"
+#include "ntfs.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR 512
+#define MBR_EXTENDED_LIMIT 128 // Logical partitions followed in an EBR chain
+
+// Probed in order; the more specific boot sectors come first
+static const FsBackend* const backends[] = {
+    &ntfs_backend,
+    &exfat_backend,
+    &fat_backend,
+    &ext4_backend,
+};
+
+static uint32_t le32(const unsigned char* p) {
+    return (uint32_t)(p[0] | p[1] << 8 | p[2] << 16) | (uint32_t)p[3] << 24;
+}
+
+static uint64_t le64(const unsigned char* p) {
+    return (uint64_t)le32(p) | (uint64_t)le32(p + 4) << 32;
+}
+
+const FsBackend* volume_detect(EvidenceImage* image, long long offset) {
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (backends[i]->probe(image, offset)) return backends[i];
+    }
+    return NULL;
+}
+
+static int add_volume(EvidenceImage* image, Volume* volumes, int count, int max,
+                      long long offset, long long length, int partition) {
+    if (count >= max || offset <= 0 || offset >= image_size(image)) return count;
+    Volume* volume = &volumes[count];
+    volume->offset = offset;
+    volume->length = length;
+    volume->partition = partition;
+    volume->backend = volume_detect(image, offset);
+    return count + 1;
+}
+
+static int is_extended(unsigned char type) {
+    return type == 0x05 || type == 0x0F || type == 0x85;
+}
+
+// Logical partitions: each EBR holds one partition, relative to itself,
+// and a link to the next EBR, relative to the start of the extended one
+static int scan_extended(EvidenceImage* image, long long base, Volume* volumes, int count, int max,
+                         int* partition) {
+    unsigned char ebr[SECTOR];
+    long long current = base;
+    for (int hops = 0; hops < MBR_EXTENDED_LIMIT; hops++) {
+        if (image_read(image, current, ebr, SECTOR) != SECTOR || ebr[510] != 0x55 || ebr[511] != 0xAA) break;
+
+        const unsigned char* logical = ebr + 446;
+        if (logical[4] != 0 && le32(logical + 8) != 0) {
+            count = add_volume(image, volumes, count, max, current + (long long)le32(logical + 8) * SECTOR,
+                               (long long)le32(logical + 12) * SECTOR, (*partition)++);
+        }
+        const unsigned char* link = ebr + 446 + 16;
+        if (!is_extended(link[4]) || le32(link + 8) == 0) break;
+        current = base + (long long)le32(link + 8) * SECTOR;
+    }
+    return count;
+}
+
+static int scan_gpt(EvidenceImage* image, Volume* volumes, int count, int max) {
+    unsigned char header[SECTOR];
+    if (image_read(image, SECTOR, header, SECTOR) != SECTOR || memcmp(header, "EFI PART", 8) != 0) return count;
+
+    long long table = (long long)le64(header + 0x48) * SECTOR;
+    uint32_t entries = le32(header + 0x50);
+    uint32_t entry_size = le32(header + 0x54);
+    if (entry_size < 128 || entry_size > SECTOR || entries > 1024) return count;
+
+    static const unsigned char unused[16];
+    unsigned char entry[SECTOR];
+    for (uint32_t i = 0; i < entries; i++) {
+        if (image_read(image, table + (long long)i * entry_size, entry, entry_size) != (long)entry_size) break;
+        if (memcmp(entry, unused, 16) == 0) continue;
+        long long first = (long long)le64(entry + 0x20);
+        long long last = (long long)le64(entry + 0x28);
+        if (last < first) continue;
+        count = add_volume(image, volumes, count, max, first * SECTOR, (last - first + 1) * SECTOR, (int)i + 1);
+    }
+    return count;
+}
+
+int volume_scan(EvidenceImage* image, Volume* volumes, int max) {
+    if (max <= 0) return 0;
+
+    // A bare volume: no partition table to walk
+    const FsBackend* backend = volume_detect(image, 0);
+    if (backend) {
+        volumes[0].offset = 0;
+        volumes[0].length = image_size(image);
+        volumes[0].partition = 0;
+        volumes[0].backend = backend;
+        return 1;
+    }
+
+    unsigned char mbr[SECTOR];
+    if (image_read(image, 0, mbr, SECTOR) != SECTOR || mbr[510] != 0x55 || mbr[511] != 0xAA) return 0;
+
+    int count = 0;
+    int logical = 5; // Logical partitions are numbered after the four primary slots
+    for (int i = 0; i < 4; i++) {
+        const unsigned char* entry = mbr + 446 + i * 16;
+        long long start = (long long)le32(entry + 8) * SECTOR;
+        if (entry[4] == 0 || start == 0) continue;
+        if (entry[4] == 0xEE) return scan_gpt(image, volumes, count, max);
+        if (is_extended(entry[4])) {
+            count = scan_extended(image, start, volumes, count, max, &logical);
+        } else {
+            count = add_volume(image, volumes, count, max, start, (long long)le32(entry + 12) * SECTOR, i + 1);
+        }
+    }
+    return count;
+}
+
+int volume_extents_add(VolumeExtents* extents, long long offset, long long length) {
+    if (length <= 0) return 0;
+    if (extents->count > 0) {
+        ImageRun* last = &extents->runs[extents->count - 1];
+        if (last->offset + last->length == offset) {
+            last->length += length;
+            return 0;
+        }
+    }
+    if (extents->count == extents->capacity) {
+        int capacity = extents->capacity ? extents->capacity * 2 : 256;
+        ImageRun* runs = realloc(extents->runs, (size_t)capacity * sizeof(ImageRun));
+        if (!runs) return -1;
+        extents->runs = runs;
+        extents->capacity = capacity;
+    }
+    extents->runs[extents->count].offset = offset;
+    extents->runs[extents->count].length = length;
+    extents->count++;
+    return 0;
+}
+
+int volume_extents_add_bits(VolumeExtents* extents, const unsigned char* bitmap, long long bits,
+                            long long base, long long unit) {
+    long long i = 0;
+    while (i < bits) {
+        // Whole bytes of free or used units are skipped at once
+        if ((i & 7) == 0 && i + 8 <= bits && bitmap[i >> 3] == 0x00) {
+            i += 8;
+            continue;
+        }
+        if (!(bitmap[i >> 3] >> (i & 7) & 1)) {
+            i++;
+            continue;
+        }
+        long long first = i++;
+        while (i < bits) {
+            if ((i & 7) == 0 && i + 8 <= bits && bitmap[i >> 3] == 0xFF) {
+                i += 8;
+            } else if (bitmap[i >> 3] >> (i & 7) & 1) {
+                i++;
+            } else {
+                break;
+            }
+        }
+        if (volume_extents_add(extents, base + first * unit, (i - first) * unit) != 0) return -1;
+    }
+    return 0;
+}
+
+void volume_extents_free(VolumeExtents* extents) {
+    free(extents->runs);
+    extents->runs = NULL;
+    extents->count = 0;
+    extents->capacity = 0;
+}
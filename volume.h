@@ -0,0 +1,74 @@
+#ifndef VOLUME_H
+#define VOLUME_H
+
+#include "filetable.h"
+#include "image.h"
+
+// Volumes and file system backends
+//
+// Partition tables (MBR with extended partitions, GPT) are walked to find
+// the volumes of an image, and each volume is offered to the file system
+// backends in turn. A backend recognises its boot sector or superblock
+// and appends the volume's tree to the file table in preorder, exposing
+// file content as image runs so analysis can read it sequentially.
+// Backends also report the space a volume allocates, read from its
+// allocation bitmap or table, so carving can leave metadata alone.
+
+#define VOLUME_MAX 64
+
+typedef struct {
+    long long records;   // Metadata records walked: MFT records, inodes, directory entries
+    long long entries;   // Entries added to the file table
+    long long deleted;
+    long long orphans;
+    int threads;
+    double seconds;
+} VolumeStats;
+
+// Growable list of image extents
+typedef struct {
+    ImageRun* runs;
+    int count;
+    int capacity;
+} VolumeExtents;
+
+typedef struct {
+    const char* name;
+    // Whether the volume starting at offset holds this file system
+    int (*probe)(EvidenceImage* image, long long offset);
+    // Add the volume's tree under parent. Worker threads open their own
+    // handles on path; threads <= 0 uses every online CPU. 0 on success.
+    int (*load)(EvidenceImage* image, const char* path, long long offset,
+                FileTable* table, int parent, int threads, VolumeStats* stats);
+    // Append the space the volume allocates to extents: what its bitmap
+    // or allocation table marks in use, plus the boot area and metadata
+    // kept outside it. Extents may overlap. 0 on success.
+    int (*allocated)(EvidenceImage* image, long long offset, VolumeExtents* extents);
+} FsBackend;
+
+typedef struct {
+    long long offset;
+    long long length;
+    int partition;              // 1-based partition number, 0 for an unpartitioned image
+    const FsBackend* backend;   // NULL when no backend recognises it
+} Volume;
+
+// Backend for the volume at offset, or NULL
+const FsBackend* volume_detect(EvidenceImage* image, long long offset);
+
+// Find the volumes of an image: the image itself when it holds a file
+// system, otherwise its partitions. Returns the number found.
+int volume_scan(EvidenceImage* image, Volume* volumes, int max);
+
+// Append [offset, offset + length), merging with the last extent when it
+// ends there. Returns 0, or -1 when out of memory.
+int volume_extents_add(VolumeExtents* extents, long long offset, long long length);
+
+// Append the units whose bits are set in bitmap[0, bits), least
+// significant bit first; bit i covers [base + i * unit, base + (i + 1) * unit)
+int volume_extents_add_bits(VolumeExtents* extents, const unsigned char* bitmap, long long bits,
+                            long long base, long long unit);
+
+void volume_extents_free(VolumeExtents* extents);
+
+#endif